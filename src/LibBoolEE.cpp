@@ -15,6 +15,7 @@ this program.  If not, see <http://www.gnu.org/licenses/>.
 ******************************************************************************/
 
 #include "LibBoolEE.h"
+#include "memusage.h"
 
 std::vector<std::string> LibBoolEE::singleParse(const std::string & formula, const char op, ErrorReport* errorReport) {
     int start_pos = -1;
@@ -145,6 +146,124 @@ bool LibBoolEE::resolveRec(const std::string &source, const Vals & valuation, Er
     }
 }
 
+LibBoolEE::Formula LibBoolEE::compile(const std::string &source, const std::vector<std::string> & variables, ErrorReport* errorReport) {
+    std::map<std::string, size_t> indices;
+    for (size_t i = 0; i < variables.size(); i++) {
+        indices.insert(std::make_pair(variables[i], i));
+    }
+    Formula formula;
+    formula.nodes.emplace_back(); // Reserve the root
+    size_t root = compileRec(removeWhitespaces(source), indices, formula, errorReport);
+    formula.nodes[0] = formula.nodes[root];
+    return formula;
+}
+
+size_t LibBoolEE::compileRec(const std::string &source, const std::map<std::string, size_t> & variables, Formula & formula, ErrorReport* errorReport) {
+    if (source.empty()) {
+        if (errorReport) {
+            errorReport->type = ErrorReport::ErrorType::EmptySubExpression;
+            errorReport->vecUserData.emplace_back(source);
+            errorReport->strDevData = "bad-txns-null-verifier-empty-sub-expression";
+        }
+        throw std::runtime_error("An empty subexpression was encountered");
+    }
+
+    Formula::Node node;
+    node.value = 0;
+
+    char current_op = '|';
+    // Try to divide by |
+    std::vector<std::string> subexpressions = singleParse(source, current_op, errorReport);
+    // No | on the top level
+    if (subexpressions.size() == 1) {
+        current_op = '&';
+        subexpressions = singleParse(source, current_op, errorReport);
+    }
+
+    // No valid name found
+    if (subexpressions.size() == 0) {
+        if (errorReport) {
+            errorReport->type = ErrorReport::ErrorType::InvalidQualifierName;
+            errorReport->vecUserData.emplace_back(source);
+            errorReport->strDevData = "bad-txns-null-verifier-no-sub-expressions";
+        }
+        throw std::runtime_error("The subexpression " + source + " is not a valid formula.");
+    }
+
+    // No binary top level operator found
+    else if (subexpressions.size() == 1) {
+        if (source[0] == '!') {
+            node.type = Formula::NOT;
+            node.children.push_back(compileRec(source.substr(1), variables, formula, errorReport));
+        }
+        else if (source[0] == '(') {
+            return compileRec(source.substr(1, source.size() - 2), variables, formula, errorReport);
+        }
+        else if (source == "1" || source == "0") {
+            node.type = Formula::CONSTANT;
+            node.value = source == "1";
+        }
+        else if (variables.count(source) == 0) {
+            if (errorReport) {
+                errorReport->type = ErrorReport::ErrorType::VariableNotFound;
+                errorReport->vecUserData.emplace_back(source);
+                errorReport->strDevData = "bad-txns-null-verifier-variable-not-found";
+            }
+            throw std::runtime_error("Variable '" + source + "' not found in the interpretation.");
+        }
+        else {
+            node.type = Formula::VARIABLE;
+            node.value = variables.at(source);
+        }
+    }
+    else {
+        node.type = current_op == '|' ? Formula::OR : Formula::AND;
+        for (std::vector<std::string>::iterator it = subexpressions.begin(); it != subexpressions.end(); it++) {
+            node.children.push_back(compileRec(*it, variables, formula, errorReport));
+        }
+    }
+
+    formula.nodes.push_back(node);
+    return formula.nodes.size() - 1;
+}
+
+bool LibBoolEE::Formula::evaluate(const std::vector<bool> & values) const {
+    return evaluateNode(0, values);
+}
+
+size_t LibBoolEE::Formula::DynamicMemoryUsage() const {
+    size_t usage = memusage::DynamicUsage(nodes);
+    for (const Node & node : nodes)
+        usage += memusage::DynamicUsage(node.children);
+    return usage;
+}
+
+bool LibBoolEE::Formula::evaluateNode(size_t index, const std::vector<bool> & values) const {
+    const Node & node = nodes[index];
+    switch (node.type) {
+        case VARIABLE:
+            return values[node.value];
+        case CONSTANT:
+            return node.value != 0;
+        case NOT:
+            return !evaluateNode(node.children[0], values);
+        case OR:
+            for (size_t child : node.children) {
+                if (evaluateNode(child, values)) {
+                    return true;
+                }
+            }
+            return false;
+        default: // AND
+            for (size_t child : node.children) {
+                if (!evaluateNode(child, values)) {
+                    return false;
+                }
+            }
+            return true;
+    }
+}
+
 std::string LibBoolEE::trim(const std::string &source) {
     static const std::string WHITESPACES = " \n\r\t\v\f";
     const size_t front = source.find_first_not_of(WHITESPACES);
@@ -44,9 +44,38 @@ public:
     typedef std::map<std::string, bool> Vals; ///< Valuation of atomic propositions
     typedef std::pair<std::string, bool> Val; ///< A single proposition valuation
 
+    /// A formula parsed once, that can then be evaluated under many valuations without being parsed again.
+    /// Variable i of the formula is the i-th variable given to compile(), and is valued by values[i].
+    class Formula {
+    public:
+        // @return	true iff the formula is true when variable i has the value values[i]
+        bool evaluate(const std::vector<bool> & values) const;
+
+        // @return	the heap memory held by the parsed formula
+        size_t DynamicMemoryUsage() const;
+
+    private:
+        friend class LibBoolEE;
+
+        enum NodeType { VARIABLE, CONSTANT, NOT, OR, AND };
+
+        struct Node {
+            NodeType type;
+            size_t value;                   ///< The variable index for VARIABLE nodes, the value for CONSTANT nodes
+            std::vector<size_t> children;   ///< Indices into nodes for NOT, OR and AND nodes
+        };
+
+        std::vector<Node> nodes;            ///< nodes[0] is the root
+
+        bool evaluateNode(size_t node, const std::vector<bool> & values) const;
+    };
+
     // @return	true iff the formula is true under the valuation (where the valuation are pairs (variable,value))
     static bool resolve(const std::string & source, const Vals & valuation,  ErrorReport* errorReport = nullptr);
 
+    // @return	the formula parsed into a Formula over the given variables, throwing wherever resolve() would under a valuation of exactly those variables
+    static Formula compile(const std::string & source, const std::vector<std::string> & variables, ErrorReport* errorReport = nullptr);
+
     // @return  new string made from the source by removing whitespaces
     static std::string removeWhitespaces(const std::string & source);
 
@@ -62,6 +91,9 @@ private:
     // @return	true iff the formula is true under the valuation (where the valuation are pairs (variable,value))---used internally
     static bool resolveRec(const std::string & source, const Vals & valuation, ErrorReport* errorReport = nullptr);
 
+    // @return	the index of the node the formula was parsed into, following the same steps as resolveRec---used internally
+    static size_t compileRec(const std::string & source, const std::map<std::string, size_t> & variables, Formula & formula, ErrorReport* errorReport = nullptr);
+
 
     // @return	new string made from the source by removing the leading and trailing white spaces
     static std::string trim(const std::string & source);
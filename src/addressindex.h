@@ -310,6 +310,205 @@ struct CAddressIndexIteratorHeightKey {
     }
 };
 
+/**
+ * Key of the height ordered address index. It holds every field of the CAddressIndexKey it mirrors,
+ * but puts the height and position in the block ahead of the asset, so that all of an address's
+ * deltas across assets can be read for a range of heights with one seek, already in chain order.
+ */
+struct CAddressHeightIndexKey {
+    unsigned int type;
+    uint160 hashBytes;
+    int blockHeight;
+    unsigned int txindex;
+    std::string asset;
+    uint256 txhash;
+    size_t index;
+    bool spending;
+
+    size_t GetSerializeSize() const {
+        return 34 + asset.size();
+    }
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        ser_writedata8(s, type);
+        hashBytes.Serialize(s);
+        // Heights are stored big-endian for key sorting in LevelDB
+        ser_writedata32be(s, blockHeight);
+        ser_writedata32be(s, txindex);
+        ::Serialize(s, asset);
+        txhash.Serialize(s);
+        ser_writedata32(s, index);
+        char f = spending;
+        ser_writedata8(s, f);
+    }
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        type = ser_readdata8(s);
+        hashBytes.Unserialize(s);
+        blockHeight = ser_readdata32be(s);
+        txindex = ser_readdata32be(s);
+        ::Unserialize(s, asset);
+        txhash.Unserialize(s);
+        index = ser_readdata32(s);
+        char f = ser_readdata8(s);
+        spending = f;
+    }
+
+    explicit CAddressHeightIndexKey(const CAddressIndexKey& key) {
+        type = key.type;
+        hashBytes = key.hashBytes;
+        blockHeight = key.blockHeight;
+        txindex = key.txindex;
+        asset = key.asset;
+        txhash = key.txhash;
+        index = key.index;
+        spending = key.spending;
+    }
+
+    CAddressHeightIndexKey() {
+        SetNull();
+    }
+
+    void SetNull() {
+        type = 0;
+        hashBytes.SetNull();
+        blockHeight = 0;
+        txindex = 0;
+        asset.clear();
+        txhash.SetNull();
+        index = 0;
+        spending = false;
+    }
+
+    CAddressIndexKey GetAddressIndexKey() const {
+        return CAddressIndexKey(type, hashBytes, asset, blockHeight, txindex, txhash, index, spending);
+    }
+};
+
+struct CAddressHeightIndexIteratorKey {
+    unsigned int type;
+    uint160 hashBytes;
+    int blockHeight;
+
+    size_t GetSerializeSize() const {
+        return 25;
+    }
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        ser_writedata8(s, type);
+        hashBytes.Serialize(s);
+        ser_writedata32be(s, blockHeight);
+    }
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        type = ser_readdata8(s);
+        hashBytes.Unserialize(s);
+        blockHeight = ser_readdata32be(s);
+    }
+
+    CAddressHeightIndexIteratorKey(unsigned int addressType, uint160 addressHash, int height) {
+        type = addressType;
+        hashBytes = addressHash;
+        blockHeight = height;
+    }
+
+    CAddressHeightIndexIteratorKey() {
+        SetNull();
+    }
+
+    void SetNull() {
+        type = 0;
+        hashBytes.SetNull();
+        blockHeight = 0;
+    }
+};
+
+/** Key of the running balance of one asset held by one address */
+struct CAddressBalanceKey {
+    unsigned int type;
+    uint160 hashBytes;
+    std::string asset;
+
+    size_t GetSerializeSize() const {
+        return 21 + asset.size();
+    }
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        ser_writedata8(s, type);
+        hashBytes.Serialize(s);
+        ::Serialize(s, asset);
+    }
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        type = ser_readdata8(s);
+        hashBytes.Unserialize(s);
+        ::Unserialize(s, asset);
+    }
+
+    CAddressBalanceKey(unsigned int addressType, uint160 addressHash, std::string assetName) {
+        type = addressType;
+        hashBytes = addressHash;
+        asset = assetName;
+    }
+
+    CAddressBalanceKey() {
+        SetNull();
+    }
+
+    void SetNull() {
+        type = 0;
+        hashBytes.SetNull();
+        asset.clear();
+    }
+
+    friend bool operator<(const CAddressBalanceKey& a, const CAddressBalanceKey& b) {
+        if (a.type != b.type)
+            return a.type < b.type;
+        if (a.hashBytes != b.hashBytes)
+            return a.hashBytes < b.hashBytes;
+        return a.asset < b.asset;
+    }
+};
+
+/** Sum of all address index deltas of an address and asset: the balance, and the total of the positive deltas */
+struct CAddressBalanceValue {
+    CAmount balance;
+    CAmount received;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(balance);
+        READWRITE(received);
+    }
+
+    CAddressBalanceValue(CAmount balanceIn, CAmount receivedIn) {
+        balance = balanceIn;
+        received = receivedIn;
+    }
+
+    CAddressBalanceValue() {
+        SetNull();
+    }
+
+    void SetNull() {
+        balance = 0;
+        received = 0;
+    }
+
+    bool IsNull() const {
+        return balance == 0 && received == 0;
+    }
+
+    /** Add (nSign = 1) or remove (nSign = -1) one address index delta */
+    void ApplyDelta(CAmount nDelta, int nSign) {
+        balance += nSign * nDelta;
+        if (nDelta > 0)
+            received += nSign * nDelta;
+    }
+};
+
 struct CMempoolAddressDelta
 {
     int64_t time;
@@ -134,7 +134,7 @@ bool CAssetsDB::LoadAssets()
 
                 // Loaded enough from database to have in memory.
                 // No need to load everything if it is just going to be removed from the cache
-                if (passetsCache->Size() == (passetsCache->MaxSize() / 2))
+                if (passetsCache->DynamicMemoryUsage() >= passetsCache->MaxMemoryUsage() / 2)
                     break;
             } else {
                 return error("%s: failed to read asset", __func__);
@@ -173,42 +173,55 @@ bool CAssetsDB::LoadAssets()
     return true;
 }
 
-bool CAssetsDB::AssetDir(std::vector<CDatabasedAssetData>& assets, const std::string filter, const size_t count, const long start)
+bool CAssetsDB::AssetDir(std::vector<CDatabasedAssetData>& assets, const std::string filter, const size_t count, const long start, const std::string& after)
 {
     FlushStateToDisk();
 
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
-    pcursor->Seek(std::make_pair(ASSET_FLAG, std::string()));
 
     auto prefix = filter;
     bool wildcard = prefix.back() == '*';
     if (wildcard)
         prefix.pop_back();
 
+    auto fMatches = [&prefix, wildcard](const std::string& name) {
+        return prefix == "" ||
+               (wildcard && name.find(prefix) == 0) ||
+               (!wildcard && name == prefix);
+    };
+
     size_t skip = 0;
-    if (start >= 0) {
+    if (!after.empty()) {
+        // Resume directly after the last key of the previous page
+        pcursor->Seek(std::make_pair(ASSET_FLAG, after));
+        std::pair<char, std::string> key;
+        if (pcursor->Valid() && pcursor->GetKey(key) && key.first == ASSET_FLAG && key.second == after)
+            pcursor->Next();
+        if (start > 0)
+            skip = start;
+    } else if (start >= 0) {
+        pcursor->Seek(std::make_pair(ASSET_FLAG, std::string()));
         skip = start;
-    }
-    else {
-        // compute table size for backwards offset
-        long table_size = 0;
+    } else {
+        // Walk backwards from the end of the table until we are -start matches from the end
+        const size_t nFromEnd = -start;
+        size_t nFound = 0;
+        pcursor->SeekToLastWithPrefix(ASSET_FLAG);
         while (pcursor->Valid()) {
             boost::this_thread::interruption_point();
 
             std::pair<char, std::string> key;
-            if (pcursor->GetKey(key) && key.first == ASSET_FLAG) {
-                if (prefix == "" ||
-                    (wildcard && key.second.find(prefix) == 0) ||
-                    (!wildcard && key.second == prefix)) {
-                    table_size += 1;
-                }
-            }
-            pcursor->Next();
+            if (!pcursor->GetKey(key) || key.first != ASSET_FLAG)
+                break;
+            if (fMatches(key.second) && ++nFound == nFromEnd)
+                break;
+            pcursor->Prev();
         }
-        skip = table_size + start;
-        pcursor->SeekToFirst();
-    }
 
+        // Fewer matches than requested, start from the beginning of the table
+        if (nFound < nFromEnd)
+            pcursor->Seek(std::make_pair(ASSET_FLAG, std::string()));
+    }
 
     size_t loaded = 0;
     size_t offset = 0;
@@ -219,9 +232,7 @@ bool CAssetsDB::AssetDir(std::vector<CDatabasedAssetData>& assets, const std::st
 
         std::pair<char, std::string> key;
         if (pcursor->GetKey(key) && key.first == ASSET_FLAG) {
-            if (prefix == "" ||
-                    (wildcard && key.second.find(prefix) == 0) ||
-                    (!wildcard && key.second == prefix)) {
+            if (fMatches(key.second)) {
                 if (offset < skip) {
                     offset += 1;
                 }
@@ -317,14 +328,14 @@ bool CAssetsDB::AddressDir(std::vector<std::pair<std::string, CAmount> >& vecAss
 }
 
 // Can get to total count of addresses that belong to a certain asset_name, or get you the list of all address that belong to a certain asset_name
-bool CAssetsDB::AssetAddressDir(std::vector<std::pair<std::string, CAmount> >& vecAddressAmount, int& totalEntries, const bool& fGetTotal, const std::string& assetName, const size_t count, const long start)
+bool CAssetsDB::AssetAddressDir(std::vector<std::pair<std::string, CAmount> >& vecAddressAmount, int& totalEntries, const bool& fGetTotal, const std::string& assetName, const size_t count, const long start, const std::string& after)
 {
     FlushStateToDisk();
 
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
-    pcursor->Seek(std::make_pair(ASSET_ADDRESS_QUANTITY_FLAG, std::make_pair(assetName, std::string())));
 
     if (fGetTotal) {
+        pcursor->Seek(std::make_pair(ASSET_ADDRESS_QUANTITY_FLAG, std::make_pair(assetName, std::string())));
         totalEntries = 0;
         while (pcursor->Valid()) {
             boost::this_thread::interruption_point();
@@ -332,6 +343,8 @@ bool CAssetsDB::AssetAddressDir(std::vector<std::pair<std::string, CAmount> >& v
             std::pair<char, std::pair<std::string, std::string> > key;
             if (pcursor->GetKey(key) && key.first == ASSET_ADDRESS_QUANTITY_FLAG && key.second.first == assetName) {
                 totalEntries += 1;
+            } else {
+                break;
             }
             pcursor->Next();
         }
@@ -339,23 +352,36 @@ bool CAssetsDB::AssetAddressDir(std::vector<std::pair<std::string, CAmount> >& v
     }
 
     size_t skip = 0;
-    if (start >= 0) {
+    if (!after.empty()) {
+        // Resume directly after the last address of the previous page
+        pcursor->Seek(std::make_pair(ASSET_ADDRESS_QUANTITY_FLAG, std::make_pair(assetName, after)));
+        std::pair<char, std::pair<std::string, std::string> > key;
+        if (pcursor->Valid() && pcursor->GetKey(key) && key.first == ASSET_ADDRESS_QUANTITY_FLAG && key.second.first == assetName && key.second.second == after)
+            pcursor->Next();
+        if (start > 0)
+            skip = start;
+    } else if (start >= 0) {
+        pcursor->Seek(std::make_pair(ASSET_ADDRESS_QUANTITY_FLAG, std::make_pair(assetName, std::string())));
         skip = start;
-    }
-    else {
-        // compute table size for backwards offset
-        long table_size = 0;
+    } else {
+        // Every entry under this prefix belongs to the asset, so step back -start entries from the end
+        const size_t nFromEnd = -start;
+        size_t nFound = 0;
+        pcursor->SeekToLastWithPrefix(std::make_pair(ASSET_ADDRESS_QUANTITY_FLAG, assetName));
         while (pcursor->Valid()) {
             boost::this_thread::interruption_point();
 
             std::pair<char, std::pair<std::string, std::string> > key;
-            if (pcursor->GetKey(key) && key.first == ASSET_ADDRESS_QUANTITY_FLAG && key.second.first == assetName) {
-                table_size += 1;
-            }
-            pcursor->Next();
+            if (!pcursor->GetKey(key) || key.first != ASSET_ADDRESS_QUANTITY_FLAG || key.second.first != assetName)
+                break;
+            if (++nFound == nFromEnd)
+                break;
+            pcursor->Prev();
         }
-        skip = table_size + start;
-        pcursor->SeekToFirst();
+
+        // Fewer entries than requested, start from the first address of the asset
+        if (nFound < nFromEnd)
+            pcursor->Seek(std::make_pair(ASSET_ADDRESS_QUANTITY_FLAG, std::make_pair(assetName, std::string())));
     }
 
     size_t loaded = 0;
@@ -388,6 +414,34 @@ bool CAssetsDB::AssetAddressDir(std::vector<std::pair<std::string, CAmount> >& v
     return true;
 }
 
+bool CAssetsDB::ForEachAssetAddressQuantity(const std::string& assetName, std::function<bool(const std::string& address, const CAmount& amount)> fn, CDBSnapshot* pview)
+{
+    if (!pview)
+        FlushStateToDisk();
+
+    std::unique_ptr<CDBIterator> pcursor(pview ? pview->NewIterator() : NewIterator());
+    pcursor->Seek(std::make_pair(ASSET_ADDRESS_QUANTITY_FLAG, std::make_pair(assetName, std::string())));
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+
+        std::pair<char, std::pair<std::string, std::string> > key;
+        if (!pcursor->GetKey(key) || key.first != ASSET_ADDRESS_QUANTITY_FLAG || key.second.first != assetName)
+            break;
+
+        CAmount amount;
+        if (!pcursor->GetValue(amount))
+            return error("%s: failed to Asset Address Quanity", __func__);
+
+        if (!fn(key.second.second, amount))
+            return false;
+
+        pcursor->Next();
+    }
+
+    return true;
+}
+
 bool CAssetsDB::AssetDir(std::vector<CDatabasedAssetData>& assets)
 {
     return CAssetsDB::AssetDir(assets, "*", MAX_SIZE, 0);
@@ -8,6 +8,7 @@
 #include "fs.h"
 #include "serialize.h"
 
+#include <functional>
 #include <string>
 #include <map>
 #include <dbwrapper.h>
@@ -87,11 +88,16 @@ public:
 
     // Helper functions
     bool LoadAssets();
-    bool AssetDir(std::vector<CDatabasedAssetData>& assets, const std::string filter, const size_t count, const long start);
+    // A non-empty 'after' resumes the listing directly after that key (asset name / address) of a previous page
+    bool AssetDir(std::vector<CDatabasedAssetData>& assets, const std::string filter, const size_t count, const long start, const std::string& after = "");
     bool AssetDir(std::vector<CDatabasedAssetData>& assets);
 
     bool AddressDir(std::vector<std::pair<std::string, CAmount> >& vecAssetAmount, int& totalEntries, const bool& fGetTotal, const std::string& address, const size_t count, const long start);
-    bool AssetAddressDir(std::vector<std::pair<std::string, CAmount> >& vecAddressAmount, int& totalEntries, const bool& fGetTotal, const std::string& assetName, const size_t count, const long start);
+    bool AssetAddressDir(std::vector<std::pair<std::string, CAmount> >& vecAddressAmount, int& totalEntries, const bool& fGetTotal, const std::string& assetName, const size_t count, const long start, const std::string& after = "");
+
+    // Visit every address holding assetName in a single pass over the index; stops early if fn returns false.
+    // Reads from pview, a frozen view of this database, instead of flushing and reading the database when given
+    bool ForEachAssetAddressQuantity(const std::string& assetName, std::function<bool(const std::string& address, const CAmount& amount)> fn, CDBSnapshot* pview = nullptr);
 };
 
 
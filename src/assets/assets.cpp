@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <regex>
+#include <algorithm>
 #include <script/script.h>
 #include <version.h>
 #include <streams.h>
@@ -44,23 +45,6 @@ std::map<std::string, uint256> mapReissuedAssets;
 static const auto MAX_NAME_LENGTH = 31;
 static const auto MAX_CHANNEL_NAME_LENGTH = 12;
 
-// min lengths are expressed by quantifiers
-static const std::regex ROOT_NAME_CHARACTERS("^[A-Z0-9._]{3,}$");
-static const std::regex SUB_NAME_CHARACTERS("^[A-Z0-9._]+$");
-static const std::regex UNIQUE_TAG_CHARACTERS("^[-A-Za-z0-9@$%&*()[\\]{}_.?:]+$");
-static const std::regex MSGCHANNEL_TAG_CHARACTERS("^[A-Za-z0-9_]+$");
-static const std::regex VOTE_TAG_CHARACTERS("^[A-Z0-9._]+$");
-
-// Restricted assets
-static const std::regex QUALIFIER_NAME_CHARACTERS("#[A-Z0-9._]{3,}$");
-static const std::regex SUB_QUALIFIER_NAME_CHARACTERS("#[A-Z0-9._]+$");
-static const std::regex RESTRICTED_NAME_CHARACTERS("\\$[A-Z0-9._]{3,}$");
-
-static const std::regex DOUBLE_PUNCTUATION("^.*[._]{2,}.*$");
-static const std::regex LEADING_PUNCTUATION("^[._].*$");
-static const std::regex TRAILING_PUNCTUATION("^.*[._]$");
-static const std::regex QUALIFIER_LEADING_PUNCTUATION("^[#\\$][._].*$"); // Used for qualifier assets, and restricted asset only
-
 static const std::string SUB_NAME_DELIMITER = "/";
 static const std::string UNIQUE_TAG_DELIMITER = "#";
 static const std::string MSGCHANNEL_TAG_DELIMITER = "~";
@@ -68,140 +52,246 @@ static const std::string MSGCHANNEL_TAG_DELIMITER = "~";
 static const std::string VOTE_TAG_DELIMITER = "^";
 static const std::string RESTRICTED_TAG_DELIMITER = "$";
 
-static const std::regex UNIQUE_INDICATOR(R"(^[^^~#!]+#[^~#!\/]+$)");
-static const std::regex MSGCHANNEL_INDICATOR(R"(^[^^~#!]+~[^~#!\/]+$)");
-static const std::regex OWNER_INDICATOR(R"(^[^^~#!]+!$)");
-static const std::regex VOTE_INDICATOR(R"(^[^^~#!]+\^[^~#!\/]+$)");
+/**
+ * Asset names are validated against a per-byte character class table instead of std::regex.
+ * Every rule the old regular expressions expressed is reproduced here exactly:
+ *
+ *   NAME_CHAR        [A-Z0-9._]                        root, sub, vote tag, qualifier and restricted names
+ *   UNIQUE_TAG_CHAR  [-A-Za-z0-9@$%&*()[\]{}_.?:]      unique tags
+ *   MSGCHANNEL_CHAR  [A-Za-z0-9_]                      message channel tags
+ *   PUNCTUATION      [._]                              can't be doubled, leading or trailing
+ *
+ * Min lengths that used to be expressed by quantifiers are passed to CheckNameChars explicitly.
+ */
+enum AssetNameCharClass : uint8_t {
+    NAME_CHAR = 1 << 0,
+    UNIQUE_TAG_CHAR = 1 << 1,
+    MSGCHANNEL_CHAR = 1 << 2,
+    PUNCTUATION = 1 << 3
+};
+
+class CAssetNameCharTable
+{
+    uint8_t table[256];
+
+    void Add(char from, char to, uint8_t flags)
+    {
+        for (int c = (unsigned char)from; c <= (unsigned char)to; c++)
+            table[c] |= flags;
+    }
+
+    void Add(const char* chars, uint8_t flags)
+    {
+        for (; *chars; chars++)
+            table[(unsigned char)*chars] |= flags;
+    }
+
+public:
+    CAssetNameCharTable()
+    {
+        memset(table, 0, sizeof(table));
+        Add('A', 'Z', NAME_CHAR | UNIQUE_TAG_CHAR | MSGCHANNEL_CHAR);
+        Add('0', '9', NAME_CHAR | UNIQUE_TAG_CHAR | MSGCHANNEL_CHAR);
+        Add('a', 'z', UNIQUE_TAG_CHAR | MSGCHANNEL_CHAR);
+        Add("_", NAME_CHAR | UNIQUE_TAG_CHAR | MSGCHANNEL_CHAR | PUNCTUATION);
+        Add(".", NAME_CHAR | UNIQUE_TAG_CHAR | PUNCTUATION);
+        Add("-@$%&*()[]{}?:", UNIQUE_TAG_CHAR);
+    }
+
+    bool Is(char c, uint8_t flags) const { return (table[(unsigned char)c] & flags) != 0; }
+};
 
-static const std::regex QUALIFIER_INDICATOR("^[#][A-Z0-9._]{3,}$"); // Starts with #
-static const std::regex SUB_QUALIFIER_INDICATOR("^#[A-Z0-9._]+\\/#[A-Z0-9._]+$"); // Starts with #
-static const std::regex RESTRICTED_INDICATOR("^[\\$][A-Z0-9._]{3,}$"); // Starts with $
+static const CAssetNameCharTable assetNameChars;
 
-static const std::regex RAVEN_NAMES("^RVN$|^RAVEN$|^RAVENCOIN$|^#RVN$|^#RAVEN$|^#RAVENCOIN$");
+/**
+ * Check that [begin, end) is at least nMinLength characters long and only holds characters of charClass.
+ * When fCheckPunctuation is set, '.' and '_' may also not appear twice in a row or as the last character,
+ * and when fCheckLeading is set they may not be the first character either.
+ */
+static bool CheckNameChars(const char* begin, const char* end, uint8_t charClass, size_t nMinLength, bool fCheckPunctuation, bool fCheckLeading)
+{
+    if (end - begin < (ptrdiff_t)nMinLength || begin == end)
+        return false;
+
+    bool fLastPunctuation = false;
+    for (const char* p = begin; p != end; ++p) {
+        if (!assetNameChars.Is(*p, charClass))
+            return false;
+        bool fPunctuation = assetNameChars.Is(*p, PUNCTUATION);
+        if (fCheckPunctuation && fPunctuation && (fLastPunctuation || (fCheckLeading && p == begin)))
+            return false;
+        fLastPunctuation = fPunctuation;
+    }
+
+    return !(fCheckPunctuation && fLastPunctuation);
+}
+
+static bool IsRavenName(const char* begin, const char* end)
+{
+    static const std::string names[] = {"RVN", "RAVEN", "RAVENCOIN"};
+    for (const std::string& raven : names) {
+        if ((size_t)(end - begin) == raven.size() && std::equal(begin, end, raven.begin()))
+            return true;
+    }
+    return false;
+}
 
 bool IsRootNameValid(const std::string& name)
 {
-    return std::regex_match(name, ROOT_NAME_CHARACTERS)
-        && !std::regex_match(name, DOUBLE_PUNCTUATION)
-        && !std::regex_match(name, LEADING_PUNCTUATION)
-        && !std::regex_match(name, TRAILING_PUNCTUATION)
-        && !std::regex_match(name, RAVEN_NAMES);
+    return CheckNameChars(name.data(), name.data() + name.size(), NAME_CHAR, 3, true, true)
+        && !IsRavenName(name.data(), name.data() + name.size());
 }
 
 bool IsQualifierNameValid(const std::string& name)
 {
-    return std::regex_match(name, QUALIFIER_NAME_CHARACTERS)
-           && !std::regex_match(name, DOUBLE_PUNCTUATION)
-           && !std::regex_match(name, QUALIFIER_LEADING_PUNCTUATION)
-           && !std::regex_match(name, TRAILING_PUNCTUATION)
-           && !std::regex_match(name, RAVEN_NAMES);
+    // '#' followed by three or more name characters, the first of which can't be punctuation either
+    return !name.empty() && name[0] == '#'
+           && CheckNameChars(name.data() + 1, name.data() + name.size(), NAME_CHAR, 3, true, true)
+           && !IsRavenName(name.data() + 1, name.data() + name.size());
 }
 
 bool IsRestrictedNameValid(const std::string& name)
 {
-    return std::regex_match(name, RESTRICTED_NAME_CHARACTERS)
-           && !std::regex_match(name, DOUBLE_PUNCTUATION)
-           && !std::regex_match(name, LEADING_PUNCTUATION)
-           && !std::regex_match(name, TRAILING_PUNCTUATION)
-           && !std::regex_match(name, RAVEN_NAMES);
+    // Unlike qualifiers, punctuation directly after the '$' has always been accepted
+    return !name.empty() && name[0] == '$'
+           && CheckNameChars(name.data() + 1, name.data() + name.size(), NAME_CHAR, 3, true, false);
 }
 
 bool IsSubQualifierNameValid(const std::string& name)
 {
-    return std::regex_match(name, SUB_QUALIFIER_NAME_CHARACTERS)
-           && !std::regex_match(name, DOUBLE_PUNCTUATION)
-           && !std::regex_match(name, LEADING_PUNCTUATION)
-           && !std::regex_match(name, TRAILING_PUNCTUATION);
+    return !name.empty() && name[0] == '#'
+           && CheckNameChars(name.data() + 1, name.data() + name.size(), NAME_CHAR, 1, true, false);
 }
 
 bool IsSubNameValid(const std::string& name)
 {
-    return std::regex_match(name, SUB_NAME_CHARACTERS)
-        && !std::regex_match(name, DOUBLE_PUNCTUATION)
-        && !std::regex_match(name, LEADING_PUNCTUATION)
-        && !std::regex_match(name, TRAILING_PUNCTUATION);
+    return CheckNameChars(name.data(), name.data() + name.size(), NAME_CHAR, 1, true, true);
 }
 
 bool IsUniqueTagValid(const std::string& tag)
 {
-    return std::regex_match(tag, UNIQUE_TAG_CHARACTERS);
+    return CheckNameChars(tag.data(), tag.data() + tag.size(), UNIQUE_TAG_CHAR, 1, false, false);
 }
 
 bool IsVoteTagValid(const std::string& tag)
 {
-    return std::regex_match(tag, VOTE_TAG_CHARACTERS);
+    return CheckNameChars(tag.data(), tag.data() + tag.size(), NAME_CHAR, 1, false, false);
 }
 
 bool IsMsgChannelTagValid(const std::string &tag)
 {
-    return std::regex_match(tag, MSGCHANNEL_TAG_CHARACTERS)
-        && !std::regex_match(tag, DOUBLE_PUNCTUATION)
-        && !std::regex_match(tag, LEADING_PUNCTUATION)
-        && !std::regex_match(tag, TRAILING_PUNCTUATION);
+    return CheckNameChars(tag.data(), tag.data() + tag.size(), MSGCHANNEL_CHAR, 1, true, true);
 }
 
-bool IsNameValidBeforeTag(const std::string& name)
+/** Checks a '/' separated path of a root name followed by any number of sub names, without splitting it. */
+static bool IsNameValidBeforeTag(const char* begin, const char* end)
 {
-    std::vector<std::string> parts;
-    boost::split(parts, name, boost::is_any_of(SUB_NAME_DELIMITER));
-
-    if (!IsRootNameValid(parts.front())) return false;
+    const char* partEnd = std::find(begin, end, '/');
+    if (!CheckNameChars(begin, partEnd, NAME_CHAR, 3, true, true) || IsRavenName(begin, partEnd))
+        return false;
 
-    if (parts.size() > 1)
-    {
-        for (unsigned long i = 1; i < parts.size(); i++)
-        {
-            if (!IsSubNameValid(parts[i])) return false;
-        }
+    while (partEnd != end) {
+        begin = partEnd + 1;
+        partEnd = std::find(begin, end, '/');
+        if (!CheckNameChars(begin, partEnd, NAME_CHAR, 1, true, true))
+            return false;
     }
 
     return true;
 }
 
+bool IsNameValidBeforeTag(const std::string& name)
+{
+    return IsNameValidBeforeTag(name.data(), name.data() + name.size());
+}
+
 bool IsQualifierNameValidBeforeTag(const std::string& name)
 {
-    std::vector<std::string> parts;
-    boost::split(parts, name, boost::is_any_of(SUB_NAME_DELIMITER));
+    auto index = name.find(SUB_NAME_DELIMITER);
+    if (!IsQualifierNameValid(name.substr(0, index))) return false;
 
-    if (!IsQualifierNameValid(parts.front())) return false;
+    if (index == std::string::npos)
+        return true;
 
     // Qualifiers can only have one sub qualifier under it
-    if (parts.size() > 2) {
+    if (name.find(SUB_NAME_DELIMITER, index + 1) != std::string::npos)
         return false;
-    }
-
-    if (parts.size() > 1)
-    {
-
-        for (unsigned long i = 1; i < parts.size(); i++)
-        {
-            if (!IsSubQualifierNameValid(parts[i])) return false;
-        }
-    }
 
-    return true;
+    return IsSubQualifierNameValid(name.substr(index + 1));
 }
 
 bool IsAssetNameASubasset(const std::string& name)
 {
-    std::vector<std::string> parts;
-    boost::split(parts, name, boost::is_any_of(SUB_NAME_DELIMITER));
-
-    if (!IsRootNameValid(parts.front())) return false;
-
-    return parts.size() > 1;
+    auto index = name.find(SUB_NAME_DELIMITER);
+    return index != std::string::npos && IsRootNameValid(name.substr(0, index));
 }
 
 bool IsAssetNameASubQualifier(const std::string& name)
 {
-    std::vector<std::string> parts;
-    boost::split(parts, name, boost::is_any_of(SUB_NAME_DELIMITER));
+    auto index = name.find(SUB_NAME_DELIMITER);
+    return index != std::string::npos && IsQualifierNameValid(name.substr(0, index));
+}
 
-    if (!IsQualifierNameValid(parts.front())) return false;
+/**
+ * Work out which kind of asset a name claims to be from its tag characters, in a single scan.
+ * This only looks at the layout of the delimiters ('#', '~', '!', '^', '/', '$'); whether the parts
+ * between them are valid is left to IsTypeCheckNameValid. Names that don't carry any indicator are
+ * reported as ROOT, callers tell root and sub assets apart themselves.
+ */
+AssetType ClassifyAssetName(const std::string& name)
+{
+    static const size_t npos = std::string::npos;
+    size_t nLength = name.size();
+    size_t nUnique = 0, nChannel = 0, nOwner = 0, nSub = 0;
+    size_t posUnique = npos, posChannel = npos, posOwner = npos, posFirstVote = npos, posFirstSub = npos, posLastSub = npos;
+    bool fNameCharsAfterFirst = true;
 
-    return parts.size() > 1;
-}
+    for (size_t i = 0; i < nLength; i++) {
+        switch (name[i]) {
+            case '#': nUnique++; posUnique = i; break;
+            case '~': nChannel++; posChannel = i; break;
+            case '!': nOwner++; posOwner = i; break;
+            case '^': if (posFirstVote == npos) posFirstVote = i; break;
+            case '/': nSub++; if (posFirstSub == npos) posFirstSub = i; posLastSub = i; break;
+        }
+        if (i > 0 && !assetNameChars.Is(name[i], NAME_CHAR))
+            fNameCharsAfterFirst = false;
+    }
+
+    // <name>#<tag>, <name>~<tag> and <name>^<tag>: the name can't hold a '^' and the tag can't hold a '/'
+    auto fTagged = [&](size_t pos) -> bool {
+        return pos > 0 && pos + 1 < nLength
+               && (posFirstVote == npos || posFirstVote >= pos)
+               && (posLastSub == npos || posLastSub < pos);
+    };
+
+    if (nUnique == 1 && nChannel == 0 && nOwner == 0 && fTagged(posUnique))
+        return AssetType::UNIQUE;
+    if (nChannel == 1 && nUnique == 0 && nOwner == 0 && fTagged(posChannel))
+        return AssetType::MSGCHANNEL;
+    if (nOwner == 1 && posOwner + 1 == nLength && nLength > 1 && nUnique == 0 && nChannel == 0 && posFirstVote == npos)
+        return AssetType::OWNER;
+    if (posFirstVote != npos && nUnique == 0 && nChannel == 0 && nOwner == 0 && fTagged(posFirstVote))
+        return AssetType::VOTE;
+
+    if (nLength == 0)
+        return AssetType::ROOT;
 
+    // #<qualifier> and $<restricted>: everything after the first character is a name character
+    if ((name[0] == '#' || name[0] == '$') && fNameCharsAfterFirst && nLength > 3)
+        return name[0] == '#' ? AssetType::QUALIFIER : AssetType::RESTRICTED;
+
+    // #<qualifier>/#<sub qualifier>
+    if (name[0] == '#' && nUnique == 2 && nSub == 1 && posFirstSub > 1 && posUnique == posFirstSub + 1 && posUnique + 1 < nLength) {
+        for (size_t i = 1; i < nLength; i++) {
+            if (i != posFirstSub && i != posUnique && !assetNameChars.Is(name[i], NAME_CHAR))
+                return AssetType::ROOT;
+        }
+        return AssetType::SUB_QUALIFIER;
+    }
+
+    return AssetType::ROOT;
+}
 
 bool IsAssetNameValid(const std::string& name, AssetType& assetType, std::string& error)
 {
@@ -211,77 +301,16 @@ bool IsAssetNameValid(const std::string& name, AssetType& assetType, std::string
         return false;
 
     assetType = AssetType::INVALID;
-    if (std::regex_match(name, UNIQUE_INDICATOR))
-    {
-        bool ret = IsTypeCheckNameValid(AssetType::UNIQUE, name, error);
-        if (ret)
-            assetType = AssetType::UNIQUE;
-
-        return ret;
-    }
-    else if (std::regex_match(name, MSGCHANNEL_INDICATOR))
-    {
-        bool ret = IsTypeCheckNameValid(AssetType::MSGCHANNEL, name, error);
-        if (ret)
-            assetType = AssetType::MSGCHANNEL;
-
-        return ret;
-    }
-    else if (std::regex_match(name, OWNER_INDICATOR))
-    {
-        bool ret = IsTypeCheckNameValid(AssetType::OWNER, name, error);
-        if (ret)
-            assetType = AssetType::OWNER;
-
-        return ret;
-    }
-    else if (std::regex_match(name, VOTE_INDICATOR))
-    {
-        bool ret = IsTypeCheckNameValid(AssetType::VOTE, name, error);
-        if (ret)
-            assetType = AssetType::VOTE;
-
-        return ret;
-    }
-    else if (std::regex_match(name, QUALIFIER_INDICATOR))
-    {
-        bool ret = IsTypeCheckNameValid(AssetType::QUALIFIER, name, error);
-        if (ret) {
-            if (IsAssetNameASubQualifier(name))
-                assetType = AssetType::SUB_QUALIFIER;
-            else
-                assetType = AssetType::QUALIFIER;
-        }
-
-        return ret;
-    }
-    else if (std::regex_match(name, SUB_QUALIFIER_INDICATOR))
-    {
-        bool ret = IsTypeCheckNameValid(AssetType::SUB_QUALIFIER, name, error);
-        if (ret) {
-            if (IsAssetNameASubQualifier(name))
-                assetType = AssetType::SUB_QUALIFIER;
-        }
 
-        return ret;
-    }
-    else if (std::regex_match(name, RESTRICTED_INDICATOR))
-    {
-        bool ret = IsTypeCheckNameValid(AssetType::RESTRICTED, name, error);
-        if (ret)
-            assetType = AssetType::RESTRICTED;
+    AssetType type = ClassifyAssetName(name);
+    if (type == AssetType::ROOT && IsAssetNameASubasset(name))
+        type = AssetType::SUB;
 
-        return ret;
-    }
-    else
-    {
-        auto type = IsAssetNameASubasset(name) ? AssetType::SUB : AssetType::ROOT;
-        bool ret = IsTypeCheckNameValid(type, name, error);
-        if (ret)
-            assetType = type;
+    bool ret = IsTypeCheckNameValid(type, name, error);
+    if (ret)
+        assetType = type;
 
-        return ret;
-    }
+    return ret;
 }
 
 bool IsAssetNameValid(const std::string& name)
@@ -305,26 +334,41 @@ bool IsAssetNameARoot(const std::string& name)
 
 bool IsAssetNameAnOwner(const std::string& name)
 {
-    return IsAssetNameValid(name) && std::regex_match(name, OWNER_INDICATOR);
+    AssetType type;
+    return IsAssetNameValid(name, type) && type == AssetType::OWNER;
 }
 
 bool IsAssetNameAnRestricted(const std::string& name)
 {
-    return IsAssetNameValid(name) && std::regex_match(name, RESTRICTED_INDICATOR);
+    AssetType type;
+    return IsAssetNameValid(name, type) && type == AssetType::RESTRICTED;
 }
 
 bool IsAssetNameAQualifier(const std::string& name, bool fOnlyQualifiers)
 {
+    AssetType type;
+    if (!IsAssetNameValid(name, type))
+        return false;
+
     if (fOnlyQualifiers) {
-        return IsAssetNameValid(name) && std::regex_match(name, QUALIFIER_INDICATOR);
+        return type == AssetType::QUALIFIER;
     }
 
-    return IsAssetNameValid(name) && (std::regex_match(name, QUALIFIER_INDICATOR) || std::regex_match(name, SUB_QUALIFIER_INDICATOR));
+    return type == AssetType::QUALIFIER || type == AssetType::SUB_QUALIFIER;
 }
 
 bool IsAssetNameAnMsgChannel(const std::string& name)
 {
-    return IsAssetNameValid(name) && std::regex_match(name, MSGCHANNEL_INDICATOR);
+    AssetType type;
+    return IsAssetNameValid(name, type) && type == AssetType::MSGCHANNEL;
+}
+
+/** Split a tagged name into the part before the first delimiter and the tag after the last one. */
+static void SplitAssetTag(const std::string& name, const std::string& delimiter, std::string& strName, std::string& strTag)
+{
+    strName = name.substr(0, name.find(delimiter));
+    auto index = name.rfind(delimiter);
+    strTag = index == std::string::npos ? name : name.substr(index + delimiter.size());
 }
 
 // TODO get the string translated below
@@ -332,17 +376,17 @@ bool IsTypeCheckNameValid(const AssetType type, const std::string& name, std::st
 {
     if (type == AssetType::UNIQUE) {
         if (name.size() > MAX_NAME_LENGTH) { error = "Name is greater than max length of " + std::to_string(MAX_NAME_LENGTH); return false; }
-        std::vector<std::string> parts;
-        boost::split(parts, name, boost::is_any_of(UNIQUE_TAG_DELIMITER));
-        bool valid = IsNameValidBeforeTag(parts.front()) && IsUniqueTagValid(parts.back());
+        std::string strName, strTag;
+        SplitAssetTag(name, UNIQUE_TAG_DELIMITER, strName, strTag);
+        bool valid = IsNameValidBeforeTag(strName) && IsUniqueTagValid(strTag);
         if (!valid) { error = "Unique name contains invalid characters (Valid characters are: A-Z a-z 0-9 @ $ % & * ( ) [ ] { } _ . ? : -)";  return false; }
         return true;
     } else if (type == AssetType::MSGCHANNEL) {
         if (name.size() > MAX_NAME_LENGTH) { error = "Name is greater than max length of " + std::to_string(MAX_NAME_LENGTH); return false; }
-        std::vector<std::string> parts;
-        boost::split(parts, name, boost::is_any_of(MSGCHANNEL_TAG_DELIMITER));
-        bool valid = IsNameValidBeforeTag(parts.front()) && IsMsgChannelTagValid(parts.back());
-        if (parts.back().size() > MAX_CHANNEL_NAME_LENGTH) { error = "Channel name is greater than max length of " + std::to_string(MAX_CHANNEL_NAME_LENGTH); return false; }
+        std::string strName, strTag;
+        SplitAssetTag(name, MSGCHANNEL_TAG_DELIMITER, strName, strTag);
+        bool valid = IsNameValidBeforeTag(strName) && IsMsgChannelTagValid(strTag);
+        if (strTag.size() > MAX_CHANNEL_NAME_LENGTH) { error = "Channel name is greater than max length of " + std::to_string(MAX_CHANNEL_NAME_LENGTH); return false; }
         if (!valid) { error = "Message Channel name contains invalid characters (Valid characters are: A-Z 0-9 _ .) (special characters can't be the first or last characters)";  return false; }
         return true;
     } else if (type == AssetType::OWNER) {
@@ -352,9 +396,9 @@ bool IsTypeCheckNameValid(const AssetType type, const std::string& name, std::st
         return true;
     } else if (type == AssetType::VOTE) {
         if (name.size() > MAX_NAME_LENGTH) { error = "Name is greater than max length of " + std::to_string(MAX_NAME_LENGTH); return false; }
-        std::vector<std::string> parts;
-        boost::split(parts, name, boost::is_any_of(VOTE_TAG_DELIMITER));
-        bool valid = IsNameValidBeforeTag(parts.front()) && IsVoteTagValid(parts.back());
+        std::string strName, strTag;
+        SplitAssetTag(name, VOTE_TAG_DELIMITER, strName, strTag);
+        bool valid = IsNameValidBeforeTag(strName) && IsVoteTagValid(strTag);
         if (!valid) { error = "Vote name contains invalid characters (Valid characters are: A-Z 0-9 _ .) (special characters can't be the first or last characters)";  return false; }
         return true;
     } else if (type == AssetType::QUALIFIER || type == AssetType::SUB_QUALIFIER) {
@@ -2580,7 +2624,7 @@ bool CAssetsCache::DumpCacheToDatabase()
         // Add the new qualifier commands to the database
         for (auto newQualifierAddress : setNewQualifierAddressToAdd) {
             if (newQualifierAddress.type == QualifierType::REMOVE_QUALIFIER) {
-                passetsQualifierCache->Erase(newQualifierAddress.GetHash().GetHex());
+                UpdateAddressQualifiersCache(newQualifierAddress.address, newQualifierAddress.assetName, false);
                 if (!prestricteddb->EraseAddressQualifier(newQualifierAddress.address, newQualifierAddress.assetName)) {
                     dirty = true;
                     message = "_Failed Erasing address qualifier from database";
@@ -2593,7 +2637,7 @@ bool CAssetsCache::DumpCacheToDatabase()
                     }
                 }
             } else if (newQualifierAddress.type == QualifierType::ADD_QUALIFIER) {
-                passetsQualifierCache->Put(newQualifierAddress.GetHash().GetHex(), 1);
+                UpdateAddressQualifiersCache(newQualifierAddress.address, newQualifierAddress.assetName, true);
                 if (!prestricteddb->WriteAddressQualifier(newQualifierAddress.address, newQualifierAddress.assetName))
                 {
                     dirty = true;
@@ -2616,7 +2660,7 @@ bool CAssetsCache::DumpCacheToDatabase()
         // Undo the qualifier commands
         for (auto undoQualifierAddress : setNewQualifierAddressToRemove) {
             if (undoQualifierAddress.type == QualifierType::REMOVE_QUALIFIER) { // If we are undoing a removal, we write the data to database
-                passetsQualifierCache->Put(undoQualifierAddress.GetHash().GetHex(), 1);
+                UpdateAddressQualifiersCache(undoQualifierAddress.address, undoQualifierAddress.assetName, true);
                 if (!prestricteddb->WriteAddressQualifier(undoQualifierAddress.address, undoQualifierAddress.assetName)) {
                     dirty = true;
                     message = "_Failed undoing a removal of a address qualifier  from database";
@@ -2629,7 +2673,7 @@ bool CAssetsCache::DumpCacheToDatabase()
                     }
                 }
             } else if (undoQualifierAddress.type == QualifierType::ADD_QUALIFIER) { // If we are undoing an addition, we remove the data from the database
-                passetsQualifierCache->Erase(undoQualifierAddress.GetHash().GetHex());
+                UpdateAddressQualifiersCache(undoQualifierAddress.address, undoQualifierAddress.assetName, false);
                 if (!prestricteddb->EraseAddressQualifier(undoQualifierAddress.address, undoQualifierAddress.assetName))
                 {
                     dirty = true;
@@ -3456,9 +3500,8 @@ bool CAssetsCache::GetAssetMetaDataIfExists(const std::string &name, CNewAsset &
 
     // Check the cache, if it doesn't exist in the cache. Try and read it from database
     if (passetsCache) {
-        if (passetsCache->Exists(name)) {
-            CDatabasedAssetData data;
-            data = passetsCache->Get(name);
+        CDatabasedAssetData data;
+        if (passetsCache->Find(name, data)) {
             asset = data.asset;
             nHeight = data.nHeight;
             blockHash = data.blockHash;
@@ -3574,6 +3617,121 @@ bool GetAssetData(const CScript& script, CAssetOutputEntry& data)
     return false;
 }
 
+const CTxAssetOutput* CTxAssetOutputs::Find(unsigned int n) const
+{
+    auto it = std::lower_bound(vOutputs.begin(), vOutputs.end(), n,
+                               [](const CTxAssetOutput& output, unsigned int index) { return output.n < index; });
+    if (it == vOutputs.end() || it->n != n)
+        return nullptr;
+    return &*it;
+}
+
+static std::shared_ptr<const CTxAssetOutputs> ParseTxAssetOutputs(const CTransaction& tx, bool fTransferScriptsSizeDeployed)
+{
+    std::shared_ptr<CTxAssetOutputs> outputs;
+    for (unsigned int n = 0; n < tx.vout.size(); n++) {
+        const CScript& script = tx.vout[n].scriptPubKey;
+        int nType = 0;
+        bool fIsOwner = false;
+        int nScriptOffset = 0;
+        if (!script.IsAssetScript(nType, fIsOwner, nScriptOffset))
+            continue;
+
+        if (!outputs) {
+            outputs = std::make_shared<CTxAssetOutputs>();
+            outputs->fTransferScriptsSizeDeployed = fTransferScriptsSizeDeployed;
+        }
+
+        CTxAssetOutput output;
+        output.n = n;
+        output.type = txnouttype(nType);
+        output.fIsOwner = fIsOwner;
+        output.nScriptOffset = nScriptOffset;
+        output.nAmount = 0;
+        output.nExpireTime = 0;
+
+        // Only transfers carry a message and an expiration, the other outputs leave them unset
+        CAssetOutputEntry data{};
+        output.fValid = GetAssetData(script, data);
+        if (output.fValid) {
+            output.type = data.type;
+            output.assetName = data.assetName;
+            output.nAmount = data.nAmount;
+            output.destination = data.destination;
+            output.strAddress = EncodeDestination(data.destination);
+            output.message = data.message;
+            output.nExpireTime = data.expireTime;
+            output.hashBytes = uint160(std::vector<unsigned char>(script.begin() + 3, script.begin() + 23));
+        }
+        outputs->vOutputs.push_back(std::move(output));
+    }
+
+    if (!outputs) {
+        // Most transactions carry no assets, they all share one empty entry
+        static const std::shared_ptr<const CTxAssetOutputs> empty[2] = {
+            std::make_shared<const CTxAssetOutputs>(CTxAssetOutputs{false, {}}),
+            std::make_shared<const CTxAssetOutputs>(CTxAssetOutputs{true, {}})
+        };
+        return empty[fTransferScriptsSizeDeployed];
+    }
+    return outputs;
+}
+
+std::shared_ptr<const CTxAssetOutputs> GetTxAssetOutputs(const CTransaction& tx)
+{
+    bool fTransferScriptsSizeDeployed = AreTransferScriptsSizeDeployed();
+    std::shared_ptr<const CTxAssetOutputs> outputs = tx.assetOutputs.Get();
+    if (!outputs || outputs->fTransferScriptsSizeDeployed != fTransferScriptsSizeDeployed) {
+        outputs = ParseTxAssetOutputs(tx, fTransferScriptsSizeDeployed);
+        tx.assetOutputs.Set(outputs);
+    }
+    return outputs;
+}
+
+bool GetAssetData(const CTransaction& tx, unsigned int n, CAssetOutputEntry& data)
+{
+    std::shared_ptr<const CTxAssetOutputs> outputs = GetTxAssetOutputs(tx);
+    const CTxAssetOutput* output = outputs->Find(n);
+    if (!output || !output->fValid)
+        return false;
+
+    data.type = output->type;
+    data.assetName = output->assetName;
+    data.nAmount = output->nAmount;
+    data.destination = output->destination;
+    data.message = output->message;
+    data.expireTime = output->nExpireTime;
+    return true;
+}
+
+bool TransferAssetFromTransaction(const CTransaction& tx, unsigned int n, CAssetTransfer& assetTransfer, std::string& strAddress)
+{
+    std::shared_ptr<const CTxAssetOutputs> outputs = GetTxAssetOutputs(tx);
+    const CTxAssetOutput* output = outputs->Find(n);
+    if (!output || !output->fValid || output->type != TX_TRANSFER_ASSET)
+        return false;
+
+    assetTransfer.strName = output->assetName;
+    assetTransfer.nAmount = output->nAmount;
+    assetTransfer.message = output->message;
+    assetTransfer.nExpireTime = output->nExpireTime;
+    strAddress = output->strAddress;
+    return true;
+}
+
+bool ParseAssetScript(const CTransaction& tx, unsigned int n, uint160& hashBytes, std::string& assetName, CAmount& assetAmount)
+{
+    std::shared_ptr<const CTxAssetOutputs> outputs = GetTxAssetOutputs(tx);
+    const CTxAssetOutput* output = outputs->Find(n);
+    if (!output || !output->fValid)
+        return false;
+
+    hashBytes = output->hashBytes;
+    assetName = output->assetName;
+    assetAmount = output->nAmount;
+    return true;
+}
+
 #ifdef ENABLE_WALLET
 void GetAllAdministrativeAssets(CWallet *pwallet, std::vector<std::string> &names, int nMinConf)
 {
@@ -3764,9 +3922,9 @@ bool GetAllMyAssetBalances(std::map<std::string, std::vector<COutput> >& outputs
     for (const auto& pair : outputs) {
         if (prefix.empty() || pair.first.find(prefix) == 0) { // Check for prefix
             CAmount balance = 0;
-            for (auto txout : pair.second) { // Compute balance of asset by summing all Available Outputs
+            for (const auto& txout : pair.second) { // Compute balance of asset by summing all Available Outputs
                 CAssetOutputEntry data;
-                if (GetAssetData(txout.tx->tx->vout[txout.i].scriptPubKey, data))
+                if (GetAssetData(*txout.tx->tx, txout.i, data))
                     balance += data.nAmount;
             }
             amounts.insert(std::make_pair(pair.first, balance));
@@ -3791,7 +3949,7 @@ bool GetMyAssetBalance(const std::string& name, CAmount& balance, const int& con
         auto& ref = outputs.at(name);
         for (const auto& txout : ref) {
             CAssetOutputEntry data;
-            if (GetAssetData(txout.tx->tx->vout[txout.i].scriptPubKey, data)) {
+            if (GetAssetData(*txout.tx->tx, txout.i, data)) {
                 balance += data.nAmount;
             }
         }
@@ -4618,8 +4776,7 @@ bool CAssetsCache::GetAssetVerifierStringIfExists(const std::string &name, CNull
 
     // Check the cache, if it doesn't exist in the cache. Try and read it from database
     if (passetsVerifierCache) {
-        if (passetsVerifierCache->Exists(name)) {
-            verifierString = passetsVerifierCache->Get(name);
+        if (passetsVerifierCache->Find(name, verifierString)) {
             return true;
         }
     }
@@ -4691,28 +4848,49 @@ bool CAssetsCache::CheckForAddressQualifier(const std::string &qualifier_name, c
         }
     }
 
-    // Check the cache, if it doesn't exist in the cache. Try and read it from database
-    if (passetsQualifierCache) {
-        if (passetsQualifierCache->Exists(cachedQualifierAddress.GetHash().GetHex())) {
-            return true;
-        }
-    }
+    // Check the qualifiers the database holds for the address, reading all of them at once if they aren't cached
+    std::set<std::string> setQualifiers;
+    if (!GetDatabasedAddressQualifiers(address, setQualifiers))
+        return false;
 
-    if (prestricteddb) {
+    // Check for the exact qualifier, then for any of its sub qualifiers
+    auto qualifierIterator = setQualifiers.lower_bound(qualifier_name);
+    if (qualifierIterator != setQualifiers.end() && *qualifierIterator == qualifier_name)
+        return true;
 
-        // Check for exact qualifier, and add to cache if it exists
-        if (prestricteddb->ReadAddressQualifier(address, qualifier_name)) {
-            passetsQualifierCache->Put(cachedQualifierAddress.GetHash().GetHex(), 1);
-            return true;
-        }
+    qualifierIterator = setQualifiers.lower_bound(qualifier_name + "/");
+    return qualifierIterator != setQualifiers.end() && qualifierIterator->compare(0, qualifier_name.size() + 1, qualifier_name + "/") == 0;
+}
 
-        // Look for sub qualifiers
-        if (prestricteddb->CheckForAddressRootQualifier(address, qualifier_name)){
-            return true;
-        }
+bool GetDatabasedAddressQualifiers(const std::string& address, std::set<std::string>& setQualifiers)
+{
+    if (passetsAddressQualifiersCache && passetsAddressQualifiersCache->Find(address, setQualifiers)) {
+        return true;
     }
 
-    return false;
+    if (!prestricteddb)
+        return false;
+
+    if (!prestricteddb->ReadAddressQualifiers(address, setQualifiers))
+        return false;
+
+    if (passetsAddressQualifiersCache)
+        passetsAddressQualifiersCache->Put(address, setQualifiers);
+    return true;
+}
+
+void UpdateAddressQualifiersCache(const std::string& address, const std::string& qualifier, bool fAdd)
+{
+    // Addresses that aren't cached will be read from the database once it has been updated
+    if (!passetsAddressQualifiersCache)
+        return;
+
+    passetsAddressQualifiersCache->Update(address, [&qualifier, fAdd](std::set<std::string>& setQualifiers) {
+        if (fAdd)
+            setQualifiers.insert(qualifier);
+        else
+            setQualifiers.erase(qualifier);
+    });
 }
 
 
@@ -4757,7 +4935,8 @@ bool CAssetsCache::CheckForAddressRestriction(const std::string &restricted_name
 
     // Check the cache, if it doesn't exist in the cache. Try and read it from database
     if (passetsRestrictionCache) {
-        if (passetsRestrictionCache->Exists(cachedRestrictedAddress.GetHash().GetHex())) {
+        int8_t fRestricted;
+        if (passetsRestrictionCache->Find(cachedRestrictedAddress.GetHash().GetHex(), fRestricted)) {
             return true;
         }
     }
@@ -4816,7 +4995,8 @@ bool CAssetsCache::CheckForGlobalRestriction(const std::string &restricted_name,
 
     // Check the cache, if it doesn't exist in the cache. Try and read it from database
     if (passetsGlobalRestrictionCache) {
-        if (passetsGlobalRestrictionCache->Exists(cachedRestrictedGlobal.assetName)) {
+        int8_t fRestricted;
+        if (passetsGlobalRestrictionCache->Find(cachedRestrictedGlobal.assetName, fRestricted)) {
             return true;
         }
     }
@@ -4857,7 +5037,7 @@ std::string GetStrippedVerifierString(const std::string& verifier)
     return str_without_qualifier_tags;
 }
 
-bool CheckVerifierString(const std::string& verifier, std::set<std::string>& setFoundQualifiers, std::string& strError, ErrorReport* errorReport)
+static bool ParseVerifierString(const std::string& verifier, std::set<std::string>& setFoundQualifiers, std::string& strError, ErrorReport* errorReport)
 {
     // If verifier string is true, always return true
     if (verifier == "true") {
@@ -4933,6 +5113,63 @@ bool CheckVerifierString(const std::string& verifier, std::set<std::string>& set
     }
 }
 
+/** The result of checking a verifier string, and the string compiled for evaluation when it is valid */
+struct CCompiledVerifierString
+{
+    bool fValid;
+    std::string strError;
+    std::vector<std::string> vQualifiers; //! The qualifiers found, without their '#'. Qualifier i is variable i of the formula
+    LibBoolEE::Formula formula;
+};
+
+//! Heap memory held by a compiled verifier string, see passetsCompiledVerifierCache
+static inline size_t CacheDynamicUsage(const std::shared_ptr<const CCompiledVerifierString>& compiled)
+{
+    size_t usage = memusage::DynamicUsage(compiled) + CacheDynamicUsage(compiled->strError) +
+                   memusage::DynamicUsage(compiled->vQualifiers) + compiled->formula.DynamicMemoryUsage();
+    for (const std::string& qualifier : compiled->vQualifiers)
+        usage += CacheDynamicUsage(qualifier);
+    return usage;
+}
+
+/**
+ * Verifier strings are checked and compiled once, and kept in passetsCompiledVerifierCache keyed by the string
+ * itself so that no entry ever goes stale. A restricted asset's verifier is evaluated for every transfer of it,
+ * always against the same few strings. Without the cache, as in the unit tests, each string is compiled on use.
+ */
+static std::shared_ptr<const CCompiledVerifierString> GetCompiledVerifierString(const std::string& verifier)
+{
+    std::shared_ptr<const CCompiledVerifierString> cached;
+    if (passetsCompiledVerifierCache && passetsCompiledVerifierCache->Find(verifier, cached))
+        return cached;
+
+    std::shared_ptr<CCompiledVerifierString> compiled = std::make_shared<CCompiledVerifierString>();
+    std::set<std::string> setFoundQualifiers;
+    compiled->fValid = ParseVerifierString(verifier, setFoundQualifiers, compiled->strError, nullptr);
+    compiled->vQualifiers.assign(setFoundQualifiers.begin(), setFoundQualifiers.end());
+    if (compiled->fValid && verifier != "true") {
+        // Can't throw, ParseVerifierString resolved the string with these same qualifiers
+        compiled->formula = LibBoolEE::compile(verifier, compiled->vQualifiers);
+    }
+
+    if (passetsCompiledVerifierCache)
+        passetsCompiledVerifierCache->Put(verifier, compiled);
+    return compiled;
+}
+
+bool CheckVerifierString(const std::string& verifier, std::set<std::string>& setFoundQualifiers, std::string& strError, ErrorReport* errorReport)
+{
+    // Error reports are only filled in by parsing the string again
+    if (errorReport)
+        return ParseVerifierString(verifier, setFoundQualifiers, strError, errorReport);
+
+    std::shared_ptr<const CCompiledVerifierString> compiled = GetCompiledVerifierString(verifier);
+    setFoundQualifiers.insert(compiled->vQualifiers.begin(), compiled->vQualifiers.end());
+    if (!compiled->fValid)
+        strError = compiled->strError;
+    return compiled->fValid;
+}
+
 bool VerifyNullAssetDataFlag(const int& flag, std::string& strError)
 {
     // Check the flag
@@ -5154,53 +5391,39 @@ bool ContextualCheckVerifierString(CAssetsCache* cache, const std::string& verif
     if (check_address.empty())
         return true;
 
-    // Create an object that stores if an address contains a qualifier
-    LibBoolEE::Vals vals;
-
-    // Add the qualifiers into the vals object
-    for (auto qualifier : setFoundQualifiers) {
-        std::string search = QUALIFIER_CHAR + qualifier;
-
-        // Check to see if the address contains the qualifier
-        bool has_qualifier = cache->CheckForAddressQualifier(search, check_address, true);
-
-        // Add the true or false value into the vals
-        vals.insert(std::make_pair(qualifier, has_qualifier));
-    }
-
-    try {
-        bool ret = LibBoolEE::resolve(verifier, vals, errorReport);
-        if (!ret) {
-            if (errorReport) {
-                if (errorReport->type == ErrorReport::ErrorType::NotSetError) {
-                    errorReport->type = ErrorReport::ErrorType::FailedToVerifyAgainstAddress;
-                    errorReport->vecUserData.emplace_back(check_address);
-                    errorReport->strDevData = "bad-txns-null-verifier-address-failed-verification";
-                }
-            }
-
-            error("%s : The address %s failed to verify against: %s. Is null %d", __func__, check_address, verifier, errorReport ? 0 : 1);
-            strError = "bad-txns-null-verifier-address-failed-verification";
-        }
-        return ret;
+    // The string passed CheckVerifierString, so it has been compiled, and its formula can't fail to evaluate
+    std::shared_ptr<const CCompiledVerifierString> compiled = GetCompiledVerifierString(verifier);
 
-    } catch (const std::runtime_error& run_error) {
+    // Check to see if the address contains each qualifier, in the order of the formula's variables
+    std::vector<bool> vHasQualifier(compiled->vQualifiers.size());
+    for (size_t i = 0; i < compiled->vQualifiers.size(); i++)
+        vHasQualifier[i] = cache->CheckForAddressQualifier(QUALIFIER_CHAR + compiled->vQualifiers[i], check_address, true);
 
+    bool ret = compiled->formula.evaluate(vHasQualifier);
+    if (!ret) {
         if (errorReport) {
             if (errorReport->type == ErrorReport::ErrorType::NotSetError) {
-                errorReport->type = ErrorReport::ErrorType::InvalidSyntax;
+                errorReport->type = ErrorReport::ErrorType::FailedToVerifyAgainstAddress;
+                errorReport->vecUserData.emplace_back(check_address);
+                errorReport->strDevData = "bad-txns-null-verifier-address-failed-verification";
             }
-
-            errorReport->vecUserData.emplace_back(run_error.what());
-            errorReport->strDevData = "bad-txns-null-verifier-failed-contexual-syntax-check";
         }
 
-        strError = "bad-txns-null-verifier-failed-contexual-syntax-check";
-        return error("%s : Verifier string failed to resolve. Please check string syntax - exception: %s\n", __func__, run_error.what());
+        error("%s : The address %s failed to verify against: %s. Is null %d", __func__, check_address, verifier, errorReport ? 0 : 1);
+        strError = "bad-txns-null-verifier-address-failed-verification";
     }
+    return ret;
 }
 
 bool ContextualCheckTransferAsset(CAssetsCache* assetCache, const CAssetTransfer& transfer, const std::string& address, std::string& strError)
+{
+    if (!CheckTransferAsset(transfer, AreMessagesDeployed(), AreRestrictedAssetsDeployed(), strError))
+        return false;
+
+    return ContextualCheckTransferAssetRestrictions(assetCache, transfer, address, strError);
+}
+
+bool CheckTransferAsset(const CAssetTransfer& transfer, const bool fMessagesDeployed, const bool fRestrictedDeployed, std::string& strError)
 {
     strError = "";
     AssetType assetType;
@@ -5214,7 +5437,7 @@ bool ContextualCheckTransferAsset(CAssetsCache* assetCache, const CAssetTransfer
         return false;
     }
 
-    if (AreMessagesDeployed()) {
+    if (fMessagesDeployed) {
         // This is for the current testnet6 only.
         if (transfer.nAmount <= 0) {
             strError = "Invalid parameter: asset amount can't be equal to or less than zero.";
@@ -5238,18 +5461,34 @@ bool ContextualCheckTransferAsset(CAssetsCache* assetCache, const CAssetTransfer
 
     // If the transfer is a message channel asset. Check to make sure that it is UNIQUE_ASSET_AMOUNT
     if (assetType == AssetType::MSGCHANNEL) {
-        if (!AreMessagesDeployed()) {
+        if (!fMessagesDeployed) {
             strError = "bad-txns-transfer-msgchannel-before-messaging-is-active";
             return false;
         }
     }
 
     if (assetType == AssetType::RESTRICTED) {
-        if (!AreRestrictedAssetsDeployed()) {
+        if (!fRestrictedDeployed) {
             strError = "bad-txns-transfer-restricted-before-it-is-active";
             return false;
         }
+    }
 
+    // If the transfer is a qualifier channel asset.
+    if (assetType == AssetType::QUALIFIER || assetType == AssetType::SUB_QUALIFIER) {
+        if (!fRestrictedDeployed) {
+            strError = "bad-txns-transfer-qualifier-before-it-is-active";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ContextualCheckTransferAssetRestrictions(CAssetsCache* assetCache, const CAssetTransfer& transfer, const std::string& address, std::string& strError)
+{
+    // Only the tag is looked at to tell a restricted asset. The name may not have been validated yet: when the
+    // checks are queued, this runs before the queued CAssetCheck, which rejects an invalid name on its own.
+    if (ClassifyAssetName(transfer.strName) == AssetType::RESTRICTED) {
         if (assetCache) {
             if (assetCache->CheckForGlobalRestriction(transfer.strName, true)) {
                 strError = "bad-txns-transfer-restricted-asset-that-is-globally-restricted";
@@ -5264,14 +5503,6 @@ bool ContextualCheckTransferAsset(CAssetsCache* assetCache, const CAssetTransfer
             return false;
         }
     }
-
-    // If the transfer is a qualifier channel asset.
-    if (assetType == AssetType::QUALIFIER || assetType == AssetType::SUB_QUALIFIER) {
-        if (!AreRestrictedAssetsDeployed()) {
-            strError = "bad-txns-transfer-qualifier-before-it-is-active";
-            return false;
-        }
-    }
     return true;
 }
 
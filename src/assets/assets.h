@@ -9,12 +9,15 @@
 #include "amount.h"
 #include "tinyformat.h"
 #include "assettypes.h"
+#include "pubkey.h"
 
 #include <string>
 #include <set>
 #include <map>
 #include <unordered_map>
 #include <list>
+#include <memory>
+#include <vector>
 
 #define RVN_R 114
 #define RVN_V 118
@@ -56,9 +59,9 @@ class CTransaction;
 class CTxOut;
 class Coin;
 class CWallet;
+struct CCompiledVerifierString;
 class CReserveKey;
 class CWalletTx;
-struct CAssetOutputEntry;
 class CCoinControl;
 struct CBlockAssetUndo;
 class COutput;
@@ -66,6 +69,9 @@ class COutput;
 // 2500 * 82 Bytes == 205 KB (kilobytes) of memory
 #define MAX_CACHE_ASSETS_SIZE 2500
 
+// Memory, in megabytes, shared by the in-memory asset and message caches (-assetcachesize)
+#define DEFAULT_ASSET_CACHE_SIZE 16
+
 // Create map that store that state of current reissued transaction that the mempool as accepted.
 // If an asset name is in this map, any other reissue transactions wont be accepted into the mempool
 extern std::map<uint256, std::string> mapReissuedTx;
@@ -123,6 +129,15 @@ struct ErrorReport {
 
 std::string GetUserErrorString(const ErrorReport& report);
 
+/**
+ * Asset state is layered in the same way as CCoinsViewCache over CCoinsView:
+ *   database <- passets (the global tip cache) <- child caches
+ * A default constructed CAssetsCache is a child view over passets. It only records
+ * its own changes in the dirty sets below, and every lookup falls through to the
+ * passets dirty sets, then to the LRU caches and databases.
+ * Forking a view is therefore O(1), Flush() commits the child's changes into passets
+ * in O(changes), and dropping the child discards them.
+ */
 class CAssetsCache : public CAssets
 {
 private:
@@ -176,96 +191,9 @@ public :
         ClearDirtyCache();
     }
 
-    CAssetsCache(const CAssetsCache& cache) : CAssets(cache)
-    {
-        //! Copy dirty cache also
-        this->vSpentAssets = cache.vSpentAssets;
-        this->vUndoAssetAmount = cache.vUndoAssetAmount;
-
-        //! Transfer Caches
-        this->setNewTransferAssetsToAdd = cache.setNewTransferAssetsToAdd;
-        this->setNewTransferAssetsToRemove = cache.setNewTransferAssetsToRemove;
-
-        //! Issue Caches
-        this->setNewAssetsToRemove = cache.setNewAssetsToRemove;
-        this->setNewAssetsToAdd = cache.setNewAssetsToAdd;
-
-        //! Reissue Caches
-        this->setNewReissueToRemove = cache.setNewReissueToRemove;
-        this->setNewReissueToAdd = cache.setNewReissueToAdd;
-
-        //! Owner Caches
-        this->setNewOwnerAssetsToAdd = cache.setNewOwnerAssetsToAdd;
-        this->setNewOwnerAssetsToRemove = cache.setNewOwnerAssetsToRemove;
-
-        //! Qualifier Caches
-        this->setNewQualifierAddressToAdd = cache.setNewQualifierAddressToAdd;
-        this->setNewQualifierAddressToRemove = cache.setNewQualifierAddressToRemove;
-
-        //! Restricted Address Caches
-        this->setNewRestrictedAddressToAdd = cache.setNewRestrictedAddressToAdd;
-        this->setNewRestrictedAddressToRemove = cache.setNewRestrictedAddressToRemove;
-
-        //! Restricted Global Caches
-        this->setNewRestrictedGlobalToAdd = cache.setNewRestrictedGlobalToAdd;
-        this->setNewRestrictedGlobalToRemove = cache.setNewRestrictedGlobalToRemove;
-
-        //! Restricted Verifier Caches
-        this->setNewRestrictedVerifierToAdd = cache.setNewRestrictedVerifierToAdd;
-        this->setNewRestrictedVerifierToRemove = cache.setNewRestrictedVerifierToRemove;
-
-        //! Root Qualifier Address Map
-        this->mapRootQualifierAddressesAdd = cache.mapRootQualifierAddressesAdd;
-        this->mapRootQualifierAddressesRemove = cache.mapRootQualifierAddressesRemove;
-    }
-
-    CAssetsCache& operator=(const CAssetsCache& cache)
-    {
-        this->mapAssetsAddressAmount = cache.mapAssetsAddressAmount;
-        this->mapReissuedAssetData = cache.mapReissuedAssetData;
-
-        //! Copy dirty cache also
-        this->vSpentAssets = cache.vSpentAssets;
-        this->vUndoAssetAmount = cache.vUndoAssetAmount;
-
-        //! Transfer Caches
-        this->setNewTransferAssetsToAdd = cache.setNewTransferAssetsToAdd;
-        this->setNewTransferAssetsToRemove = cache.setNewTransferAssetsToRemove;
-
-        //! Issue Caches
-        this->setNewAssetsToRemove = cache.setNewAssetsToRemove;
-        this->setNewAssetsToAdd = cache.setNewAssetsToAdd;
-
-        //! Reissue Caches
-        this->setNewReissueToRemove = cache.setNewReissueToRemove;
-        this->setNewReissueToAdd = cache.setNewReissueToAdd;
-
-        //! Owner Caches
-        this->setNewOwnerAssetsToAdd = cache.setNewOwnerAssetsToAdd;
-        this->setNewOwnerAssetsToRemove = cache.setNewOwnerAssetsToRemove;
-
-        //! Qualifier Caches
-        this->setNewQualifierAddressToAdd = cache.setNewQualifierAddressToAdd;
-        this->setNewQualifierAddressToRemove = cache.setNewQualifierAddressToRemove;
-
-        //! Restricted Address Caches
-        this->setNewRestrictedAddressToAdd = cache.setNewRestrictedAddressToAdd;
-        this->setNewRestrictedAddressToRemove = cache.setNewRestrictedAddressToRemove;
-
-        //! Restricted Global Caches
-        this->setNewRestrictedGlobalToAdd = cache.setNewRestrictedGlobalToAdd;
-        this->setNewRestrictedGlobalToRemove = cache.setNewRestrictedGlobalToRemove;
-
-        //! Restricted Verifier Caches
-        this->setNewRestrictedVerifierToAdd = cache.setNewRestrictedVerifierToAdd;
-        this->setNewRestrictedVerifierToRemove = cache.setNewRestrictedVerifierToRemove;
-
-        //! Root Qualifier Address Map
-        this->mapRootQualifierAddressesAdd = cache.mapRootQualifierAddressesAdd;
-        this->mapRootQualifierAddressesRemove = cache.mapRootQualifierAddressesRemove;
-
-        return *this;
-    }
+    //! Forking the cache is done by constructing an empty cache, never by copying one. See the class comment.
+    CAssetsCache(const CAssetsCache& cache) = delete;
+    CAssetsCache& operator=(const CAssetsCache& cache) = delete;
 
     //! Cache only undo functions
     bool RemoveNewAsset(const CNewAsset& asset, const std::string address);
@@ -400,6 +328,9 @@ bool IsAssetNameValid(const std::string& name);
 bool IsAssetNameValid(const std::string& name, AssetType& assetType);
 bool IsAssetNameValid(const std::string& name, AssetType& assetType, std::string& error);
 
+//! Get the asset type a name indicates by its tag characters, without validating the parts of the name (ROOT for untagged names)
+AssetType ClassifyAssetName(const std::string& name);
+
 //! Check if an unique tagname is valid
 bool IsUniqueTagValid(const std::string& tag);
 
@@ -516,6 +447,41 @@ bool GetAssetInfoFromScript(const CScript& scriptPubKey, std::string& strName, C
 
 bool GetAssetData(const CScript& script, CAssetOutputEntry& data);
 
+/** An asset output of a transaction, as parsed once by GetTxAssetOutputs */
+struct CTxAssetOutput
+{
+    unsigned int n;             //! Index of the output in the transaction
+    txnouttype type;            //! TX_NEW_ASSET, TX_TRANSFER_ASSET or TX_REISSUE_ASSET
+    bool fIsOwner;
+    int nScriptOffset;          //! Offset of the asset data that follows OP_RVN_ASSET in the script
+    bool fValid;                //! Whether the asset data could be read, as GetAssetData returns
+    std::string assetName;
+    CAmount nAmount;
+    CTxDestination destination;
+    std::string strAddress;
+    std::string message;
+    int64_t nExpireTime;
+    uint160 hashBytes;          //! The address bytes the address index files the output under
+};
+
+struct CTxAssetOutputs
+{
+    //! Transfers are read from a different offset once this is active, see TransferAssetFromScript
+    bool fTransferScriptsSizeDeployed;
+    //! The transaction's asset outputs, ordered by index
+    std::vector<CTxAssetOutput> vOutputs;
+
+    const CTxAssetOutput* Find(unsigned int n) const;
+};
+
+//! The parsed asset outputs of a transaction, computed on first use and kept with the transaction
+std::shared_ptr<const CTxAssetOutputs> GetTxAssetOutputs(const CTransaction& tx);
+
+//! The same results as the script based functions, for output n of tx, from its parsed asset outputs
+bool GetAssetData(const CTransaction& tx, unsigned int n, CAssetOutputEntry& data);
+bool TransferAssetFromTransaction(const CTransaction& tx, unsigned int n, CAssetTransfer& assetTransfer, std::string& strAddress);
+bool ParseAssetScript(const CTransaction& tx, unsigned int n, uint160& hashBytes, std::string& assetName, CAmount& assetAmount);
+
 bool GetBestAssetAddressAmount(CAssetsCache& cache, const std::string& assetName, const std::string& address);
 
 
@@ -551,6 +517,12 @@ bool VerifyWalletHasAsset(const std::string& asset_name, std::pair<int, std::str
 /** Helper method for extracting address bytes, asset name and amount from an asset script */
 bool ParseAssetScript(CScript scriptPubKey, uint160 &hashBytes, std::string &assetName, CAmount &assetAmount);
 
+/** Reads every qualifier the database holds for an address, through passetsAddressQualifiersCache */
+bool GetDatabasedAddressQualifiers(const std::string& address, std::set<std::string>& setQualifiers);
+
+/** Keeps a cached address qualifier set in line with a qualifier being written to or erased from the database */
+void UpdateAddressQualifiersCache(const std::string& address, const std::string& qualifier, bool fAdd);
+
 /** Helper method for extracting #TAGS from a verifier string */
 void ExtractVerifierStringQualifiers(const std::string& verifier, std::set<std::string>& qualifiers);
 bool CheckVerifierString(const std::string& verifier, std::set<std::string>& setFoundQualifiers, std::string& strError, ErrorReport* errorReport = nullptr);
@@ -566,6 +538,7 @@ bool VerifyGlobalRestrictedChange(CAssetsCache& cache, const CNullAssetTxData& d
 bool CheckVerifierAssetTxOut(const CTxOut& txout, std::string& strError);
 bool CheckNewAsset(const CNewAsset& asset, std::string& strError);
 bool CheckReissueAsset(const CReissueAsset& asset, std::string& strError);
+bool CheckTransferAsset(const CAssetTransfer& transfer, const bool fMessagesDeployed, const bool fRestrictedDeployed, std::string& strError);
 
 //// Contextual Check functions
 bool ContextualCheckNullAssetTxOut(const CTxOut& txout, CAssetsCache* assetCache, std::string& strError, std::vector<std::pair<std::string, CNullAssetTxData>>* myNullAssetData = nullptr);
@@ -574,6 +547,7 @@ bool ContextualCheckVerifierAssetTxOut(const CTxOut& txout, CAssetsCache* assetC
 bool ContextualCheckVerifierString(CAssetsCache* cache, const std::string& verifier, const std::string& check_address, std::string& strError, ErrorReport* errorReport = nullptr);
 bool ContextualCheckNewAsset(CAssetsCache* assetCache, const CNewAsset& asset, std::string& strError, bool fCheckMempool = false);
 bool ContextualCheckTransferAsset(CAssetsCache* assetCache, const CAssetTransfer& transfer, const std::string& address, std::string& strError);
+bool ContextualCheckTransferAssetRestrictions(CAssetsCache* assetCache, const CAssetTransfer& transfer, const std::string& address, std::string& strError);
 bool ContextualCheckReissueAsset(CAssetsCache* assetCache, const CReissueAsset& reissue_asset, std::string& strError, const CTransaction& tx);
 bool ContextualCheckReissueAsset(CAssetsCache* assetCache, const CReissueAsset& reissue_asset, std::string& strError);
 bool ContextualCheckUniqueAssetTx(CAssetsCache* assetCache, std::string& strError, const CTransaction& tx);
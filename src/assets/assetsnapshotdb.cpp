@@ -10,6 +10,24 @@
 #include <boost/thread.hpp>
 
 static const char SNAPSHOTCHECK_FLAG = 'C'; // Snapshot Check
+static const char SNAPSHOT_OWNERS_FLAG = 'O'; // Chunk of snapshot owners
+static const char SNAPSHOT_STATUS_FLAG = 'S'; // Snapshot progress/timing
+
+//  Number of owners stored under a single chunk key
+static const size_t SNAPSHOT_CHUNK_SIZE = 1000;
+
+//  Write the pending chunks out once the batch grows past this size
+static const size_t SNAPSHOT_BATCH_SIZE = 1 << 20;
+
+std::string CAssetSnapshotStatus::StateString() const
+{
+    switch (state) {
+        case SNAPSHOT_IN_PROGRESS: return "in_progress";
+        case SNAPSHOT_COMPLETE: return "complete";
+        case SNAPSHOT_FAILED: return "failed";
+        default: return "unknown";
+    }
+}
 
 CAssetSnapshotDBEntry::CAssetSnapshotDBEntry()
 {
@@ -36,7 +54,7 @@ CAssetSnapshotDB::CAssetSnapshotDB(size_t nCacheSize, bool fMemory, bool fWipe)
 }
 
 bool CAssetSnapshotDB::AddAssetOwnershipSnapshot(
-    const std::string & p_assetName, int p_height)
+    const std::string & p_assetName, int p_height, CDBSnapshot * p_view)
 {
     LogPrint(BCLog::REWARDS, "AddAssetOwnershipSnapshot: Adding snapshot for '%s' at height %d\n",
         p_assetName.c_str(), p_height);
@@ -47,65 +65,84 @@ bool CAssetSnapshotDB::AddAssetOwnershipSnapshot(
         return false;
     }
 
-    std::set<std::pair<std::string, CAmount>> ownersAndAmounts;
-    std::vector<std::pair<std::string, CAmount>> tempOwnersAndAmounts;
-    int totalEntryCount;
+    CAssetSnapshotDBEntry snapshotEntry(p_assetName, p_height, std::set<std::pair<std::string, CAmount>>());
 
-    if (!passetsdb->AssetAddressDir(tempOwnersAndAmounts, totalEntryCount, true, p_assetName, INT_MAX, 0)) {
-        LogPrint(BCLog::REWARDS, "AddAssetOwnershipSnapshot: Failed to retrieve assets directory for '%s'\n", p_assetName.c_str());
-        return false;
-    }
+    CAssetSnapshotStatus status;
+    status.startTime = GetTimeMicros();
+    SetSnapshotStatus(snapshotEntry.heightAndName, status);
 
-    //  Retrieve all of the addresses/amounts in batches
-    const int MAX_RETRIEVAL_COUNT = 100;
-    bool errorsOccurred = false;
+    //  Drop whatever a previous attempt at this height left behind
+    CDBBatch batch(*this);
+    EraseSnapshot(batch, snapshotEntry.heightAndName);
 
-    for (int retrievalOffset = 0; retrievalOffset < totalEntryCount; retrievalOffset += MAX_RETRIEVAL_COUNT) {
-        //  Retrieve the specified segment of addresses
-        if (!passetsdb->AssetAddressDir(tempOwnersAndAmounts, totalEntryCount, false, p_assetName, MAX_RETRIEVAL_COUNT, retrievalOffset)) {
-            LogPrint(BCLog::REWARDS, "AddAssetOwnershipSnapshot: Failed to retrieve assets directory for '%s'\n", p_assetName.c_str());
-            errorsOccurred = true;
-            break;
+    //  Stream the owners straight out of the asset DB, writing them out in chunks as we go.
+    //      Addresses in the asset index were encoded from valid destinations when they were
+    //      written, so they are not decoded again here.
+    std::vector<std::pair<std::string, CAmount>> chunk;
+    chunk.reserve(SNAPSHOT_CHUNK_SIZE);
+    uint32_t nChunk = 0;
+    bool fWriteFailed = false;
+
+    auto flushChunk = [&]() -> bool {
+        batch.Write(std::make_pair(SNAPSHOT_OWNERS_FLAG, std::make_pair(snapshotEntry.heightAndName, nChunk++)), chunk);
+        chunk.clear();
+        if (batch.SizeEstimate() > SNAPSHOT_BATCH_SIZE) {
+            if (!WriteBatch(batch))
+                return false;
+            batch.Clear();
         }
+        SetSnapshotStatus(snapshotEntry.heightAndName, status);
+        return true;
+    };
 
-        //  Verify that some addresses were returned
-        if (tempOwnersAndAmounts.size() == 0) {
-            LogPrint(BCLog::REWARDS, "AddAssetOwnershipSnapshot: No addresses were retrieved.\n");
-            continue;
+    bool fStreamed = passetsdb->ForEachAssetAddressQuantity(p_assetName, [&](const std::string& address, const CAmount& amount) -> bool {
+        if (address.empty()) {
+            LogPrint(BCLog::REWARDS, "AddAssetOwnershipSnapshot: Skipping empty address.\n");
+            return true;
         }
 
-        //  Move these into the main set
-        for (auto const & currPair : tempOwnersAndAmounts) {
-            //  Verify that the address is valid
-            CTxDestination dest = DecodeDestination(currPair.first);
-            if (IsValidDestination(dest)) {
-                ownersAndAmounts.insert(currPair);
-            }
-            else {
-                LogPrint(BCLog::REWARDS, "AddAssetOwnershipSnapshot: Address '%s' is invalid.\n", currPair.first.c_str());
-            }
+        chunk.emplace_back(address, amount);
+        status.ownerCount++;
+        status.elapsedTime = GetTimeMicros() - status.startTime;
+
+        if (chunk.size() == SNAPSHOT_CHUNK_SIZE && !flushChunk()) {
+            fWriteFailed = true;
+            return false;
         }
+        return true;
+    }, p_view);
 
-        tempOwnersAndAmounts.clear();
-    }
+    if (fStreamed && !chunk.empty() && !flushChunk())
+        fWriteFailed = true;
 
-    if (errorsOccurred) {
+    if (!fStreamed || fWriteFailed) {
         LogPrint(BCLog::REWARDS, "AddAssetOwnershipSnapshot: Errors occurred while acquiring ownership info for asset '%s'.\n", p_assetName.c_str());
+        status.state = CAssetSnapshotStatus::SNAPSHOT_FAILED;
+        SetSnapshotStatus(snapshotEntry.heightAndName, status);
         return false;
     }
-    if (ownersAndAmounts.size() == 0) {
+    if (status.ownerCount == 0) {
         LogPrint(BCLog::REWARDS, "AddAssetOwnershipSnapshot: No owners exist for asset '%s'.\n", p_assetName.c_str());
+        status.state = CAssetSnapshotStatus::SNAPSHOT_FAILED;
+        SetSnapshotStatus(snapshotEntry.heightAndName, status);
         return false;
     }
 
-    //  Write the snapshot to the database. We don't care if we overwrite, because it should be identical.
-    CAssetSnapshotDBEntry snapshotEntry(p_assetName, p_height, ownersAndAmounts);
+    //  The entry itself is written last, so a snapshot is only visible once all of its chunks are
+    status.state = CAssetSnapshotStatus::SNAPSHOT_COMPLETE;
+    status.elapsedTime = GetTimeMicros() - status.startTime;
+    batch.Write(std::make_pair(SNAPSHOT_STATUS_FLAG, snapshotEntry.heightAndName), status);
+    batch.Write(std::make_pair(SNAPSHOTCHECK_FLAG, snapshotEntry.heightAndName), snapshotEntry);
 
-    if (Write(std::make_pair(SNAPSHOTCHECK_FLAG, snapshotEntry.heightAndName), snapshotEntry)) {
-        LogPrint(BCLog::REWARDS, "AddAssetOwnershipSnapshot: Successfully added snapshot for '%s' at height %d (ownerCount = %d).\n",
-            p_assetName.c_str(), p_height, ownersAndAmounts.size());
+    if (WriteBatch(batch)) {
+        SetSnapshotStatus(snapshotEntry.heightAndName, status);
+        LogPrint(BCLog::REWARDS, "AddAssetOwnershipSnapshot: Successfully added snapshot for '%s' at height %d (ownerCount = %d) in %.2fms.\n",
+            p_assetName.c_str(), p_height, status.ownerCount, status.elapsedTime * 0.001);
         return true;
     }
+
+    status.state = CAssetSnapshotStatus::SNAPSHOT_FAILED;
+    SetSnapshotStatus(snapshotEntry.heightAndName, status);
     return false;
 }
 
@@ -122,6 +159,27 @@ bool CAssetSnapshotDB::RetrieveOwnershipSnapshot(
 
     bool succeeded = Read(std::make_pair(SNAPSHOTCHECK_FLAG, heightAndName), p_snapshotEntry);
 
+    //  Owners are stored in chunks next to the entry (older snapshots carry them inline)
+    if (succeeded) {
+        std::unique_ptr<CDBIterator> pcursor(NewIterator());
+        pcursor->Seek(std::make_pair(SNAPSHOT_OWNERS_FLAG, std::make_pair(heightAndName, (uint32_t)0)));
+        while (pcursor->Valid()) {
+            boost::this_thread::interruption_point();
+
+            std::pair<char, std::pair<std::string, uint32_t>> key;
+            if (!pcursor->GetKey(key) || key.first != SNAPSHOT_OWNERS_FLAG || key.second.first != heightAndName)
+                break;
+
+            std::vector<std::pair<std::string, CAmount>> chunk;
+            if (!pcursor->GetValue(chunk)) {
+                succeeded = false;
+                break;
+            }
+            p_snapshotEntry.ownersAndAmounts.insert(chunk.begin(), chunk.end());
+            pcursor->Next();
+        }
+    }
+
     LogPrint(BCLog::REWARDS, "%s : Retrieval of snapshot for '%s' %s!\n",
         __func__,
         heightAndName.c_str(),
@@ -140,7 +198,14 @@ bool CAssetSnapshotDB::RemoveOwnershipSnapshot(
         __func__,
         heightAndName.c_str());
 
-    bool succeeded = Erase(std::make_pair(SNAPSHOTCHECK_FLAG, heightAndName), true);
+    CDBBatch batch(*this);
+    EraseSnapshot(batch, heightAndName);
+    bool succeeded = WriteBatch(batch, true);
+
+    {
+        LOCK(cs_status);
+        mapSnapshotStatus.erase(heightAndName);
+    }
 
     LogPrint(BCLog::REWARDS, "%s : Removal of snapshot for '%s' %s!\n",
         __func__,
@@ -149,3 +214,43 @@ bool CAssetSnapshotDB::RemoveOwnershipSnapshot(
 
     return succeeded;
 }
+
+void CAssetSnapshotDB::EraseSnapshot(CDBBatch & p_batch, const std::string & p_heightAndName)
+{
+    p_batch.Erase(std::make_pair(SNAPSHOTCHECK_FLAG, p_heightAndName));
+    p_batch.Erase(std::make_pair(SNAPSHOT_STATUS_FLAG, p_heightAndName));
+
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    pcursor->Seek(std::make_pair(SNAPSHOT_OWNERS_FLAG, std::make_pair(p_heightAndName, (uint32_t)0)));
+    while (pcursor->Valid()) {
+        std::pair<char, std::pair<std::string, uint32_t>> key;
+        if (!pcursor->GetKey(key) || key.first != SNAPSHOT_OWNERS_FLAG || key.second.first != p_heightAndName)
+            break;
+        p_batch.Erase(key);
+        pcursor->Next();
+    }
+}
+
+void CAssetSnapshotDB::SetSnapshotStatus(const std::string & p_heightAndName, const CAssetSnapshotStatus & p_status)
+{
+    LOCK(cs_status);
+    mapSnapshotStatus[p_heightAndName] = p_status;
+}
+
+bool CAssetSnapshotDB::GetSnapshotStatus(
+    const std::string & p_assetName, int p_height,
+    CAssetSnapshotStatus & p_status)
+{
+    std::string heightAndName = std::to_string(p_height) + p_assetName;
+
+    {
+        LOCK(cs_status);
+        auto it = mapSnapshotStatus.find(heightAndName);
+        if (it != mapSnapshotStatus.end()) {
+            p_status = it->second;
+            return true;
+        }
+    }
+
+    return Read(std::make_pair(SNAPSHOT_STATUS_FLAG, heightAndName), p_status);
+}
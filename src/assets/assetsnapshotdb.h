@@ -5,10 +5,12 @@
 #ifndef ASSETSNAPSHOTDB_H
 #define ASSETSNAPSHOTDB_H
 
+#include <map>
 #include <set>
 
 #include <dbwrapper.h>
 #include "amount.h"
+#include "sync.h"
 
 class CAssetSnapshotDBEntry
 {
@@ -53,16 +55,72 @@ public:
     }
 };
 
+//  Progress and timing of an ownership snapshot, kept in memory while the snapshot
+//      is being taken and persisted next to it once it has completed
+class CAssetSnapshotStatus
+{
+public:
+    enum State : int8_t {
+        SNAPSHOT_IN_PROGRESS = 0,
+        SNAPSHOT_COMPLETE = 1,
+        SNAPSHOT_FAILED = 2
+    };
+
+    int8_t state;
+    uint64_t ownerCount;
+    int64_t startTime;      // Micros
+    int64_t elapsedTime;    // Micros
+
+    CAssetSnapshotStatus()
+    {
+        SetNull();
+    }
+
+    void SetNull()
+    {
+        state = SNAPSHOT_IN_PROGRESS;
+        ownerCount = 0;
+        startTime = 0;
+        elapsedTime = 0;
+    }
+
+    std::string StateString() const;
+
+    // Serialization methods
+    ADD_SERIALIZE_METHODS;
+
+    template<typename Stream, typename Operation>
+    inline void SerializationOp(Stream &s, Operation ser_action)
+    {
+        READWRITE(state);
+        READWRITE(ownerCount);
+        READWRITE(startTime);
+        READWRITE(elapsedTime);
+    }
+};
+
 class CAssetSnapshotDB  : public CDBWrapper {
+private:
+    //  Status of the snapshots taken since startup, keyed by heightAndName
+    CCriticalSection cs_status;
+    std::map<std::string, CAssetSnapshotStatus> mapSnapshotStatus;
+
+    void SetSnapshotStatus(const std::string & p_heightAndName, const CAssetSnapshotStatus & p_status);
+
+    //  Queue the erasure of a snapshot entry, its owner chunks and its status
+    void EraseSnapshot(CDBBatch & p_batch, const std::string & p_heightAndName);
+
 public:
     explicit CAssetSnapshotDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
 
     CAssetSnapshotDB(const CAssetSnapshotDB&) = delete;
     CAssetSnapshotDB& operator=(const CAssetSnapshotDB&) = delete;
 
-    //  Add an entry to the snapshot at the specified height
+    //  Add an entry to the snapshot at the specified height. The owners are streamed
+    //      from the asset DB in one pass and written out in chunks as they are read.
+    //      p_view, when given, is a view of the asset DB frozen at that height.
     bool AddAssetOwnershipSnapshot(
-        const std::string & p_assetName, int p_height);
+        const std::string & p_assetName, int p_height, CDBSnapshot * p_view = nullptr);
 
     //  Read all of the entries at a specified height
     bool RetrieveOwnershipSnapshot(
@@ -72,6 +130,11 @@ public:
     //  Remove the asset snapshot at the specified height
     bool RemoveOwnershipSnapshot(
         const std::string & p_assetName, int p_height);
+
+    //  Progress/timing of the snapshot at the specified height, if one was started
+    bool GetSnapshotStatus(
+        const std::string & p_assetName, int p_height,
+        CAssetSnapshotStatus & p_status);
 };
 
 
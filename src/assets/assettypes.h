@@ -9,9 +9,15 @@
 #include <sstream>
 #include <list>
 #include <unordered_map>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
 #include "amount.h"
+#include "pubkey.h"
 #include "script/standard.h"
 #include "primitives/transaction.h"
+#include "memusage.h"
 
 #define MAX_UNIT 8
 #define MIN_UNIT 0
@@ -331,6 +337,18 @@ public:
     void ConstructTransaction(CScript& script) const;
 };
 
+/** The asset data of one transaction output, as read by GetAssetData */
+struct CAssetOutputEntry
+{
+    txnouttype type;
+    std::string assetName;
+    CTxDestination destination;
+    CAmount nAmount;
+    std::string message;
+    int64_t expireTime;
+    int vout;
+};
+
 /** THESE ARE ONLY TO BE USED WHEN ADDING THINGS TO THE CACHE DURING CONNECT AND DISCONNECT BLOCK */
 struct CAssetCacheNewAsset
 {
@@ -652,4 +670,231 @@ private:
     size_t maxSize;
 };
 
+//! Heap memory held by the keys and values of the asset caches, see CShardedLRUCache
+static inline size_t CacheDynamicUsage(int8_t) { return 0; }
+static inline size_t CacheDynamicUsage(int) { return 0; }
+static inline size_t CacheDynamicUsage(const std::string& str) { return str.capacity() > 15 ? memusage::MallocUsage(str.capacity() + 1) : 0; }
+
+static inline size_t CacheDynamicUsage(const std::set<std::string>& set)
+{
+    size_t usage = memusage::DynamicUsage(set);
+    for (const std::string& str : set)
+        usage += CacheDynamicUsage(str);
+    return usage;
+}
+
+static inline size_t CacheDynamicUsage(const CDatabasedAssetData& data)
+{
+    return CacheDynamicUsage(data.asset.strName) + CacheDynamicUsage(data.asset.strIPFSHash);
+}
+
+static inline size_t CacheDynamicUsage(const CNullAssetTxVerifierString& verifier)
+{
+    return CacheDynamicUsage(verifier.verifier_string);
+}
+
+/**
+ * Least Recently Used Cache bounded by the memory its entries use, that can be shared between threads.
+ * Keys are spread over independently locked shards that each evict their own least recently used
+ * entries, so lookups from different threads rarely wait on each other. Each key is stored once, in its
+ * map node, and the recency list only points at it. Values are returned by copy, so a later eviction
+ * can't invalidate them.
+ */
+template<typename cache_key_t, typename cache_value_t>
+class CShardedLRUCache
+{
+public:
+    static const size_t SHARDS = 16;
+
+    explicit CShardedLRUCache(size_t max_usage) : maxUsage(max_usage), nHits(0), nMisses(0), nEvictions(0)
+    {
+    }
+
+    CShardedLRUCache(const CShardedLRUCache&) = delete;
+    CShardedLRUCache& operator=(const CShardedLRUCache&) = delete;
+
+    void Put(const cache_key_t& key, const cache_value_t& value)
+    {
+        size_t usage = EntryUsage(key, value);
+        Shard& shard = GetShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto it = shard.entries.find(key);
+        if (it != shard.entries.end()) {
+            shard.usage -= it->second.usage;
+            it->second.value = value;
+            it->second.usage = usage;
+            shard.order.splice(shard.order.begin(), shard.order, it->second.position);
+        } else {
+            it = shard.entries.emplace(key, Entry(value, usage)).first;
+            shard.order.push_front(&it->first);
+            it->second.position = shard.order.begin();
+        }
+        shard.usage += usage;
+        TrimShard(shard);
+    }
+
+    /**
+     * Changes the cached value of a key in place, by calling fn on it under the shard's lock, so that
+     * concurrent updates of the same key can't undo each other. Returns false, without calling fn, when
+     * the key isn't cached.
+     */
+    template<typename Fn>
+    bool Update(const cache_key_t& key, Fn fn)
+    {
+        Shard& shard = GetShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.entries.find(key);
+        if (it == shard.entries.end())
+            return false;
+
+        fn(it->second.value);
+        shard.usage -= it->second.usage;
+        it->second.usage = EntryUsage(key, it->second.value);
+        shard.usage += it->second.usage;
+        shard.order.splice(shard.order.begin(), shard.order, it->second.position);
+        TrimShard(shard);
+        return true;
+    }
+
+    void Erase(const cache_key_t& key)
+    {
+        Shard& shard = GetShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.entries.find(key);
+        if (it != shard.entries.end()) {
+            shard.usage -= it->second.usage;
+            shard.order.erase(it->second.position);
+            shard.entries.erase(it);
+        }
+    }
+
+    //! Looks the key up and copies its value out in one step, counted as a hit or a miss
+    bool Find(const cache_key_t& key, cache_value_t& value)
+    {
+        Shard& shard = GetShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.entries.find(key);
+        if (it == shard.entries.end()) {
+            nMisses++;
+            return false;
+        }
+        nHits++;
+        shard.order.splice(shard.order.begin(), shard.order, it->second.position);
+        value = it->second.value;
+        return true;
+    }
+
+    cache_value_t Get(const cache_key_t& key)
+    {
+        Shard& shard = GetShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.entries.find(key);
+        if (it == shard.entries.end())
+            throw std::range_error("There is no such key in cache");
+        shard.order.splice(shard.order.begin(), shard.order, it->second.position);
+        return it->second.value;
+    }
+
+    //! Not counted as a hit or a miss, callers after the value look it up with Find()
+    bool Exists(const cache_key_t& key)
+    {
+        Shard& shard = GetShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.entries.count(key) > 0;
+    }
+
+    size_t Size()
+    {
+        size_t size = 0;
+        for (Shard& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            size += shard.entries.size();
+        }
+        return size;
+    }
+
+    size_t DynamicMemoryUsage()
+    {
+        size_t usage = 0;
+        for (Shard& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            usage += shard.usage;
+        }
+        return usage;
+    }
+
+    size_t MaxMemoryUsage() const
+    {
+        return maxUsage;
+    }
+
+    void Clear()
+    {
+        for (Shard& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.order.clear();
+            shard.entries.clear();
+            shard.usage = 0;
+        }
+    }
+
+    uint64_t Hits() const { return nHits; }
+    uint64_t Misses() const { return nMisses; }
+    uint64_t Evictions() const { return nEvictions; }
+
+private:
+    typedef std::list<const cache_key_t*> order_list_t;
+
+    struct Entry
+    {
+        cache_value_t value;
+        size_t usage;
+        typename order_list_t::iterator position;
+
+        Entry(const cache_value_t& valueIn, size_t usageIn) : value(valueIn), usage(usageIn) {}
+    };
+
+    struct Shard
+    {
+        std::mutex mutex;
+        std::unordered_map<cache_key_t, Entry> entries;
+        order_list_t order; //! Most recently used first
+        size_t usage = 0;
+    };
+
+    Shard& GetShard(const cache_key_t& key)
+    {
+        // Use the high bits, the low ones already pick the bucket inside the shard
+        size_t hash = std::hash<cache_key_t>()(key);
+        return shards[(hash >> (sizeof(size_t) * 4)) % SHARDS];
+    }
+
+    //! Evicts the shard's least recently used entries until it is within its share, keeping at least the most recent one
+    void TrimShard(Shard& shard)
+    {
+        while (shard.usage > maxUsage / SHARDS && shard.order.size() > 1) {
+            auto last = shard.entries.find(*shard.order.back());
+            shard.usage -= last->second.usage;
+            shard.order.pop_back();
+            shard.entries.erase(last);
+            nEvictions++;
+        }
+    }
+
+    static size_t EntryUsage(const cache_key_t& key, const cache_value_t& value)
+    {
+        // The map node, its bucket and the list node, plus what the key and value hold on the heap
+        return memusage::MallocUsage(sizeof(typename std::unordered_map<cache_key_t, Entry>::value_type) + sizeof(void*)) + sizeof(void*) +
+               memusage::MallocUsage(sizeof(const cache_key_t*) + 2 * sizeof(void*)) +
+               CacheDynamicUsage(key) + CacheDynamicUsage(value);
+    }
+
+    Shard shards[SHARDS];
+    const size_t maxUsage;
+    std::atomic<uint64_t> nHits;
+    std::atomic<uint64_t> nMisses;
+    std::atomic<uint64_t> nEvictions;
+};
+
 #endif //RAVENCOIN_NEWASSET_H
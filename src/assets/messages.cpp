@@ -78,7 +78,8 @@ bool IsChannelSubscribed(const std::string &name)
         return false;
 
     // Check the Channel Cache and see if it is in the Cache
-    if (pMessageSubscribedChannelsCache->Exists(name))
+    int fSubscribed;
+    if (pMessageSubscribedChannelsCache->Find(name, fSubscribed))
         return true;
 
     // Check if we have already searched for this before
@@ -113,8 +114,7 @@ bool GetMessage(const COutPoint& out, CMessage& message)
         return false;
 
     // Check database cache
-    if (pMessagesCache->Exists(out.ToSerializedString())) {
-        message = pMessagesCache->Get(out.ToSerializedString());
+    if (pMessagesCache->Find(out.ToSerializedString(), message)) {
         return true;
     }
 
@@ -215,14 +215,15 @@ bool ScanForMessageChannels(std::string& strError)
                 return false;
             }
 
-            for (auto out : ptx->vout) {
+            for (unsigned int n = 0; n < ptx->vout.size(); n++) {
+                const CTxOut& out = ptx->vout[n];
                 int nType = -1;
                 bool fOwner = false;
                 if (vpwallets[0]->IsMine(out) == ISMINE_SPENDABLE) { // Is the out mine
                     if (out.scriptPubKey.IsAssetScript(nType, fOwner)) {
                         CAssetOutputEntry assetData;
                         // Get the asset data from the script
-                        if (GetAssetData(out.scriptPubKey, assetData)) {
+                        if (GetAssetData(*ptx, n, assetData)) {
                             AssetType type;
                             IsAssetNameValid(assetData.assetName, type);
 
@@ -274,7 +275,8 @@ bool IsAddressSeen(const std::string &address)
     if (setDirtySeenAddressAdd.count(address)) // Check dirty set
         return true;
 
-    if (pMessagesSeenAddressCache->Exists(address)) {
+    int fSeen;
+    if (pMessagesSeenAddressCache->Find(address, fSeen)) {
         return true;
     }
 
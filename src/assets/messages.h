@@ -8,6 +8,7 @@
 
 #include <uint256.h>
 #include <serialize.h>
+#include <assets/assettypes.h>
 
 class CMessage;
 class COutPoint;
@@ -123,6 +124,12 @@ public:
     }
 };
 
+//! Heap memory held by a message in pMessagesCache
+static inline size_t CacheDynamicUsage(const CMessage& message)
+{
+    return CacheDynamicUsage(message.strName) + CacheDynamicUsage(message.ipfsHash);
+}
+
 class CZMQMessage {
 public:
     int blockHeight;
@@ -8,7 +8,11 @@
 
 #include <boost/thread.hpp>
 
+#include <algorithm>
+
 static const char MESSAGE_FLAG = 'Z'; // Message
+static const char MESSAGE_TIME_INDEX = 'I'; // Messages by time
+static const char MESSAGE_CHANNEL_INDEX = 'N'; // Messages by channel and time
 static const char MY_MESSAGE_CHANNEL = 'C'; // My followed Channels
 static const char MY_SEEN_ADDRESSES = 'S'; // Addresses that have been seen on the chain
 static const char DB_FLAG = 'D'; // Database Flags
@@ -19,9 +23,58 @@ static const char MY_RESTRICTED_ADDRESSES = 'R'; // Addresses that have been res
 CMessageDB::CMessageDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(GetDataDir() / "messages" / "messages", nCacheSize, fMemory, fWipe) {
 }
 
+/** Index key of a message, with the time written big endian so the keys sort by time */
+struct CMessageTimeKey
+{
+    int64_t time;
+    COutPoint out;
+
+    CMessageTimeKey() : time(0) { }
+    CMessageTimeKey(int64_t _time, const COutPoint& _out) : time(_time), out(_out) { }
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata32be(s, (uint32_t)((uint64_t)time >> 32));
+        ser_writedata32be(s, (uint32_t)time);
+        s << out;
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        uint64_t nHigh = ser_readdata32be(s);
+        time = (int64_t)((nHigh << 32) | ser_readdata32be(s));
+        s >> out;
+    }
+};
+
+static void WriteMessageIndexes(CDBBatch& batch, const CMessage& message)
+{
+    CMessageTimeKey key(message.time, message.out);
+    batch.Write(std::make_pair(MESSAGE_TIME_INDEX, key), '1');
+    batch.Write(std::make_pair(MESSAGE_CHANNEL_INDEX, std::make_pair(message.strName, key)), '1');
+}
+
+static void EraseMessageIndexes(CDBBatch& batch, const CMessage& message)
+{
+    CMessageTimeKey key(message.time, message.out);
+    batch.Erase(std::make_pair(MESSAGE_TIME_INDEX, key));
+    batch.Erase(std::make_pair(MESSAGE_CHANNEL_INDEX, std::make_pair(message.strName, key)));
+}
+
 bool CMessageDB::WriteMessage(const CMessage &message)
 {
-    return Write(std::make_pair(MESSAGE_FLAG, message.out), message);
+    CDBBatch batch(*this);
+
+    // A message put back in another block has moved in time
+    CMessage previous;
+    if (ReadMessage(message.out, previous) && (previous.time != message.time || previous.strName != message.strName))
+        EraseMessageIndexes(batch, previous);
+
+    batch.Write(std::make_pair(MESSAGE_FLAG, message.out), message);
+    WriteMessageIndexes(batch, message);
+    return WriteBatch(batch);
 }
 
 bool CMessageDB::ReadMessage(const COutPoint &out, CMessage &message)
@@ -31,33 +84,137 @@ bool CMessageDB::ReadMessage(const COutPoint &out, CMessage &message)
 
 bool CMessageDB::EraseMessage(const COutPoint &out)
 {
-    return Erase(std::make_pair(MESSAGE_FLAG, out));
+    CDBBatch batch(*this);
+
+    CMessage message;
+    if (ReadMessage(out, message))
+        EraseMessageIndexes(batch, message);
+
+    batch.Erase(std::make_pair(MESSAGE_FLAG, out));
+    return WriteBatch(batch);
 }
 
-bool CMessageDB::LoadMessages(std::set<CMessage>& setMessages)
+bool CMessageDB::LoadMessages(std::vector<CMessage>& vMessages, const std::string& channel, int64_t nSince, size_t nLimit)
 {
+    vMessages.clear();
+
+    // The time index stores times unsigned, a negative seek would land past every message
+    if (nSince < 0)
+        return false;
+
+    auto fMatches = [&channel, nSince](const CMessage& message) -> bool {
+        return (channel.empty() || message.strName == channel) && message.time >= nSince;
+    };
+    auto fTimeOrder = [](const CMessage& lhs, const CMessage& rhs) -> bool {
+        return lhs.time < rhs.time || (lhs.time == rhs.time && lhs.out < rhs.out);
+    };
+    auto fFull = [&vMessages, nLimit]() -> bool {
+        return nLimit && vMessages.size() >= nLimit;
+    };
+
+    // The dirty messages replace their databased copies, removed ones are dropped
+    std::vector<CMessage> vDirtyMessages;
+    for (const auto& pair : mapDirtyMessagesAdd) {
+        if (fMatches(pair.second))
+            vDirtyMessages.push_back(pair.second);
+    }
+    for (const auto& pair : mapDirtyMessagesOrphaned) {
+        if (mapDirtyMessagesAdd.count(pair.first) || setDirtyMessagesRemove.count(pair.first))
+            continue;
+        CMessage message = pair.second;
+        message.status = MessageStatus::ORPHAN;
+        if (fMatches(message))
+            vDirtyMessages.push_back(message);
+    }
+    std::sort(vDirtyMessages.begin(), vDirtyMessages.end(), fTimeOrder);
+    auto dirtyIter = vDirtyMessages.begin();
+
+    // Walk the index from nSince, merging in the dirty messages as their time comes up
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    CMessageTimeKey start(nSince, COutPoint());
+    if (channel.empty())
+        pcursor->Seek(std::make_pair(MESSAGE_TIME_INDEX, start));
+    else
+        pcursor->Seek(std::make_pair(MESSAGE_CHANNEL_INDEX, std::make_pair(channel, start)));
+
+    while (pcursor->Valid() && !fFull()) {
+        boost::this_thread::interruption_point();
+
+        COutPoint out;
+        if (channel.empty()) {
+            std::pair<char, CMessageTimeKey> key;
+            if (!pcursor->GetKey(key) || key.first != MESSAGE_TIME_INDEX)
+                break;
+            out = key.second.out;
+        } else {
+            std::pair<char, std::pair<std::string, CMessageTimeKey> > key;
+            if (!pcursor->GetKey(key) || key.first != MESSAGE_CHANNEL_INDEX || key.second.first != channel)
+                break;
+            out = key.second.second.out;
+        }
+        pcursor->Next();
+
+        if (mapDirtyMessagesAdd.count(out) || mapDirtyMessagesOrphaned.count(out) || setDirtyMessagesRemove.count(out))
+            continue;
+
+        CMessage message;
+        if (!ReadMessage(out, message)) {
+            LogPrintf("%s: failed to read message %s\n", __func__, out.ToString());
+            continue;
+        }
+
+        while (dirtyIter != vDirtyMessages.end() && fTimeOrder(*dirtyIter, message) && !fFull())
+            vMessages.push_back(*dirtyIter++);
+        if (!fFull())
+            vMessages.push_back(message);
+    }
+
+    while (dirtyIter != vDirtyMessages.end() && !fFull())
+        vMessages.push_back(*dirtyIter++);
 
+    return true;
+}
+
+bool CMessageDB::BuildMessageIndexes()
+{
+    bool fIndexed = false;
+    if (ReadFlag("messageindexes", fIndexed) && fIndexed)
+        return true;
+
+    LogPrintf("%s: Indexing messages by time and channel\n", __func__);
+
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
     pcursor->Seek(std::make_pair(MESSAGE_FLAG, COutPoint()));
 
-    // Load messages
+    CDBBatch batch(*this);
+    int nCount = 0;
     while (pcursor->Valid()) {
         boost::this_thread::interruption_point();
         std::pair<char, COutPoint> key;
-        if (pcursor->GetKey(key) && key.first == MESSAGE_FLAG) {
-            CMessage message;
-            if (pcursor->GetValue(message)) {
-                setMessages.insert(message);
-                pcursor->Next();
-            } else {
-                LogPrintf("%s: failed to read message\n", __func__);
-                pcursor->Next();
-            }
-        } else {
+        if (!pcursor->GetKey(key) || key.first != MESSAGE_FLAG)
             break;
+
+        CMessage message;
+        if (pcursor->GetValue(message)) {
+            WriteMessageIndexes(batch, message);
+            nCount++;
+        } else {
+            LogPrintf("%s: failed to read message\n", __func__);
+        }
+        pcursor->Next();
+
+        if (batch.SizeEstimate() > (1 << 20)) {
+            if (!WriteBatch(batch))
+                return error("%s: failed to write message indexes", __func__);
+            batch.Clear();
         }
     }
-    return true;
+
+    if (!WriteBatch(batch))
+        return error("%s: failed to write message indexes", __func__);
+
+    LogPrintf("%s: Indexed %d messages\n", __func__, nCount);
+    return WriteFlag("messageindexes", true);
 }
 
 bool CMessageDB::EraseAllMessages(int& count)
@@ -18,13 +18,19 @@ public:
     CMessageDB(const CMessageDB&) = delete;
     CMessageDB& operator=(const CMessageDB&) = delete;
 
-    // Database of messages
+    // Database of messages, indexed by time and by channel and time
     bool WriteMessage(const CMessage& message);
     bool ReadMessage(const COutPoint& out, CMessage& message);
     bool EraseMessage(const COutPoint& out);
-    bool LoadMessages(std::set<CMessage>& setMessages);
     bool EraseAllMessages(int& count);
 
+    // Load the messages, with the ones not flushed yet merged in, in time order. Only those of channel when it isn't
+    // empty and sent at or after nSince, at most nLimit of them when it isn't 0.
+    bool LoadMessages(std::vector<CMessage>& vMessages, const std::string& channel = "", int64_t nSince = 0, size_t nLimit = 0);
+
+    // Index the messages written before the indexes existed, once
+    bool BuildMessageIndexes();
+
     // Write / Read Database flags
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
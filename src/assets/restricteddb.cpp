@@ -53,6 +53,37 @@ bool CRestrictedDB::EraseAddressQualifier(const std::string &address, const std:
     return Erase(std::make_pair(ADDRESS_QULAIFIER_FLAG, std::make_pair(address, tag)));
 }
 
+// Every tag of an address in database key order, read with a single seek as the address leads the key
+bool CRestrictedDB::ReadAddressQualifiers(const std::string &address, std::vector<std::string> &tags)
+{
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+
+    pcursor->Seek(std::make_pair(ADDRESS_QULAIFIER_FLAG, std::make_pair(address, std::string())));
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char, std::pair<std::string, std::string> > key;
+        if (pcursor->GetKey(key) && key.first == ADDRESS_QULAIFIER_FLAG && key.second.first == address) {
+            tags.emplace_back(key.second.second);
+            pcursor->Next();
+        } else {
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool CRestrictedDB::ReadAddressQualifiers(const std::string &address, std::set<std::string> &tags)
+{
+    std::vector<std::string> vTags;
+    if (!ReadAddressQualifiers(address, vTags))
+        return false;
+
+    tags.insert(vTags.begin(), vTags.end());
+    return true;
+}
+
 // Address Tags
 bool CRestrictedDB::WriteQualifierAddress(const std::string &address, const std::string &tag)
 {
@@ -172,23 +203,8 @@ bool CRestrictedDB::GetAddressQualifiers(std::string& address, std::vector<std::
 {
     FlushStateToDisk();
 
-    std::unique_ptr<CDBIterator> pcursor(NewIterator());
-
-    pcursor->Seek(std::make_pair(ADDRESS_QULAIFIER_FLAG, std::make_pair(address, std::string())));
-
     // Load all qualifiers related to that given address
-    while (pcursor->Valid()) {
-        boost::this_thread::interruption_point();
-        std::pair<char, std::pair<std::string, std::string> > key;
-        if (pcursor->GetKey(key) && key.first == ADDRESS_QULAIFIER_FLAG && key.second.first == address) {
-            qualifiers.emplace_back(key.second.second);
-            pcursor->Next();
-        } else {
-            break;
-        }
-    }
-
-    return true;
+    return ReadAddressQualifiers(address, qualifiers);
 }
 
 bool CRestrictedDB::GetAddressRestrictions(std::string& address, std::vector<std::string>& restrictions)
@@ -8,6 +8,8 @@
 
 #include <dbwrapper.h>
 
+#include <set>
+
 class CRestrictedDB  : public CDBWrapper {
 
 public:
@@ -25,6 +27,8 @@ public:
     bool WriteAddressQualifier(const std::string &address, const std::string &tag);
     bool ReadAddressQualifier(const std::string &address, const std::string &tag);
     bool EraseAddressQualifier(const std::string &address, const std::string &tag);
+    bool ReadAddressQualifiers(const std::string &address, std::vector<std::string> &tags);
+    bool ReadAddressQualifiers(const std::string &address, std::set<std::string> &tags);
 
     // Database of the Qualifier to the address that are assigned to them
     bool WriteQualifierAddress(const std::string &address, const std::string &tag);
@@ -17,10 +17,42 @@
 #include <utilmoneystr.h>
 #include "assets/rewards.h"
 #include "assetsnapshotdb.h"
+#include "validationinterface.h"
 #include "wallet/wallet.h"
 
+#include <deque>
+
+#include <boost/thread.hpp>
+
 std::map<uint256, CRewardSnapshot> mapRewardSnapshots;
 
+//  Distribution lists of the distributions still being paid out, generated once instead of on every block (guarded by cs_main)
+static std::map<uint256, std::vector<OwnerAndAmount>> mapDistributionLists;
+
+struct CPendingOwnershipSnapshot
+{
+    std::string strAssetName;
+    int nHeight;
+    std::shared_ptr<CDBSnapshot> view;
+};
+
+//  Work handed to the rewards thread
+static boost::mutex csRewardsQueue;
+static boost::condition_variable condRewardsQueue;
+static std::deque<CPendingOwnershipSnapshot> queueOwnershipSnapshots;
+//  Distributions for the rewards thread to look over, and the ones to look over again after the next block
+static std::set<uint256> setDistributionsToCheck;
+static std::set<uint256> setDistributionsToRetry;
+//  Transactions paying out the distributions, by txid, with the distribution each one pays
+static std::map<uint256, uint256> mapDistributionTxids;
+//  Whether the rewards thread is running and working on what it took from the queue, for SyncWithRewardsThread()
+static bool fRewardsThreadRunning = false;
+static bool fRewardsThreadBusy = false;
+static boost::condition_variable condRewardsIdle;
+
+//  Held while queued snapshots are written out, so FlushOwnershipSnapshots() also waits for the one in progress
+static boost::mutex csWriteOwnershipSnapshots;
+
 uint256 CRewardSnapshot::GetHash() const
 {
     return SerializeHash(*this, SER_GETHASH);
@@ -36,11 +68,195 @@ bool AddDistributeRewardSnapshot(CRewardSnapshot& p_rewardSnapshot)
 
     if (pDistributeSnapshotDb->AddDistributeSnapshot(hash, p_rewardSnapshot)) {
         mapRewardSnapshots[hash] = p_rewardSnapshot;
+        {
+            boost::lock_guard<boost::mutex> lock(csRewardsQueue);
+            setDistributionsToCheck.insert(hash);
+        }
+        condRewardsQueue.notify_one();
     }
 
     return true;
 }
 
+void QueueOwnershipSnapshot(const std::string& p_assetName, int p_height, const std::shared_ptr<CDBSnapshot>& p_view)
+{
+    {
+        boost::lock_guard<boost::mutex> lock(csRewardsQueue);
+        queueOwnershipSnapshots.push_back(CPendingOwnershipSnapshot{p_assetName, p_height, p_view});
+    }
+    condRewardsQueue.notify_one();
+}
+
+void FlushOwnershipSnapshots()
+{
+    //  A snapshot interrupted half way would be lost, as its block is already connected
+    boost::this_thread::disable_interruption noInterruption;
+    boost::lock_guard<boost::mutex> writeLock(csWriteOwnershipSnapshots);
+    while (true) {
+        CPendingOwnershipSnapshot pending;
+        {
+            boost::lock_guard<boost::mutex> lock(csRewardsQueue);
+            if (queueOwnershipSnapshots.empty())
+                return;
+            pending = std::move(queueOwnershipSnapshots.front());
+            queueOwnershipSnapshots.pop_front();
+        }
+
+        if (pAssetSnapshotDb == nullptr || !pAssetSnapshotDb->AddAssetOwnershipSnapshot(pending.strAssetName, pending.nHeight, pending.view.get())) {
+            LogPrint(BCLog::REWARDS, "%s: Failed to snapshot owners for '%s' at height %d!\n", __func__,
+                     pending.strAssetName.c_str(), pending.nHeight);
+        }
+    }
+}
+
+void RetryRewardDistribution(const uint256& p_hash)
+{
+    boost::lock_guard<boost::mutex> lock(csRewardsQueue);
+    setDistributionsToRetry.insert(p_hash);
+}
+
+void WatchRewardDistributionTransaction(const uint256& p_hash, const uint256& p_txid)
+{
+    boost::lock_guard<boost::mutex> lock(csRewardsQueue);
+    mapDistributionTxids[p_txid] = p_hash;
+}
+
+void UnwatchRewardDistribution(const uint256& p_hash)
+{
+    boost::lock_guard<boost::mutex> lock(csRewardsQueue);
+    for (auto it = mapDistributionTxids.begin(); it != mapDistributionTxids.end(); ) {
+        if (it->second == p_hash)
+            it = mapDistributionTxids.erase(it);
+        else
+            ++it;
+    }
+    setDistributionsToRetry.erase(p_hash);
+}
+
+std::set<uint256> TakeRewardDistributionsToCheck()
+{
+    std::set<uint256> setDistributions;
+    boost::lock_guard<boost::mutex> lock(csRewardsQueue);
+    setDistributions.swap(setDistributionsToCheck);
+    return setDistributions;
+}
+
+/**
+ * Wakes the rewards thread for the distributions a block affects: those with a transaction in it or
+ * conflicted by it, and those waiting to be retried. Blocks that touch none of them cost a lookup per
+ * transaction, and only while a distribution is being paid out.
+ */
+class CRewardsValidationInterface : public CValidationInterface
+{
+protected:
+    void BlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex, const std::vector<CTransactionRef>& txnConflicted) override
+    {
+        bool fWake = false;
+        {
+            boost::lock_guard<boost::mutex> lock(csRewardsQueue);
+            if (mapDistributionTxids.empty() && setDistributionsToRetry.empty())
+                return;
+
+            for (const std::vector<CTransactionRef>* vtx : {&block->vtx, &txnConflicted}) {
+                for (const CTransactionRef& tx : *vtx) {
+                    auto it = mapDistributionTxids.find(tx->GetHash());
+                    if (it != mapDistributionTxids.end() && setDistributionsToCheck.insert(it->second).second)
+                        fWake = true;
+                }
+            }
+
+            for (const uint256& hash : setDistributionsToRetry) {
+                if (setDistributionsToCheck.insert(hash).second)
+                    fWake = true;
+            }
+            setDistributionsToRetry.clear();
+        }
+        if (fWake)
+            condRewardsQueue.notify_one();
+    }
+};
+
+static CRewardsValidationInterface rewardsValidationInterface;
+
+void RegisterRewardsValidationInterface()
+{
+    RegisterValidationInterface(&rewardsValidationInterface);
+}
+
+void UnregisterRewardsValidationInterface()
+{
+    UnregisterValidationInterface(&rewardsValidationInterface);
+}
+
+//  Marks the rewards thread as running until it exits, however it exits, so that SyncWithRewardsThread() never waits on it in vain
+class CRewardsThreadRunning
+{
+public:
+    ~CRewardsThreadRunning()
+    {
+        {
+            boost::lock_guard<boost::mutex> lock(csRewardsQueue);
+            fRewardsThreadRunning = false;
+            fRewardsThreadBusy = false;
+        }
+        condRewardsIdle.notify_all();
+    }
+};
+
+static void ThreadRewards()
+{
+    CRewardsThreadRunning running;
+
+    try {
+        while (true) {
+            std::set<uint256> setDistributions;
+            {
+                boost::unique_lock<boost::mutex> lock(csRewardsQueue);
+                fRewardsThreadBusy = false;
+                while (queueOwnershipSnapshots.empty() && setDistributionsToCheck.empty()) {
+                    condRewardsIdle.notify_all();
+                    condRewardsQueue.wait(lock);
+                }
+                fRewardsThreadBusy = true;
+                setDistributions.swap(setDistributionsToCheck);
+            }
+
+            //  Snapshots only read their frozen view of the asset DB, so they are taken without cs_main
+            FlushOwnershipSnapshots();
+
+#ifdef ENABLE_WALLET
+            if (!setDistributions.empty()) {
+                LOCK(cs_main);
+                if (vpwallets.size())
+                    CheckRewardDistributions(vpwallets[0], setDistributions);
+            }
+#endif
+            boost::this_thread::interruption_point();
+        }
+    } catch (const boost::thread_interrupted&) {
+        //  The blocks these were taken at are already connected, so finish writing them before exiting
+        FlushOwnershipSnapshots();
+        throw;
+    }
+}
+
+void StartRewardsThread(boost::thread_group& threadGroup)
+{
+    //  Set before the thread starts, so that work queued from here on is waited for
+    {
+        boost::lock_guard<boost::mutex> lock(csRewardsQueue);
+        fRewardsThreadRunning = true;
+    }
+    threadGroup.create_thread(boost::bind(&TraceThread<void (*)()>, "rewards", &ThreadRewards));
+}
+
+void SyncWithRewardsThread()
+{
+    boost::unique_lock<boost::mutex> lock(csRewardsQueue);
+    while (fRewardsThreadRunning && (fRewardsThreadBusy || !queueOwnershipSnapshots.empty() || !setDistributionsToCheck.empty()))
+        condRewardsIdle.wait(lock);
+}
+
 bool GenerateDistributionList(const CRewardSnapshot& p_rewardSnapshot, std::vector<OwnerAndAmount>& vecDistributionList)
 {
     vecDistributionList.clear();
@@ -180,36 +396,39 @@ bool GenerateDistributionList(const CRewardSnapshot& p_rewardSnapshot, std::vect
 
 void DistributeRewardSnapshot(CWallet * p_wallet, const CRewardSnapshot& p_rewardSnapshot)
 {
+    const uint256 hash = p_rewardSnapshot.GetHash();
+
     if (p_wallet->IsLocked()) {
         LogPrint(BCLog::REWARDS, "Skipping distribution: Wallet is locked!\n");
+        RetryRewardDistribution(hash);
         return;
     }
 
     if (IsInitialBlockDownload()) {
         LogPrint(BCLog::REWARDS, "Skipping distribution: Syncing Chain!\n");
+        RetryRewardDistribution(hash);
         return;
     }
 
-    //  Retrieve the asset snapshot entry for the target asset at the specified height
-    CAssetSnapshotDBEntry snapshotEntry;
-
-    if (!pAssetSnapshotDb->RetrieveOwnershipSnapshot(p_rewardSnapshot.strOwnershipAsset, p_rewardSnapshot.nHeight, snapshotEntry)) {
-        LogPrint(BCLog::REWARDS, "Failed to retrieve ownership snapshot!\n");
-        return;
-    }
-
-    //  Generate payment transactions and store in the payments DB
-    std::vector<OwnerAndAmount> paymentDetails;
-    if (!GenerateDistributionList(p_rewardSnapshot, paymentDetails)) {
-        LogPrint(BCLog::REWARDS, "Failed to generate payment details!\n");
-        return;
+    //  Generate the payment list the first time round, it only depends on the ownership snapshot
+    auto listIter = mapDistributionLists.find(hash);
+    if (listIter == mapDistributionLists.end()) {
+        std::vector<OwnerAndAmount> vecDistributionList;
+        if (!GenerateDistributionList(p_rewardSnapshot, vecDistributionList)) {
+            LogPrint(BCLog::REWARDS, "Failed to generate payment details!\n");
+            RetryRewardDistribution(hash);
+            return;
+        }
+        listIter = mapDistributionLists.emplace(hash, std::move(vecDistributionList)).first;
     }
+    const std::vector<OwnerAndAmount>& paymentDetails = listIter->second;
 
     int nNumberOfTransactions = ((int)paymentDetails.size() / MAX_PAYMENTS_PER_TRANSACTION) + 1;
-    CRewardSnapshot copyRewardSnapshot = p_rewardSnapshot;
+    bool fAllConfirmed = true;
     for (int i = 0; i < nNumberOfTransactions; i++) {
         uint256 txid;
-        if (pDistributeSnapshotDb->GetDistributeTransaction(p_rewardSnapshot.GetHash(), i, txid)) {
+        if (pDistributeSnapshotDb->GetDistributeTransaction(hash, i, txid)) {
+            WatchRewardDistributionTransaction(hash, txid);
             CTransactionRef txRef;
             uint256 hashBlock;
             auto walletTx = p_wallet->GetWalletTx(txid);
@@ -227,6 +446,8 @@ void DistributeRewardSnapshot(CWallet * p_wallet, const CRewardSnapshot& p_rewar
                 }
             } else {
                 LogPrint(BCLog::REWARDS, "Failed to get wallet Tx: %s\n", txid.GetHex());
+                RetryRewardDistribution(hash);
+                fAllConfirmed = false;
             }
         } else {
             LogPrint(BCLog::REWARDS, "Didn't find transaction in database creating new transaction: %s %s %d %d\n", p_rewardSnapshot.strOwnershipAsset, p_rewardSnapshot.strDistributionAsset, p_rewardSnapshot.nDistributionAmount, i);
@@ -236,9 +457,26 @@ void DistributeRewardSnapshot(CWallet * p_wallet, const CRewardSnapshot& p_rewar
             std::string change = "";
             if (!BuildTransaction(p_wallet, p_rewardSnapshot, paymentDetails, start, change, retTxid)) {
                 LogPrint(BCLog::REWARDS, "Failed to build Tx: distribute: %s, amount: %d\n", p_rewardSnapshot.strDistributionAsset, p_rewardSnapshot.nDistributionAmount);
+                RetryRewardDistribution(hash);
                 return;
             }
-            pDistributeSnapshotDb->AddDistributeTransaction(p_rewardSnapshot.GetHash(), i, retTxid);
+            pDistributeSnapshotDb->AddDistributeTransaction(hash, i, retTxid);
+            WatchRewardDistributionTransaction(hash, retTxid);
+            fAllConfirmed = false;
+        }
+    }
+
+    //  Every payment is in a block, so stop checking on this distribution
+    if (fAllConfirmed) {
+        CRewardSnapshot completeRewardSnapshot = p_rewardSnapshot;
+        completeRewardSnapshot.nStatus = CRewardSnapshot::COMPLETE;
+        if (pDistributeSnapshotDb->OverrideDistributeSnapshot(hash, completeRewardSnapshot)) {
+            mapRewardSnapshots[hash] = completeRewardSnapshot;
+            mapDistributionLists.erase(hash);
+            UnwatchRewardDistribution(hash);
+            LogPrint(BCLog::REWARDS, "Distribution complete: %s\n", hash.GetHex());
+        } else {
+            RetryRewardDistribution(hash);
         }
     }
 }
@@ -382,10 +620,15 @@ bool BuildTransaction(
     return true;
 }
 
-void CheckRewardDistributions(CWallet * p_wallet)
+void CheckRewardDistributions(CWallet * p_wallet, const std::set<uint256>& p_setDistributions)
 {
-    for (auto item : mapRewardSnapshots) {
-        DistributeRewardSnapshot(p_wallet, item.second);
+    for (const uint256& hash : p_setDistributions) {
+        auto item = mapRewardSnapshots.find(hash);
+        if (item == mapRewardSnapshots.end() || item->second.nStatus == CRewardSnapshot::COMPLETE) {
+            UnwatchRewardDistribution(hash);
+            continue;
+        }
+        DistributeRewardSnapshot(p_wallet, item->second);
     }
 }
 
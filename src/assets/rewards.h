@@ -14,11 +14,18 @@
 #include <map>
 #include <unordered_map>
 #include <list>
+#include <memory>
 
 
 class CRewardSnapshot;
 class CWallet;
 class CRewardSnapshot;
+class CDBSnapshot;
+
+namespace boost
+{
+    class thread_group;
+} // namespace boost
 
 extern std::map<uint256, CRewardSnapshot> mapRewardSnapshots;
 
@@ -149,6 +156,30 @@ enum {
 bool GenerateDistributionList(const CRewardSnapshot& p_rewardSnapshot, std::vector<OwnerAndAmount>& vecDistributionList);
 bool AddDistributeRewardSnapshot(CRewardSnapshot& p_rewardSnapshot);
 
+/**
+ * Ownership snapshots and reward distributions are worked on by the rewards thread, so that connecting a
+ * block only has to freeze a view of the asset database instead of walking every owner of the asset.
+ */
+//  Hand the owners of p_assetName at p_height to the rewards thread; p_view must be a view of the asset DB at that height
+void QueueOwnershipSnapshot(const std::string& p_assetName, int p_height, const std::shared_ptr<CDBSnapshot>& p_view);
+//  Write out any queued ownership snapshots on the calling thread, returning once all of them are in the snapshot DB
+void FlushOwnershipSnapshots();
+//  Have the rewards thread look over the distributions a connected block affects
+void RegisterRewardsValidationInterface();
+void UnregisterRewardsValidationInterface();
+//  Have the rewards thread look the distribution over again once the next block is connected
+void RetryRewardDistribution(const uint256& p_hash);
+//  Have the rewards thread look the distribution over again once p_txid, one of its payments, is connected or conflicted
+void WatchRewardDistributionTransaction(const uint256& p_hash, const uint256& p_txid);
+//  Stop looking the distribution over as blocks are connected
+void UnwatchRewardDistribution(const uint256& p_hash);
+//  Take the distributions the rewards thread was asked to look over, leaving none for it
+std::set<uint256> TakeRewardDistributionsToCheck();
+//  Start the rewards thread in threadGroup, it exits once interrupted
+void StartRewardsThread(boost::thread_group& threadGroup);
+//  Wait until the rewards thread, if it is running, is done with the snapshots and distributions queued so far. Must not be called with cs_main held
+void SyncWithRewardsThread();
+
 #ifdef ENABLE_WALLET
 void DistributeRewardSnapshot(CWallet * p_wallet, const CRewardSnapshot& p_rewardSnapshot);
 
@@ -157,7 +188,7 @@ bool BuildTransaction(
         const std::vector<OwnerAndAmount> & p_pendingPayments, const int& start,
         std::string& change_address, uint256& retTxid);
 
-void CheckRewardDistributions(CWallet * p_wallet);
+void CheckRewardDistributions(CWallet * p_wallet, const std::set<uint256>& p_setDistributions);
 #endif //ENABLE_WALLET
 
 
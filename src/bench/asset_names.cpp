@@ -0,0 +1,71 @@
+// Copyright (c) 2017-2020 The Raven Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "assets/assets.h"
+#include "LibBoolEE.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+// A mix of every asset type, valid and invalid, like the names seen while checking asset transactions
+static const std::vector<std::string> vAssetNames = {
+    "RAVEN_COIN", "ABC/SUB/SUB2", "ABC#UNIQUE_Tag-1", "ABC~CHANNEL", "ABC!", "ABC^VOTE",
+    "#QUALIFIER", "#QUALIFIER/#SUB", "$RESTRICTED", "MAX_ASSET_IS_30_CHARACTERS_LNG",
+    "AB..C", "_ABC", "RVN", "ABC/", "nolower", "#RAVEN"
+};
+
+static void AssetNameValidation(benchmark::State& state)
+{
+    AssetType type;
+    std::string error;
+    while (state.KeepRunning()) {
+        for (const std::string& name : vAssetNames)
+            IsAssetNameValid(name, type, error);
+    }
+}
+
+static void AssetNameClassification(benchmark::State& state)
+{
+    while (state.KeepRunning()) {
+        for (const std::string& name : vAssetNames)
+            ClassifyAssetName(name);
+    }
+}
+
+// A restricted asset verifier, checked against one address the way every transfer of the asset is
+static const std::string strVerifier = "((KYC&!BANNED)|ACCREDITED&US_RESIDENT)|(EXEMPT)";
+
+static void VerifierStringResolve(benchmark::State& state)
+{
+    std::set<std::string> setQualifiers;
+    ExtractVerifierStringQualifiers(strVerifier, setQualifiers);
+    while (state.KeepRunning()) {
+        LibBoolEE::Vals vals;
+        for (const std::string& qualifier : setQualifiers)
+            vals.insert(std::make_pair(qualifier, qualifier == "KYC"));
+        LibBoolEE::resolve(strVerifier, vals);
+    }
+}
+
+static void VerifierStringCompiled(benchmark::State& state)
+{
+    std::set<std::string> setQualifiers;
+    ExtractVerifierStringQualifiers(strVerifier, setQualifiers);
+    std::vector<std::string> vQualifiers(setQualifiers.begin(), setQualifiers.end());
+    LibBoolEE::Formula formula = LibBoolEE::compile(strVerifier, vQualifiers);
+    while (state.KeepRunning()) {
+        std::vector<bool> values(vQualifiers.size());
+        for (size_t i = 0; i < vQualifiers.size(); i++)
+            values[i] = vQualifiers[i] == "KYC";
+        formula.evaluate(values);
+    }
+}
+
+BENCHMARK(AssetNameValidation);
+BENCHMARK(AssetNameClassification);
+BENCHMARK(VerifierStringResolve);
+BENCHMARK(VerifierStringCompiled);
@@ -0,0 +1,83 @@
+// Copyright (c) 2017-2020 The Raven Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "assets/assets.h"
+#include "base58.h"
+#include "chainparams.h"
+#include "primitives/transaction.h"
+
+#include <vector>
+
+// A block's worth of asset transfers, each paying two transfers and RVN change
+static std::vector<CTransactionRef> AssetTransferBlock()
+{
+    CScript scriptRVN = GetScriptForDestination(DecodeDestination(GetParams().GlobalBurnAddress()));
+
+    std::vector<CTransactionRef> vtx;
+    for (int i = 0; i < 500; i++) {
+        CMutableTransaction mtx;
+        mtx.nLockTime = i;
+        for (int j = 0; j < 2; j++) {
+            CScript script = scriptRVN;
+            CAssetTransfer transfer("BENCH_ASSET", (i + 1) * COIN);
+            transfer.ConstructTransaction(script);
+            mtx.vout.emplace_back(CTxOut(0, script));
+        }
+        mtx.vout.emplace_back(CTxOut(COIN, scriptRVN));
+        vtx.push_back(MakeTransactionRef(std::move(mtx)));
+    }
+    return vtx;
+}
+
+// The asset reads connecting a block makes of every output: CheckTransaction and CheckTxAssets read
+// the transfer, AddCoins the asset data, and the address index the address and amount. Each one used to
+// deserialize the script again.
+static void AssetOutputsConnectBlockScripts(benchmark::State& state)
+{
+    std::vector<CTransactionRef> vtx = AssetTransferBlock();
+    while (state.KeepRunning()) {
+        for (const CTransactionRef& tx : vtx) {
+            for (const CTxOut& out : tx->vout) {
+                CAssetTransfer transfer;
+                std::string strAddress;
+                TransferAssetFromScript(out.scriptPubKey, transfer, strAddress);
+                TransferAssetFromScript(out.scriptPubKey, transfer, strAddress);
+                CAssetOutputEntry data;
+                GetAssetData(out.scriptPubKey, data);
+                uint160 hashBytes;
+                std::string strName;
+                CAmount nAmount;
+                ParseAssetScript(out.scriptPubKey, hashBytes, strName, nAmount);
+            }
+        }
+    }
+}
+
+// The same reads served from the transaction's parsed asset outputs, parsed once per transaction
+static void AssetOutputsConnectBlockParsed(benchmark::State& state)
+{
+    std::vector<CTransactionRef> vtx = AssetTransferBlock();
+    while (state.KeepRunning()) {
+        for (const CTransactionRef& tx : vtx) {
+            tx->assetOutputs.Clear();
+            for (unsigned int n = 0; n < tx->vout.size(); n++) {
+                CAssetTransfer transfer;
+                std::string strAddress;
+                TransferAssetFromTransaction(*tx, n, transfer, strAddress);
+                TransferAssetFromTransaction(*tx, n, transfer, strAddress);
+                CAssetOutputEntry data;
+                GetAssetData(*tx, n, data);
+                uint160 hashBytes;
+                std::string strName;
+                CAmount nAmount;
+                ParseAssetScript(*tx, n, hashBytes, strName, nAmount);
+            }
+        }
+    }
+}
+
+BENCHMARK(AssetOutputsConnectBlockScripts);
+BENCHMARK(AssetOutputsConnectBlockParsed);
@@ -4,7 +4,9 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "bench.h"
+#include "coins.h"
 #include "policy/policy.h"
+#include "random.h"
 #include "txmempool.h"
 
 #include <list>
@@ -112,4 +114,77 @@ static void MempoolEviction(benchmark::State& state)
     }
 }
 
+// Accepting and evicting transactions between a small set of addresses, maintaining the mempool address
+// and spent indexes as is done with -addressindex and -spentindex
+static void MempoolAddressIndex(benchmark::State& state)
+{
+    FastRandomContext rand(true);
+    std::vector<CScript> vScripts;
+    for (int i = 0; i < 100; i++) {
+        uint256 hash = rand.rand256();
+        vScripts.push_back(CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(hash.begin(), hash.begin() + 20) << OP_EQUALVERIFY << OP_CHECKSIG);
+    }
+
+    CCoinsView base;
+    CCoinsViewCache view(&base);
+    std::vector<CTransactionRef> vTxs;
+    for (int i = 0; i < 1000; i++) {
+        CMutableTransaction tx;
+        tx.vin.resize(2);
+        tx.vout.resize(2);
+        for (int j = 0; j < 2; j++) {
+            tx.vin[j].prevout = COutPoint(rand.rand256(), j);
+            view.AddCoin(tx.vin[j].prevout, Coin(CTxOut(10 * COIN, vScripts[rand.randrange(vScripts.size())]), 1, false), false);
+            tx.vout[j] = CTxOut(9 * COIN, vScripts[rand.randrange(vScripts.size())]);
+        }
+        vTxs.push_back(MakeTransactionRef(tx));
+    }
+
+    CTxMemPool pool;
+    LockPoints lp;
+    while (state.KeepRunning()) {
+        for (const CTransactionRef& tx : vTxs) {
+            CTxMemPoolEntry entry(tx, 10000LL, 0, 1, false, 4, lp);
+            pool.addUnchecked(tx->GetHash(), entry);
+            pool.addAddressIndex(entry, view);
+            pool.addSpentIndex(entry, view);
+        }
+        pool.TrimToSize(0);
+    }
+}
+
+// Indexing and then removing a block's worth of transactions that all spend from and pay to one address, as
+// the transactions of an exchange's hot wallet do
+static void MempoolAddressIndexBusyAddress(benchmark::State& state)
+{
+    FastRandomContext rand(true);
+    uint256 hashHot = rand.rand256();
+    CScript scriptHot = CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(hashHot.begin(), hashHot.begin() + 20) << OP_EQUALVERIFY << OP_CHECKSIG;
+
+    CCoinsView base;
+    CCoinsViewCache view(&base);
+    std::vector<CTxMemPoolEntry> vEntries;
+    LockPoints lp;
+    for (int i = 0; i < 2000; i++) {
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].prevout = COutPoint(rand.rand256(), 0);
+        view.AddCoin(tx.vin[0].prevout, Coin(CTxOut(10 * COIN, scriptHot), 1, false), false);
+        uint256 hash = rand.rand256();
+        tx.vout.push_back(CTxOut(COIN, CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(hash.begin(), hash.begin() + 20) << OP_EQUALVERIFY << OP_CHECKSIG));
+        tx.vout.push_back(CTxOut(8 * COIN, scriptHot));
+        vEntries.push_back(CTxMemPoolEntry(MakeTransactionRef(tx), 10000LL, 0, 1, false, 4, lp));
+    }
+
+    CTxMemPool pool;
+    while (state.KeepRunning()) {
+        for (const CTxMemPoolEntry& entry : vEntries)
+            pool.addAddressIndex(entry, view);
+        for (const CTxMemPoolEntry& entry : vEntries)
+            pool.removeAddressIndex(entry.GetTx().GetHash());
+    }
+}
+
 BENCHMARK(MempoolEviction);
+BENCHMARK(MempoolAddressIndex);
+BENCHMARK(MempoolAddressIndexBusyAddress);
@@ -0,0 +1,234 @@
+// Copyright (c) 2017-2020 The Raven Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "hash.h"
+#include "primitives/block.h"
+#include "uint256.h"
+
+#include <crypto/ethash/include/ethash/ethash.hpp>
+
+#include <vector>
+
+// Header times inside each PoW era on mainnet, the network bench_raven selects
+static const uint32_t X16R_ERA_TIME = 1546300800;    // Tue Jan 01 2019
+static const uint32_t X16RV2_ERA_TIME = 1577836800;  // Wed Jan 01 2020
+static const uint32_t KAWPOW_ERA_TIME = 1609459200;  // Fri Jan 01 2021
+static const uint32_t KAWPOW_ERA_HEIGHT = 1500000;
+
+/**
+ * Previous block hashes whose last 16 nibbles are rotations of 0..f, so that every one of the
+ * sixteen X16R/X16RV2 rounds runs each algorithm exactly once, in a different order per hash.
+ */
+static std::vector<uint256> X16PrevBlockHashes()
+{
+    static const std::string strNibbles = "0123456789abcdef";
+    std::vector<uint256> hashes;
+    for (size_t i = 0; i < strNibbles.size(); i++) {
+        std::string strOrder = strNibbles.substr(i) + strNibbles.substr(0, i);
+        hashes.push_back(uint256S(std::string(48, '7') + strOrder));
+    }
+    return hashes;
+}
+
+static CBlockHeader EraHeader(uint32_t nTime)
+{
+    CBlockHeader header;
+    header.nVersion = 0x20000000;
+    header.hashMerkleRoot = uint256S("0x6b86b273ff34fce19d6b804eff5a3f5747ada4eaa22f1d49c01e52ddb7875b4b");
+    header.nTime = nTime;
+    header.nBits = 0x1b01ffff;
+    header.nNonce = 0;
+    header.nHeight = KAWPOW_ERA_HEIGHT;
+    header.nNonce64 = 0;
+    return header;
+}
+
+// The single 512 bit primitives, on the 64 byte input every round after the first one hashes
+#define BENCH_SPH(name, context)                                            \
+    static void SPH_##name(benchmark::State& state)                         \
+    {                                                                       \
+        unsigned char data[64] = {0};                                       \
+        context ctx;                                                        \
+        while (state.KeepRunning()) {                                       \
+            sph_##name##_init(&ctx);                                        \
+            sph_##name(&ctx, data, sizeof(data));                           \
+            sph_##name##_close(&ctx, data);                                 \
+        }                                                                   \
+    }                                                                       \
+    BENCHMARK(SPH_##name);
+
+BENCH_SPH(blake512, sph_blake512_context)
+BENCH_SPH(bmw512, sph_bmw512_context)
+BENCH_SPH(groestl512, sph_groestl512_context)
+BENCH_SPH(jh512, sph_jh512_context)
+BENCH_SPH(keccak512, sph_keccak512_context)
+BENCH_SPH(skein512, sph_skein512_context)
+BENCH_SPH(luffa512, sph_luffa512_context)
+BENCH_SPH(cubehash512, sph_cubehash512_context)
+BENCH_SPH(shavite512, sph_shavite512_context)
+BENCH_SPH(simd512, sph_simd512_context)
+BENCH_SPH(echo512, sph_echo512_context)
+BENCH_SPH(hamsi512, sph_hamsi512_context)
+BENCH_SPH(fugue512, sph_fugue512_context)
+BENCH_SPH(shabal512, sph_shabal512_context)
+BENCH_SPH(whirlpool, sph_whirlpool_context)
+BENCH_SPH(sha512, sph_sha512_context)
+
+// X16RV2 runs tiger in front of keccak, luffa and sha512
+static void SPH_tiger(benchmark::State& state)
+{
+    unsigned char data[64] = {0};
+    sph_tiger_context ctx;
+    while (state.KeepRunning()) {
+        sph_tiger_init(&ctx);
+        sph_tiger(&ctx, data, sizeof(data));
+        sph_tiger_close(&ctx, data);
+    }
+}
+
+static void X16RHash(benchmark::State& state)
+{
+    CBlockHeader header = EraHeader(X16R_ERA_TIME);
+    std::vector<uint256> vPrevHashes = X16PrevBlockHashes();
+    size_t i = 0;
+    while (state.KeepRunning()) {
+        header.hashPrevBlock = vPrevHashes[i++ % vPrevHashes.size()];
+        header.GetX16RHash();
+    }
+}
+
+static void X16RV2Hash(benchmark::State& state)
+{
+    CBlockHeader header = EraHeader(X16RV2_ERA_TIME);
+    std::vector<uint256> vPrevHashes = X16PrevBlockHashes();
+    size_t i = 0;
+    while (state.KeepRunning()) {
+        header.hashPrevBlock = vPrevHashes[i++ % vPrevHashes.size()];
+        header.GetX16RV2Hash();
+    }
+}
+
+// KAWPOW without the DAG: checks a header against its claimed mix hash, what GetHash() does
+static void KAWPOWHashOnlyMix(benchmark::State& state)
+{
+    CBlockHeader header = EraHeader(KAWPOW_ERA_TIME);
+    while (state.KeepRunning()) {
+        header.nNonce64++;
+        KAWPOWHash_OnlyMix(header);
+    }
+}
+
+// KAWPOW with the light cache of the header's epoch, as used when validating the mix hash
+static void KAWPOWHashFull(benchmark::State& state)
+{
+    CBlockHeader header = EraHeader(KAWPOW_ERA_TIME);
+    uint256 mix_hash;
+    KAWPOWHash(header, mix_hash); // Build the epoch context outside of the timed loop
+    while (state.KeepRunning()) {
+        header.nNonce64++;
+        KAWPOWHash(header, mix_hash);
+    }
+}
+
+// Full header hashing through CBlockHeader::GetHash(), once for every PoW era
+static void BlockHeaderHashX16R(benchmark::State& state)
+{
+    CBlockHeader header = EraHeader(X16R_ERA_TIME);
+    while (state.KeepRunning()) {
+        header.nNonce++;
+        header.GetHash();
+    }
+}
+
+static void BlockHeaderHashX16RV2(benchmark::State& state)
+{
+    CBlockHeader header = EraHeader(X16RV2_ERA_TIME);
+    while (state.KeepRunning()) {
+        header.nNonce++;
+        header.GetHash();
+    }
+}
+
+static void BlockHeaderHashKAWPOW(benchmark::State& state)
+{
+    CBlockHeader header = EraHeader(KAWPOW_ERA_TIME);
+    while (state.KeepRunning()) {
+        header.nNonce64++;
+        header.GetHash();
+    }
+}
+
+// Header sync: hashing a run of consecutive KAWPOW headers, as done for every headers message
+static void KAWPOWHeaderSync(benchmark::State& state)
+{
+    std::vector<CBlockHeader> vHeaders;
+    for (uint32_t i = 0; i < 2000; i++) {
+        CBlockHeader header = EraHeader(KAWPOW_ERA_TIME + i * 60);
+        header.nHeight = KAWPOW_ERA_HEIGHT + i;
+        header.nNonce64 = i;
+        header.mix_hash = SerializeHash(header);
+        vHeaders.push_back(header);
+    }
+
+    while (state.KeepRunning()) {
+        for (const CBlockHeader& header : vHeaders) {
+            header.hashCache.Clear();
+            header.GetHash();
+        }
+    }
+}
+
+// The repeated GetHash() calls made on one received block once its hash has been memoized
+static void BlockHeaderHashCached(benchmark::State& state)
+{
+    CBlock block;
+    static_cast<CBlockHeader&>(block) = EraHeader(KAWPOW_ERA_TIME);
+    block.GetHash();
+    while (state.KeepRunning()) {
+        block.GetHash();
+    }
+}
+
+// The uint256 <-> ethash::hash256 conversions KAWPOW verification does three of per header,
+// through hex strings as it used to and byte for byte as it does now
+static void KAWPOWHashConversionHex(benchmark::State& state)
+{
+    uint256 hash = uint256S("0x6b86b273ff34fce19d6b804eff5a3f5747ada4eaa22f1d49c01e52ddb7875b4b");
+    while (state.KeepRunning()) {
+        hash = uint256S(to_hex(to_hash256(hash.GetHex())));
+    }
+}
+
+static void KAWPOWHashConversionBytes(benchmark::State& state)
+{
+    uint256 hash = uint256S("0x6b86b273ff34fce19d6b804eff5a3f5747ada4eaa22f1d49c01e52ddb7875b4b");
+    while (state.KeepRunning()) {
+        hash = to_uint256(to_hash256(hash));
+    }
+}
+
+// Building the light cache for a new epoch, paid once every 7500 blocks and on every restart
+static void EthashEpochContextCreate(benchmark::State& state)
+{
+    const int epoch_number = ethash::get_epoch_number(KAWPOW_ERA_HEIGHT);
+    while (state.KeepRunning()) {
+        ethash::create_epoch_context(epoch_number);
+    }
+}
+
+BENCHMARK(SPH_tiger);
+BENCHMARK(X16RHash);
+BENCHMARK(X16RV2Hash);
+BENCHMARK(KAWPOWHashOnlyMix);
+BENCHMARK(KAWPOWHashFull);
+BENCHMARK(BlockHeaderHashX16R);
+BENCHMARK(BlockHeaderHashX16RV2);
+BENCHMARK(BlockHeaderHashKAWPOW);
+BENCHMARK(KAWPOWHeaderSync);
+BENCHMARK(BlockHeaderHashCached);
+BENCHMARK(KAWPOWHashConversionHex);
+BENCHMARK(KAWPOWHashConversionBytes);
+BENCHMARK(EthashEpochContextCreate);
@@ -263,7 +263,7 @@ void AddCoins(CCoinsViewCache& cache, const CTransaction &tx, int nHeight, uint2
         if (AreAssetsDeployed()) {
             if (assetsCache) {
                 CAssetOutputEntry assetData;
-                if (GetAssetData(tx.vout[i].scriptPubKey, assetData)) {
+                if (GetAssetData(tx, i, assetData)) {
 
                     // If this is a transfer asset, and the amount is greater than zero
                     // We want to make sure it is added to the asset addresses database if (fAssetIndex == true)
@@ -186,8 +186,9 @@ bool CheckTransaction(const CTransaction& tx, CValidationState &state, bool fChe
     bool fContainsRestrictedAssetReissue = false;
     bool fContainsNullAssetVerifierTx = false;
     int nCountAddTagOuts = 0;
-    for (const auto& txout : tx.vout)
+    for (unsigned int n = 0; n < tx.vout.size(); n++)
     {
+        const CTxOut& txout = tx.vout[n];
         if (txout.nValue < 0)
             return state.DoS(100, false, REJECT_INVALID, "bad-txns-vout-negative");
         if (txout.nValue > MAX_MONEY)
@@ -266,7 +267,7 @@ bool CheckTransaction(const CTransaction& tx, CValidationState &state, bool fChe
             if (nType == TX_TRANSFER_ASSET) {
                 CAssetTransfer transfer;
                 std::string address;
-                if (!TransferAssetFromScript(txout.scriptPubKey, transfer, address))
+                if (!TransferAssetFromTransaction(tx, n, transfer, address))
                     return state.DoS(100, false, REJECT_INVALID, "bad-txns-transfer-asset-bad-deserialize");
 
                 // insert into set, so that later on we can check asset null data transactions
@@ -604,7 +605,7 @@ bool Consensus::CheckTxInputs(const CTransaction& tx, CValidationState& state, c
 }
 
 //! Check to make sure that the inputs and outputs CAmount match exactly.
-bool Consensus::CheckTxAssets(const CTransaction& tx, CValidationState& state, const CCoinsViewCache& inputs, CAssetsCache* assetCache, bool fCheckMempool, std::vector<std::pair<std::string, uint256> >& vPairReissueAssets, const bool fRunningUnitTests, std::set<CMessage>* setMessages, int64_t nBlocktime,   std::vector<std::pair<std::string, CNullAssetTxData>>* myNullAssetData)
+bool Consensus::CheckTxAssets(const CTransaction& tx, CValidationState& state, const CCoinsViewCache& inputs, CAssetsCache* assetCache, bool fCheckMempool, std::vector<std::pair<std::string, uint256> >& vPairReissueAssets, const bool fRunningUnitTests, std::set<CMessage>* setMessages, int64_t nBlocktime,   std::vector<std::pair<std::string, CNullAssetTxData>>* myNullAssetData, std::vector<CAssetCheck>* pvChecks)
 {
     // are the actual inputs available?
     if (!inputs.HaveInputs(tx)) {
@@ -686,11 +687,17 @@ bool Consensus::CheckTxAssets(const CTransaction& tx, CValidationState& state, c
         if (nType == TX_TRANSFER_ASSET) {
             CAssetTransfer transfer;
             std::string address = "";
-            if (!TransferAssetFromScript(txout.scriptPubKey, transfer, address))
+            if (!TransferAssetFromTransaction(tx, index, transfer, address))
                 return state.DoS(100, false, REJECT_INVALID, "bad-tx-asset-transfer-bad-deserialize", false, "", tx.GetHash());
 
-            if (!ContextualCheckTransferAsset(assetCache, transfer, address, strError))
+            if (pvChecks) {
+                // Leave the checks that don't need the asset cache to the script check threads
+                pvChecks->emplace_back(transfer, tx, AreMessagesDeployed(), AreRestrictedAssetsDeployed());
+                if (!ContextualCheckTransferAssetRestrictions(assetCache, transfer, address, strError))
+                    return state.DoS(100, false, REJECT_INVALID, strError, false, "", tx.GetHash());
+            } else if (!ContextualCheckTransferAsset(assetCache, transfer, address, strError)) {
                 return state.DoS(100, false, REJECT_INVALID, strError, false, "", tx.GetHash());
+            }
 
             // Add to the total value of assets in the outputs
             if (totalOutputs.count(transfer.strName))
@@ -22,6 +22,7 @@ class CTxOut;
 class uint256;
 class CMessage;
 class CNullAssetTxData;
+class CAssetCheck;
 
 /** Transaction validation functions */
 
@@ -38,7 +39,12 @@ namespace Consensus {
 bool CheckTxInputs(const CTransaction& tx, CValidationState& state, const CCoinsViewCache& inputs, int nSpendHeight, CAmount& txfee);
 
 /** RVN START */
-bool CheckTxAssets(const CTransaction& tx, CValidationState& state, const CCoinsViewCache& inputs, CAssetsCache* assetCache, bool fCheckMempool, std::vector<std::pair<std::string, uint256> >& vPairReissueAssets, const bool fRunningUnitTests = false, std::set<CMessage>* setMessages = nullptr, int64_t nBlocktime = 0,  std::vector<std::pair<std::string, CNullAssetTxData>>* myNullAssetData = nullptr);
+/**
+ * Check the asset inputs and outputs of this transaction against the asset cache.
+ * If pvChecks is not nullptr, the transfer checks that don't read the asset cache are appended
+ * to it instead of being run.
+ */
+bool CheckTxAssets(const CTransaction& tx, CValidationState& state, const CCoinsViewCache& inputs, CAssetsCache* assetCache, bool fCheckMempool, std::vector<std::pair<std::string, uint256> >& vPairReissueAssets, const bool fRunningUnitTests = false, std::set<CMessage>* setMessages = nullptr, int64_t nBlocktime = 0,  std::vector<std::pair<std::string, CNullAssetTxData>>* myNullAssetData = nullptr, std::vector<CAssetCheck>* pvChecks = nullptr);
 /** RVN END */
 } // namespace Consensus
 
@@ -145,6 +145,37 @@ public:
 
     void Next();
 
+    void SeekToLast();
+
+    void Prev();
+
+    /**
+     * Position the iterator on the last entry whose serialized key starts with
+     * the serialized form of prefix. If no such entry exists the iterator is left
+     * on the closest preceding entry (or invalid), so callers must still check the key.
+     */
+    template<typename K> void SeekToLastWithPrefix(const K& prefix) {
+        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+        ssKey.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
+        ssKey << prefix;
+        std::string strKey(ssKey.begin(), ssKey.end());
+
+        // Smallest key that sorts after every key carrying this prefix
+        while (!strKey.empty() && (unsigned char)strKey.back() == 0xff)
+            strKey.pop_back();
+        if (strKey.empty()) {
+            piter->SeekToLast();
+            return;
+        }
+        strKey.back() = (char)((unsigned char)strKey.back() + 1);
+
+        piter->Seek(leveldb::Slice(strKey));
+        if (piter->Valid())
+            piter->Prev();
+        else
+            piter->SeekToLast();
+    }
+
     template<typename K> bool GetKey(K& key) {
         leveldb::Slice slKey = piter->key();
         try {
@@ -177,6 +208,7 @@ public:
 class CDBWrapper
 {
     friend const std::vector<unsigned char>& dbwrapper_private::GetObfuscateKey(const CDBWrapper &w);
+    friend class CDBSnapshot;
 private:
     //! custom environment this database is using (may be nullptr in case of default environment)
     leveldb::Env* penv;
@@ -210,6 +242,14 @@ private:
 
     std::vector<unsigned char> CreateObfuscateKey() const;
 
+    //! iterate over the database as it was when the snapshot was taken, see CDBSnapshot
+    CDBIterator *NewIterator(const leveldb::Snapshot *psnapshot)
+    {
+        leveldb::ReadOptions snapshotoptions = iteroptions;
+        snapshotoptions.snapshot = psnapshot;
+        return new CDBIterator(*this, pdb->NewIterator(snapshotoptions));
+    }
+
 public:
     /**
      * @param[in] path        Location in the filesystem where leveldb data will be stored.
@@ -341,4 +381,25 @@ public:
 
 };
 
+/**
+ * A read only view of a database frozen at the moment it was constructed, for reading a consistent state
+ * on another thread while the database keeps being written to. Released on destruction, which must happen
+ * before the database itself is destroyed.
+ */
+class CDBSnapshot
+{
+private:
+    CDBWrapper &parent;
+    const leveldb::Snapshot *psnapshot;
+
+public:
+    explicit CDBSnapshot(CDBWrapper &_parent) : parent(_parent), psnapshot(_parent.pdb->GetSnapshot()) { };
+    ~CDBSnapshot() { parent.pdb->ReleaseSnapshot(psnapshot); }
+
+    CDBSnapshot(const CDBSnapshot&) = delete;
+    CDBSnapshot& operator=(const CDBSnapshot&) = delete;
+
+    CDBIterator *NewIterator() { return parent.NewIterator(psnapshot); }
+};
+
 #endif // RAVEN_DBWRAPPER_H
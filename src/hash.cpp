@@ -12,6 +12,12 @@
 
 #include <crypto/ethash/include/ethash/progpow.hpp>
 
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <set>
+#include <thread>
+
 //TODO remove these
 double algoHashTotal[16];
 int algoHashHits[16];
@@ -255,38 +261,215 @@ uint64_t SipHashUint256Extra(uint64_t k0, uint64_t k1, const uint256& val, uint3
     return v0 ^ v1 ^ v2 ^ v3;
 }
 
-uint256 KAWPOWHash(const CBlockHeader& blockHeader, uint256& mix_hash)
+/**
+ * Light ethash epoch contexts take a good fraction of a second to build and hold 16MB or more each,
+ * so the ones in use are kept in a small LRU shared by every KAWPOW caller (block validation, the
+ * miner and the mining RPCs). Lookups are safe from any thread; a context is built outside of the
+ * lock, and callers asking for an epoch that is already being built wait for it instead of building
+ * it a second time. When prebuilding is enabled the next epoch's context is built on a background
+ * thread as the chain gets close to an epoch boundary.
+ */
+class CEthashContextCache
 {
-    static ethash::epoch_context_ptr context{nullptr, nullptr};
+private:
+    std::mutex cs;
+    std::condition_variable cvBuilt;
+    std::list<std::shared_ptr<const ethash::epoch_context>> listContexts; // most recently used first
+    std::set<int> setBuilding;
+    size_t nMaxSize;
+    bool fPrebuild;
+    std::thread threadPrebuild;
+    bool fPrebuildRunning;
+    EthashContextCacheStats stats;
+
+    //! Add a freshly built context and drop the least recently used ones over the limit. Requires cs.
+    void Insert(const std::shared_ptr<const ethash::epoch_context>& context)
+    {
+        listContexts.push_front(context);
+        while (listContexts.size() > nMaxSize) {
+            listContexts.pop_back();
+            stats.evictions++;
+        }
+    }
 
-    // Get the context from the block height
-    const auto epoch_number = ethash::get_epoch_number(blockHeader.nHeight);
+    std::shared_ptr<const ethash::epoch_context> Build(int epoch_number)
+    {
+        int64_t nTimeStart = GetTimeMicros();
+        std::shared_ptr<const ethash::epoch_context> context = ethash::create_epoch_context(epoch_number);
+        LogPrint(BCLog::BENCH, "%s: built ethash epoch %d context in %.2fms\n", __func__, epoch_number, (GetTimeMicros() - nTimeStart) * 0.001);
+        return context;
+    }
+
+public:
+    CEthashContextCache() : nMaxSize(DEFAULT_ETHASH_CONTEXT_CACHE_SIZE), fPrebuild(false), fPrebuildRunning(false) {}
+
+    ~CEthashContextCache()
+    {
+        Stop();
+    }
+
+    //! Stop prebuilding, and wait for a prebuild that is under way to finish
+    void Stop()
+    {
+        std::thread thread;
+        {
+            std::lock_guard<std::mutex> lock(cs);
+            fPrebuild = false;
+            thread.swap(threadPrebuild);
+        }
+        if (thread.joinable())
+            thread.join();
+    }
 
-    if (!context || context->epoch_number != epoch_number)
-        context = ethash::create_epoch_context(epoch_number);
+    void Configure(size_t nMaxSizeIn, bool fPrebuildIn)
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        nMaxSize = std::max(nMaxSizeIn, (size_t)1);
+        fPrebuild = fPrebuildIn;
+        while (listContexts.size() > nMaxSize) {
+            listContexts.pop_back();
+            stats.evictions++;
+        }
+    }
+
+    std::shared_ptr<const ethash::epoch_context> Get(int epoch_number)
+    {
+        std::unique_lock<std::mutex> lock(cs);
+        while (true) {
+            for (auto it = listContexts.begin(); it != listContexts.end(); ++it) {
+                if ((*it)->epoch_number == epoch_number) {
+                    listContexts.splice(listContexts.begin(), listContexts, it);
+                    stats.hits++;
+                    return listContexts.front();
+                }
+            }
+
+            if (!setBuilding.count(epoch_number))
+                break;
+
+            cvBuilt.wait(lock);
+        }
+
+        stats.misses++;
+        setBuilding.insert(epoch_number);
+        lock.unlock();
+
+        std::shared_ptr<const ethash::epoch_context> context = Build(epoch_number);
+
+        lock.lock();
+        setBuilding.erase(epoch_number);
+        if (context)
+            Insert(context);
+        cvBuilt.notify_all();
+
+        return context;
+    }
+
+    void Prebuild(int epoch_number)
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        if (!fPrebuild || fPrebuildRunning || setBuilding.count(epoch_number))
+            return;
+
+        for (const auto& context : listContexts) {
+            if (context->epoch_number == epoch_number)
+                return;
+        }
+
+        // The previous prebuild has finished, so this doesn't block
+        if (threadPrebuild.joinable())
+            threadPrebuild.join();
+
+        fPrebuildRunning = true;
+        setBuilding.insert(epoch_number);
+        threadPrebuild = std::thread([this, epoch_number]() {
+            RenameThread("raven-ethash");
+            std::shared_ptr<const ethash::epoch_context> context = Build(epoch_number);
+
+            std::lock_guard<std::mutex> lock(cs);
+            setBuilding.erase(epoch_number);
+            if (context) {
+                // Keep it behind the contexts in use, it is only needed once the chain gets there
+                listContexts.push_back(context);
+                if (listContexts.size() > nMaxSize) {
+                    listContexts.pop_back();
+                    stats.evictions++;
+                } else {
+                    stats.prebuilt++;
+                }
+            }
+            fPrebuildRunning = false;
+            cvBuilt.notify_all();
+        });
+    }
+
+    EthashContextCacheStats GetStats()
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        EthashContextCacheStats ret = stats;
+        ret.size = listContexts.size();
+        ret.capacity = nMaxSize;
+        ret.memory = 0;
+        for (const auto& context : listContexts)
+            ret.memory += ethash::get_light_cache_size(context->light_cache_num_items);
+        return ret;
+    }
+};
+
+static CEthashContextCache ethashContextCache;
+
+void InitEthashContextCache(size_t nMaxSize, bool fPrebuild)
+{
+    ethashContextCache.Configure(nMaxSize, fPrebuild);
+}
+
+std::shared_ptr<const ethash::epoch_context> GetEthashEpochContext(int block_number)
+{
+    const int epoch_number = ethash::get_epoch_number(block_number);
+    auto context = ethashContextCache.Get(epoch_number);
+
+    // Get the next epoch ready before the chain crosses into it
+    if (block_number % ethash::epoch_length >= ethash::epoch_length - ETHASH_PREBUILD_BLOCKS)
+        ethashContextCache.Prebuild(epoch_number + 1);
+
+    return context;
+}
+
+void StopEthashContextCache()
+{
+    ethashContextCache.Stop();
+}
+
+EthashContextCacheStats GetEthashContextCacheStats()
+{
+    return ethashContextCache.GetStats();
+}
+
+uint256 KAWPOWHash(const CBlockHeader& blockHeader, uint256& mix_hash)
+{
+    // Get the context from the block height
+    const auto context = GetEthashEpochContext(blockHeader.nHeight);
 
     // Build the header_hash
-    uint256 nHeaderHash = blockHeader.GetKAWPOWHeaderHash();
-    const auto header_hash = to_hash256(nHeaderHash.GetHex());
+    const auto header_hash = to_hash256(blockHeader.GetKAWPOWHeaderHash());
 
     // ProgPow hash
     const auto result = progpow::hash(*context, blockHeader.nHeight, header_hash, blockHeader.nNonce64);
 
-    mix_hash = uint256S(to_hex(result.mix_hash));
-    return uint256S(to_hex(result.final_hash));
+    mix_hash = to_uint256(result.mix_hash);
+    return to_uint256(result.final_hash);
 }
 
 
 uint256 KAWPOWHash_OnlyMix(const CBlockHeader& blockHeader)
 {
     // Build the header_hash
-    uint256 nHeaderHash = blockHeader.GetKAWPOWHeaderHash();
-    const auto header_hash = to_hash256(nHeaderHash.GetHex());
+    const auto header_hash = to_hash256(blockHeader.GetKAWPOWHeaderHash());
 
     // ProgPow hash
-    const auto result = progpow::hash_no_verify(blockHeader.nHeight, header_hash, to_hash256(blockHeader.mix_hash.GetHex()), blockHeader.nNonce64);
+    const auto result = progpow::hash_no_verify(blockHeader.nHeight, header_hash, to_hash256(blockHeader.mix_hash), blockHeader.nNonce64);
 
-    return uint256S(to_hex(result));
+    return to_uint256(result);
 }
 
 
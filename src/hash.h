@@ -39,6 +39,8 @@
 
 #include <crypto/ethash/helpers.hpp>
 
+#include <algorithm>
+#include <memory>
 #include <vector>
 
 class CBlockHeader;
@@ -605,9 +607,57 @@ inline uint256 HashX16RV2(const T1 pbegin, const T1 pend, const uint256 PrevBloc
     return hash[15].trim256();
 }
 
+/** Default for -ethashcachesize, the number of ethash epoch contexts kept for KAWPOW verification */
+static const unsigned int DEFAULT_ETHASH_CONTEXT_CACHE_SIZE = 3;
+/** Default for -ethashprebuild */
+static const bool DEFAULT_ETHASH_PREBUILD = true;
+/** Start building the next epoch's context this many blocks before the epoch boundary */
+static const int ETHASH_PREBUILD_BLOCKS = 100;
+
+struct EthashContextCacheStats
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t prebuilt = 0;
+    uint64_t evictions = 0;
+    size_t size = 0;
+    size_t capacity = 0;
+    size_t memory = 0;
+};
+
+/** Set how many epoch contexts are kept, and whether the next one is built in the background */
+void InitEthashContextCache(size_t nMaxSize, bool fPrebuild);
+
+/** Stop building epoch contexts in the background, waiting for one under way. Called on shutdown. */
+void StopEthashContextCache();
+
+/** Get the light epoch context for the epoch of a block height, from the shared cache */
+std::shared_ptr<const ethash::epoch_context> GetEthashEpochContext(int block_number);
+
+EthashContextCacheStats GetEthashContextCacheStats();
+
 uint256 KAWPOWHash(const CBlockHeader& blockHeader, uint256& mix_hash);
 uint256 KAWPOWHash_OnlyMix(const CBlockHeader& blockHeader);
 
+/**
+ * Convert between uint256 and ethash::hash256 without going through hex strings.
+ * ethash keeps its bytes in the order uint256::GetHex() prints them, so these reverse the bytes,
+ * giving the same result as to_hash256(hash.GetHex()) and uint256S(to_hex(hash)).
+ */
+inline ethash::hash256 to_hash256(const uint256& hash)
+{
+    ethash::hash256 result;
+    std::reverse_copy(hash.begin(), hash.end(), result.bytes);
+    return result;
+}
+
+inline uint256 to_uint256(const ethash::hash256& hash)
+{
+    uint256 result;
+    std::reverse_copy(hash.bytes, hash.bytes + sizeof(hash.bytes), result.begin());
+    return result;
+}
+
 
 #endif // RAVEN_HASH_H
 
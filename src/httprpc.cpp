@@ -143,6 +143,69 @@ static bool RPCAuthorized(const std::string& strAuth, std::string& strAuthUserna
     return multiUserAuthorized(strUserPass);
 }
 
+/** Bytes of a streamed result gathered before they're sent on as one chunk */
+static const size_t RPC_STREAM_CHUNK_SIZE = 64 * 1024;
+
+/** Streams a result array as the body of a chunked reply, wrapped in the same object JSONRPCReply() makes */
+class HTTPRPCResultStream : public RPCResultStream
+{
+private:
+    HTTPRequest* req;
+    std::string strBuffer;
+    bool fStarted;
+    bool fFirst;
+
+    void Flush()
+    {
+        if (!strBuffer.empty()) {
+            req->WriteReplyChunk(strBuffer);
+            strBuffer.clear();
+        }
+    }
+
+public:
+    explicit HTTPRPCResultStream(HTTPRequest* reqIn) : req(reqIn), fStarted(false), fFirst(true) {}
+
+    bool Started() const { return fStarted; }
+
+    void BeginArray() override
+    {
+        assert(!fStarted);
+        req->WriteHeader("Content-Type", "application/json");
+        req->StartChunkedReply(HTTP_OK);
+        fStarted = true;
+        strBuffer = "{\"result\":[";
+    }
+
+    void Write(const UniValue& value) override
+    {
+        if (!fFirst)
+            strBuffer += ",";
+        fFirst = false;
+        strBuffer += value.write();
+        if (strBuffer.size() >= RPC_STREAM_CHUNK_SIZE)
+            Flush();
+    }
+
+    void EndArray() override
+    {
+        strBuffer += "]";
+    }
+
+    void Finish(const UniValue& id)
+    {
+        strBuffer += ",\"error\":null,\"id\":" + id.write() + "}\n";
+        Flush();
+        req->EndChunkedReply();
+    }
+
+    /** Errors can't be reported once the result started, so the client just gets the reply cut short */
+    void Abort()
+    {
+        req->EndChunkedReply();
+    }
+};
+
 static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
 {
     // JSONRPC handles only POST
@@ -172,6 +235,7 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
         return false;
     }
 
+    HTTPRPCResultStream resultStream(req);
     try {
         // Parse request
         UniValue valRequest;
@@ -185,9 +249,16 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
         // singleton request
         if (valRequest.isObject()) {
             jreq.parse(valRequest);
+            jreq.resultStream = &resultStream;
 
             UniValue result = tableRPC.execute(jreq);
 
+            // A streamed result was sent already
+            if (resultStream.Started()) {
+                resultStream.Finish(jreq.id);
+                return true;
+            }
+
             // Send reply
             strReply = JSONRPCReply(result, NullUniValue, jreq.id);
 
@@ -200,9 +271,19 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
         req->WriteHeader("Content-Type", "application/json");
         req->WriteReply(HTTP_OK, strReply);
     } catch (const UniValue& objError) {
+        if (resultStream.Started()) {
+            LogPrintf("%s: streamed %s result cut short: %s\n", __func__, jreq.strMethod, objError.write());
+            resultStream.Abort();
+            return false;
+        }
         JSONErrorReply(req, objError, jreq.id);
         return false;
     } catch (const std::exception& e) {
+        if (resultStream.Started()) {
+            LogPrintf("%s: streamed %s result cut short: %s\n", __func__, jreq.strMethod, e.what());
+            resultStream.Abort();
+            return false;
+        }
         JSONErrorReply(req, JSONRPCError(RPC_PARSE_ERROR, e.what()), jreq.id);
         return false;
     }
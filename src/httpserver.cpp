@@ -23,9 +23,12 @@
 #include <sys/stat.h>
 #include <signal.h>
 #include <future>
+#include <condition_variable>
+#include <mutex>
 
 #include <event2/thread.h>
 #include <event2/buffer.h>
+#include <event2/bufferevent.h>
 #include <event2/util.h>
 #include <event2/keyvalq_struct.h>
 
@@ -545,6 +548,10 @@ HTTPRequest::HTTPRequest(struct evhttp_request* _req) : req(_req),
 }
 HTTPRequest::~HTTPRequest()
 {
+    if (chunkedReply && !replySent) {
+        // A chunked reply that was cut short still has to give the request back
+        EndChunkedReply();
+    }
     if (!replySent) {
         // Keep track of whether reply was sent to avoid request leaks
         LogPrintf("%s: Unhandled request\n", __func__);
@@ -610,6 +617,147 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
     req = nullptr; // transferred back to main thread
 }
 
+/** Bytes of a chunked reply allowed to wait in the connection's output buffer before the writer holds back */
+static const size_t MAX_CHUNKED_REPLY_QUEUED = 4 << 20;
+
+/**
+ * A chunked reply in progress, shared between the worker thread writing it and the events sending it
+ * from the main thread. The request belongs to libevent again once the reply started, and is freed
+ * along with the connection if the client goes away, so the events check fClosed before touching it.
+ */
+struct HTTPChunkedReply
+{
+    std::mutex cs;
+    std::condition_variable cond;
+    //! Bytes in the connection's output buffer, as last seen from the main thread
+    size_t nQueued;
+    //! Number of times nQueued was updated
+    uint64_t nUpdates;
+    //! The connection closed, freeing the request
+    bool fClosed;
+    //! Reference held by the connection's close callback. Main thread only.
+    std::shared_ptr<HTTPChunkedReply>* pCloseRef;
+
+    HTTPChunkedReply() : nQueued(0), nUpdates(0), fClosed(false), pCloseRef(nullptr) {}
+};
+
+/** Record how much is waiting to be sent to the client. Main thread only. */
+static void http_chunked_reply_update(struct evhttp_request* req, const std::shared_ptr<HTTPChunkedReply>& reply)
+{
+    size_t nQueued = 0;
+    struct evhttp_connection* con = evhttp_request_get_connection(req);
+    struct bufferevent* bev = con ? evhttp_connection_get_bufferevent(con) : nullptr;
+    if (bev)
+        nQueued = evbuffer_get_length(bufferevent_get_output(bev));
+    std::lock_guard<std::mutex> lock(reply->cs);
+    reply->nQueued = nQueued;
+    reply->nUpdates++;
+    reply->cond.notify_all();
+}
+
+/** Called by libevent when the connection of a chunked reply goes away, with the reply's own reference. */
+static void http_chunked_reply_closed(struct evhttp_connection*, void* arg)
+{
+    std::shared_ptr<HTTPChunkedReply>* pReply = static_cast<std::shared_ptr<HTTPChunkedReply>*>(arg);
+    std::shared_ptr<HTTPChunkedReply> reply = *pReply;
+    reply->pCloseRef = nullptr;
+    delete pReply;
+    std::lock_guard<std::mutex> lock(reply->cs);
+    reply->fClosed = true;
+    reply->cond.notify_all();
+}
+
+static bool http_chunked_reply_closed(const std::shared_ptr<HTTPChunkedReply>& reply)
+{
+    std::lock_guard<std::mutex> lock(reply->cs);
+    return reply->fClosed;
+}
+
+void HTTPRequest::StartChunkedReply(int nStatus)
+{
+    assert(!replySent && !chunkedReply && req);
+    chunkedReply = std::make_shared<HTTPChunkedReply>();
+    struct evhttp_request* r = req;
+    std::shared_ptr<HTTPChunkedReply> reply = chunkedReply;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [r, reply, nStatus]() {
+        struct evhttp_connection* con = evhttp_request_get_connection(r);
+        if (con) {
+            reply->pCloseRef = new std::shared_ptr<HTTPChunkedReply>(reply);
+            evhttp_connection_set_closecb(con, http_chunked_reply_closed, reply->pCloseRef);
+        }
+        evhttp_send_reply_start(r, nStatus, nullptr);
+    });
+    ev->trigger(nullptr);
+}
+
+void HTTPRequest::WriteReplyChunk(const std::string& strChunk)
+{
+    assert(!replySent && chunkedReply && req);
+    std::shared_ptr<HTTPChunkedReply> reply = chunkedReply;
+    struct evhttp_request* r = req;
+    {
+        // Hold back while the client is behind, giving up if it stops reading altogether
+        std::unique_lock<std::mutex> lock(reply->cs);
+        int64_t nTimeout = gArgs.GetArg("-rpcservertimeout", DEFAULT_HTTP_SERVER_TIMEOUT);
+        int64_t nDeadline = GetTime() + nTimeout;
+        size_t nLastQueued = reply->nQueued;
+        while (!reply->fClosed && reply->nQueued > MAX_CHUNKED_REPLY_QUEUED) {
+            if (GetTime() > nDeadline)
+                throw std::runtime_error("HTTP client stopped reading the reply");
+            uint64_t nUpdates = reply->nUpdates;
+            lock.unlock();
+            HTTPEvent* ev = new HTTPEvent(eventBase, true, [r, reply]() {
+                if (!http_chunked_reply_closed(reply))
+                    http_chunked_reply_update(r, reply);
+            });
+            ev->trigger(nullptr);
+            lock.lock();
+            reply->cond.wait_for(lock, std::chrono::milliseconds(100), [&reply, nUpdates]() {
+                return reply->fClosed || reply->nUpdates != nUpdates;
+            });
+            if (reply->nQueued < nLastQueued)
+                nDeadline = GetTime() + nTimeout;
+            nLastQueued = reply->nQueued;
+        }
+        if (reply->fClosed)
+            throw std::runtime_error("HTTP client went away during the reply");
+    }
+
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [r, reply, strChunk]() {
+        if (http_chunked_reply_closed(reply))
+            return;
+        struct evbuffer* evb = evbuffer_new();
+        assert(evb);
+        evbuffer_add(evb, strChunk.data(), strChunk.size());
+        evhttp_send_reply_chunk(r, evb);
+        evbuffer_free(evb);
+        http_chunked_reply_update(r, reply);
+    });
+    ev->trigger(nullptr);
+}
+
+void HTTPRequest::EndChunkedReply()
+{
+    assert(!replySent && chunkedReply && req);
+    struct evhttp_request* r = req;
+    std::shared_ptr<HTTPChunkedReply> reply = chunkedReply;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [r, reply]() {
+        if (http_chunked_reply_closed(reply))
+            return;
+        // Take back the close callback's reference before the connection can go away normally
+        struct evhttp_connection* con = evhttp_request_get_connection(r);
+        if (con && reply->pCloseRef) {
+            evhttp_connection_set_closecb(con, nullptr, nullptr);
+            delete reply->pCloseRef;
+            reply->pCloseRef = nullptr;
+        }
+        evhttp_send_reply_end(r);
+    });
+    ev->trigger(nullptr);
+    replySent = true;
+    req = nullptr; // transferred back to main thread
+}
+
 CService HTTPRequest::GetPeer()
 {
     evhttp_connection* con = evhttp_request_get_connection(req);
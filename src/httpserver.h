@@ -9,6 +9,7 @@
 #include <string>
 #include <stdint.h>
 #include <functional>
+#include <memory>
 
 static const int DEFAULT_HTTP_THREADS=4;
 static const int DEFAULT_HTTP_WORKQUEUE=16;
@@ -55,11 +56,14 @@ struct event_base* EventBase();
 /** In-flight HTTP request.
  * Thin C++ wrapper around evhttp_request.
  */
+struct HTTPChunkedReply;
+
 class HTTPRequest
 {
 private:
     struct evhttp_request* req;
     bool replySent;
+    std::shared_ptr<HTTPChunkedReply> chunkedReply;
 
 public:
     explicit HTTPRequest(struct evhttp_request* req);
@@ -115,6 +119,27 @@ public:
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
     void WriteReply(int nStatus, const std::string& strReply = "");
+
+    /**
+     * Start a reply whose body follows piece by piece with WriteReplyChunk(), using chunked
+     * transfer encoding, for replies too large to build in memory first.
+     *
+     * @note Call this instead of WriteReply, and finish with EndChunkedReply.
+     */
+    void StartChunkedReply(int nStatus);
+
+    /**
+     * Send the next piece of a chunked reply. Waits while much of what was sent before is
+     * still queued for the client, so a slow reader doesn't make the reply pile up in memory.
+     *
+     * @throws std::runtime_error when the client went away
+     */
+    void WriteReplyChunk(const std::string& strChunk);
+
+    /**
+     * Finish a chunked reply. As with WriteReply, do not call any other HTTPRequest methods after this.
+     */
+    void EndChunkedReply();
 };
 
 /** Event handler closure.
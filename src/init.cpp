@@ -48,6 +48,7 @@
 #include "assets/assets.h"
 #include "assets/assetdb.h"
 #include "assets/snapshotrequestdb.h"
+#include "assets/rewards.h"
 #ifdef ENABLE_WALLET
 #include "wallet/init.h"
 #include <wallet/wallet.h>
@@ -262,6 +263,9 @@ void PrepareShutdown()
         pblocktree = nullptr;
 
         /** RVN START */
+        // Ownership snapshots still queued read from views of the asset database, finish them before closing it
+        FlushOwnershipSnapshots();
+
         delete passets;
         passets = nullptr;
 
@@ -292,8 +296,11 @@ void PrepareShutdown()
         delete passetsVerifierCache;
         passetsVerifierCache = nullptr;
 
-        delete passetsQualifierCache;
-        passetsQualifierCache = nullptr;
+        delete passetsCompiledVerifierCache;
+        passetsCompiledVerifierCache = nullptr;
+
+        delete passetsAddressQualifiersCache;
+        passetsAddressQualifiersCache = nullptr;
 
         delete passetsRestrictionCache;
         passetsRestrictionCache = nullptr;
@@ -330,6 +337,8 @@ void PrepareShutdown()
     }
 #endif
 
+    UnregisterRewardsValidationInterface();
+
 #ifndef WIN32
     try {
         fs::remove(GetPidFile());
@@ -356,8 +365,9 @@ void Shutdown()
     if(!fRequestRestart) {
         PrepareShutdown();
     }
-    // Shutdown part 2: Stop TOR thread and close wallets
+    // Shutdown part 2: Stop TOR and ethash prebuild threads and close wallets
     StopTorControl();
+    StopEthashContextCache();
  #ifdef ENABLE_WALLET
     CloseWallets();
  #endif
@@ -433,6 +443,7 @@ std::string HelpMessage(HelpMessageMode mode)
     if (showDebug)
         strUsage += HelpMessageOpt("-blocksonly", strprintf(_("Whether to operate in a blocks only mode (default: %u)"), DEFAULT_BLOCKSONLY));
     strUsage +=HelpMessageOpt("-assumevalid=<hex>", strprintf(_("If this block is in the chain assume that it and its ancestors are valid and potentially skip their script verification (0 to verify all, default: %s, testnet: %s)"), defaultChainParams->GetConsensus().defaultAssumeValid.GetHex(), testnetChainParams->GetConsensus().defaultAssumeValid.GetHex()));
+    strUsage += HelpMessageOpt("-assetcachesize=<n>", strprintf(_("Set the memory shared by the in-memory asset and message caches in megabytes (minimum: 1, default: %d)"), DEFAULT_ASSET_CACHE_SIZE));
     strUsage += HelpMessageOpt("-conf=<file>", strprintf(_("Specify configuration file (default: %s)"), RAVEN_CONF_FILENAME));
     if (mode == HMM_RAVEND)
     {
@@ -478,6 +489,8 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-txindex", strprintf(_("Maintain a full transaction index, used by the getrawtransaction rpc call (default: %u)"), DEFAULT_TXINDEX));
 
     strUsage += HelpMessageOpt("-addressindex", strprintf(_("Maintain a full address index, used to query for the balance, txids and unspent outputs for addresses (default: %u)"), DEFAULT_ADDRESSINDEX));
+    strUsage += HelpMessageOpt("-addressheightindex", strprintf(_("With -addressindex, also keep the address index ordered by height across assets, used to query an address's txids in a range of heights (default: %u)"), DEFAULT_ADDRESSHEIGHTINDEX));
+    strUsage += HelpMessageOpt("-addressindexthreads=<n>", strprintf(_("Number of threads reading the address index for a call with many addresses (1 to %d, default: %d)"), MAX_ADDRESSINDEX_THREADS, DEFAULT_ADDRESSINDEX_THREADS));
     strUsage += HelpMessageOpt("-timestampindex", strprintf(_("Maintain a timestamp index for block hashes, used to query blocks hashes by a range of timestamps (default: %u)"), DEFAULT_TIMESTAMPINDEX));
     strUsage += HelpMessageOpt("-spentindex", strprintf(_("Maintain a full spent index, used to query the spending txid and input index for an outpoint (default: %u)"), DEFAULT_SPENTINDEX));
 
@@ -532,6 +545,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-zmqpubrawblock=<address>", _("Enable publish raw block in <address>"));
     strUsage += HelpMessageOpt("-zmqpubrawtx=<address>", _("Enable publish raw transaction in <address>"));
     strUsage += HelpMessageOpt("-zmqpubrawmessage=<address>", _("Enable publish raw asset messages in <address>"));
+    strUsage += HelpMessageOpt("-zmqpubassetdelta=<address>", _("Enable publish the asset changes of connected and disconnected blocks in <address>"));
 #endif
 
     strUsage += HelpMessageGroup(_("Debugging/Testing options:"));
@@ -543,6 +557,7 @@ std::string HelpMessage(HelpMessageMode mode)
         strUsage += HelpMessageOpt("-checkblockindex", strprintf("Do a full consistency check for mapBlockIndex, setBlockIndexCandidates, chainActive and mapBlocksUnlinked occasionally. Also sets -checkmempool (default: %u)", defaultChainParams->DefaultConsistencyChecks()));
         strUsage += HelpMessageOpt("-checkmempool=<n>", strprintf("Run checks every <n> transactions (default: %u)", defaultChainParams->DefaultConsistencyChecks()));
         strUsage += HelpMessageOpt("-checkpoints", strprintf("Disable expensive verification for known chain history (default: %u)", DEFAULT_CHECKPOINTS_ENABLED));
+        strUsage += HelpMessageOpt("-checkindexpow", strprintf("Re-check the proof of work of every block index entry at startup. When disabled, entries below the last checkpoint that were validated before are trusted (default: %u)", DEFAULT_CHECK_INDEX_POW));
         strUsage += HelpMessageOpt("-disablesafemode", strprintf("Disable safemode, override a real safe mode event (default: %u)", DEFAULT_DISABLE_SAFEMODE));
         strUsage += HelpMessageOpt("-deprecatedrpc=<method>", "Allows deprecated RPC method(s) to be used");
         strUsage += HelpMessageOpt("-testsafemode", strprintf("Force safe mode (default: %u)", DEFAULT_TESTSAFEMODE));
@@ -567,6 +582,8 @@ std::string HelpMessage(HelpMessageMode mode)
     {
         strUsage += HelpMessageOpt("-logtimemicros", strprintf("Add microsecond precision to debug timestamps (default: %u)", DEFAULT_LOGTIMEMICROS));
         strUsage += HelpMessageOpt("-mocktime=<n>", "Replace actual time with <n> seconds since epoch (default: 0)");
+        strUsage += HelpMessageOpt("-ethashcachesize=<n>", strprintf("Keep the ethash epoch contexts (16MB or more each) of up to <n> epochs for KAWPOW verification (default: %u)", DEFAULT_ETHASH_CONTEXT_CACHE_SIZE));
+        strUsage += HelpMessageOpt("-ethashprebuild", strprintf("Build the next epoch's ethash context in the background when the chain gets within %d blocks of an epoch boundary (default: %u)", ETHASH_PREBUILD_BLOCKS, DEFAULT_ETHASH_PREBUILD));
         strUsage += HelpMessageOpt("-maxsigcachesize=<n>", strprintf("Limit sum of signature cache and script execution cache sizes to <n> MiB (default: %u)", DEFAULT_MAX_SIG_CACHE_SIZE));
         strUsage += HelpMessageOpt("-maxtipage=<n>", strprintf("Maximum tip age in seconds to consider node in initial block download (default: %u)", DEFAULT_MAX_TIP_AGE));
     }
@@ -1342,6 +1359,7 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
 
     InitSignatureCache();
     InitScriptExecutionCache();
+    InitEthashContextCache(std::max(gArgs.GetArg("-ethashcachesize", DEFAULT_ETHASH_CONTEXT_CACHE_SIZE), (int64_t)1), gArgs.GetBoolArg("-ethashprebuild", DEFAULT_ETHASH_PREBUILD));
 
     LogPrintf("Using %u threads for script verification\n", nScriptCheckThreads);
     if (nScriptCheckThreads) {
@@ -1514,11 +1532,15 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
     nCoinDBCache = std::min(nCoinDBCache, nMaxCoinsDBCache << 20); // cap total coins db cache
     nTotalCache -= nCoinDBCache;
     nCoinCacheUsage = nTotalCache; // the rest goes to in-memory cache
+    int64_t nAssetCacheSize = std::max(gArgs.GetArg("-assetcachesize", DEFAULT_ASSET_CACHE_SIZE), (int64_t)1) << 20;
+    int64_t nAssetMetaDataCacheSize = nAssetCacheSize / 2; // asset metadata is read the most, the other eight caches share the rest
+    int64_t nAssetSmallCacheSize = (nAssetCacheSize - nAssetMetaDataCacheSize) / 8;
     int64_t nMempoolSizeMax = gArgs.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
     LogPrintf("Cache configuration:\n");
     LogPrintf("* Using %.1fMiB for block index database\n", nBlockTreeDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for chain state database\n", nCoinDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for in-memory UTXO set (plus up to %.1fMiB of unused mempool space)\n", nCoinCacheUsage * (1.0 / 1024 / 1024), nMempoolSizeMax * (1.0 / 1024 / 1024));
+    LogPrintf("* Using %.1fMiB for in-memory asset caches\n", nAssetCacheSize * (1.0 / 1024 / 1024));
 
     bool fLoaded = false;
     while (!fLoaded && !fRequestShutdown) {
@@ -1557,7 +1579,8 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
                     // Restricted assets
                     delete prestricteddb;
                     delete passetsVerifierCache;
-                    delete passetsQualifierCache;
+                    delete passetsCompiledVerifierCache;
+                    delete passetsAddressQualifiersCache;
                     delete passetsRestrictionCache;
                     delete passetsGlobalRestrictionCache;
 
@@ -1569,12 +1592,12 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
                     // Basic assets
                     passetsdb = new CAssetsDB(nBlockTreeDBCache, false, fReset);
                     passets = new CAssetsCache();
-                    passetsCache = new CLRUCache<std::string, CDatabasedAssetData>(MAX_CACHE_ASSETS_SIZE);
+                    passetsCache = new CShardedLRUCache<std::string, CDatabasedAssetData>(nAssetMetaDataCacheSize);
 
                     // Messaging assets
-                    pMessagesCache = new CLRUCache<std::string, CMessage>(1000);
-                    pMessageSubscribedChannelsCache = new CLRUCache<std::string, int>(1000);
-                    pMessagesSeenAddressCache = new CLRUCache<std::string, int>(1000);
+                    pMessagesCache = new CShardedLRUCache<std::string, CMessage>(nAssetSmallCacheSize);
+                    pMessageSubscribedChannelsCache = new CShardedLRUCache<std::string, int>(nAssetSmallCacheSize);
+                    pMessagesSeenAddressCache = new CShardedLRUCache<std::string, int>(nAssetSmallCacheSize);
                     pmessagedb = new CMessageDB(nBlockTreeDBCache, false, false);
                     pmessagechanneldb = new CMessageChannelDB(nBlockTreeDBCache, false, false);
 
@@ -1583,11 +1606,11 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
 
                     // Restricted assets
                     prestricteddb = new CRestrictedDB(nBlockTreeDBCache, false, fReset);
-                    passetsVerifierCache = new CLRUCache<std::string, CNullAssetTxVerifierString>(
-                            MAX_CACHE_ASSETS_SIZE);
-                    passetsQualifierCache = new CLRUCache<std::string, int8_t>(MAX_CACHE_ASSETS_SIZE);
-                    passetsRestrictionCache = new CLRUCache<std::string, int8_t>(MAX_CACHE_ASSETS_SIZE);
-                    passetsGlobalRestrictionCache = new CLRUCache<std::string, int8_t>(MAX_CACHE_ASSETS_SIZE);
+                    passetsVerifierCache = new CShardedLRUCache<std::string, CNullAssetTxVerifierString>(nAssetSmallCacheSize);
+                    passetsCompiledVerifierCache = new CShardedLRUCache<std::string, std::shared_ptr<const CCompiledVerifierString>>(nAssetSmallCacheSize);
+                    passetsAddressQualifiersCache = new CShardedLRUCache<std::string, std::set<std::string>>(nAssetSmallCacheSize);
+                    passetsRestrictionCache = new CShardedLRUCache<std::string, int8_t>(nAssetSmallCacheSize);
+                    passetsGlobalRestrictionCache = new CShardedLRUCache<std::string, int8_t>(nAssetSmallCacheSize);
 
                     // Rewards
                     pSnapshotRequestDb = new CSnapshotRequestDB(nBlockTreeDBCache, false, false);
@@ -1602,6 +1625,11 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
                         break;
                     }
 
+                    if (!pmessagedb->BuildMessageIndexes()) {
+                        strLoadError = _("Failed to index the Messages Database");
+                        break;
+                    }
+
                     if (!passetsdb->ReadReissuedMempoolState())
                         LogPrintf(
                                 "Database failed to load last Reissued Mempool State. Will have to start from empty state");
@@ -1844,6 +1872,8 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
         vImportFiles.push_back(strFile);
     }
 
+    RegisterRewardsValidationInterface();
+    StartRewardsThread(threadGroup);
     threadGroup.create_thread(boost::bind(&ThreadImport, vImportFiles));
 
     // Wait for genesis block to be processed
@@ -11,6 +11,8 @@
 #include "utilstrencodings.h"
 #include "crypto/common.h"
 
+#include <atomic>
+
 
 static const uint32_t MAINNET_X16RV2ACTIVATIONTIME = 1569945600;
 static const uint32_t TESTNET_X16RV2ACTIVATIONTIME = 1567533600;
@@ -35,46 +37,118 @@ void BlockNetwork::SetNetwork(const std::string& net)
     }
 }
 
-uint256 CBlockHeader::GetHash() const
+/** An immutable snapshot of a header's fields, with the hashes computed from them */
+struct CBlockHeaderHashCache
 {
-    if (nTime < nKAWPOWActivationTime) {
-        uint32_t nTimeToUse = MAINNET_X16RV2ACTIVATIONTIME;
-        if (bNetwork.fOnTestnet) {
-            nTimeToUse = TESTNET_X16RV2ACTIVATIONTIME;
-        } else if (bNetwork.fOnRegtest) {
-            nTimeToUse = REGTEST_X16RV2ACTIVATIONTIME;
-        }
-        if (nTime >= nTimeToUse) {
-            return HashX16RV2(BEGIN(nVersion), END(nNonce), hashPrevBlock);
-        }
+    int32_t nVersion;
+    uint256 hashPrevBlock;
+    uint256 hashMerkleRoot;
+    uint32_t nTime;
+    uint32_t nBits;
+    uint32_t nNonce;
+    uint32_t nHeight;
+    uint64_t nNonce64;
+    uint256 mix_hash;
+
+    bool fHaveHash;
+    uint256 hash;                // GetHash()
+    bool fHaveHashFull;
+    uint256 hashFull;            // GetHashFull()
+    uint256 mix_hash_full;       // mix hash output by GetHashFull()
+
+    explicit CBlockHeaderHashCache(const CBlockHeader& header) :
+        nVersion(header.nVersion), hashPrevBlock(header.hashPrevBlock), hashMerkleRoot(header.hashMerkleRoot),
+        nTime(header.nTime), nBits(header.nBits), nNonce(header.nNonce), nHeight(header.nHeight),
+        nNonce64(header.nNonce64), mix_hash(header.mix_hash), fHaveHash(false), fHaveHashFull(false) {}
+
+    bool Matches(const CBlockHeader& header) const
+    {
+        return nNonce == header.nNonce && nNonce64 == header.nNonce64 && nTime == header.nTime &&
+               nVersion == header.nVersion && nBits == header.nBits && nHeight == header.nHeight &&
+               hashPrevBlock == header.hashPrevBlock && hashMerkleRoot == header.hashMerkleRoot &&
+               mix_hash == header.mix_hash;
+    }
+};
 
-        return HashX16R(BEGIN(nVersion), END(nNonce), hashPrevBlock);
-    } else {
-        return KAWPOWHash_OnlyMix(*this);
+static std::atomic<uint64_t> nHeaderHashComputed{0};
+static std::atomic<uint64_t> nHeaderHashCached{0};
+
+void GetBlockHeaderHashStats(uint64_t& nComputed, uint64_t& nCached)
+{
+    nComputed = nHeaderHashComputed.load(std::memory_order_relaxed);
+    nCached = nHeaderHashCached.load(std::memory_order_relaxed);
+}
+
+/** A new cache entry for the header, carrying over what the current entry holds if it still applies */
+static std::shared_ptr<CBlockHeaderHashCache> NewHashCacheEntry(const CBlockHeader& header,
+                                                                const std::shared_ptr<const CBlockHeaderHashCache>& current)
+{
+    if (current && current->Matches(header))
+        return std::make_shared<CBlockHeaderHashCache>(*current);
+    return std::make_shared<CBlockHeaderHashCache>(header);
+}
+
+static bool IsX16RV2Time(uint32_t nTime)
+{
+    uint32_t nTimeToUse = MAINNET_X16RV2ACTIVATIONTIME;
+    if (bNetwork.fOnTestnet) {
+        nTimeToUse = TESTNET_X16RV2ACTIVATIONTIME;
+    } else if (bNetwork.fOnRegtest) {
+        nTimeToUse = REGTEST_X16RV2ACTIVATIONTIME;
     }
+    return nTime >= nTimeToUse;
 }
 
-uint256 CBlockHeader::GetHashFull(uint256& mix_hash) const
+uint256 CBlockHeader::GetHash() const
 {
+    std::shared_ptr<const CBlockHeaderHashCache> cache = hashCache.Get();
+    if (cache && cache->fHaveHash && cache->Matches(*this)) {
+        nHeaderHashCached.fetch_add(1, std::memory_order_relaxed);
+        return cache->hash;
+    }
+
+    uint256 hash;
     if (nTime < nKAWPOWActivationTime) {
-        uint32_t nTimeToUse = MAINNET_X16RV2ACTIVATIONTIME;
-        if (bNetwork.fOnTestnet) {
-            nTimeToUse = TESTNET_X16RV2ACTIVATIONTIME;
-        } else if (bNetwork.fOnRegtest) {
-            nTimeToUse = REGTEST_X16RV2ACTIVATIONTIME;
-        }
-        if (nTime >= nTimeToUse) {
-            return HashX16RV2(BEGIN(nVersion), END(nNonce), hashPrevBlock);
+        if (IsX16RV2Time(nTime)) {
+            hash = HashX16RV2(BEGIN(nVersion), END(nNonce), hashPrevBlock);
+        } else {
+            hash = HashX16R(BEGIN(nVersion), END(nNonce), hashPrevBlock);
         }
-
-        return HashX16R(BEGIN(nVersion), END(nNonce), hashPrevBlock);
     } else {
-        return KAWPOWHash(*this, mix_hash);
+        hash = KAWPOWHash_OnlyMix(*this);
     }
+    nHeaderHashComputed.fetch_add(1, std::memory_order_relaxed);
+
+    std::shared_ptr<CBlockHeaderHashCache> entry = NewHashCacheEntry(*this, cache);
+    entry->fHaveHash = true;
+    entry->hash = hash;
+    hashCache.Set(entry);
+    return hash;
 }
 
+uint256 CBlockHeader::GetHashFull(uint256& mix_hash) const
+{
+    // Before KAWPOW there is no mix hash, and the full hash is the plain header hash
+    if (nTime < nKAWPOWActivationTime)
+        return GetHash();
+
+    std::shared_ptr<const CBlockHeaderHashCache> cache = hashCache.Get();
+    if (cache && cache->fHaveHashFull && cache->Matches(*this)) {
+        nHeaderHashCached.fetch_add(1, std::memory_order_relaxed);
+        mix_hash = cache->mix_hash_full;
+        return cache->hashFull;
+    }
 
+    uint256 hash = KAWPOWHash(*this, mix_hash);
+    nHeaderHashComputed.fetch_add(1, std::memory_order_relaxed);
 
+    std::shared_ptr<CBlockHeaderHashCache> entry = NewHashCacheEntry(*this, cache);
+    entry->fHaveHashFull = true;
+    entry->hashFull = hash;
+    entry->mix_hash_full = mix_hash;
+    hashCache.Set(entry);
+    return hash;
+}
 
 uint256 CBlockHeader::GetX16RHash() const
 {
@@ -11,6 +11,8 @@
 #include "serialize.h"
 #include "uint256.h"
 
+#include <memory>
+
 /** Nodes collect new transactions into a block, hash them into a hash tree,
  * and scan through nonce values to make the block's hash satisfy proof-of-work
  * requirements.  When they solve the proof-of-work, they broadcast the block
@@ -32,6 +34,40 @@ public:
 
 extern BlockNetwork bNetwork;
 
+class CBlockHeader;
+struct CBlockHeaderHashCache;
+
+/**
+ * Memory only: holds the proof of work hashes last computed for a header, so that the many GetHash()
+ * calls made on the same block while it is received, checked and connected only hash it once.
+ * Entries are immutable and remember the header fields they were computed from, so a cached hash is
+ * only used while the header is unchanged; mutating a field (e.g. the miner bumping nNonce) simply
+ * makes the next call compute it again. Loads and stores are atomic, as shared blocks are hashed from
+ * several threads.
+ */
+class CBlockHeaderHashCacheRef
+{
+private:
+    std::shared_ptr<const CBlockHeaderHashCache> ptr;
+
+public:
+    CBlockHeaderHashCacheRef() {}
+    CBlockHeaderHashCacheRef(const CBlockHeaderHashCacheRef& other) : ptr(std::atomic_load(&other.ptr)) {}
+
+    CBlockHeaderHashCacheRef& operator=(const CBlockHeaderHashCacheRef& other)
+    {
+        std::atomic_store(&ptr, std::atomic_load(&other.ptr));
+        return *this;
+    }
+
+    std::shared_ptr<const CBlockHeaderHashCache> Get() const { return std::atomic_load(&ptr); }
+    void Set(const std::shared_ptr<const CBlockHeaderHashCache>& entry) { std::atomic_store(&ptr, entry); }
+    void Clear() { std::atomic_store(&ptr, std::shared_ptr<const CBlockHeaderHashCache>()); }
+};
+
+/** Number of header hashes computed, and number served from the header's hash cache */
+void GetBlockHeaderHashStats(uint64_t& nComputed, uint64_t& nCached);
+
 
 class CBlockHeader
 {
@@ -50,6 +86,9 @@ public:
     uint64_t nNonce64;
     uint256 mix_hash;
 
+    // memory only
+    mutable CBlockHeaderHashCacheRef hashCache;
+
     CBlockHeader()
     {
         SetNull();
@@ -85,6 +124,7 @@ public:
         nNonce64 = 0;
         nHeight = 0;
         mix_hash.SetNull();
+        hashCache.Clear();
     }
 
     bool IsNull() const
@@ -162,6 +202,7 @@ public:
         block.nHeight        = nHeight;
         block.nNonce64       = nNonce64;
         block.mix_hash       = mix_hash;
+        block.hashCache      = hashCache;
         return block;
     }
 
@@ -8,6 +8,7 @@
 #define RAVEN_PRIMITIVES_TRANSACTION_H
 
 #include <stdint.h>
+#include <memory>
 #include "amount.h"
 #include "script/script.h"
 #include "serialize.h"
@@ -17,6 +18,7 @@ static const int SERIALIZE_TRANSACTION_NO_WITNESS = 0x40000000;
 
 class CCoinsViewCache;
 class CNullAssetTxVerifierString;
+struct CTxAssetOutputs;
 
 /** An outpoint - a combination of a transaction hash and an index n into its vout */
 class COutPoint
@@ -264,6 +266,32 @@ inline void SerializeTransaction(const TxType& tx, Stream& s) {
 }
 
 
+/**
+ * Memory only: the asset data of a transaction's outputs, parsed the first time it is asked for (see
+ * GetTxAssetOutputs) so that mempool acceptance, the asset checks, block connection, the address index
+ * and the wallet don't each deserialize the same asset scripts again. Loads and stores are atomic, as
+ * transactions are shared between threads.
+ */
+class CTxAssetOutputsRef
+{
+private:
+    std::shared_ptr<const CTxAssetOutputs> ptr;
+
+public:
+    CTxAssetOutputsRef() {}
+    CTxAssetOutputsRef(const CTxAssetOutputsRef& other) : ptr(std::atomic_load(&other.ptr)) {}
+
+    CTxAssetOutputsRef& operator=(const CTxAssetOutputsRef& other)
+    {
+        std::atomic_store(&ptr, std::atomic_load(&other.ptr));
+        return *this;
+    }
+
+    std::shared_ptr<const CTxAssetOutputs> Get() const { return std::atomic_load(&ptr); }
+    void Set(const std::shared_ptr<const CTxAssetOutputs>& entry) { std::atomic_store(&ptr, entry); }
+    void Clear() { std::atomic_store(&ptr, std::shared_ptr<const CTxAssetOutputs>()); }
+};
+
 /** The basic transaction that is broadcasted on the network and contained in
  * blocks.  A transaction can contain multiple inputs and outputs.
  */
@@ -289,6 +317,9 @@ public:
     const int32_t nVersion;
     const uint32_t nLockTime;
 
+    // memory only
+    mutable CTxAssetOutputsRef assetOutputs;
+
 private:
     /** Memory only. */
     const uint256 hash;
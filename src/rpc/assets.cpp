@@ -6,6 +6,7 @@
 //#include <base58.h>
 #include "assets/assets.h"
 #include "assets/assetdb.h"
+#include "assets/rewards.h"
 #include <map>
 #include "tinyformat.h"
 //#include <rpc/server.h>
@@ -1075,9 +1076,9 @@ UniValue listaddressesbyasset(const JSONRPCRequest &request)
         return "_This rpc call is not functional unless -assetindex is enabled. To enable, please run the wallet with -assetindex, this will require a reindex to occur";
     }
 
-    if (request.fHelp || !AreAssetsDeployed() || request.params.size() > 4 || request.params.size() < 1)
+    if (request.fHelp || !AreAssetsDeployed() || request.params.size() > 5 || request.params.size() < 1)
         throw std::runtime_error(
-                "listaddressesbyasset \"asset_name\" (onlytotal) (count) (start)\n"
+                "listaddressesbyasset \"asset_name\" (onlytotal) (count) (start) (\"after\")\n"
                 + AssetActivationWarning() +
                 "\nReturns a list of all address that own the given asset (with balances)"
                 "\nOr returns the total size of how many address own the given asset"
@@ -1087,6 +1088,7 @@ UniValue listaddressesbyasset(const JSONRPCRequest &request)
                 "2. \"onlytotal\"                (boolean, optional, default=false) when false result is just a list of addresses with balances -- when true the result is just a single number representing the number of addresses\n"
                 "3. \"count\"                    (integer, optional, default=50000, MAX=50000) truncates results to include only the first _count_ assets found\n"
                 "4. \"start\"                    (integer, optional, default=0) results skip over the first _start_ assets found (if negative it skips back from the end)\n"
+                "5. \"after\"                    (string, optional, default=\"\") resume cursor -- pass the last address of the previous page to continue right after it\n"
 
                 "\nResult:\n"
                 "[ "
@@ -1098,6 +1100,7 @@ UniValue listaddressesbyasset(const JSONRPCRequest &request)
                 + HelpExampleCli("listaddressesbyasset", "\"ASSET_NAME\" false 2 0")
                 + HelpExampleCli("listaddressesbyasset", "\"ASSET_NAME\" true")
                 + HelpExampleCli("listaddressesbyasset", "\"ASSET_NAME\"")
+                + HelpExampleCli("listaddressesbyasset", "\"ASSET_NAME\" false 1000 0 \"LAST_ADDRESS_OF_PREVIOUS_PAGE\"")
         );
 
     LOCK(cs_main);
@@ -1119,13 +1122,20 @@ UniValue listaddressesbyasset(const JSONRPCRequest &request)
         start = request.params[3].get_int();
     }
 
+    std::string after = "";
+    if (request.params.size() > 4) {
+        after = request.params[4].get_str();
+        if (!after.empty() && start < 0)
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "start can't be negative when after is given.");
+    }
+
     if (!IsAssetNameValid(asset_name))
         return "_Not a valid asset name";
 
     LOCK(cs_main);
     std::vector<std::pair<std::string, CAmount> > vecAddressAmounts;
     int nTotalEntries = 0;
-    if (!passetsdb->AssetAddressDir(vecAddressAmounts, nTotalEntries, fOnlyTotal, asset_name, count, start))
+    if (!passetsdb->AssetAddressDir(vecAddressAmounts, nTotalEntries, fOnlyTotal, asset_name, count, start, after))
         throw JSONRPCError(RPC_INTERNAL_ERROR, "couldn't retrieve address asset directory.");
 
     // If only the number of addresses is wanted return it
@@ -1670,9 +1680,9 @@ UniValue reissue(const JSONRPCRequest& request)
 
 UniValue listassets(const JSONRPCRequest& request)
 {
-    if (request.fHelp || !AreAssetsDeployed() || request.params.size() > 4)
+    if (request.fHelp || !AreAssetsDeployed() || request.params.size() > 5)
         throw std::runtime_error(
-                "listassets \"( asset )\" ( verbose ) ( count ) ( start )\n"
+                "listassets \"( asset )\" ( verbose ) ( count ) ( start ) \"( after )\"\n"
                 + AssetActivationWarning() +
                 "\nReturns a list of all assets\n"
                 "\nThis could be a slow/expensive operation as it reads from the database\n"
@@ -1682,6 +1692,7 @@ UniValue listassets(const JSONRPCRequest& request)
                 "2. \"verbose\"                  (boolean, optional, default=false) when false result is just a list of asset names -- when true results are asset name mapped to metadata\n"
                 "3. \"count\"                    (integer, optional, default=ALL) truncates results to include only the first _count_ assets found\n"
                 "4. \"start\"                    (integer, optional, default=0) results skip over the first _start_ assets found (if negative it skips back from the end)\n"
+                "5. \"after\"                    (string, optional, default=\"\") resume cursor -- pass the last asset name of the previous page to continue right after it\n"
 
                 "\nResult (verbose=false):\n"
                 "[\n"
@@ -1707,6 +1718,7 @@ UniValue listassets(const JSONRPCRequest& request)
                 + HelpExampleRpc("listassets", "")
                 + HelpExampleCli("listassets", "ASSET")
                 + HelpExampleCli("listassets", "\"ASSET*\" true 10 20")
+                + HelpExampleCli("listassets", "\"ASSET*\" false 10 0 \"LAST_ASSET_OF_PREVIOUS_PAGE\"")
         );
 
     ObserveSafeMode();
@@ -1737,8 +1749,15 @@ UniValue listassets(const JSONRPCRequest& request)
         start = request.params[3].get_int();
     }
 
+    std::string after = "";
+    if (request.params.size() > 4) {
+        after = request.params[4].get_str();
+        if (!after.empty() && start < 0)
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "start can't be negative when after is given.");
+    }
+
     std::vector<CDatabasedAssetData> assets;
-    if (!passetsdb->AssetDir(assets, filter, count, start))
+    if (!passetsdb->AssetDir(assets, filter, count, start, after))
         throw JSONRPCError(RPC_INTERNAL_ERROR, "couldn't retrieve asset directory.");
 
     UniValue result;
@@ -1771,6 +1790,22 @@ UniValue listassets(const JSONRPCRequest& request)
     return result;
 }
 
+template<typename cache_key_t, typename cache_value_t>
+static void AddLRUCacheInfo(UniValue& caches, const std::string& name, CShardedLRUCache<cache_key_t, cache_value_t>* cache)
+{
+    if (!cache)
+        return;
+
+    UniValue info(UniValue::VOBJ);
+    info.push_back(Pair("entries", (uint64_t)cache->Size()));
+    info.push_back(Pair("usage", (uint64_t)cache->DynamicMemoryUsage()));
+    info.push_back(Pair("max usage", (uint64_t)cache->MaxMemoryUsage()));
+    info.push_back(Pair("hits", cache->Hits()));
+    info.push_back(Pair("misses", cache->Misses()));
+    info.push_back(Pair("evictions", cache->Evictions()));
+    caches.push_back(Pair(name, info));
+}
+
 UniValue getcacheinfo(const JSONRPCRequest& request)
 {
     if (request.fHelp || !AreAssetsDeployed() || request.params.size())
@@ -1789,6 +1824,16 @@ UniValue getcacheinfo(const JSONRPCRequest& request)
                 "  asset metadata map:\n"
                 "  asset metadata list (est):\n"
                 "  dirty cache (est):\n"
+                "  lru caches: {\n"
+                "    name: {\n"
+                "      entries:\n"
+                "      usage:\n"
+                "      max usage:\n"
+                "      hits:\n"
+                "      misses:\n"
+                "      evictions:\n"
+                "    }, ...\n"
+                "  }\n"
 
 
                 "]\n"
@@ -1821,11 +1866,23 @@ UniValue getcacheinfo(const JSONRPCRequest& request)
 
     info.push_back(Pair("reissue tracking (memory only)", (int)memusage::DynamicUsage(mapReissuedAssets) + (int)memusage::DynamicUsage(mapReissuedTx)));
     info.push_back(Pair("asset data", descendants));
-    info.push_back(Pair("asset metadata map",  (int)memusage::DynamicUsage(passetsCache->GetItemsMap())));
-    info.push_back(Pair("asset metadata list (est)",  (int)passetsCache->GetItemsList().size() * (32 + 80))); // Max 32 bytes for asset name, 80 bytes max for asset data
+    info.push_back(Pair("asset metadata map",  (int)passetsCache->DynamicMemoryUsage()));
+    info.push_back(Pair("asset metadata list (est)",  (int)passetsCache->Size() * (32 + 80))); // Max 32 bytes for asset name, 80 bytes max for asset data
     info.push_back(Pair("dirty cache (est)",  (int)currentActiveAssetCache->GetCacheSize()));
     info.push_back(Pair("dirty cache V2 (est)",  (int)currentActiveAssetCache->GetCacheSizeV2()));
 
+    UniValue lruCaches(UniValue::VOBJ);
+    AddLRUCacheInfo(lruCaches, "asset metadata", passetsCache);
+    AddLRUCacheInfo(lruCaches, "messages", pMessagesCache);
+    AddLRUCacheInfo(lruCaches, "subscribed channels", pMessageSubscribedChannelsCache);
+    AddLRUCacheInfo(lruCaches, "seen addresses", pMessagesSeenAddressCache);
+    AddLRUCacheInfo(lruCaches, "verifier strings", passetsVerifierCache);
+    AddLRUCacheInfo(lruCaches, "compiled verifier strings", passetsCompiledVerifierCache);
+    AddLRUCacheInfo(lruCaches, "address qualifiers", passetsAddressQualifiersCache);
+    AddLRUCacheInfo(lruCaches, "address restrictions", passetsRestrictionCache);
+    AddLRUCacheInfo(lruCaches, "global restrictions", passetsGlobalRestrictionCache);
+    info.push_back(Pair("lru caches", lruCaches));
+
     result.push_back(info);
     return result;
 }
@@ -2232,7 +2289,7 @@ UniValue checkaddresstag(const JSONRPCRequest& request)
     if (!prestricteddb)
         throw JSONRPCError(RPC_DATABASE_ERROR, "Restricted asset database not available");
 
-    if (!passetsQualifierCache)
+    if (!passetsAddressQualifiersCache)
         throw JSONRPCError(RPC_DATABASE_ERROR, "Qualifier cache not available");
 
     if (!passets)
@@ -2957,6 +3014,9 @@ UniValue getsnapshot(const JSONRPCRequest& request)
     if (!pAssetSnapshotDb)
         throw JSONRPCError(RPC_DATABASE_ERROR, std::string("Asset Snapshot database is not setup. Please restart wallet to try again"));
 
+    //  Wait for the rewards thread to write out the snapshots taken so far
+    FlushOwnershipSnapshots();
+
     LOCK(cs_main);
     UniValue result (UniValue::VOBJ);
 
@@ -3017,6 +3077,9 @@ UniValue purgesnapshot(const JSONRPCRequest& request)
     if (!pAssetSnapshotDb)
         throw JSONRPCError(RPC_DATABASE_ERROR, std::string("Asset Snapshot database is not setup. Please restart wallet to try again"));
 
+    //  Wait for the rewards thread to write out the snapshots taken so far
+    FlushOwnershipSnapshots();
+
     LOCK(cs_main);
     UniValue result (UniValue::VOBJ);
 
@@ -3042,14 +3105,14 @@ static const CRPCCommand commands[] =
 #endif
     { "assets",   "listassetbalancesbyaddress", &listassetbalancesbyaddress, {"address", "onlytotal", "count", "start"} },
     { "assets",   "getassetdata",               &getassetdata,               {"asset_name"}},
-    { "assets",   "listaddressesbyasset",       &listaddressesbyasset,       {"asset_name", "onlytotal", "count", "start"}},
+    { "assets",   "listaddressesbyasset",       &listaddressesbyasset,       {"asset_name", "onlytotal", "count", "start", "after"}},
 #ifdef ENABLE_WALLET
     { "assets",   "transferfromaddress",        &transferfromaddress,        {"asset_name", "from_address", "qty", "to_address", "message", "expire_time", "rvn_change_address", "asset_change_address"}},
     { "assets",   "transferfromaddresses",      &transferfromaddresses,      {"asset_name", "from_addresses", "qty", "to_address", "message", "expire_time", "rvn_change_address", "asset_change_address"}},
     { "assets",   "transfer",                   &transfer,                   {"asset_name", "qty", "to_address", "message", "expire_time", "change_address", "asset_change_address"}},
     { "assets",   "reissue",                    &reissue,                    {"asset_name", "qty", "to_address", "change_address", "reissuable", "new_units", "new_ipfs"}},
 #endif
-    { "assets",   "listassets",                 &listassets,                 {"asset", "verbose", "count", "start"}},
+    { "assets",   "listassets",                 &listassets,                 {"asset", "verbose", "count", "start", "after"}},
     { "assets",   "getcacheinfo",               &getcacheinfo,               {}},
 
 #ifdef ENABLE_WALLET
@@ -204,6 +204,8 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "listassetbalancesbyaddress", 2, "count"},
     { "listassetbalancesbyaddress", 3, "start"},
     { "sendmessage", 2, "expire_time"},
+    { "viewallmessages", 1, "since"},
+    { "viewallmessages", 2, "limit"},
     { "requestsnapshot", 1, "block_height"},
     { "getsnapshotrequest", 1, "block_height"},
     { "listsnapshotrequests", 1, "block_height"},
@@ -39,11 +39,16 @@ std::string MessageActivationWarning()
 }
 
 UniValue viewallmessages(const JSONRPCRequest& request) {
-    if (request.fHelp || !AreMessagesDeployed() || request.params.size() != 0)
+    if (request.fHelp || !AreMessagesDeployed() || request.params.size() > 3)
         throw std::runtime_error(
-                "viewallmessages \n"
+                "viewallmessages ( \"channel\" since limit )\n"
                 + MessageActivationWarning() +
-                "\nView all messages that the wallet contains\n"
+                "\nView all messages that the wallet contains, oldest first\n"
+
+                "\nArguments:\n"
+                "1. \"channel\"                  (string, optional, default=\"\") Only view the messages sent on this channel\n"
+                "2. since                        (numeric, optional, default=0) Only view the messages sent at or after this UTC timestamp\n"
+                "3. limit                        (numeric, optional, default=0) View at most this many messages, 0 for all of them\n"
 
                 "\nResult:\n"
                 "\"Asset Name:\"                     (string) The name of the asset the message was sent on\n"
@@ -57,6 +62,7 @@ UniValue viewallmessages(const JSONRPCRequest& request) {
 
                 "\nExamples:\n"
                 + HelpExampleCli("viewallmessages", "")
+                + HelpExampleCli("viewallmessages", "\"ASSET_NAME~CHANNEL\" 1546300800 100")
                 + HelpExampleRpc("viewallmessages", "")
         );
 
@@ -72,32 +78,31 @@ UniValue viewallmessages(const JSONRPCRequest& request) {
         return ret;
     }
 
-    std::set<CMessage> setMessages;
-
-    pmessagedb->LoadMessages(setMessages);
-
-    for (auto pair : mapDirtyMessagesOrphaned) {
-        CMessage message = pair.second;
-        message.status = MessageStatus::ORPHAN;
-        if (setMessages.count(message))
-            setMessages.erase(message);
-        setMessages.insert(message);
-    }
-
-    for (auto out : setDirtyMessagesRemove) {
-        CMessage message;
-        message.out = out;
-        setMessages.erase(message);
-    }
-
-    for (auto pair : mapDirtyMessagesAdd) {
-        setMessages.erase(pair.second);
-        setMessages.insert(pair.second);
+    std::string channel = "";
+    if (request.params.size() > 0)
+        channel = request.params[0].get_str();
+
+    int64_t nSince = 0;
+    if (request.params.size() > 1)
+        nSince = request.params[1].get_int64();
+    if (nSince < 0)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid since, must not be negative");
+
+    int nLimit = 0;
+    if (request.params.size() > 2)
+        nLimit = request.params[2].get_int();
+    if (nLimit < 0)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid limit, must not be negative");
+
+    std::vector<CMessage> vMessages;
+    {
+        LOCK(cs_messaging);
+        pmessagedb->LoadMessages(vMessages, channel, nSince, nLimit);
     }
 
     UniValue messages(UniValue::VARR);
 
-    for (auto message : setMessages) {
+    for (const auto& message : vMessages) {
         UniValue obj(UniValue::VOBJ);
 
         obj.push_back(Pair("Asset Name", message.strName));
@@ -488,7 +493,7 @@ UniValue viewmyrestrictedaddresses(const JSONRPCRequest& request) {
 static const CRPCCommand commands[] =
     {           //  category    name                          actor (function)             argNames
                 //  ----------- ------------------------      -----------------------      ----------
-            { "messages",       "viewallmessages",            &viewallmessages,            {}},
+            { "messages",       "viewallmessages",            &viewallmessages,            {"channel", "since", "limit"}},
             { "messages",       "viewallmessagechannels",     &viewallmessagechannels,     {}},
             { "messages",       "subscribetochannel",         &subscribetochannel,         {"channel_name"}},
             { "messages",       "unsubscribefromchannel",     &unsubscribefromchannel,     {"channel_name"}},
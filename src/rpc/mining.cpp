@@ -786,7 +786,7 @@ static UniValue getkawpowhash(const JSONRPCRequest& request) {
     if (nHeight > (uint32_t)chainActive.Height() + 10)
         throw JSONRPCError(RPC_DESERIALIZATION_ERROR, "Block height is to large");
 
-    const auto header_hash = to_hash256(str_header_hash);
+    const auto header_hash = to_hash256(uint256S(str_header_hash));
 
     uint256 target;
     bool fCheckTarget = false;
@@ -795,18 +795,14 @@ static UniValue getkawpowhash(const JSONRPCRequest& request) {
         fCheckTarget = true;
     }
 
-    static ethash::epoch_context_ptr context{nullptr, nullptr};
-
     // Get the context from the block height
-    const auto epoch_number = ethash::get_epoch_number(nHeight);
-    if (!context || context->epoch_number != epoch_number)
-        context = ethash::create_epoch_context(epoch_number);
+    const auto context = GetEthashEpochContext(nHeight);
 
     // ProgPow hash
     const auto result = progpow::hash(*context, nHeight, header_hash, nNonce);
 
-    uint256 mined_mix_hash = uint256S(to_hex(result.mix_hash));
-    uint256 mined_final_hash = uint256S(to_hex(result.final_hash));
+    uint256 mined_mix_hash = to_uint256(result.mix_hash);
+    uint256 mined_final_hash = to_uint256(result.final_hash);
 
     bool mix_hash_match = false;
     bool final_hash_meets_target = false;
@@ -26,6 +26,7 @@
 #endif
 #include "warnings.h"
 
+#include <functional>
 #include <stdint.h>
 #ifdef HAVE_MALLOC_INFO
 #include <malloc.h>
@@ -505,6 +506,30 @@ static UniValue RPCLockedMemoryInfo()
     return obj;
 }
 
+static UniValue RPCEthashMemoryInfo()
+{
+    EthashContextCacheStats stats = GetEthashContextCacheStats();
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("contexts", uint64_t(stats.size)));
+    obj.push_back(Pair("max_contexts", uint64_t(stats.capacity)));
+    obj.push_back(Pair("bytes", uint64_t(stats.memory)));
+    obj.push_back(Pair("hits", stats.hits));
+    obj.push_back(Pair("misses", stats.misses));
+    obj.push_back(Pair("prebuilt", stats.prebuilt));
+    obj.push_back(Pair("evictions", stats.evictions));
+    return obj;
+}
+
+static UniValue RPCHeaderHashInfo()
+{
+    uint64_t nComputed, nCached;
+    GetBlockHeaderHashStats(nComputed, nCached);
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("computed", nComputed));
+    obj.push_back(Pair("cached", nCached));
+    return obj;
+}
+
 #ifdef HAVE_MALLOC_INFO
 static std::string RPCMallocInfo()
 {
@@ -546,6 +571,19 @@ UniValue getmemoryinfo(const JSONRPCRequest& request)
             "    \"locked\": xxxxxx,       (numeric) Amount of bytes that succeeded locking. If this number is smaller than total, locking pages failed at some point and key data could be swapped to disk.\n"
             "    \"chunks_used\": xxxxx,   (numeric) Number allocated chunks\n"
             "    \"chunks_free\": xxxxx,   (numeric) Number unused chunks\n"
+            "  },\n"
+            "  \"ethash\": {               (json object) Information about the ethash epoch contexts kept for KAWPOW verification\n"
+            "    \"contexts\": xx,         (numeric) Number of epoch contexts held\n"
+            "    \"max_contexts\": xx,     (numeric) Maximum number of epoch contexts held (-ethashcachesize)\n"
+            "    \"bytes\": xxxxxxx,       (numeric) Bytes used by the light caches of the held contexts\n"
+            "    \"hits\": xxxxx,          (numeric) Lookups served from a held context\n"
+            "    \"misses\": xxxxx,        (numeric) Lookups that had to build a context\n"
+            "    \"prebuilt\": xxxxx,      (numeric) Contexts built ahead of an epoch boundary in the background\n"
+            "    \"evictions\": xxxxx,     (numeric) Contexts dropped to stay within max_contexts\n"
+            "  },\n"
+            "  \"headerhash\": {           (json object) Block header proof of work hashing\n"
+            "    \"computed\": xxxxx,      (numeric) Header hashes computed\n"
+            "    \"cached\": xxxxx,        (numeric) Header hashes served from the header's memoized hash\n"
             "  }\n"
             "}\n"
             "\nResult (mode \"mallocinfo\"):\n"
@@ -559,6 +597,8 @@ UniValue getmemoryinfo(const JSONRPCRequest& request)
     if (mode == "stats") {
         UniValue obj(UniValue::VOBJ);
         obj.push_back(Pair("locked", RPCLockedMemoryInfo()));
+        obj.push_back(Pair("ethash", RPCEthashMemoryInfo()));
+        obj.push_back(Pair("headerhash", RPCHeaderHashInfo()));
         return obj;
     } else if (mode == "mallocinfo") {
 #ifdef HAVE_MALLOC_INFO
@@ -709,6 +749,260 @@ bool timestampSort(std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> a,
     return a.second.time < b.second.time;
 }
 
+/** Entries read from the address index at a time while a result is streamed or paged through */
+static const size_t ADDRESS_INDEX_PAGE_SIZE = 10000;
+
+/** The optional "limit" and "after" of the address index RPCs, to page through the history of one address */
+struct AddressIndexPaging
+{
+    size_t nLimit;
+    std::string strAfter;
+
+    AddressIndexPaging() : nLimit(0) {}
+    bool IsPaged() const { return nLimit > 0 || !strAfter.empty(); }
+    /** Entries to read for a page: one more than the limit tells whether another page follows */
+    size_t ReadLimit() const { return nLimit > 0 ? nLimit + 1 : 0; }
+};
+
+static AddressIndexPaging getAddressIndexPaging(const UniValue& params, size_t nAddresses)
+{
+    AddressIndexPaging paging;
+    if (!params[0].isObject())
+        return paging;
+
+    UniValue limitValue = find_value(params[0].get_obj(), "limit");
+    if (!limitValue.isNull()) {
+        int nLimit = limitValue.get_int();
+        if (nLimit <= 0) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Limit is expected to be greater than zero");
+        }
+        paging.nLimit = nLimit;
+    }
+    UniValue afterValue = find_value(params[0].get_obj(), "after");
+    if (!afterValue.isNull()) {
+        paging.strAfter = afterValue.get_str();
+    }
+    if (paging.IsPaged() && nAddresses != 1) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Limit and after can only be used with a single address");
+    }
+    return paging;
+}
+
+/** The "after" cursor of a page is the last key of the address index it returned */
+template <typename K>
+static std::string MakeAddressIndexCursor(const K& key)
+{
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << key;
+    return HexStr(ss.begin(), ss.end());
+}
+
+template <typename K>
+static K ParseAddressIndexCursor(const std::string& strAfter, const std::pair<uint160, int>& address)
+{
+    if (!IsHex(strAfter)) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid after cursor");
+    }
+    std::vector<unsigned char> data(ParseHex(strAfter));
+    CDataStream ss(data, SER_DISK, CLIENT_VERSION);
+    K key;
+    try {
+        ss >> key;
+    } catch (const std::exception&) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid after cursor");
+    }
+    if (!ss.empty() || key.hashBytes != address.first || (int)key.type != address.second) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid after cursor");
+    }
+    return key;
+}
+
+static UniValue AddressDeltaToJSON(const std::pair<CAddressIndexKey, CAmount>& delta)
+{
+    std::string address;
+    if (!getAddressFromIndex(delta.first.type, delta.first.hashBytes, address)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.push_back(Pair("assetName", delta.first.asset));
+    result.push_back(Pair("satoshis", delta.second));
+    result.push_back(Pair("txid", delta.first.txhash.GetHex()));
+    result.push_back(Pair("index", (int)delta.first.index));
+    result.push_back(Pair("blockindex", (int)delta.first.txindex));
+    result.push_back(Pair("height", delta.first.blockHeight));
+    result.push_back(Pair("address", address));
+    return result;
+}
+
+static UniValue AddressUtxoToJSON(const std::pair<CAddressUnspentKey, CAddressUnspentValue>& utxo, const std::string& assetName)
+{
+    std::string address;
+    if (!getAddressFromIndex(utxo.first.type, utxo.first.hashBytes, address)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
+    }
+
+    std::string assetNameOut = "RVN";
+    if (assetName != "RVN") {
+        CAmount _amount;
+        if (!GetAssetInfoFromScript(utxo.second.script, assetNameOut, _amount)) {
+            throw JSONRPCError(RPC_INTERNAL_ERROR, "Couldn't decode asset script");
+        }
+    }
+
+    UniValue output(UniValue::VOBJ);
+    output.push_back(Pair("address", address));
+    output.push_back(Pair("assetName", assetNameOut));
+    output.push_back(Pair("txid", utxo.first.txhash.GetHex()));
+    output.push_back(Pair("outputIndex", (int)utxo.first.index));
+    output.push_back(Pair("script", HexStr(utxo.second.script.begin(), utxo.second.script.end())));
+    output.push_back(Pair("satoshis", utxo.second.satoshis));
+    output.push_back(Pair("height", utxo.second.blockHeight));
+    return output;
+}
+
+/**
+ * Read the txids of one address in chain order, a page of deltas at a time, passing each to fn until it
+ * returns false. Reading starts after the cursor, skipping the rest of the cursor's transaction, and
+ * leaves the cursor on the last delta of the last txid passed. Returns whether more txids follow.
+ */
+static bool ReadAddressTxids(const std::pair<uint160, int>& address, bool includeAssets, int start, int end,
+                             CAddressIndexKey& cursor, bool& fCursor, std::function<bool(const uint256&)> fn)
+{
+    while (true) {
+        std::vector<std::pair<CAddressIndexKey, CAmount> > deltas;
+        const CAddressIndexKey* pAfter = fCursor ? &cursor : nullptr;
+        bool fRead = includeAssets ? GetAddressIndex(address.first, address.second, deltas, start, end, pAfter, ADDRESS_INDEX_PAGE_SIZE)
+                                   : GetAddressIndex(address.first, address.second, RVN, deltas, start, end, pAfter, ADDRESS_INDEX_PAGE_SIZE);
+        if (!fRead) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+        }
+
+        for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=deltas.begin(); it!=deltas.end(); it++) {
+            if (!fCursor || it->first.txhash != cursor.txhash) {
+                if (!fn(it->first.txhash))
+                    return true;
+            }
+            cursor = it->first;
+            fCursor = true;
+        }
+
+        if (deltas.size() < ADDRESS_INDEX_PAGE_SIZE)
+            return false;
+    }
+}
+
+/** One address's deltas, of one asset or of all of them in chain order, read from the address index a page at a time */
+class CAddressDeltaPager
+{
+public:
+    CAddressDeltaPager(const std::pair<uint160, int>& addressIn, const std::string& assetNameIn, int startIn, int endIn)
+        : address(addressIn), assetName(assetNameIn), start(startIn), end(endIn), nPos(0), fLast(false)
+    {
+        ReadPage();
+    }
+
+    bool Valid() const { return nPos < page.size(); }
+    const CAddressIndexKey& Key() const { return page[nPos].first; }
+
+    void Next()
+    {
+        if (++nPos == page.size() && !fLast)
+            ReadPage();
+    }
+
+private:
+    std::pair<uint160, int> address;
+    //! Empty for all assets, which only come in chain order from the height ordered index
+    std::string assetName;
+    int start;
+    int end;
+    std::vector<std::pair<CAddressIndexKey, CAmount> > page;
+    size_t nPos;
+    bool fLast;
+
+    void ReadPage()
+    {
+        CAddressIndexKey after;
+        bool fAfter = !page.empty();
+        if (fAfter)
+            after = page.back().first;
+        page.clear();
+        nPos = 0;
+
+        const CAddressIndexKey* pAfter = fAfter ? &after : nullptr;
+        bool fRead = assetName.empty() ? GetAddressIndex(address.first, address.second, page, start, end, pAfter, ADDRESS_INDEX_PAGE_SIZE)
+                                       : GetAddressIndex(address.first, address.second, assetName, page, start, end, pAfter, ADDRESS_INDEX_PAGE_SIZE);
+        if (!fRead) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+        }
+        fLast = page.size() < ADDRESS_INDEX_PAGE_SIZE;
+    }
+};
+
+/**
+ * Read the deltas of many addresses in chain order, by height and then by position in the block, of one asset or
+ * when assetName is empty of all of them. Each address, or without the height ordered index each asset of it, is
+ * read a page at a time and merged, so memory grows with their number rather than with the history. All first
+ * pages are read before fn is first called.
+ */
+static void ReadAddressesDeltas(const std::vector<std::pair<uint160, int> >& addresses, const std::string& assetName, int start, int end,
+                                std::function<void(const CAddressIndexKey&)> fn)
+{
+    std::vector<CAddressDeltaPager> pagers;
+    for (std::vector<std::pair<uint160, int> >::const_iterator it = addresses.begin(); it != addresses.end(); it++) {
+        if (!assetName.empty() || fAddressHeightIndex) {
+            pagers.emplace_back(*it, assetName, start, end);
+        } else {
+            std::vector<std::string> assets;
+            if (!GetAddressIndexAssets((*it).first, (*it).second, assets)) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+            }
+            for (const std::string& asset : assets)
+                pagers.emplace_back(*it, asset, start, end);
+        }
+    }
+
+    // A heap of the pagers, the one whose next delta comes first in the chain on top
+    auto fAfterInChain = [](const CAddressDeltaPager* a, const CAddressDeltaPager* b) {
+        return std::make_pair(a->Key().blockHeight, a->Key().txindex) > std::make_pair(b->Key().blockHeight, b->Key().txindex);
+    };
+    std::vector<CAddressDeltaPager*> heap;
+    for (CAddressDeltaPager& pager : pagers) {
+        if (pager.Valid())
+            heap.push_back(&pager);
+    }
+    std::make_heap(heap.begin(), heap.end(), fAfterInChain);
+
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), fAfterInChain);
+        CAddressDeltaPager* pager = heap.back();
+        fn(pager->Key());
+        pager->Next();
+        if (pager->Valid()) {
+            std::push_heap(heap.begin(), heap.end(), fAfterInChain);
+        } else {
+            heap.pop_back();
+        }
+    }
+}
+
+/** Read the txids of many addresses in chain order, passing each once to fn */
+static void ReadAddressesTxids(const std::vector<std::pair<uint160, int> >& addresses, bool includeAssets, int start, int end,
+                               std::function<void(const uint256&)> fn)
+{
+    // The deltas of a transaction come one after another, as they share its place in the chain
+    uint256 prevhash;
+    bool fPrev = false;
+    ReadAddressesDeltas(addresses, includeAssets ? "" : RVN, start, end, [&](const CAddressIndexKey& key) {
+        if (!fPrev || key.txhash != prevhash) {
+            prevhash = key.txhash;
+            fPrev = true;
+            fn(prevhash);
+        }
+    });
+}
+
 UniValue getaddressmempool(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() > 2)
@@ -815,8 +1109,10 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
             "    ],\n"
             "  \"chainInfo\",  (boolean, optional, default false) Include chain info with results\n"
             "  \"assetName\"   (string, optional) Get UTXOs for a particular asset instead of RVN ('*' for all assets).\n"
+            "  \"limit\"       (number, optional) Return at most this many UTXOs of a single address, in index order rather than by height\n"
+            "  \"after\"       (string, optional) Continue after the page that returned this cursor\n"
             "}\n"
-            "\nResult\n"
+            "\nResult (by height)\n"
             "[\n"
             "  {\n"
             "    \"address\"  (string) The address base58check encoded\n"
@@ -828,6 +1124,13 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
             "    \"satoshis\"  (number) The number of satoshis of the output\n"
             "  }\n"
             "]\n"
+            "\nResult (with limit or after, or chainInfo)\n"
+            "{\n"
+            "  \"utxos\": [...],  (array) The UTXOs as above\n"
+            "  \"after\": \"xxxx\",  (string) Cursor of the next page, if there may be one\n"
+            "  \"hash\": \"xxxx\",   (string) With chainInfo, the hash of the chain tip\n"
+            "  \"height\": n,      (number) With chainInfo, the height of the chain tip\n"
+            "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getaddressutxos", "'{\"addresses\": [\"12c6DSiU4Rq3P4ZxziKxzrL5LmMBrzjrJX\"]}'")
             + HelpExampleRpc("getaddressutxos", "{\"addresses\": [\"12c6DSiU4Rq3P4ZxziKxzrL5LmMBrzjrJX\"]}")
@@ -856,56 +1159,112 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
+    AddressIndexPaging paging = getAddressIndexPaging(request.params, addresses.size());
+    CAddressUnspentKey after;
+    if (!paging.strAfter.empty()) {
+        after = ParseAddressIndexCursor<CAddressUnspentKey>(paging.strAfter, addresses[0]);
+        if (assetName != "*" && after.asset != assetName) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid after cursor");
+        }
+    }
+    const CAddressUnspentKey* pAfter = paging.strAfter.empty() ? nullptr : &after;
+
+    // Without a limit, the UTXOs are streamed where the transport allows it, by height as otherwise. When there
+    // are more than a page of them, they're found in chain order from the address deltas that received them
+    if (request.resultStream && !includeChainInfo && !paging.IsPaged()) {
+        std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > unspentOutputs;
+        for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
+            size_t nReadLimit = ADDRESS_INDEX_PAGE_SIZE + 1 - unspentOutputs.size();
+            bool fRead = assetName == "*" ? GetAddressUnspent((*it).first, (*it).second, unspentOutputs, nullptr, nReadLimit)
+                                          : GetAddressUnspent((*it).first, (*it).second, assetName, unspentOutputs, nullptr, nReadLimit);
+            if (!fRead) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+            }
+            if (unspentOutputs.size() > ADDRESS_INDEX_PAGE_SIZE)
+                break;
+        }
+
+        if (unspentOutputs.size() <= ADDRESS_INDEX_PAGE_SIZE) {
+            std::sort(unspentOutputs.begin(), unspentOutputs.end(), heightSort);
+            request.resultStream->BeginArray();
+            for (std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >::const_iterator it=unspentOutputs.begin(); it!=unspentOutputs.end(); it++) {
+                request.resultStream->Write(AddressUtxoToJSON(*it, assetName));
+            }
+            request.resultStream->EndArray();
+            return NullUniValue;
+        }
+        unspentOutputs.clear();
+
+        bool fStarted = false;
+        ReadAddressesDeltas(addresses, assetName == "*" ? "" : assetName, 0, 0, [&](const CAddressIndexKey& key) {
+            if (!fStarted) {
+                request.resultStream->BeginArray();
+                fStarted = true;
+            }
+            // All assets but RVN, as with the unspent index
+            if (key.spending || (assetName == "*" && key.asset == RVN))
+                return;
+            std::pair<CAddressUnspentKey, CAddressUnspentValue> utxo;
+            utxo.first = CAddressUnspentKey(key.type, key.hashBytes, key.asset, key.txhash, key.index);
+            if (GetAddressUnspentOutput(utxo.first, utxo.second)) {
+                request.resultStream->Write(AddressUtxoToJSON(utxo, assetName));
+            }
+        });
+        if (!fStarted)
+            request.resultStream->BeginArray();
+        request.resultStream->EndArray();
+        return NullUniValue;
+    }
+
     std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > unspentOutputs;
 
-    for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
+    // Many addresses are read in one pass over the index, paging only ever has one
+    if (addresses.size() > 1) {
+        bool fRead = assetName == "*" ? GetAddressUnspent(addresses, unspentOutputs)
+                                      : GetAddressUnspent(addresses, assetName, unspentOutputs);
+        if (!fRead) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+        }
+    } else for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
         if (assetName == "*") {
-            if (!GetAddressUnspent((*it).first, (*it).second, unspentOutputs)) {
+            if (!GetAddressUnspent((*it).first, (*it).second, unspentOutputs, pAfter, paging.ReadLimit())) {
                 throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
             }
         } else {
-            if (!GetAddressUnspent((*it).first, (*it).second, assetName, unspentOutputs)) {
+            if (!GetAddressUnspent((*it).first, (*it).second, assetName, unspentOutputs, pAfter, paging.ReadLimit())) {
                 throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
             }
         }
     }
 
-    std::sort(unspentOutputs.begin(), unspentOutputs.end(), heightSort);
+    // Pages come in index order, as sorting them by height would need all of them
+    bool fMore = false;
+    if (paging.IsPaged()) {
+        fMore = paging.nLimit > 0 && unspentOutputs.size() > paging.nLimit;
+        if (fMore)
+            unspentOutputs.resize(paging.nLimit);
+    } else {
+        std::sort(unspentOutputs.begin(), unspentOutputs.end(), heightSort);
+    }
 
     UniValue utxos(UniValue::VARR);
 
     for (std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >::const_iterator it=unspentOutputs.begin(); it!=unspentOutputs.end(); it++) {
-        UniValue output(UniValue::VOBJ);
-        std::string address;
-        if (!getAddressFromIndex(it->first.type, it->first.hashBytes, address)) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
-        }
-
-        std::string assetNameOut = "RVN";
-        if (assetName != "RVN") {
-            CAmount _amount;
-            if (!GetAssetInfoFromScript(it->second.script, assetNameOut, _amount)) {
-                throw JSONRPCError(RPC_INTERNAL_ERROR, "Couldn't decode asset script");
-            }
-        }
-
-        output.push_back(Pair("address", address));
-        output.push_back(Pair("assetName", assetNameOut));
-        output.push_back(Pair("txid", it->first.txhash.GetHex()));
-        output.push_back(Pair("outputIndex", (int)it->first.index));
-        output.push_back(Pair("script", HexStr(it->second.script.begin(), it->second.script.end())));
-        output.push_back(Pair("satoshis", it->second.satoshis));
-        output.push_back(Pair("height", it->second.blockHeight));
-        utxos.push_back(output);
+        utxos.push_back(AddressUtxoToJSON(*it, assetName));
     }
 
-    if (includeChainInfo) {
+    if (includeChainInfo || paging.IsPaged()) {
         UniValue result(UniValue::VOBJ);
         result.push_back(Pair("utxos", utxos));
+        if (fMore) {
+            result.push_back(Pair("after", MakeAddressIndexCursor(unspentOutputs.back().first)));
+        }
 
-        LOCK(cs_main);
-        result.push_back(Pair("hash", chainActive.Tip()->GetBlockHash().GetHex()));
-        result.push_back(Pair("height", (int)chainActive.Height()));
+        if (includeChainInfo) {
+            LOCK(cs_main);
+            result.push_back(Pair("hash", chainActive.Tip()->GetBlockHash().GetHex()));
+            result.push_back(Pair("height", (int)chainActive.Height()));
+        }
         return result;
     } else {
         return utxos;
@@ -929,6 +1288,8 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
             "  \"end\" (number) The end block height\n"
             "  \"chainInfo\" (boolean) Include chain info in results, only applies if start and end specified\n"
             "  \"assetName\"   (string, optional) Get deltas for a particular asset instead of RVN.\n"
+            "  \"limit\"       (number, optional) Return at most this many deltas of a single address\n"
+            "  \"after\"       (string, optional) Continue after the page that returned this cursor\n"
             "}\n"
             "\nResult:\n"
             "[\n"
@@ -941,6 +1302,13 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
             "    \"address\"  (string) The base58check encoded address\n"
             "  }\n"
             "]\n"
+            "\nResult (with limit or after, or chainInfo):\n"
+            "{\n"
+            "  \"deltas\": [...],  (array) The deltas as above\n"
+            "  \"after\": \"xxxx\",  (string) Cursor of the next page, if there may be one\n"
+            "  \"start\": {...},   (object) With chainInfo, the hash and height of the start block\n"
+            "  \"end\": {...},     (object) With chainInfo, the hash and height of the end block\n"
+            "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getaddressdeltas", "'{\"addresses\": [\"12c6DSiU4Rq3P4ZxziKxzrL5LmMBrzjrJX\"]}'")
             + HelpExampleRpc("getaddressdeltas", "{\"addresses\": [\"12c6DSiU4Rq3P4ZxziKxzrL5LmMBrzjrJX\"]}")
@@ -986,42 +1354,82 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
+    AddressIndexPaging paging = getAddressIndexPaging(request.params, addresses.size());
+    bool fChainInfo = includeChainInfo && start > 0 && end > 0;
+
+    // Without a limit, the deltas are streamed page by page where the transport allows it
+    if (request.resultStream && !fChainInfo && !paging.IsPaged()) {
+        bool fStarted = false;
+        for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
+            CAddressIndexKey after;
+            bool fAfter = false;
+            while (true) {
+                std::vector<std::pair<CAddressIndexKey, CAmount> > page;
+                if (!GetAddressIndex((*it).first, (*it).second, assetName, page, start, end, fAfter ? &after : nullptr, ADDRESS_INDEX_PAGE_SIZE)) {
+                    throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+                }
+                if (!fStarted) {
+                    request.resultStream->BeginArray();
+                    fStarted = true;
+                }
+                for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator itDelta=page.begin(); itDelta!=page.end(); itDelta++) {
+                    request.resultStream->Write(AddressDeltaToJSON(*itDelta));
+                }
+                if (page.size() < ADDRESS_INDEX_PAGE_SIZE)
+                    break;
+                after = page.back().first;
+                fAfter = true;
+            }
+        }
+        request.resultStream->EndArray();
+        return NullUniValue;
+    }
+
+    CAddressIndexKey after;
+    if (!paging.strAfter.empty()) {
+        after = ParseAddressIndexCursor<CAddressIndexKey>(paging.strAfter, addresses[0]);
+        if (after.asset != assetName) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid after cursor");
+        }
+    }
+    const CAddressIndexKey* pAfter = paging.strAfter.empty() ? nullptr : &after;
+
     std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
 
     for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
         if (start > 0 && end > 0) {
-            if (!GetAddressIndex((*it).first, (*it).second, assetName, addressIndex, start, end)) {
+            if (!GetAddressIndex((*it).first, (*it).second, assetName, addressIndex, start, end, pAfter, paging.ReadLimit())) {
                 throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
             }
         } else {
-            if (!GetAddressIndex((*it).first, (*it).second, assetName, addressIndex)) {
+            if (!GetAddressIndex((*it).first, (*it).second, assetName, addressIndex, 0, 0, pAfter, paging.ReadLimit())) {
                 throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
             }
         }
     }
 
+    bool fMore = paging.nLimit > 0 && addressIndex.size() > paging.nLimit;
+    if (fMore)
+        addressIndex.resize(paging.nLimit);
+
     UniValue deltas(UniValue::VARR);
 
     for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=addressIndex.begin(); it!=addressIndex.end(); it++) {
-        std::string address;
-        if (!getAddressFromIndex(it->first.type, it->first.hashBytes, address)) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
-        }
+        deltas.push_back(AddressDeltaToJSON(*it));
+    }
 
-        UniValue delta(UniValue::VOBJ);
-        delta.push_back(Pair("assetName", it->first.asset));
-        delta.push_back(Pair("satoshis", it->second));
-        delta.push_back(Pair("txid", it->first.txhash.GetHex()));
-        delta.push_back(Pair("index", (int)it->first.index));
-        delta.push_back(Pair("blockindex", (int)it->first.txindex));
-        delta.push_back(Pair("height", it->first.blockHeight));
-        delta.push_back(Pair("address", address));
-        deltas.push_back(delta);
+    if (paging.IsPaged() && !fChainInfo) {
+        UniValue result(UniValue::VOBJ);
+        result.push_back(Pair("deltas", deltas));
+        if (fMore) {
+            result.push_back(Pair("after", MakeAddressIndexCursor(addressIndex.back().first)));
+        }
+        return result;
     }
 
     UniValue result(UniValue::VOBJ);
 
-    if (includeChainInfo && start > 0 && end > 0) {
+    if (fChainInfo) {
         LOCK(cs_main);
 
         if (start > chainActive.Height() || end > chainActive.Height()) {
@@ -1041,6 +1449,9 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
         endInfo.push_back(Pair("height", end));
 
         result.push_back(Pair("deltas", deltas));
+        if (fMore) {
+            result.push_back(Pair("after", MakeAddressIndexCursor(addressIndex.back().first)));
+        }
         result.push_back(Pair("start", startInfo));
         result.push_back(Pair("end", endInfo));
 
@@ -1101,27 +1512,20 @@ UniValue getaddressbalance(const JSONRPCRequest& request)
         if (!AreAssetsDeployed())
             throw JSONRPCError(RPC_INVALID_PARAMETER, "Assets aren't active.  includeAssets can't be true.");
 
-        std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+        std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue> > addressBalances;
 
-        for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-            if (!GetAddressIndex((*it).first, (*it).second, addressIndex)) {
-                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-            }
+        if (!GetAddressBalances(addresses, addressBalances)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
         }
 
         //assetName -> (received, balance)
         std::map<std::string, std::pair<CAmount, CAmount>> balances;
 
-        for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it = addressIndex.begin();
-             it != addressIndex.end(); it++) {
-            std::string assetName = it->first.asset;
-            if (balances.count(assetName) == 0) {
-                balances[assetName] = std::make_pair(0, 0);
-            }
-            if (it->second > 0) {
-                balances[assetName].first += it->second;
-            }
-            balances[assetName].second += it->second;
+        for (std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue> >::const_iterator it = addressBalances.begin();
+             it != addressBalances.end(); it++) {
+            std::pair<CAmount, CAmount>& assetBalance = balances[it->first.asset];
+            assetBalance.first += it->second.received;
+            assetBalance.second += it->second.balance;
         }
 
         UniValue result(UniValue::VARR);
@@ -1138,23 +1542,26 @@ UniValue getaddressbalance(const JSONRPCRequest& request)
         return result;
 
     } else {
-        std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
-
-        for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-            if (!GetAddressIndex((*it).first, (*it).second, RVN, addressIndex)) {
-                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-            }
-        }
-
         CAmount balance = 0;
         CAmount received = 0;
 
-        for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it = addressIndex.begin();
-             it != addressIndex.end(); it++) {
-            if (it->second > 0) {
-                received += it->second;
+        if (addresses.size() != 1) {
+            std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue> > addressBalances;
+            if (!GetAddressBalances(addresses, RVN, addressBalances)) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+            }
+            for (std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue> >::const_iterator it = addressBalances.begin();
+                 it != addressBalances.end(); it++) {
+                balance += it->second.balance;
+                received += it->second.received;
+            }
+        } else {
+            CAddressBalanceValue addressBalance;
+            if (!GetAddressBalance(addresses[0].first, addresses[0].second, RVN, addressBalance)) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
             }
-            balance += it->second;
+            balance += addressBalance.balance;
+            received += addressBalance.received;
         }
 
         UniValue result(UniValue::VOBJ);
@@ -1181,13 +1588,20 @@ UniValue getaddresstxids(const JSONRPCRequest& request)
             "    ]\n"
             "  \"start\" (number, optional) The start block height\n"
             "  \"end\" (number, optional) The end block height\n"
+            "  \"limit\" (number, optional) Return at most this many txids of a single address\n"
+            "  \"after\" (string, optional) Continue after the page that returned this cursor\n"
             "},\n"
             "\"includeAssets\" (boolean, optional, default false)  If true this will return an expanded result which includes asset transactions\n"
-            "\nResult:\n"
+            "\nResult (in chain order, by height and then by position in the block):\n"
             "[\n"
             "  \"transactionid\"  (string) The transaction id\n"
             "  ,...\n"
             "]\n"
+            "\nResult (with limit or after):\n"
+            "{\n"
+            "  \"txids\": [...],   (array) The txids as above\n"
+            "  \"after\": \"xxxx\",  (string) Cursor of the next page, if there may be one\n"
+            "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getaddresstxids", "'{\"addresses\": [\"12c6DSiU4Rq3P4ZxziKxzrL5LmMBrzjrJX\"]}'")
             + HelpExampleRpc("getaddresstxids", "{\"addresses\": [\"12c6DSiU4Rq3P4ZxziKxzrL5LmMBrzjrJX\"]}")
@@ -1211,6 +1625,11 @@ UniValue getaddresstxids(const JSONRPCRequest& request)
             end = endValue.get_int();
         }
     }
+    // A range only applies with both of its ends
+    if (start <= 0 || end <= 0) {
+        start = 0;
+        end = 0;
+    }
 
     bool includeAssets = false;
     if (request.params.size() > 1) {
@@ -1221,54 +1640,62 @@ UniValue getaddresstxids(const JSONRPCRequest& request)
         if (!AreAssetsDeployed())
             throw JSONRPCError(RPC_INVALID_PARAMETER, "Assets aren't active.  includeAssets can't be true.");
 
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+    AddressIndexPaging paging = getAddressIndexPaging(request.params, addresses.size());
 
-    for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        if (includeAssets) {
-            if (start > 0 && end > 0) {
-                if (!GetAddressIndex((*it).first, (*it).second, addressIndex, start, end)) {
-                    throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-                }
-            } else {
-                if (!GetAddressIndex((*it).first, (*it).second, addressIndex)) {
-                    throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-                }
-            }
-        } else {
-            if (start > 0 && end > 0) {
-                if (!GetAddressIndex((*it).first, (*it).second, RVN, addressIndex, start, end)) {
-                    throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-                }
-            } else {
-                if (!GetAddressIndex((*it).first, (*it).second, RVN, addressIndex)) {
-                    throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-                }
-            }
+    if (paging.IsPaged()) {
+        // Pages continue from the last delta returned, so they need a single address's deltas in chain order,
+        // which with every asset only the height ordered index has
+        if (includeAssets && !fAddressHeightIndex) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Limit and after with includeAssets require -addressheightindex");
         }
-    }
 
-    std::set<std::pair<int, std::string> > txids;
-    UniValue result(UniValue::VARR);
+        CAddressIndexKey cursor;
+        bool fCursor = false;
+        if (!paging.strAfter.empty()) {
+            cursor = ParseAddressIndexCursor<CAddressIndexKey>(paging.strAfter, addresses[0]);
+            if (!includeAssets && cursor.asset != RVN) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid after cursor");
+            }
+            fCursor = true;
+        }
 
-    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=addressIndex.begin(); it!=addressIndex.end(); it++) {
-        int height = it->first.blockHeight;
-        std::string txid = it->first.txhash.GetHex();
+        UniValue txids(UniValue::VARR);
+        bool fMore = ReadAddressTxids(addresses[0], includeAssets, start, end, cursor, fCursor, [&](const uint256& txhash) -> bool {
+            if (paging.nLimit > 0 && txids.size() >= paging.nLimit)
+                return false;
+            txids.push_back(txhash.GetHex());
+            return true;
+        });
 
-        if (addresses.size() > 1) {
-            txids.insert(std::make_pair(height, txid));
-        } else {
-            if (txids.insert(std::make_pair(height, txid)).second) {
-                result.push_back(txid);
-            }
+        UniValue result(UniValue::VOBJ);
+        result.push_back(Pair("txids", txids));
+        if (fMore) {
+            result.push_back(Pair("after", MakeAddressIndexCursor(cursor)));
         }
+        return result;
     }
 
-    if (addresses.size() > 1) {
-        for (std::set<std::pair<int, std::string> >::const_iterator it=txids.begin(); it!=txids.end(); it++) {
-            result.push_back(it->second);
-        }
+    // Without a limit, the txids are streamed where the transport allows it, in the same order as otherwise
+    if (request.resultStream) {
+        bool fStarted = false;
+        ReadAddressesTxids(addresses, includeAssets, start, end, [&](const uint256& txhash) {
+            if (!fStarted) {
+                request.resultStream->BeginArray();
+                fStarted = true;
+            }
+            request.resultStream->Write(txhash.GetHex());
+        });
+        if (!fStarted)
+            request.resultStream->BeginArray();
+        request.resultStream->EndArray();
+        return NullUniValue;
     }
 
+    UniValue result(UniValue::VARR);
+    ReadAddressesTxids(addresses, includeAssets, start, end, [&](const uint256& txhash) {
+        result.push_back(txhash.GetHex());
+    });
+
     return result;
 
 }
@@ -35,6 +35,7 @@
 #include "wallet/walletdb.h"
 #include "assets/snapshotrequestdb.h"
 #include "assets/assetsnapshotdb.h"
+#include "assets/rewards.h"
 
 #ifdef ENABLE_WALLET
 
@@ -145,6 +146,11 @@ UniValue getsnapshotrequest(const JSONRPCRequest& request) {
                 "{\n"
                 "  asset_name: (string),\n"
                 "  block_height: (number),\n"
+                "  snapshot: {                  (only once the snapshot has been started)\n"
+                "    status: (string),          \"in_progress\", \"complete\" or \"failed\"\n"
+                "    owners_processed: (number),\n"
+                "    elapsed_ms: (number),\n"
+                "  }\n"
                 "}\n"
 
                 "\nExamples:\n"
@@ -172,6 +178,15 @@ UniValue getsnapshotrequest(const JSONRPCRequest& request) {
         obj.push_back(Pair("asset_name", snapshotRequest.assetName));
         obj.push_back(Pair("block_height", snapshotRequest.heightForSnapshot));
 
+        CAssetSnapshotStatus snapshotStatus;
+        if (pAssetSnapshotDb && pAssetSnapshotDb->GetSnapshotStatus(asset_name, block_height, snapshotStatus)) {
+            UniValue status(UniValue::VOBJ);
+            status.push_back(Pair("status", snapshotStatus.StateString()));
+            status.push_back(Pair("owners_processed", (uint64_t)snapshotStatus.ownerCount));
+            status.push_back(Pair("elapsed_ms", snapshotStatus.elapsedTime / 1000));
+            obj.push_back(Pair("snapshot", status));
+        }
+
         return obj;
     }
     else {
@@ -479,6 +494,21 @@ UniValue getdistributestatus(const JSONRPCRequest& request) {
 }
 #endif
 
+UniValue syncwithrewardsthread(const JSONRPCRequest& request) {
+    if (request.fHelp || request.params.size() > 0)
+        throw std::runtime_error(
+                "syncwithrewardsthread\n"
+                "\nWaits for the rewards thread to take the ownership snapshots and look over the distributions queued so far.\n"
+
+                "\nExamples:\n"
+                + HelpExampleCli("syncwithrewardsthread", "")
+                + HelpExampleRpc("syncwithrewardsthread", "")
+        );
+
+    SyncWithRewardsThread();
+    return NullUniValue;
+}
+
 
 
 static const CRPCCommand commands[] =
@@ -490,8 +520,9 @@ static const CRPCCommand commands[] =
             {   "rewards",      "listsnapshotrequests",         &listsnapshotrequests,         {"asset_name", "block_height"}},
             {   "rewards",      "cancelsnapshotrequest",      &cancelsnapshotrequest,      {"asset_name", "block_height"}},
             {   "rewards",      "distributereward",           &distributereward,           {"asset_name", "snapshot_height", "distribution_asset_name", "gross_distribution_amount", "exception_addresses", "change_address"}},
-            {   "rewards",      "getdistributestatus",        &getdistributestatus,            {"asset_name", "block_height", "distribution_asset_name", "gross_distribution_amount", "exception_addresses"}}
+            {   "rewards",      "getdistributestatus",        &getdistributestatus,            {"asset_name", "block_height", "distribution_asset_name", "gross_distribution_amount", "exception_addresses"}},
     #endif
+            {   "hidden",       "syncwithrewardsthread",      &syncwithrewardsthread,      {}}
     };
 
 void RegisterRewardsRPCCommands(CRPCTable &t)
@@ -37,6 +37,20 @@ struct UniValueType {
     UniValue::VType type;
 };
 
+/**
+ * Sends a large array result to the client element by element as an RPC method produces it, instead
+ * of it being returned as one UniValue. Only set where the transport can stream the reply.
+ */
+class RPCResultStream
+{
+public:
+    virtual ~RPCResultStream() {}
+    /** Start the result array. A method that streams its result returns NullUniValue after EndArray(). */
+    virtual void BeginArray() = 0;
+    virtual void Write(const UniValue& value) = 0;
+    virtual void EndArray() = 0;
+};
+
 class JSONRPCRequest
 {
 public:
@@ -46,8 +60,9 @@ public:
     bool fHelp;
     std::string URI;
     std::string authUser;
+    RPCResultStream* resultStream;
 
-    JSONRPCRequest() : id(NullUniValue), params(NullUniValue), fHelp(false) {}
+    JSONRPCRequest() : id(NullUniValue), params(NullUniValue), fHelp(false), resultStream(nullptr) {}
     void parse(const UniValue& valRequest);
 };
 
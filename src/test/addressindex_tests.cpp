@@ -0,0 +1,321 @@
+// Copyright (c) 2017-2020 The Raven Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "addressindex.h"
+#include "random.h"
+#include "txdb.h"
+#include "validation.h"
+#include "test/test_raven.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <map>
+#include <set>
+
+static uint160 RandomAddressHash()
+{
+    uint256 hash = InsecureRand256();
+    return uint160(std::vector<unsigned char>(hash.begin(), hash.begin() + 20));
+}
+
+// Balances summed from the deltas of an address, the way getaddressbalance used to
+static std::map<std::string, CAddressBalanceValue> SumAddressIndex(CBlockTreeDB& db, const uint160& addressHash, int type)
+{
+    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+    BOOST_CHECK(db.ReadAddressIndex(addressHash, type, addressIndex));
+    std::map<std::string, CAddressBalanceValue> balances;
+    for (const auto& delta : addressIndex)
+        balances[delta.first.asset].ApplyDelta(delta.second, 1);
+    for (auto it = balances.begin(); it != balances.end();) {
+        if (it->second.IsNull())
+            it = balances.erase(it);
+        else
+            ++it;
+    }
+    return balances;
+}
+
+static std::map<std::string, CAddressBalanceValue> ReadBalances(CBlockTreeDB& db, const uint160& addressHash, int type)
+{
+    std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue> > vBalances;
+    BOOST_CHECK(db.ReadAddressBalances(addressHash, type, vBalances));
+    std::map<std::string, CAddressBalanceValue> balances;
+    for (const auto& balance : vBalances) {
+        BOOST_CHECK(balance.first.hashBytes == addressHash);
+        balances[balance.first.asset] = balance.second;
+    }
+    return balances;
+}
+
+static bool SameBalances(const std::map<std::string, CAddressBalanceValue>& a, const std::map<std::string, CAddressBalanceValue>& b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (auto ita = a.begin(), itb = b.begin(); ita != a.end(); ++ita, ++itb) {
+        if (ita->first != itb->first || ita->second.balance != itb->second.balance || ita->second.received != itb->second.received)
+            return false;
+    }
+    return true;
+}
+
+BOOST_FIXTURE_TEST_SUITE(addressindex_tests, BasicTestingSetup)
+
+    BOOST_AUTO_TEST_CASE(address_balance_index_test)
+    {
+        BOOST_TEST_MESSAGE("Running Address Balance Index Test");
+
+        CBlockTreeDB db(1 << 20, true);
+        std::vector<uint160> vAddresses = {RandomAddressHash(), RandomAddressHash(), RandomAddressHash()};
+        std::vector<std::string> vAssets = {RVN, "ASSET", "ASSET/SUB"};
+
+        // Connect blocks of random receives and spends, keeping every block's deltas to disconnect them again
+        std::vector<std::vector<std::pair<CAddressIndexKey, CAmount> > > vBlocks;
+        for (int nHeight = 1; nHeight <= 50; nHeight++) {
+            std::vector<std::pair<CAddressIndexKey, CAmount> > vDeltas;
+            for (int i = 0; i < 20; i++) {
+                const uint160& addressHash = vAddresses[InsecureRandRange(vAddresses.size())];
+                const std::string& assetName = vAssets[InsecureRandRange(vAssets.size())];
+                bool fSpending = InsecureRandBool();
+                CAmount nValue = 1 + InsecureRandRange(100000);
+                vDeltas.push_back(std::make_pair(CAddressIndexKey(1 + (i % 2), addressHash, assetName, nHeight, i, InsecureRand256(), 0, fSpending),
+                                                 fSpending ? -nValue : nValue));
+            }
+            BOOST_CHECK(db.WriteAddressIndex(vDeltas));
+            vBlocks.push_back(vDeltas);
+        }
+
+        // Writing a block's deltas again, as after an unclean shutdown, doesn't count them twice
+        BOOST_CHECK(db.WriteAddressIndex(vBlocks.back()));
+
+        for (const uint160& addressHash : vAddresses) {
+            for (int type = 1; type <= 2; type++) {
+                std::map<std::string, CAddressBalanceValue> expected = SumAddressIndex(db, addressHash, type);
+                BOOST_CHECK(SameBalances(ReadBalances(db, addressHash, type), expected));
+
+                CAddressBalanceValue balance;
+                BOOST_CHECK(db.ReadAddressBalance(addressHash, type, RVN, balance));
+                BOOST_CHECK_EQUAL(balance.balance, expected[RVN].balance);
+                BOOST_CHECK_EQUAL(balance.received, expected[RVN].received);
+            }
+        }
+
+        // Disconnecting blocks takes their deltas off again
+        while (vBlocks.size() > 25) {
+            BOOST_CHECK(db.EraseAddressIndex(vBlocks.back()));
+            vBlocks.pop_back();
+        }
+        for (const uint160& addressHash : vAddresses)
+            for (int type = 1; type <= 2; type++)
+                BOOST_CHECK(SameBalances(ReadBalances(db, addressHash, type), SumAddressIndex(db, addressHash, type)));
+
+        // Rebuilding from the deltas gives the same balances
+        std::map<std::string, CAddressBalanceValue> before = ReadBalances(db, vAddresses[0], 1);
+        BOOST_CHECK(db.BuildAddressBalanceIndex());
+        BOOST_CHECK(SameBalances(ReadBalances(db, vAddresses[0], 1), before));
+
+        // Disconnecting everything leaves nothing behind
+        while (!vBlocks.empty()) {
+            BOOST_CHECK(db.EraseAddressIndex(vBlocks.back()));
+            vBlocks.pop_back();
+        }
+        for (const uint160& addressHash : vAddresses)
+            for (int type = 1; type <= 2; type++)
+                BOOST_CHECK(ReadBalances(db, addressHash, type).empty());
+    }
+
+    BOOST_AUTO_TEST_CASE(address_height_index_test)
+    {
+        BOOST_TEST_MESSAGE("Running Address Height Index Test");
+
+        CBlockTreeDB db(1 << 20, true);
+        uint160 addressHash = RandomAddressHash();
+        std::vector<std::string> vAssets = {RVN, "ASSET", "ASSET/SUB", "OTHER"};
+
+        // Deltas written before the height index is turned on, and after
+        std::vector<std::pair<CAddressIndexKey, CAmount> > vDeltas;
+        for (int nHeight = 1; nHeight <= 100; nHeight++) {
+            std::vector<std::pair<CAddressIndexKey, CAmount> > vBlockDeltas;
+            for (int i = 0; i < 4; i++) {
+                const std::string& assetName = vAssets[InsecureRandRange(vAssets.size())];
+                vBlockDeltas.push_back(std::make_pair(CAddressIndexKey(1, addressHash, assetName, nHeight, i, InsecureRand256(), 0, false), 1 + InsecureRandRange(1000)));
+            }
+            if (nHeight == 60) {
+                fAddressHeightIndex = true;
+                BOOST_CHECK(db.BuildAddressHeightIndex());
+            }
+            BOOST_CHECK(db.WriteAddressIndex(vBlockDeltas));
+            vDeltas.insert(vDeltas.end(), vBlockDeltas.begin(), vBlockDeltas.end());
+        }
+
+        // Disconnect the last block
+        std::vector<std::pair<CAddressIndexKey, CAmount> > vLastBlock(vDeltas.end() - 4, vDeltas.end());
+        BOOST_CHECK(db.EraseAddressIndex(vLastBlock));
+        vDeltas.resize(vDeltas.size() - 4);
+
+        for (const std::pair<int, int>& range : std::vector<std::pair<int, int> >{{0, 0}, {1, 99}, {10, 20}, {50, 70}, {99, 200}}) {
+            std::vector<std::pair<CAddressIndexKey, CAmount> > vByHeight;
+            BOOST_CHECK(db.ReadAddressIndexByHeight(addressHash, 1, vByHeight, range.first, range.second));
+
+            // The deltas come back in chain order, as they were written
+            std::vector<std::pair<CAddressIndexKey, CAmount> > vExpected;
+            for (const auto& delta : vDeltas)
+                if ((range.first == 0 || delta.first.blockHeight >= range.first) && (range.second == 0 || delta.first.blockHeight <= range.second))
+                    vExpected.push_back(delta);
+            BOOST_CHECK_EQUAL(vByHeight.size(), vExpected.size());
+            for (size_t i = 0; i < std::min(vByHeight.size(), vExpected.size()); i++) {
+                BOOST_CHECK(vByHeight[i].first.txhash == vExpected[i].first.txhash);
+                BOOST_CHECK_EQUAL(vByHeight[i].first.asset, vExpected[i].first.asset);
+                BOOST_CHECK_EQUAL(vByHeight[i].first.blockHeight, vExpected[i].first.blockHeight);
+                BOOST_CHECK_EQUAL(vByHeight[i].second, vExpected[i].second);
+            }
+
+            // Reading every asset's deltas from the address index keeps to the range too
+            std::vector<std::pair<CAddressIndexKey, CAmount> > vByAsset;
+            BOOST_CHECK(db.ReadAddressIndex(addressHash, 1, vByAsset, range.first, range.second));
+            BOOST_CHECK_EQUAL(vByAsset.size(), vExpected.size());
+        }
+
+        // The assets the address has deltas of are listed once each
+        std::set<std::string> setAssets;
+        for (const auto& delta : vDeltas)
+            setAssets.insert(delta.first.asset);
+        std::vector<std::string> vListed;
+        BOOST_CHECK(db.ReadAddressIndexAssets(addressHash, 1, vListed));
+        BOOST_CHECK_EQUAL(vListed.size(), setAssets.size());
+        BOOST_CHECK(std::set<std::string>(vListed.begin(), vListed.end()) == setAssets);
+        vListed.clear();
+        BOOST_CHECK(db.ReadAddressIndexAssets(addressHash, 2, vListed));
+        BOOST_CHECK(vListed.empty());
+
+        // Turning it off again leaves nothing behind
+        BOOST_CHECK(db.EraseAddressHeightIndex());
+        fAddressHeightIndex = false;
+        std::vector<std::pair<CAddressIndexKey, CAmount> > vByHeight;
+        BOOST_CHECK(db.ReadAddressIndexByHeight(addressHash, 1, vByHeight));
+        BOOST_CHECK(vByHeight.empty());
+    }
+
+    BOOST_AUTO_TEST_CASE(address_index_paging_test)
+    {
+        BOOST_TEST_MESSAGE("Running Address Index Paging Test");
+
+        CBlockTreeDB db(1 << 20, true);
+        uint160 addressHash = RandomAddressHash();
+
+        std::vector<std::pair<CAddressIndexKey, CAmount> > vDeltas;
+        std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > vUnspent;
+        for (int nHeight = 1; nHeight <= 40; nHeight++) {
+            for (int i = 0; i < 3; i++) {
+                uint256 txhash = InsecureRand256();
+                vDeltas.push_back(std::make_pair(CAddressIndexKey(1, addressHash, RVN, nHeight, i, txhash, 0, false), 1 + InsecureRandRange(1000)));
+                vUnspent.push_back(std::make_pair(CAddressUnspentKey(1, addressHash, RVN, txhash, 0), CAddressUnspentValue(1000, CScript(), nHeight)));
+            }
+        }
+        BOOST_CHECK(db.WriteAddressIndex(vDeltas));
+        BOOST_CHECK(db.UpdateAddressUnspentIndex(vUnspent));
+
+        // Reading page after page gives every delta once, in index order
+        std::vector<std::pair<CAddressIndexKey, CAmount> > vAll;
+        BOOST_CHECK(db.ReadAddressIndex(addressHash, 1, RVN, vAll));
+        std::vector<std::pair<CAddressIndexKey, CAmount> > vPaged;
+        while (true) {
+            std::vector<std::pair<CAddressIndexKey, CAmount> > vPage;
+            BOOST_CHECK(db.ReadAddressIndex(addressHash, 1, RVN, vPage, 0, 0, vPaged.empty() ? nullptr : &vPaged.back().first, 7));
+            BOOST_CHECK(vPage.size() <= 7);
+            vPaged.insert(vPaged.end(), vPage.begin(), vPage.end());
+            if (vPage.size() < 7)
+                break;
+        }
+        BOOST_CHECK_EQUAL(vPaged.size(), vAll.size());
+        for (size_t i = 0; i < std::min(vPaged.size(), vAll.size()); i++)
+            BOOST_CHECK(vPaged[i].first.txhash == vAll[i].first.txhash);
+
+        // Pages keep to the height range
+        std::vector<std::pair<CAddressIndexKey, CAmount> > vRange;
+        BOOST_CHECK(db.ReadAddressIndex(addressHash, 1, RVN, vRange, 10, 12, &vAll[0].first, 100));
+        BOOST_CHECK_EQUAL(vRange.size(), 9U);
+
+        // The unspent index pages the same way
+        std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > vUtxos;
+        std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > vUtxoPage;
+        do {
+            vUtxoPage.clear();
+            BOOST_CHECK(db.ReadAddressUnspentIndex(addressHash, 1, RVN, vUtxoPage, vUtxos.empty() ? nullptr : &vUtxos.back().first, 16));
+            vUtxos.insert(vUtxos.end(), vUtxoPage.begin(), vUtxoPage.end());
+        } while (vUtxoPage.size() == 16);
+        BOOST_CHECK_EQUAL(vUtxos.size(), vUnspent.size());
+        for (size_t i = 1; i < vUtxos.size(); i++)
+            BOOST_CHECK(vUtxos[i - 1].first.txhash < vUtxos[i].first.txhash);
+    }
+
+    BOOST_AUTO_TEST_CASE(address_index_batch_test)
+    {
+        BOOST_TEST_MESSAGE("Running Address Index Batch Test");
+
+        CBlockTreeDB db(1 << 22, true);
+        std::vector<std::pair<uint160, int> > vAddresses;
+        std::vector<std::pair<CAddressIndexKey, CAmount> > vDeltas;
+        std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > vUnspent;
+        std::vector<std::string> vAssets = {RVN, "ASSET"};
+        for (int i = 0; i < 1200; i++) {
+            std::pair<uint160, int> address(RandomAddressHash(), 1 + (i % 2));
+            vAddresses.push_back(address);
+            for (int j = 0; j < 3; j++) {
+                uint256 txhash = InsecureRand256();
+                const std::string& assetName = vAssets[j % 2];
+                vDeltas.push_back(std::make_pair(CAddressIndexKey(address.second, address.first, assetName, 1 + i, j, txhash, 0, false), 1 + j));
+                vUnspent.push_back(std::make_pair(CAddressUnspentKey(address.second, address.first, assetName, txhash, 0), CAddressUnspentValue(1 + j, CScript(), 1 + i)));
+            }
+        }
+        BOOST_CHECK(db.WriteAddressIndex(vDeltas));
+        BOOST_CHECK(db.UpdateAddressUnspentIndex(vUnspent));
+
+        // An address asked for twice is only read once
+        std::vector<std::pair<uint160, int> > vRequested(vAddresses);
+        vRequested.push_back(vAddresses[0]);
+
+        for (int nThreads : {1, 4}) {
+            std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > vUtxos;
+            BOOST_CHECK(db.ReadAddressUnspentIndex(vRequested, RVN, vUtxos, nThreads));
+            BOOST_CHECK_EQUAL(vUtxos.size(), 2 * vAddresses.size());
+
+            // Every asset but RVN, the same as one address at a time
+            std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > vAssetUtxos;
+            BOOST_CHECK(db.ReadAddressUnspentIndex(vRequested, vAssetUtxos, nThreads));
+            BOOST_CHECK_EQUAL(vAssetUtxos.size(), vAddresses.size());
+            std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > vSingle;
+            BOOST_CHECK(db.ReadAddressUnspentIndex(vAddresses[7].first, vAddresses[7].second, vSingle));
+            BOOST_CHECK_EQUAL(vSingle.size(), 1U);
+
+            // One output is read by its key, and isn't found once spent
+            CAddressUnspentValue unspentValue;
+            BOOST_CHECK(db.ReadAddressUnspent(vUnspent[4].first, unspentValue));
+            BOOST_CHECK_EQUAL(unspentValue.satoshis, vUnspent[4].second.satoshis);
+            BOOST_CHECK_EQUAL(unspentValue.blockHeight, vUnspent[4].second.blockHeight);
+            CAddressUnspentKey spentKey(vUnspent[4].first);
+            spentKey.index = 1;
+            BOOST_CHECK(!db.ReadAddressUnspent(spentKey, unspentValue));
+
+            std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue> > vBalances;
+            BOOST_CHECK(db.ReadAddressBalances(vRequested, RVN, vBalances, nThreads));
+            BOOST_CHECK_EQUAL(vBalances.size(), vAddresses.size());
+            CAmount nBalance = 0;
+            for (const auto& balance : vBalances)
+                nBalance += balance.second.balance;
+            BOOST_CHECK_EQUAL(nBalance, 4 * (CAmount)vAddresses.size());
+
+            std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue> > vAllBalances;
+            BOOST_CHECK(db.ReadAddressBalances(vRequested, vAllBalances, nThreads));
+            BOOST_CHECK_EQUAL(vAllBalances.size(), 2 * vAddresses.size());
+
+            // The results come in the order of the addresses' keys
+            for (size_t i = 1; i < vAllBalances.size(); i++) {
+                const CAddressBalanceKey& a = vAllBalances[i - 1].first;
+                const CAddressBalanceKey& b = vAllBalances[i].first;
+                BOOST_CHECK(a.type < b.type || (a.type == b.type && !(b.hashBytes < a.hashBytes)));
+            }
+        }
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
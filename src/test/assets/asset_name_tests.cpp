@@ -0,0 +1,435 @@
+// Copyright (c) 2017-2020 The Raven Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <assets/assets.h>
+
+#include <test/test_raven.h>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <regex>
+
+/**
+ * The std::regex based name validation that was used before the character table validator,
+ * kept verbatim so the two can be compared against each other.
+ */
+namespace regex_reference {
+
+// excluding owner tag ('!')
+static const auto MAX_NAME_LENGTH = 31;
+static const auto MAX_CHANNEL_NAME_LENGTH = 12;
+
+// min lengths are expressed by quantifiers
+static const std::regex ROOT_NAME_CHARACTERS("^[A-Z0-9._]{3,}$");
+static const std::regex SUB_NAME_CHARACTERS("^[A-Z0-9._]+$");
+static const std::regex UNIQUE_TAG_CHARACTERS("^[-A-Za-z0-9@$%&*()[\\]{}_.?:]+$");
+static const std::regex MSGCHANNEL_TAG_CHARACTERS("^[A-Za-z0-9_]+$");
+static const std::regex VOTE_TAG_CHARACTERS("^[A-Z0-9._]+$");
+
+// Restricted assets
+static const std::regex QUALIFIER_NAME_CHARACTERS("#[A-Z0-9._]{3,}$");
+static const std::regex SUB_QUALIFIER_NAME_CHARACTERS("#[A-Z0-9._]+$");
+static const std::regex RESTRICTED_NAME_CHARACTERS("\\$[A-Z0-9._]{3,}$");
+
+static const std::regex DOUBLE_PUNCTUATION("^.*[._]{2,}.*$");
+static const std::regex LEADING_PUNCTUATION("^[._].*$");
+static const std::regex TRAILING_PUNCTUATION("^.*[._]$");
+static const std::regex QUALIFIER_LEADING_PUNCTUATION("^[#\\$][._].*$"); // Used for qualifier assets, and restricted asset only
+
+static const std::string SUB_NAME_DELIMITER = "/";
+static const std::string UNIQUE_TAG_DELIMITER = "#";
+static const std::string MSGCHANNEL_TAG_DELIMITER = "~";
+// static const char RESTRICTED_TAG_CHAR = '$'; //<- Commented out - fixes "not used" warning
+static const std::string VOTE_TAG_DELIMITER = "^";
+static const std::string RESTRICTED_TAG_DELIMITER = "$";
+
+static const std::regex UNIQUE_INDICATOR(R"(^[^^~#!]+#[^~#!\/]+$)");
+static const std::regex MSGCHANNEL_INDICATOR(R"(^[^^~#!]+~[^~#!\/]+$)");
+static const std::regex OWNER_INDICATOR(R"(^[^^~#!]+!$)");
+static const std::regex VOTE_INDICATOR(R"(^[^^~#!]+\^[^~#!\/]+$)");
+
+static const std::regex QUALIFIER_INDICATOR("^[#][A-Z0-9._]{3,}$"); // Starts with #
+static const std::regex SUB_QUALIFIER_INDICATOR("^#[A-Z0-9._]+\\/#[A-Z0-9._]+$"); // Starts with #
+static const std::regex RESTRICTED_INDICATOR("^[\\$][A-Z0-9._]{3,}$"); // Starts with $
+
+static const std::regex RAVEN_NAMES("^RVN$|^RAVEN$|^RAVENCOIN$|^#RVN$|^#RAVEN$|^#RAVENCOIN$");
+
+bool IsTypeCheckNameValid(const AssetType type, const std::string& name, std::string& error);
+
+bool IsRootNameValid(const std::string& name)
+{
+    return std::regex_match(name, ROOT_NAME_CHARACTERS)
+        && !std::regex_match(name, DOUBLE_PUNCTUATION)
+        && !std::regex_match(name, LEADING_PUNCTUATION)
+        && !std::regex_match(name, TRAILING_PUNCTUATION)
+        && !std::regex_match(name, RAVEN_NAMES);
+}
+
+bool IsQualifierNameValid(const std::string& name)
+{
+    return std::regex_match(name, QUALIFIER_NAME_CHARACTERS)
+           && !std::regex_match(name, DOUBLE_PUNCTUATION)
+           && !std::regex_match(name, QUALIFIER_LEADING_PUNCTUATION)
+           && !std::regex_match(name, TRAILING_PUNCTUATION)
+           && !std::regex_match(name, RAVEN_NAMES);
+}
+
+bool IsRestrictedNameValid(const std::string& name)
+{
+    return std::regex_match(name, RESTRICTED_NAME_CHARACTERS)
+           && !std::regex_match(name, DOUBLE_PUNCTUATION)
+           && !std::regex_match(name, LEADING_PUNCTUATION)
+           && !std::regex_match(name, TRAILING_PUNCTUATION)
+           && !std::regex_match(name, RAVEN_NAMES);
+}
+
+bool IsSubQualifierNameValid(const std::string& name)
+{
+    return std::regex_match(name, SUB_QUALIFIER_NAME_CHARACTERS)
+           && !std::regex_match(name, DOUBLE_PUNCTUATION)
+           && !std::regex_match(name, LEADING_PUNCTUATION)
+           && !std::regex_match(name, TRAILING_PUNCTUATION);
+}
+
+bool IsSubNameValid(const std::string& name)
+{
+    return std::regex_match(name, SUB_NAME_CHARACTERS)
+        && !std::regex_match(name, DOUBLE_PUNCTUATION)
+        && !std::regex_match(name, LEADING_PUNCTUATION)
+        && !std::regex_match(name, TRAILING_PUNCTUATION);
+}
+
+bool IsUniqueTagValid(const std::string& tag)
+{
+    return std::regex_match(tag, UNIQUE_TAG_CHARACTERS);
+}
+
+bool IsVoteTagValid(const std::string& tag)
+{
+    return std::regex_match(tag, VOTE_TAG_CHARACTERS);
+}
+
+bool IsMsgChannelTagValid(const std::string &tag)
+{
+    return std::regex_match(tag, MSGCHANNEL_TAG_CHARACTERS)
+        && !std::regex_match(tag, DOUBLE_PUNCTUATION)
+        && !std::regex_match(tag, LEADING_PUNCTUATION)
+        && !std::regex_match(tag, TRAILING_PUNCTUATION);
+}
+
+bool IsNameValidBeforeTag(const std::string& name)
+{
+    std::vector<std::string> parts;
+    boost::split(parts, name, boost::is_any_of(SUB_NAME_DELIMITER));
+
+    if (!IsRootNameValid(parts.front())) return false;
+
+    if (parts.size() > 1)
+    {
+        for (unsigned long i = 1; i < parts.size(); i++)
+        {
+            if (!IsSubNameValid(parts[i])) return false;
+        }
+    }
+
+    return true;
+}
+
+bool IsQualifierNameValidBeforeTag(const std::string& name)
+{
+    std::vector<std::string> parts;
+    boost::split(parts, name, boost::is_any_of(SUB_NAME_DELIMITER));
+
+    if (!IsQualifierNameValid(parts.front())) return false;
+
+    // Qualifiers can only have one sub qualifier under it
+    if (parts.size() > 2) {
+        return false;
+    }
+
+    if (parts.size() > 1)
+    {
+
+        for (unsigned long i = 1; i < parts.size(); i++)
+        {
+            if (!IsSubQualifierNameValid(parts[i])) return false;
+        }
+    }
+
+    return true;
+}
+
+bool IsAssetNameASubasset(const std::string& name)
+{
+    std::vector<std::string> parts;
+    boost::split(parts, name, boost::is_any_of(SUB_NAME_DELIMITER));
+
+    if (!IsRootNameValid(parts.front())) return false;
+
+    return parts.size() > 1;
+}
+
+bool IsAssetNameASubQualifier(const std::string& name)
+{
+    std::vector<std::string> parts;
+    boost::split(parts, name, boost::is_any_of(SUB_NAME_DELIMITER));
+
+    if (!IsQualifierNameValid(parts.front())) return false;
+
+    return parts.size() > 1;
+}
+
+
+bool IsAssetNameValid(const std::string& name, AssetType& assetType, std::string& error)
+{
+    // Do a max length check first to stop the possibility of a stack exhaustion.
+    // We check for a value that is larger than the max asset name
+    if (name.length() > 40)
+        return false;
+
+    assetType = AssetType::INVALID;
+    if (std::regex_match(name, UNIQUE_INDICATOR))
+    {
+        bool ret = regex_reference::IsTypeCheckNameValid(AssetType::UNIQUE, name, error);
+        if (ret)
+            assetType = AssetType::UNIQUE;
+
+        return ret;
+    }
+    else if (std::regex_match(name, MSGCHANNEL_INDICATOR))
+    {
+        bool ret = regex_reference::IsTypeCheckNameValid(AssetType::MSGCHANNEL, name, error);
+        if (ret)
+            assetType = AssetType::MSGCHANNEL;
+
+        return ret;
+    }
+    else if (std::regex_match(name, OWNER_INDICATOR))
+    {
+        bool ret = regex_reference::IsTypeCheckNameValid(AssetType::OWNER, name, error);
+        if (ret)
+            assetType = AssetType::OWNER;
+
+        return ret;
+    }
+    else if (std::regex_match(name, VOTE_INDICATOR))
+    {
+        bool ret = regex_reference::IsTypeCheckNameValid(AssetType::VOTE, name, error);
+        if (ret)
+            assetType = AssetType::VOTE;
+
+        return ret;
+    }
+    else if (std::regex_match(name, QUALIFIER_INDICATOR))
+    {
+        bool ret = regex_reference::IsTypeCheckNameValid(AssetType::QUALIFIER, name, error);
+        if (ret) {
+            if (IsAssetNameASubQualifier(name))
+                assetType = AssetType::SUB_QUALIFIER;
+            else
+                assetType = AssetType::QUALIFIER;
+        }
+
+        return ret;
+    }
+    else if (std::regex_match(name, SUB_QUALIFIER_INDICATOR))
+    {
+        bool ret = regex_reference::IsTypeCheckNameValid(AssetType::SUB_QUALIFIER, name, error);
+        if (ret) {
+            if (IsAssetNameASubQualifier(name))
+                assetType = AssetType::SUB_QUALIFIER;
+        }
+
+        return ret;
+    }
+    else if (std::regex_match(name, RESTRICTED_INDICATOR))
+    {
+        bool ret = regex_reference::IsTypeCheckNameValid(AssetType::RESTRICTED, name, error);
+        if (ret)
+            assetType = AssetType::RESTRICTED;
+
+        return ret;
+    }
+    else
+    {
+        auto type = IsAssetNameASubasset(name) ? AssetType::SUB : AssetType::ROOT;
+        bool ret = regex_reference::IsTypeCheckNameValid(type, name, error);
+        if (ret)
+            assetType = type;
+
+        return ret;
+    }
+}
+
+bool IsAssetNameValid(const std::string& name)
+{
+    AssetType _assetType;
+    std::string _error;
+    return regex_reference::IsAssetNameValid(name, _assetType, _error);
+}
+
+bool IsAssetNameValid(const std::string& name, AssetType& assetType)
+{
+    std::string _error;
+    return regex_reference::IsAssetNameValid(name, assetType, _error);
+}
+
+bool IsAssetNameARoot(const std::string& name)
+{
+    AssetType type;
+    return regex_reference::IsAssetNameValid(name, type) && type == AssetType::ROOT;
+}
+
+bool IsAssetNameAnOwner(const std::string& name)
+{
+    return regex_reference::IsAssetNameValid(name) && std::regex_match(name, OWNER_INDICATOR);
+}
+
+bool IsAssetNameAnRestricted(const std::string& name)
+{
+    return regex_reference::IsAssetNameValid(name) && std::regex_match(name, RESTRICTED_INDICATOR);
+}
+
+bool IsAssetNameAQualifier(const std::string& name, bool fOnlyQualifiers)
+{
+    if (fOnlyQualifiers) {
+        return regex_reference::IsAssetNameValid(name) && std::regex_match(name, QUALIFIER_INDICATOR);
+    }
+
+    return regex_reference::IsAssetNameValid(name) && (std::regex_match(name, QUALIFIER_INDICATOR) || std::regex_match(name, SUB_QUALIFIER_INDICATOR));
+}
+
+bool IsAssetNameAnMsgChannel(const std::string& name)
+{
+    return regex_reference::IsAssetNameValid(name) && std::regex_match(name, MSGCHANNEL_INDICATOR);
+}
+
+bool IsTypeCheckNameValid(const AssetType type, const std::string& name, std::string& error)
+{
+    if (type == AssetType::UNIQUE) {
+        if (name.size() > MAX_NAME_LENGTH) { error = "Name is greater than max length of " + std::to_string(MAX_NAME_LENGTH); return false; }
+        std::vector<std::string> parts;
+        boost::split(parts, name, boost::is_any_of(UNIQUE_TAG_DELIMITER));
+        bool valid = IsNameValidBeforeTag(parts.front()) && IsUniqueTagValid(parts.back());
+        if (!valid) { error = "Unique name contains invalid characters (Valid characters are: A-Z a-z 0-9 @ $ % & * ( ) [ ] { } _ . ? : -)";  return false; }
+        return true;
+    } else if (type == AssetType::MSGCHANNEL) {
+        if (name.size() > MAX_NAME_LENGTH) { error = "Name is greater than max length of " + std::to_string(MAX_NAME_LENGTH); return false; }
+        std::vector<std::string> parts;
+        boost::split(parts, name, boost::is_any_of(MSGCHANNEL_TAG_DELIMITER));
+        bool valid = IsNameValidBeforeTag(parts.front()) && IsMsgChannelTagValid(parts.back());
+        if (parts.back().size() > MAX_CHANNEL_NAME_LENGTH) { error = "Channel name is greater than max length of " + std::to_string(MAX_CHANNEL_NAME_LENGTH); return false; }
+        if (!valid) { error = "Message Channel name contains invalid characters (Valid characters are: A-Z 0-9 _ .) (special characters can't be the first or last characters)";  return false; }
+        return true;
+    } else if (type == AssetType::OWNER) {
+        if (name.size() > MAX_NAME_LENGTH) { error = "Name is greater than max length of " + std::to_string(MAX_NAME_LENGTH); return false; }
+        bool valid = IsNameValidBeforeTag(name.substr(0, name.size() - 1));
+        if (!valid) { error = "Owner name contains invalid characters (Valid characters are: A-Z 0-9 _ .) (special characters can't be the first or last characters)";  return false; }
+        return true;
+    } else if (type == AssetType::VOTE) {
+        if (name.size() > MAX_NAME_LENGTH) { error = "Name is greater than max length of " + std::to_string(MAX_NAME_LENGTH); return false; }
+        std::vector<std::string> parts;
+        boost::split(parts, name, boost::is_any_of(VOTE_TAG_DELIMITER));
+        bool valid = IsNameValidBeforeTag(parts.front()) && IsVoteTagValid(parts.back());
+        if (!valid) { error = "Vote name contains invalid characters (Valid characters are: A-Z 0-9 _ .) (special characters can't be the first or last characters)";  return false; }
+        return true;
+    } else if (type == AssetType::QUALIFIER || type == AssetType::SUB_QUALIFIER) {
+        if (name.size() > MAX_NAME_LENGTH) { error = "Name is greater than max length of " + std::to_string(MAX_NAME_LENGTH); return false; }
+        bool valid = IsQualifierNameValidBeforeTag(name);
+        if (!valid) { error = "Qualifier name contains invalid characters (Valid characters are: A-Z 0-9 _ .) (# must be the first character, _ . special characters can't be the first or last characters)";  return false; }
+        return true;
+    } else if (type == AssetType::RESTRICTED) {
+        if (name.size() > MAX_NAME_LENGTH) { error = "Name is greater than max length of " + std::to_string(MAX_NAME_LENGTH); return false; }
+        bool valid = IsRestrictedNameValid(name);
+        if (!valid) { error = "Restricted name contains invalid characters (Valid characters are: A-Z 0-9 _ .) ($ must be the first character, _ . special characters can't be the first or last characters)";  return false; }
+        return true;
+    } else {
+        if (name.size() > MAX_NAME_LENGTH - 1) { error = "Name is greater than max length of " + std::to_string(MAX_NAME_LENGTH - 1); return false; }  //Assets and sub-assets need to leave one extra char for OWNER indicator
+        if (!IsAssetNameASubasset(name) && name.size() < MIN_ASSET_LENGTH) { error = "Name must be contain " + std::to_string(MIN_ASSET_LENGTH) + " characters"; return false; }
+        bool valid = IsNameValidBeforeTag(name);
+        if (!valid && IsAssetNameASubasset(name) && name.size() < 3) { error = "Name must have at least 3 characters (Valid characters are: A-Z 0-9 _ .)";  return false; }
+        if (!valid) { error = "Name contains invalid characters (Valid characters are: A-Z 0-9 _ .) (special characters can't be the first or last characters)";  return false; }
+        return true;
+    }
+}
+
+} // namespace regex_reference
+
+static const std::vector<std::string> vSeedNames = {
+    "MIN", "RVN", "RAVEN", "RAVENCOIN", "RAVEN.COIN", "A_B.C", "ABC/A", "ABC/A/1", "ABC/A_1/1.A",
+    "ABC#TAG", "ABC/SUB#a-Z@$%&*()[]{}_.?:", "ABC~CHANNEL", "ABC/SUB~Chan_1", "ABC!", "ABC/SUB!",
+    "ABC^VOTE", "ABC^V^W", "#QUAL", "#RVN", "#QUAL/#SUB", "#QUAL/#SUB/#SUB", "$RESTRICTED", "$.ABC",
+    "#_ABC", "#ABC/#.X", "MAX_ASSET_IS_30_CHARACTERS_LNG", "ABC/AB/XYZ/STILL/MAX/30/123456"
+};
+
+static const std::string strFuzzAlphabet = "ABCRVN019._#~!^/$az -@%&*()[]{}?:";
+
+static char RandomNameChar()
+{
+    // Mostly pick from the characters the validators care about, sometimes any byte at all
+    if (InsecureRandRange(8) == 0)
+        return (char)InsecureRandBits(8);
+    return strFuzzAlphabet[InsecureRandRange(strFuzzAlphabet.size())];
+}
+
+static std::string RandomAssetName()
+{
+    std::string name;
+    if (InsecureRandBool()) {
+        name = vSeedNames[InsecureRandRange(vSeedNames.size())];
+        // Mutate a known name by inserting, replacing or erasing a few characters
+        for (int i = InsecureRandRange(4); i >= 0; i--) {
+            size_t pos = name.empty() ? 0 : InsecureRandRange(name.size());
+            switch (InsecureRandRange(3)) {
+                case 0: name.insert(pos, 1, RandomNameChar()); break;
+                case 1: if (!name.empty()) name[pos] = RandomNameChar(); break;
+                case 2: if (!name.empty()) name.erase(pos, 1); break;
+            }
+        }
+    } else {
+        for (int i = InsecureRandRange(42); i > 0; i--)
+            name += RandomNameChar();
+    }
+    return name;
+}
+
+BOOST_FIXTURE_TEST_SUITE(asset_name_tests, BasicTestingSetup)
+
+    BOOST_AUTO_TEST_CASE(asset_name_regex_differential_test)
+    {
+        BOOST_TEST_MESSAGE("Running Asset Name Regex Differential Test");
+
+        std::vector<std::string> names = vSeedNames;
+        for (int i = 0; i < 50000; i++)
+            names.push_back(RandomAssetName());
+
+        for (const std::string& name : names) {
+            AssetType type = AssetType::INVALID, refType = AssetType::INVALID;
+            std::string error, refError;
+            bool valid = IsAssetNameValid(name, type, error);
+            bool refValid = regex_reference::IsAssetNameValid(name, refType, refError);
+
+            BOOST_CHECK_MESSAGE(valid == refValid, "validity differs for '" + name + "'");
+            BOOST_CHECK_MESSAGE(type == refType, "type differs for '" + name + "'");
+            BOOST_CHECK_MESSAGE(error == refError, "error differs for '" + name + "': '" + error + "' vs '" + refError + "'");
+
+            BOOST_CHECK(IsAssetNameAnOwner(name) == regex_reference::IsAssetNameAnOwner(name));
+            BOOST_CHECK(IsAssetNameAnRestricted(name) == regex_reference::IsAssetNameAnRestricted(name));
+            BOOST_CHECK(IsAssetNameAQualifier(name) == regex_reference::IsAssetNameAQualifier(name, false));
+            BOOST_CHECK(IsAssetNameAQualifier(name, true) == regex_reference::IsAssetNameAQualifier(name, true));
+            BOOST_CHECK(IsAssetNameAnMsgChannel(name) == regex_reference::IsAssetNameAnMsgChannel(name));
+            BOOST_CHECK(IsAssetNameASubQualifier(name) == regex_reference::IsAssetNameASubQualifier(name));
+            BOOST_CHECK(IsUniqueTagValid(name) == regex_reference::IsUniqueTagValid(name));
+
+            // Checking a name against an explicit type is also reachable directly from the RPC and GUI code
+            for (int nType = 0; nType < (int)AssetType::INVALID; nType++) {
+                std::string typeError, refTypeError;
+                BOOST_CHECK(IsTypeCheckNameValid((AssetType)nType, name, typeError) == regex_reference::IsTypeCheckNameValid((AssetType)nType, name, refTypeError));
+                BOOST_CHECK(typeError == refTypeError);
+            }
+        }
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -540,4 +540,60 @@ BOOST_FIXTURE_TEST_SUITE(asset_tx_tests, BasicTestingSetup)
         BOOST_CHECK(state.GetRejectReason() == "bad-txns-asset-reissued-amount-isn't-zero");
     }
 
+    BOOST_AUTO_TEST_CASE(asset_tx_queued_checks_test)
+    {
+        BOOST_TEST_MESSAGE("Running Asset TX Queued Checks Test");
+
+        SelectParams(CBaseChainParams::MAIN);
+
+        for (const std::string& strName : {std::string("RAVENTEST"), std::string("RAVEN..TEST")}) {
+            // Spend a coin holding an asset to an output transferring all of it
+            CAssetTransfer asset(strName, 1000);
+            CScript scriptPubKey = GetScriptForDestination(DecodeDestination(GetParams().GlobalBurnAddress()));
+            asset.ConstructTransaction(scriptPubKey);
+
+            CCoinsView view;
+            CCoinsViewCache coins(&view);
+
+            CTxOut txOut;
+            txOut.nValue = 0;
+            txOut.scriptPubKey = scriptPubKey;
+
+            COutPoint outpoint(uint256S("BF50CB9A63BE0019171456252989A459A7D0A5F494735278290079D22AB704A2"), 1);
+            coins.AddCoin(outpoint, Coin(txOut, 10, 0), true);
+
+            CMutableTransaction mutTx;
+            CTxIn in;
+            in.prevout = outpoint;
+            mutTx.vin.emplace_back(in);
+            mutTx.vout.emplace_back(txOut);
+
+            CTransaction tx(mutTx);
+            std::vector<std::pair<std::string, uint256>> vReissueAssets;
+
+            // Checked in place, a transfer of an asset with an invalid name is rejected
+            CValidationState state;
+            bool fValid = Consensus::CheckTxAssets(tx, state, coins, nullptr, false, vReissueAssets, true);
+            BOOST_CHECK_EQUAL(fValid, strName == "RAVENTEST");
+
+            // Queued, the same check is left to the returned check, which fails with the same reason
+            CValidationState queuedState;
+            std::vector<CAssetCheck> vChecks;
+            BOOST_CHECK(Consensus::CheckTxAssets(tx, queuedState, coins, nullptr, false, vReissueAssets, true, nullptr, 0, nullptr, &vChecks));
+            BOOST_CHECK_EQUAL(vChecks.size(), 1u);
+            BOOST_CHECK_EQUAL(vChecks[0](), fValid);
+            if (!fValid)
+                BOOST_CHECK_EQUAL(vChecks[0].GetError(), state.GetRejectReason());
+
+            // Run from the block's check queue, a failure leaves its reason for the block to be rejected with
+            CAssetCheckFailure failure;
+            vChecks[0].SetFailure(&failure);
+            CBlockCheck blockCheck;
+            blockCheck.Set(vChecks[0]);
+            BOOST_CHECK_EQUAL(blockCheck(), fValid);
+            BOOST_CHECK_EQUAL(failure.strError, fValid ? "" : state.GetRejectReason());
+            BOOST_CHECK(failure.txHash == (fValid ? uint256() : tx.GetHash()));
+        }
+    }
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
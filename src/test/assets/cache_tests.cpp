@@ -2,6 +2,10 @@
 #include "assets/assets.h"
 #include <boost/test/unit_test.hpp>
 #include <test/test_raven.h>
+#include <chainparams.h>
+#include <validation.h>
+
+#include <thread>
 
 BOOST_FIXTURE_TEST_SUITE(cache_tests, BasicTestingSetup)
 
@@ -37,5 +41,138 @@ BOOST_AUTO_TEST_CASE(cache_test)
 
 }
 
+BOOST_AUTO_TEST_CASE(sharded_cache_test)
+{
+    BOOST_TEST_MESSAGE("Running Sharded Cache Test");
+
+    const size_t nMaxUsage = 1 << 20;
+    CShardedLRUCache<std::string, CNullAssetTxVerifierString> cache(nMaxUsage);
+
+    // Filling the cache far past its memory bound evicts entries, and stays within the bound
+    for (int i = 0; i < 100000; i++)
+        cache.Put("TEST" + std::to_string(i), CNullAssetTxVerifierString("KYC & !BANNED"));
+    BOOST_CHECK(cache.DynamicMemoryUsage() <= nMaxUsage);
+    BOOST_CHECK(cache.Size() < 100000);
+    BOOST_CHECK_EQUAL(cache.Evictions(), 100000 - cache.Size());
+    BOOST_CHECK_MESSAGE(cache.Exists("TEST99999"), "Cache didn't keep the most recent entry");
+    BOOST_CHECK_MESSAGE(!cache.Exists("TEST0"), "Cache didn't remove the least recently used");
+
+    // Lookups are counted, and return copies of the values
+    uint64_t nHits = cache.Hits(), nMisses = cache.Misses();
+    CNullAssetTxVerifierString verifier;
+    BOOST_CHECK(cache.Find("TEST99999", verifier));
+    BOOST_CHECK_EQUAL(verifier.verifier_string, "KYC & !BANNED");
+    BOOST_CHECK(!cache.Find("MISSING", verifier));
+    BOOST_CHECK_EQUAL(cache.Hits(), nHits + 1);
+    BOOST_CHECK_EQUAL(cache.Misses(), nMisses + 1);
+    BOOST_CHECK(cache.Exists("TEST99999"));
+    BOOST_CHECK(!cache.Exists("MISSING"));
+    BOOST_CHECK_EQUAL(cache.Hits(), nHits + 1);
+    BOOST_CHECK_EQUAL(cache.Misses(), nMisses + 1);
+    BOOST_CHECK_THROW(cache.Get("MISSING"), std::range_error);
+
+    cache.Clear();
+    BOOST_CHECK_EQUAL(cache.Size(), 0U);
+    BOOST_CHECK_EQUAL(cache.DynamicMemoryUsage(), 0U);
+
+    // Putting an existing key replaces its value and usage, erasing it gives the usage back
+    cache.Put("TEST1", CNullAssetTxVerifierString("KYC & !BANNED"));
+    size_t nUsage = cache.DynamicMemoryUsage();
+    cache.Put("TEST1", CNullAssetTxVerifierString(std::string(100, 'A')));
+    BOOST_CHECK_EQUAL(cache.Get("TEST1").verifier_string, std::string(100, 'A'));
+    BOOST_CHECK_EQUAL(cache.Size(), 1U);
+    BOOST_CHECK(cache.DynamicMemoryUsage() > nUsage);
+
+    // Updating in place changes the value and its usage, and leaves keys that aren't cached alone
+    nUsage = cache.DynamicMemoryUsage();
+    BOOST_CHECK(cache.Update("TEST1", [](CNullAssetTxVerifierString& value) { value.verifier_string += std::string(100, 'B'); }));
+    BOOST_CHECK_EQUAL(cache.Get("TEST1").verifier_string, std::string(100, 'A') + std::string(100, 'B'));
+    BOOST_CHECK(cache.DynamicMemoryUsage() > nUsage);
+    BOOST_CHECK(!cache.Update("MISSING", [](CNullAssetTxVerifierString& value) { value.verifier_string = "KYC"; }));
+    BOOST_CHECK(!cache.Exists("MISSING"));
+
+    cache.Erase("TEST1");
+    BOOST_CHECK(!cache.Exists("TEST1"));
+    BOOST_CHECK_EQUAL(cache.DynamicMemoryUsage(), 0U);
+
+    // Threads can share the cache
+    std::atomic<bool> fMismatch(false);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&cache, &fMismatch, t] {
+            for (int i = 0; i < 10000; i++) {
+                std::string key = "THREAD" + std::to_string(t) + "_" + std::to_string(i % 500);
+                cache.Put(key, CNullAssetTxVerifierString(key));
+                CNullAssetTxVerifierString value;
+                if (cache.Find(key, value) && value.verifier_string != key)
+                    fMismatch = true;
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+    BOOST_CHECK(!fMismatch);
+    BOOST_CHECK_EQUAL(cache.Size(), 2000U);
+
+    // Concurrent updates of one key all land
+    CShardedLRUCache<std::string, std::set<std::string>> setCache(nMaxUsage);
+    setCache.Put("ADDRESS", std::set<std::string>());
+    threads.clear();
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&setCache, t] {
+            for (int i = 0; i < 250; i++)
+                setCache.Update("ADDRESS", [t, i](std::set<std::string>& set) { set.insert("#QUALIFIER" + std::to_string(t * 250 + i)); });
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+    std::set<std::string> setQualifiers;
+    BOOST_CHECK(setCache.Find("ADDRESS", setQualifiers));
+    BOOST_CHECK_EQUAL(setQualifiers.size(), 1000U);
+}
+
+BOOST_AUTO_TEST_CASE(cache_layered_view_test)
+{
+    BOOST_TEST_MESSAGE("Running Cache Layered View Test");
+
+    SelectParams(CBaseChainParams::MAIN);
+
+    fAssetIndex = true;
+    passets = new CAssetsCache();
+
+    CNewAsset asset("LAYERED", CAmount(100 * COIN), 8, 1, 0, "");
+    std::string address = GetParams().GlobalBurnAddress();
+
+    // Changes made in a child view stay in the child until it is flushed
+    {
+        CAssetsCache child;
+        BOOST_CHECK_MESSAGE(child.AddNewAsset(asset, address, 1, uint256()), "Failed to add new asset to child view");
+        BOOST_CHECK_MESSAGE(child.CheckIfAssetExists("LAYERED"), "Child view should see its own change");
+        BOOST_CHECK_MESSAGE(!passets->CheckIfAssetExists("LAYERED"), "Parent should not see unflushed child changes");
+        BOOST_CHECK_MESSAGE(passets->setNewAssetsToAdd.empty(), "Parent dirty set should be untouched");
+    }
+    BOOST_CHECK_MESSAGE(!passets->CheckIfAssetExists("LAYERED"), "Discarded child changes leaked into the parent");
+
+    // Flushing commits only the child's changes into the parent
+    {
+        CAssetsCache child;
+        BOOST_CHECK(child.AddNewAsset(asset, address, 1, uint256()));
+        BOOST_CHECK_MESSAGE(child.Flush(), "Failed to flush child view");
+    }
+    BOOST_CHECK_MESSAGE(passets->CheckIfAssetExists("LAYERED"), "Flushed child change missing from parent");
+    BOOST_CHECK_EQUAL(passets->setNewAssetsToAdd.size(), 1U);
+
+    // A fresh child sees the parent's state without copying it
+    CAssetsCache child;
+    BOOST_CHECK(child.setNewAssetsToAdd.empty());
+    BOOST_CHECK_MESSAGE(child.CheckIfAssetExists("LAYERED"), "Child view should fall through to the parent");
+    CNewAsset found;
+    BOOST_CHECK_MESSAGE(child.GetAssetMetaDataIfExists("LAYERED", found), "Child view should read parent metadata");
+    BOOST_CHECK_EQUAL(found.nAmount, CAmount(100 * COIN));
+
+    delete passets;
+    passets = nullptr;
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
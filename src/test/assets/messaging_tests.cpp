@@ -12,6 +12,9 @@
 #include <base58.h>
 #include <chainparams.h>
 #include "consensus/consensus.h"
+#include <validation.h>
+#include <assets/messages.h>
+#include <assets/myassetsdb.h>
 
 
 BOOST_FIXTURE_TEST_SUITE(messaging_tests, BasicTestingSetup)
@@ -77,5 +80,71 @@ BOOST_FIXTURE_TEST_SUITE(messaging_tests, BasicTestingSetup)
 
     }
 
+    BOOST_AUTO_TEST_CASE(message_db_index_test)
+    {
+        BOOST_TEST_MESSAGE("Running Message DB Index Test");
+
+        CMessageDB messagedb(1 << 20, true);
+        BOOST_CHECK(messagedb.BuildMessageIndexes());
+
+        // Two channels, written out of time order
+        std::vector<CMessage> vWritten;
+        for (int i = 0; i < 10; i++) {
+            COutPoint out(uint256S(strprintf("%064x", i + 1)), 0);
+            CMessage message(out, i % 2 ? "ODD~CHANNEL" : "EVEN~CHANNEL", "", 0, 1000 + ((i * 7) % 10));
+            BOOST_CHECK(messagedb.WriteMessage(message));
+            vWritten.push_back(message);
+        }
+
+        std::vector<CMessage> vMessages;
+        BOOST_CHECK(messagedb.LoadMessages(vMessages));
+        BOOST_CHECK_EQUAL(vMessages.size(), 10U);
+        for (size_t i = 1; i < vMessages.size(); i++)
+            BOOST_CHECK(vMessages[i - 1].time < vMessages[i].time);
+
+        BOOST_CHECK(messagedb.LoadMessages(vMessages, "ODD~CHANNEL", 1004, 2));
+        BOOST_CHECK_EQUAL(vMessages.size(), 2U);
+        for (const auto& message : vMessages) {
+            BOOST_CHECK_EQUAL(message.strName, "ODD~CHANNEL");
+            BOOST_CHECK(message.time >= 1004);
+        }
+        BOOST_CHECK(vMessages.size() == 2 && vMessages[0].time < vMessages[1].time);
+
+        // Rewriting a message at another time moves it in the index
+        CMessage moved = vWritten[0];
+        moved.time = 2000;
+        BOOST_CHECK(messagedb.WriteMessage(moved));
+        BOOST_CHECK(messagedb.LoadMessages(vMessages, "", 1500));
+        BOOST_CHECK(vMessages.size() == 1 && vMessages[0].out == moved.out);
+        BOOST_CHECK(messagedb.LoadMessages(vMessages));
+        BOOST_CHECK_EQUAL(vMessages.size(), 10U);
+
+        // A negative since is rejected rather than seeking past the whole index
+        BOOST_CHECK(!messagedb.LoadMessages(vMessages, "", -1));
+
+        // Messages not flushed yet are merged in, in time order
+        {
+            LOCK(cs_messaging);
+            CMessage dirty(COutPoint(uint256S(strprintf("%064x", 100)), 0), "ODD~CHANNEL", "", 0, 1002);
+            mapDirtyMessagesAdd[dirty.out] = dirty;
+            setDirtyMessagesRemove.insert(vWritten[1].out);
+
+            BOOST_CHECK(messagedb.LoadMessages(vMessages, "ODD~CHANNEL"));
+            BOOST_CHECK_EQUAL(vMessages.size(), 5U);
+            for (size_t i = 1; i < vMessages.size(); i++)
+                BOOST_CHECK(vMessages[i - 1].time < vMessages[i].time);
+            for (const auto& message : vMessages)
+                BOOST_CHECK(message.out != vWritten[1].out);
+
+            mapDirtyMessagesAdd.clear();
+            setDirtyMessagesRemove.clear();
+        }
+
+        // Erasing a message takes it out of the indexes too
+        BOOST_CHECK(messagedb.EraseMessage(vWritten[2].out));
+        BOOST_CHECK(messagedb.LoadMessages(vMessages, "EVEN~CHANNEL"));
+        BOOST_CHECK_EQUAL(vMessages.size(), 4U);
+    }
+
 
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include <amount.h>
 #include <base58.h>
 #include <chainparams.h>
+#include <validation.h>
 
 BOOST_FIXTURE_TEST_SUITE(qualifier_tests, BasicTestingSetup)
 
@@ -115,7 +116,50 @@ BOOST_FIXTURE_TEST_SUITE(qualifier_tests, BasicTestingSetup)
         BOOST_CHECK_MESSAGE(tx.VerifyNewQualfierAsset(strError), "Failed to Verify New Sub Qualifier Asset " + strError);
     }
 
-
+    BOOST_FIXTURE_TEST_CASE(address_qualifiers_cache_test, TestingSetup)
+    {
+        BOOST_TEST_MESSAGE("Running Address Qualifiers Cache Test");
+
+        prestricteddb = new CRestrictedDB(1 << 20, true);
+        passetsAddressQualifiersCache = new CShardedLRUCache<std::string, std::set<std::string>>(1 << 20);
+
+        std::string address = GetParams().GlobalBurnAddress();
+        prestricteddb->WriteAddressQualifier(address, "#ABC");
+        prestricteddb->WriteAddressQualifier(address, "#KYC/#SUB");
+        prestricteddb->WriteAddressQualifier("other_address", "#XYZ");
+
+        // All of the address's qualifiers are answered from the one read
+        BOOST_CHECK(passets->CheckForAddressQualifier("#ABC", address));
+        BOOST_CHECK(passetsAddressQualifiersCache->Exists(address));
+        BOOST_CHECK(passets->CheckForAddressQualifier("#KYC/#SUB", address));
+        BOOST_CHECK_MESSAGE(passets->CheckForAddressQualifier("#KYC", address), "Root of a sub qualifier should be found");
+        BOOST_CHECK(!passets->CheckForAddressQualifier("#KY", address));
+        BOOST_CHECK(!passets->CheckForAddressQualifier("#XYZ", address));
+
+        // The cached set follows the database as qualifiers are removed and added
+        UpdateAddressQualifiersCache(address, "#ABC", false);
+        prestricteddb->EraseAddressQualifier(address, "#ABC");
+        UpdateAddressQualifiersCache(address, "#DEF", true);
+        prestricteddb->WriteAddressQualifier(address, "#DEF");
+
+        BOOST_CHECK(!passets->CheckForAddressQualifier("#ABC", address));
+        BOOST_CHECK(passets->CheckForAddressQualifier("#DEF", address));
+
+        std::set<std::string> setQualifiers;
+        BOOST_CHECK(prestricteddb->ReadAddressQualifiers(address, setQualifiers));
+        BOOST_CHECK(setQualifiers == passetsAddressQualifiersCache->Get(address));
+
+        // The listing keeps the database's key order, where shorter tags come first
+        prestricteddb->WriteAddressQualifier("other_address", "#ZZ");
+        std::vector<std::string> vQualifiers;
+        BOOST_CHECK(prestricteddb->ReadAddressQualifiers("other_address", vQualifiers));
+        BOOST_CHECK(vQualifiers == std::vector<std::string>({"#ZZ", "#XYZ"}));
+
+        delete passetsAddressQualifiersCache;
+        passetsAddressQualifiersCache = nullptr;
+        delete prestricteddb;
+        prestricteddb = nullptr;
+    }
 
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,134 @@
+// Copyright (c) 2017-2020 The Raven Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <assets/rewards.h>
+
+#include <test/test_raven.h>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+
+#include <amount.h>
+#include <validation.h>
+#include <validationinterface.h>
+#include <assets/assetdb.h>
+#include <assets/assetsnapshotdb.h>
+
+BOOST_FIXTURE_TEST_SUITE(rewards_tests, TestingSetup)
+
+    static std::shared_ptr<const CBlock> BlockWithTransaction(uint32_t nLockTime)
+    {
+        CMutableTransaction mtx;
+        mtx.nLockTime = nLockTime;
+        std::shared_ptr<CBlock> block = std::make_shared<CBlock>();
+        block->vtx.push_back(MakeTransactionRef(mtx));
+        return block;
+    }
+
+    BOOST_AUTO_TEST_CASE(rewards_retry_scheduling_test)
+    {
+        BOOST_TEST_MESSAGE("Running Rewards Retry Scheduling Test");
+
+        RegisterRewardsValidationInterface();
+        TakeRewardDistributionsToCheck();
+
+        uint256 hashPaid = uint256S("01");
+        uint256 hashRetried = uint256S("02");
+        std::shared_ptr<const CBlock> blockPayment = BlockWithTransaction(1);
+        std::shared_ptr<const CBlock> blockOther = BlockWithTransaction(2);
+        std::vector<CTransactionRef> vNoConflicts;
+        std::vector<CTransactionRef> vPaymentConflicted = {blockPayment->vtx[0]};
+
+        // Blocks don't queue anything while no distribution is being paid out
+        GetMainSignals().BlockConnected(blockPayment, chainActive.Tip(), vNoConflicts);
+        BOOST_CHECK(TakeRewardDistributionsToCheck().empty());
+
+        // A distribution is looked over again when one of its payments is connected or conflicted, and only then
+        WatchRewardDistributionTransaction(hashPaid, blockPayment->vtx[0]->GetHash());
+        GetMainSignals().BlockConnected(blockOther, chainActive.Tip(), vNoConflicts);
+        BOOST_CHECK(TakeRewardDistributionsToCheck().empty());
+        GetMainSignals().BlockConnected(blockPayment, chainActive.Tip(), vNoConflicts);
+        BOOST_CHECK(TakeRewardDistributionsToCheck() == std::set<uint256>({hashPaid}));
+        GetMainSignals().BlockConnected(blockOther, chainActive.Tip(), vPaymentConflicted);
+        BOOST_CHECK(TakeRewardDistributionsToCheck() == std::set<uint256>({hashPaid}));
+
+        // A retry is looked over on the next block, whatever is in it, and not on the blocks after
+        RetryRewardDistribution(hashRetried);
+        GetMainSignals().BlockConnected(blockOther, chainActive.Tip(), vNoConflicts);
+        BOOST_CHECK(TakeRewardDistributionsToCheck() == std::set<uint256>({hashRetried}));
+        GetMainSignals().BlockConnected(blockOther, chainActive.Tip(), vNoConflicts);
+        BOOST_CHECK(TakeRewardDistributionsToCheck().empty());
+
+        // Unwatching a distribution drops its payments and its retry
+        RetryRewardDistribution(hashPaid);
+        UnwatchRewardDistribution(hashPaid);
+        GetMainSignals().BlockConnected(blockPayment, chainActive.Tip(), vPaymentConflicted);
+        BOOST_CHECK(TakeRewardDistributionsToCheck().empty());
+
+        UnregisterRewardsValidationInterface();
+    }
+
+    BOOST_AUTO_TEST_CASE(rewards_thread_test)
+    {
+        BOOST_TEST_MESSAGE("Running Rewards Thread Test");
+
+        passetsdb = new CAssetsDB(1 << 20, true);
+        pAssetSnapshotDb = new CAssetSnapshotDB(1 << 20, true);
+
+        BOOST_CHECK(passetsdb->WriteAssetAddressQuantity("REWARDS", "owner_a", 100 * COIN));
+        BOOST_CHECK(passetsdb->WriteAssetAddressQuantity("REWARDS", "owner_b", 200 * COIN));
+        std::shared_ptr<CDBSnapshot> viewFirst = std::make_shared<CDBSnapshot>(*passetsdb);
+        BOOST_CHECK(passetsdb->WriteAssetAddressQuantity("REWARDS", "owner_c", 300 * COIN));
+        std::shared_ptr<CDBSnapshot> viewSecond = std::make_shared<CDBSnapshot>(*passetsdb);
+
+        // Without the thread running there is nothing to wait for
+        QueueOwnershipSnapshot("REWARDS", 10, viewFirst);
+        SyncWithRewardsThread();
+
+        // The thread writes out the snapshots queued for it, from the view taken at their height
+        boost::thread_group threadGroup;
+        StartRewardsThread(threadGroup);
+        SyncWithRewardsThread();
+
+        CAssetSnapshotDBEntry snapshotEntry;
+        BOOST_CHECK(pAssetSnapshotDb->RetrieveOwnershipSnapshot("REWARDS", 10, snapshotEntry));
+        std::set<std::pair<std::string, CAmount>> setOwners = {{"owner_a", 100 * COIN}, {"owner_b", 200 * COIN}};
+        BOOST_CHECK(snapshotEntry.ownersAndAmounts == setOwners);
+
+        // And takes the distributions a block queues for it
+        RegisterRewardsValidationInterface();
+        uint256 hashRetried = uint256S("03");
+        RetryRewardDistribution(hashRetried);
+        std::vector<CTransactionRef> vNoConflicts;
+        GetMainSignals().BlockConnected(BlockWithTransaction(3), chainActive.Tip(), vNoConflicts);
+        SyncWithRewardsThread();
+        BOOST_CHECK(TakeRewardDistributionsToCheck().empty());
+        UnregisterRewardsValidationInterface();
+
+        // Stopping it, even in the middle of its work, still writes out everything queued before
+        QueueOwnershipSnapshot("REWARDS", 11, viewSecond);
+        QueueOwnershipSnapshot("REWARDS", 12, viewSecond);
+        threadGroup.interrupt_all();
+        threadGroup.join_all();
+
+        for (int nHeight : {11, 12}) {
+            BOOST_CHECK(pAssetSnapshotDb->RetrieveOwnershipSnapshot("REWARDS", nHeight, snapshotEntry));
+            BOOST_CHECK_EQUAL(snapshotEntry.ownersAndAmounts.size(), 3U);
+        }
+
+        // Once it has stopped, syncing doesn't wait on it
+        QueueOwnershipSnapshot("REWARDS", 13, viewSecond);
+        SyncWithRewardsThread();
+        FlushOwnershipSnapshots();
+        BOOST_CHECK(pAssetSnapshotDb->RetrieveOwnershipSnapshot("REWARDS", 13, snapshotEntry));
+
+        viewFirst.reset();
+        viewSecond.reset();
+        delete pAssetSnapshotDb;
+        pAssetSnapshotDb = nullptr;
+        delete passetsdb;
+        passetsdb = nullptr;
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -175,4 +175,88 @@ BOOST_FIXTURE_TEST_SUITE(serialization_tests, BasicTestingSetup)
         BOOST_CHECK_MESSAGE(IsScriptNewMsgChannelAsset(scriptPubKey), "Script wasn't a message channel");
     }
 
+    BOOST_AUTO_TEST_CASE(tx_asset_outputs_test)
+    {
+        BOOST_TEST_MESSAGE("Running Transaction Asset Outputs Test");
+
+        SelectParams(CBaseChainParams::MAIN);
+
+        CTxDestination dest = DecodeDestination(GetParams().GlobalBurnAddress());
+        CScript scriptRVN = GetScriptForDestination(dest);
+
+        CMutableTransaction mtx;
+        mtx.vout.emplace_back(CTxOut(COIN, scriptRVN));
+
+        CScript scriptNew = scriptRVN;
+        CNewAsset asset("OUTPUTS", 100000000);
+        asset.ConstructTransaction(scriptNew);
+        mtx.vout.emplace_back(CTxOut(0, scriptNew));
+
+        CScript scriptOwner = scriptRVN;
+        asset.ConstructOwnerTransaction(scriptOwner);
+        mtx.vout.emplace_back(CTxOut(0, scriptOwner));
+
+        CScript scriptTransfer = scriptRVN;
+        CAssetTransfer transfer("OUTPUTS", 5000, DecodeAssetData("QmacSRmrkVmvJfbCpmU6pK72furJ8E8fbKHindrLxmYMQo"), 1700000000);
+        transfer.ConstructTransaction(scriptTransfer);
+        mtx.vout.emplace_back(CTxOut(0, scriptTransfer));
+
+        CScript scriptReissue = scriptRVN;
+        CReissueAsset reissue("OUTPUTS", 2000, 0, 1, "");
+        reissue.ConstructTransaction(scriptReissue);
+        mtx.vout.emplace_back(CTxOut(0, scriptReissue));
+
+        CTransaction tx(mtx);
+
+        // Only the asset outputs are kept, and the entry is reused
+        std::shared_ptr<const CTxAssetOutputs> outputs = GetTxAssetOutputs(tx);
+        BOOST_CHECK_EQUAL(outputs->vOutputs.size(), 4u);
+        BOOST_CHECK(outputs->Find(0) == nullptr);
+        BOOST_CHECK(GetTxAssetOutputs(tx) == outputs);
+        BOOST_CHECK(GetTxAssetOutputs(CTransaction(tx)) == outputs);
+
+        for (unsigned int n = 0; n < tx.vout.size(); n++) {
+            const CScript& script = tx.vout[n].scriptPubKey;
+
+            CAssetOutputEntry scriptData{}, txData{};
+            bool fScript = GetAssetData(script, scriptData);
+            BOOST_CHECK_EQUAL(GetAssetData(tx, n, txData), fScript);
+            if (fScript) {
+                BOOST_CHECK(txData.type == scriptData.type);
+                BOOST_CHECK_EQUAL(txData.assetName, scriptData.assetName);
+                BOOST_CHECK_EQUAL(txData.nAmount, scriptData.nAmount);
+                BOOST_CHECK(txData.destination == scriptData.destination);
+                BOOST_CHECK_EQUAL(txData.message, scriptData.message);
+                BOOST_CHECK_EQUAL(txData.expireTime, scriptData.expireTime);
+            }
+
+            uint160 scriptHashBytes, txHashBytes;
+            std::string strScriptName, strTxName;
+            CAmount nScriptAmount = 0, nTxAmount = 0;
+            fScript = ParseAssetScript(script, scriptHashBytes, strScriptName, nScriptAmount);
+            BOOST_CHECK_EQUAL(ParseAssetScript(tx, n, txHashBytes, strTxName, nTxAmount), fScript);
+            if (fScript) {
+                BOOST_CHECK(txHashBytes == scriptHashBytes);
+                BOOST_CHECK_EQUAL(strTxName, strScriptName);
+                BOOST_CHECK_EQUAL(nTxAmount, nScriptAmount);
+            }
+
+            CAssetTransfer scriptTransfer, txTransfer;
+            std::string strScriptAddress, strTxAddress;
+            fScript = TransferAssetFromScript(script, scriptTransfer, strScriptAddress);
+            BOOST_CHECK_EQUAL(TransferAssetFromTransaction(tx, n, txTransfer, strTxAddress), fScript);
+            if (fScript) {
+                BOOST_CHECK_EQUAL(strTxAddress, strScriptAddress);
+                BOOST_CHECK_EQUAL(txTransfer.strName, scriptTransfer.strName);
+                BOOST_CHECK_EQUAL(txTransfer.nAmount, scriptTransfer.nAmount);
+                BOOST_CHECK_EQUAL(txTransfer.message, scriptTransfer.message);
+                BOOST_CHECK_EQUAL(txTransfer.nExpireTime, scriptTransfer.nExpireTime);
+            }
+        }
+
+        const CTxAssetOutput* output = outputs->Find(3);
+        BOOST_CHECK(output && output->type == TX_TRANSFER_ASSET && output->nScriptOffset > 0);
+        BOOST_CHECK(output && output->nExpireTime == 1700000000);
+    }
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
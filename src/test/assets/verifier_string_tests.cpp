@@ -11,6 +11,7 @@
 #include <amount.h>
 #include <base58.h>
 #include <chainparams.h>
+#include <validation.h>
 
 #include "LibBoolEE.h"
 
@@ -366,5 +367,61 @@ BOOST_FIXTURE_TEST_SUITE(verifier_string_tests, BasicTestingSetup)
         }
     }
 
+    BOOST_AUTO_TEST_CASE(compiled_verifier_string_test)
+    {
+        BOOST_TEST_MESSAGE("Running Compiled Verifier String Test");
+
+        std::vector<std::string> verifiers = {"KYC", "!KYC", "KYC&ABC", "KYC|!ABC", "((KYC&!ABC)|DEF&GHI&RET)|(TEST)",
+                                              "!(KYC|ABC)&(DEF|!GHI)", "KYC&1", "ABC|0", "!!KYC", "((((KYC))))"};
+
+        // The compiled formula must agree with resolve under every valuation of its qualifiers
+        for (const std::string& verifier : verifiers) {
+            std::set<std::string> setQualifiers;
+            ExtractVerifierStringQualifiers(verifier, setQualifiers);
+            setQualifiers.erase("1");
+            setQualifiers.erase("0");
+            std::vector<std::string> vQualifiers(setQualifiers.begin(), setQualifiers.end());
+
+            LibBoolEE::Formula formula = LibBoolEE::compile(verifier, vQualifiers);
+            for (unsigned int mask = 0; mask < (1u << vQualifiers.size()); mask++) {
+                LibBoolEE::Vals vals;
+                std::vector<bool> values(vQualifiers.size());
+                for (size_t i = 0; i < vQualifiers.size(); i++) {
+                    values[i] = (mask >> i) & 1;
+                    vals.insert(make_pair(vQualifiers[i], values[i]));
+                }
+                BOOST_CHECK_MESSAGE(formula.evaluate(values) == LibBoolEE::resolve(verifier, vals), verifier);
+            }
+        }
+
+        // And must throw where resolve throws
+        std::vector<std::string> vQualifiers = {"ABC", "KYC"};
+        LibBoolEE::Vals vals = {{"ABC", true}, {"KYC", true}};
+        for (const char* verifier : {"KYC|MISS", "KYC&&ABC", "(KYC", "KYC~ABC", "KYC&()", ""}) {
+            BOOST_CHECK_THROW(LibBoolEE::resolve(verifier, vals), std::runtime_error);
+            BOOST_CHECK_THROW(LibBoolEE::compile(verifier, vQualifiers), std::runtime_error);
+        }
+
+        // CheckVerifierString answers from the compiled cache the same way, every time it is asked
+        passetsCompiledVerifierCache = new CShardedLRUCache<std::string, std::shared_ptr<const CCompiledVerifierString>>(1 << 20);
+        for (int i = 0; i < 2; i++) {
+            std::set<std::string> setFoundQualifiers;
+            std::string error;
+            BOOST_CHECK(CheckVerifierString("KYC&!ABC", setFoundQualifiers, error));
+            BOOST_CHECK(setFoundQualifiers.size() == 2);
+            BOOST_CHECK(setFoundQualifiers.count("KYC") && setFoundQualifiers.count("ABC"));
+
+            setFoundQualifiers.clear();
+            BOOST_CHECK(!CheckVerifierString("KYC&!ABC|MISS(", setFoundQualifiers, error));
+            BOOST_CHECK_EQUAL(error, "bad-txns-null-verifier-failed-syntax-check");
+        }
+        BOOST_CHECK_EQUAL(passetsCompiledVerifierCache->Size(), 2U);
+        BOOST_CHECK_EQUAL(passetsCompiledVerifierCache->Hits(), 2U);
+        BOOST_CHECK(passetsCompiledVerifierCache->DynamicMemoryUsage() > 0);
+
+        delete passetsCompiledVerifierCache;
+        passetsCompiledVerifierCache = nullptr;
+    }
+
 
 BOOST_AUTO_TEST_SUITE_END()
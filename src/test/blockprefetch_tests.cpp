@@ -0,0 +1,116 @@
+// Copyright (c) 2017-2020 The Raven Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "chainparams.h"
+#include "clientversion.h"
+#include "streams.h"
+#include "validation.h"
+
+#include "test/test_raven.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(blockprefetch_tests, BasicTestingSetup)
+
+    /** Write nBlocks blocks to a temporary file the way they are laid out in a block file, with junk between them */
+    static FILE* WriteBlockFile(int nBlocks, std::vector<uint256>& vHashes, std::vector<unsigned int>& vPos)
+    {
+        CDataStream stream(SER_DISK, CLIENT_VERSION);
+        for (int i = 0; i < nBlocks; i++) {
+            // Junk the reader has to skip to find the next block
+            for (int j = 0; j < i % 3; j++)
+                stream << (unsigned char)0x00;
+
+            CBlock block;
+            block.nVersion = 1;
+            block.nTime = 1 + i; // well before KAWPOW activation
+            block.nBits = 0x207fffff;
+            block.nNonce = i;
+            CMutableTransaction mtx;
+            mtx.nLockTime = i;
+            block.vtx.push_back(MakeTransactionRef(mtx));
+
+            unsigned int nSize = ::GetSerializeSize(block, SER_DISK, CLIENT_VERSION);
+            stream << FLATDATA(GetParams().MessageStart()) << nSize;
+            vPos.push_back(stream.size());
+            stream << block;
+            vHashes.push_back(block.GetHash());
+        }
+
+        FILE* file = tmpfile();
+        BOOST_REQUIRE(file != nullptr);
+        BOOST_REQUIRE_EQUAL(fwrite(stream.data(), 1, stream.size(), file), stream.size());
+        rewind(file);
+        return file;
+    }
+
+    BOOST_AUTO_TEST_CASE(blockprefetch_read_ahead_test)
+    {
+        BOOST_TEST_MESSAGE("Running Block Prefetch Read Ahead Test");
+
+        std::vector<uint256> vHashes;
+        std::vector<unsigned int> vPos;
+        FILE* file = WriteBlockFile(10, vHashes, vPos);
+
+        std::vector<std::shared_ptr<CPrefetchedBlock>> vBlocks;
+        {
+            CBlockFilePrefetcher prefetcher(GetParams(), file);
+            std::shared_ptr<CPrefetchedBlock> prefetched;
+            while (prefetcher.Next(prefetched))
+                vBlocks.push_back(prefetched);
+            BOOST_CHECK(!prefetcher.Next(prefetched));
+            BOOST_CHECK(prefetcher.GetError().empty());
+            BOOST_CHECK_EQUAL(prefetcher.GetQueuedBytes(), 0U);
+        }
+
+        // Blocks come out in file order, each one already hashed
+        BOOST_REQUIRE_EQUAL(vBlocks.size(), vHashes.size());
+        for (size_t i = 0; i < vBlocks.size(); i++) {
+            BOOST_CHECK_EQUAL(vBlocks[i]->nPos, vPos[i]);
+            BOOST_CHECK_EQUAL(vBlocks[i]->nSize, ::GetSerializeSize(*vBlocks[i]->pblock, SER_DISK, CLIENT_VERSION));
+            BOOST_CHECK(vBlocks[i]->fHashed);
+            BOOST_CHECK(vBlocks[i]->pblock->hashCache.Get() != nullptr);
+        }
+
+        // Hashing them again is served from the hashes the prefetcher left behind
+        uint64_t nComputedBefore, nCachedBefore, nComputedAfter, nCachedAfter;
+        GetBlockHeaderHashStats(nComputedBefore, nCachedBefore);
+        for (size_t i = 0; i < vBlocks.size(); i++)
+            BOOST_CHECK(vBlocks[i]->pblock->GetHash() == vHashes[i]);
+        GetBlockHeaderHashStats(nComputedAfter, nCachedAfter);
+        BOOST_CHECK_EQUAL(nComputedAfter, nComputedBefore);
+        BOOST_CHECK_EQUAL(nCachedAfter, nCachedBefore + vBlocks.size());
+    }
+
+    BOOST_AUTO_TEST_CASE(blockprefetch_stop_test)
+    {
+        BOOST_TEST_MESSAGE("Running Block Prefetch Stop Test");
+
+        std::vector<uint256> vHashes;
+        std::vector<unsigned int> vPos;
+        FILE* file = WriteBlockFile(50, vHashes, vPos);
+        unsigned int nBlockSize = ::GetSerializeSize(CBlock(), SER_DISK, CLIENT_VERSION) + 64;
+
+        // With a small cap the reader stays a few blocks ahead, and the prefetcher can be dropped in the middle of the file
+        {
+            size_t nMaxQueuedBytes = 2 * nBlockSize;
+            CBlockFilePrefetcher prefetcher(GetParams(), file, nMaxQueuedBytes);
+            std::shared_ptr<CPrefetchedBlock> prefetched;
+            for (int i = 0; i < 5; i++) {
+                BOOST_REQUIRE(prefetcher.Next(prefetched));
+                BOOST_CHECK(prefetched->pblock->GetHash() == vHashes[i]);
+                BOOST_CHECK(prefetcher.GetQueuedBytes() <= nMaxQueuedBytes + nBlockSize);
+            }
+        }
+
+        // Or before anything was taken from it
+        vHashes.clear();
+        vPos.clear();
+        file = WriteBlockFile(50, vHashes, vPos);
+        {
+            CBlockFilePrefetcher prefetcher(GetParams(), file, 1);
+        }
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -361,4 +361,92 @@ BOOST_FIXTURE_TEST_SUITE(dbwrapper_tests, BasicTestingSetup)
     }
 
 
+
+    BOOST_AUTO_TEST_CASE(iterator_prefix_reverse_test)
+    {
+        BOOST_TEST_MESSAGE("Running Iterator Prefix Reverse Test");
+
+        fs::path ph = fs::temp_directory_path() / fs::unique_path();
+        CDBWrapper dbw(ph, (1 << 20), true, false, false);
+
+        // Three tables, keyed (flag, name); the middle one is walked backwards
+        for (char flag : {'A', 'B', 'C'}) {
+            for (int x = 0; x < 10; ++x) {
+                BOOST_CHECK(dbw.Write(std::make_pair(flag, std::string(1, (char)('a' + x))), (uint32_t)x));
+            }
+        }
+
+        std::unique_ptr<CDBIterator> it(const_cast<CDBWrapper &>(dbw).NewIterator());
+        it->SeekToLastWithPrefix('B');
+        for (int x = 9; x >= 0; --x) {
+            std::pair<char, std::string> key;
+            uint32_t value;
+            BOOST_CHECK(it->Valid());
+            if (!it->Valid())
+                break;
+            BOOST_CHECK(it->GetKey(key));
+            BOOST_CHECK(it->GetValue(value));
+            BOOST_CHECK_EQUAL(key.first, 'B');
+            BOOST_CHECK_EQUAL(key.second, std::string(1, (char)('a' + x)));
+            BOOST_CHECK_EQUAL(value, (uint32_t)x);
+            it->Prev();
+        }
+
+        // Stepping off the front of the table lands on the previous table
+        std::pair<char, std::string> key;
+        BOOST_CHECK(it->Valid() && it->GetKey(key));
+        BOOST_CHECK_EQUAL(key.first, 'A');
+
+        // The last table has no successor key
+        it->SeekToLastWithPrefix('C');
+        BOOST_CHECK(it->Valid() && it->GetKey(key));
+        BOOST_CHECK_EQUAL(key.first, 'C');
+        BOOST_CHECK_EQUAL(key.second, "j");
+
+        // A prefix with no entries leaves the iterator before where it would be
+        it->SeekToLastWithPrefix(std::make_pair('B', std::string("bb")));
+        BOOST_CHECK(it->Valid() && it->GetKey(key));
+        BOOST_CHECK_EQUAL(key.first, 'B');
+        BOOST_CHECK_EQUAL(key.second, "j");
+    }
+
+    BOOST_AUTO_TEST_CASE(snapshot_iterator_test)
+    {
+        BOOST_TEST_MESSAGE("Running Snapshot Iterator Test");
+
+        fs::path ph = fs::temp_directory_path() / fs::unique_path();
+        CDBWrapper dbw(ph, (1 << 20), true, false, true);
+
+        for (uint32_t x = 0; x < 10; ++x) {
+            BOOST_CHECK(dbw.Write(std::make_pair('S', x), x));
+        }
+
+        CDBSnapshot snapshot(dbw);
+
+        // Writes after the snapshot was taken are not seen through it
+        for (uint32_t x = 0; x < 10; x += 2) {
+            BOOST_CHECK(dbw.Erase(std::make_pair('S', x)));
+        }
+        BOOST_CHECK(dbw.Write(std::make_pair('S', (uint32_t)5), (uint32_t)50));
+        BOOST_CHECK(dbw.Write(std::make_pair('S', (uint32_t)10), (uint32_t)10));
+
+        std::unique_ptr<CDBIterator> it(snapshot.NewIterator());
+        it->Seek(std::make_pair('S', (uint32_t)0));
+        for (uint32_t x = 0; x < 10; ++x) {
+            std::pair<char, uint32_t> key;
+            uint32_t value;
+            BOOST_CHECK(it->Valid() && it->GetKey(key) && it->GetValue(value));
+            BOOST_CHECK_EQUAL(key.second, x);
+            BOOST_CHECK_EQUAL(value, x);
+            it->Next();
+        }
+        BOOST_CHECK(!it->Valid());
+
+        // While the database itself has them
+        uint32_t value;
+        BOOST_CHECK(!dbw.Read(std::make_pair('S', (uint32_t)0), value));
+        BOOST_CHECK(dbw.Read(std::make_pair('S', (uint32_t)5), value));
+        BOOST_CHECK_EQUAL(value, 50U);
+    }
+
 BOOST_AUTO_TEST_SUITE_END()
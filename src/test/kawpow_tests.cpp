@@ -13,6 +13,9 @@
 #include "crypto/ethash/helpers.hpp"
 #include "crypto/ethash/progpow_test_vectors.hpp"
 
+#include "hash.h"
+#include "uint256.h"
+
 #include <array>
 
 BOOST_FIXTURE_TEST_SUITE(kawpow_tests, BasicTestingSetup)
@@ -139,4 +142,38 @@ BOOST_AUTO_TEST_CASE(kawpow_search)
     BOOST_CHECK(sr.mix_hash == r.mix_hash);
 }
 
+BOOST_AUTO_TEST_CASE(kawpow_uint256_conversion)
+{
+    for (auto& t : progpow_hash_test_cases)
+    {
+        // The byte level conversions must agree with going through hex strings
+        const uint256 header_hash = uint256S(t.header_hash_hex);
+        BOOST_CHECK(to_hash256(header_hash) == to_hash256(header_hash.GetHex()));
+        BOOST_CHECK(to_hash256(header_hash) == to_hash256(std::string(t.header_hash_hex)));
+
+        const auto mix_hash = to_hash256(t.mix_hash_hex);
+        BOOST_CHECK(to_uint256(mix_hash) == uint256S(to_hex(mix_hash)));
+        BOOST_CHECK_EQUAL(to_uint256(mix_hash).GetHex(), t.mix_hash_hex);
+        BOOST_CHECK(to_hash256(to_uint256(mix_hash)) == mix_hash);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(kawpow_epoch_context_cache)
+{
+    EthashContextCacheStats before = GetEthashContextCacheStats();
+
+    auto context = GetEthashEpochContext(1);
+    BOOST_CHECK(context && context->epoch_number == 0);
+
+    // A second lookup in the same epoch is served from the cache
+    auto again = GetEthashEpochContext(ethash::epoch_length - ETHASH_PREBUILD_BLOCKS - 1);
+    BOOST_CHECK(again == context);
+
+    EthashContextCacheStats after = GetEthashContextCacheStats();
+    BOOST_CHECK(after.hits + after.misses == before.hits + before.misses + 2);
+    BOOST_CHECK(after.hits >= before.hits + 1);
+    BOOST_CHECK(after.size >= 1 && after.size <= after.capacity);
+    BOOST_CHECK(after.memory >= ethash::get_light_cache_size(context->light_cache_num_items));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
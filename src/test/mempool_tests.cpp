@@ -3,6 +3,7 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include "coins.h"
 #include "policy/policy.h"
 #include "txmempool.h"
 #include "util.h"
@@ -597,4 +598,80 @@ BOOST_FIXTURE_TEST_SUITE(mempool_tests, TestingSetup)
         SetMockTime(0);
     }
 
+    BOOST_AUTO_TEST_CASE(mempool_address_index_test)
+    {
+        BOOST_TEST_MESSAGE("Running Mempool Address Index Test");
+
+        TestMemPoolEntryHelper entry;
+        uint160 hashA(std::vector<unsigned char>(20, 0xaa));
+        uint160 hashB(std::vector<unsigned char>(20, 0xbb));
+        CScript scriptA = CScript() << OP_DUP << OP_HASH160 << ToByteVector(hashA) << OP_EQUALVERIFY << OP_CHECKSIG;
+        CScript scriptB = CScript() << OP_HASH160 << ToByteVector(hashB) << OP_EQUAL;
+
+        CCoinsView base;
+        CCoinsViewCache view(&base);
+        COutPoint prevoutA(InsecureRand256(), 0);
+        COutPoint prevoutB(InsecureRand256(), 1);
+        view.AddCoin(prevoutA, Coin(CTxOut(50000LL, scriptA), 1, false), false);
+        view.AddCoin(prevoutB, Coin(CTxOut(30000LL, scriptB), 1, false), false);
+
+        // tx1 spends from A, paying A and B, and tx2 spends from B paying A twice
+        CMutableTransaction tx1;
+        tx1.vin.resize(1);
+        tx1.vin[0].prevout = prevoutA;
+        tx1.vout.push_back(CTxOut(20000LL, scriptA));
+        tx1.vout.push_back(CTxOut(20000LL, scriptB));
+        CMutableTransaction tx2;
+        tx2.vin.resize(1);
+        tx2.vin[0].prevout = prevoutB;
+        tx2.vout.push_back(CTxOut(10000LL, scriptA));
+        tx2.vout.push_back(CTxOut(10000LL, scriptA));
+
+        CTxMemPool testPool;
+        for (const CMutableTransaction& tx : {tx1, tx2}) {
+            testPool.addUnchecked(tx.GetHash(), entry.FromTx(tx));
+            testPool.addAddressIndex(entry.FromTx(tx), view);
+            testPool.addSpentIndex(entry.FromTx(tx), view);
+        }
+
+        std::vector<std::pair<uint160, int> > addresses = {std::make_pair(hashA, 1), std::make_pair(hashB, 2)};
+        std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> > deltas;
+        BOOST_CHECK(testPool.getAddressIndex(addresses, RVN, deltas));
+        BOOST_CHECK_EQUAL(deltas.size(), 6U);
+
+        // Each address's deltas come in key order
+        CMempoolAddressDeltaKeyCompare compare;
+        for (size_t i = 1; i < 4; i++)
+            BOOST_CHECK(compare(deltas[i - 1].first, deltas[i].first));
+        CAmount nA = 0;
+        for (size_t i = 0; i < 4; i++) {
+            BOOST_CHECK(deltas[i].first.addressBytes == hashA);
+            nA += deltas[i].second.amount;
+        }
+        BOOST_CHECK_EQUAL(nA, -10000LL);
+
+        deltas.clear();
+        BOOST_CHECK(testPool.getAddressIndex(addresses, "ASSET", deltas));
+        BOOST_CHECK(deltas.empty());
+
+        CSpentIndexKey spentKey(prevoutA.hash, prevoutA.n);
+        CSpentIndexValue spentValue;
+        BOOST_CHECK(testPool.getSpentIndex(spentKey, spentValue));
+        BOOST_CHECK(spentValue.txid == tx1.GetHash());
+
+        // Removing tx1 takes its deltas and spends with it
+        testPool.removeRecursive(tx1);
+        deltas.clear();
+        BOOST_CHECK(testPool.getAddressIndex(addresses, deltas));
+        BOOST_CHECK_EQUAL(deltas.size(), 3U);
+        for (const auto& delta : deltas)
+            BOOST_CHECK(delta.first.txhash == tx2.GetHash());
+        BOOST_CHECK(!testPool.getSpentIndex(spentKey, spentValue));
+
+        testPool.removeRecursive(tx2);
+        deltas.clear();
+        BOOST_CHECK(testPool.getAddressIndex(addresses, deltas));
+        BOOST_CHECK(deltas.empty());
+    }
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -5,7 +5,9 @@
 
 #include "chain.h"
 #include "chainparams.h"
+#include "hash.h"
 #include "pow.h"
+#include "primitives/block.h"
 #include "random.h"
 #include "util.h"
 #include "test/test_raven.h"
@@ -96,4 +98,63 @@ BOOST_FIXTURE_TEST_SUITE(pow_tests, BasicTestingSetup)
         }
     }
 
+    /* The memoized header hash must follow every change to the header fields */
+    BOOST_AUTO_TEST_CASE(block_header_hash_cache_test)
+    {
+        CBlock block;
+        block.nVersion = 0x20000000;
+        block.hashPrevBlock = uint256S("0x0000000000000000000000000000000000000000000000000000000000000123");
+        block.nTime = 1546300800; // X16R
+        block.nBits = 0x1e00ffff;
+
+        uint64_t nComputed, nCached, nComputedBefore, nCachedBefore;
+        GetBlockHeaderHashStats(nComputedBefore, nCachedBefore);
+
+        uint256 hash = block.GetHash();
+        BOOST_CHECK(hash == block.GetX16RHash());
+        BOOST_CHECK(block.GetHash() == hash);
+        uint256 mix_hash;
+        BOOST_CHECK(block.GetHashFull(mix_hash) == hash);
+        BOOST_CHECK(mix_hash.IsNull());
+        GetBlockHeaderHashStats(nComputed, nCached);
+        BOOST_CHECK_EQUAL(nComputed - nComputedBefore, 1U);
+        BOOST_CHECK_EQUAL(nCached - nCachedBefore, 2U);
+
+        // Copies keep the cached hash
+        CBlockHeader header = block.GetBlockHeader();
+        BOOST_CHECK(header.GetHash() == hash);
+        CBlock copy(block);
+        BOOST_CHECK(copy.GetHash() == hash);
+        GetBlockHeaderHashStats(nComputed, nCached);
+        BOOST_CHECK_EQUAL(nComputed - nComputedBefore, 1U);
+
+        // Any mutation is picked up
+        block.nNonce++;
+        BOOST_CHECK(block.GetHash() != hash);
+        BOOST_CHECK(block.GetHash() == block.GetX16RHash());
+        block.nNonce--;
+        block.hashMerkleRoot = uint256S("0x0000000000000000000000000000000000000000000000000000000000000456");
+        BOOST_CHECK(block.GetHash() == block.GetX16RHash());
+        BOOST_CHECK(copy.GetHash() == hash);
+        block.nTime = 1577836800; // X16RV2
+        BOOST_CHECK(block.GetHash() == block.GetX16RV2Hash());
+
+        // KAWPOW caches the full hash together with its mix hash
+        block.nTime = nKAWPOWActivationTime;
+        block.nHeight = 1500000;
+        uint256 expected_mix_hash;
+        uint256 hashFull = KAWPOWHash(block, expected_mix_hash);
+        BOOST_CHECK(block.GetHashFull(mix_hash) == hashFull);
+        BOOST_CHECK(mix_hash == expected_mix_hash);
+        mix_hash.SetNull();
+        BOOST_CHECK(block.GetHashFull(mix_hash) == hashFull);
+        BOOST_CHECK(mix_hash == expected_mix_hash);
+        BOOST_CHECK(block.GetHash() == KAWPOWHash_OnlyMix(block));
+        block.mix_hash = expected_mix_hash;
+        BOOST_CHECK(block.GetHash() == hashFull);
+
+        block.SetNull();
+        BOOST_CHECK(!block.hashCache.Get());
+    }
+
 BOOST_AUTO_TEST_SUITE_END()
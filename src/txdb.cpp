@@ -15,8 +15,11 @@
 #include "ui_interface.h"
 #include "init.h"
 #include "validation.h"
+#include "checkqueue.h"
 
+#include <algorithm>
 #include <stdint.h>
+#include <thread>
 
 #include <boost/thread.hpp>
 
@@ -26,6 +29,8 @@ static const char DB_BLOCK_FILES = 'f';
 static const char DB_TXINDEX = 't';
 static const char DB_ADDRESSINDEX = 'a';
 static const char DB_ADDRESSUNSPENTINDEX = 'u';
+static const char DB_ADDRESSBALANCEINDEX = 'A';
+static const char DB_ADDRESSHEIGHTINDEX = 'h';
 static const char DB_TIMESTAMPINDEX = 's';
 static const char DB_BLOCKHASHINDEX = 'z';
 static const char DB_SPENTINDEX = 'p';
@@ -37,6 +42,9 @@ static const char DB_FLAG = 'F';
 static const char DB_REINDEX_FLAG = 'R';
 static const char DB_LAST_BLOCK = 'l';
 
+//! Bytes of writes to gather before committing them while building or dropping a secondary address index
+static const size_t ADDRESS_INDEX_BATCH_SIZE = 16 << 20;
+
 namespace {
 
 struct CoinEntry {
@@ -270,6 +278,12 @@ bool CBlockTreeDB::UpdateSpentIndex(const std::vector<std::pair<CSpentIndexKey,
     return WriteBatch(batch);
 }
 
+/** Position the cursor on the first key after the given one: appending a zero byte gives the next possible key */
+template <typename K>
+static void SeekAfter(CDBIterator* pcursor, char chPrefix, const K& key) {
+    pcursor->Seek(std::make_pair(std::make_pair(chPrefix, key), (char)0));
+}
+
 bool CBlockTreeDB::UpdateAddressUnspentIndex(const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue > >&vect) {
     CDBBatch batch(*this);
     for (std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++) {
@@ -282,21 +296,37 @@ bool CBlockTreeDB::UpdateAddressUnspentIndex(const std::vector<std::pair<CAddres
     return WriteBatch(batch);
 }
 
-bool CBlockTreeDB::ReadAddressUnspentIndex(uint160 addressHash, int type, std::string assetName,
-                                           std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs) {
-
-    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+bool CBlockTreeDB::ReadAddressUnspent(const CAddressUnspentKey &key, CAddressUnspentValue &value) {
+    return Read(std::make_pair(DB_ADDRESSUNSPENTINDEX, key), value);
+}
 
-    pcursor->Seek(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorAssetKey(type, addressHash, assetName)));
+/**
+ * Read the unspent outputs of one address with an existing cursor: those of one asset, or when pAssetName is
+ * null, those of every asset but RVN.
+ */
+static bool ReadAddressUnspentRows(CDBIterator* pcursor, const uint160& addressHash, int type, const std::string* pAssetName,
+                                   std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs,
+                                   const CAddressUnspentKey* pAfter, size_t nLimit) {
+
+    if (pAfter) {
+        SeekAfter(pcursor, DB_ADDRESSUNSPENTINDEX, *pAfter);
+    } else if (pAssetName) {
+        pcursor->Seek(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorAssetKey(type, addressHash, *pAssetName)));
+    } else {
+        pcursor->Seek(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, addressHash)));
+    }
 
-    while (pcursor->Valid()) {
+    size_t nStart = unspentOutputs.size();
+    while (pcursor->Valid() && (nLimit == 0 || unspentOutputs.size() - nStart < nLimit)) {
         boost::this_thread::interruption_point();
         std::pair<char,CAddressUnspentKey> key;
         if (pcursor->GetKey(key) && key.first == DB_ADDRESSUNSPENTINDEX && key.second.hashBytes == addressHash
-                && (assetName.empty() || key.second.asset == assetName)) {
+                && (!pAssetName || pAssetName->empty() || key.second.asset == *pAssetName)) {
             CAddressUnspentValue nValue;
             if (pcursor->GetValue(nValue)) {
-                unspentOutputs.push_back(std::make_pair(key.second, nValue));
+                if (pAssetName || key.second.asset != "RVN") {
+                    unspentOutputs.push_back(std::make_pair(key.second, nValue));
+                }
                 pcursor->Next();
             } else {
                 return error("failed to get address unspent value");
@@ -309,55 +339,295 @@ bool CBlockTreeDB::ReadAddressUnspentIndex(uint160 addressHash, int type, std::s
     return true;
 }
 
+bool CBlockTreeDB::ReadAddressUnspentIndex(uint160 addressHash, int type, std::string assetName,
+                                           std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs,
+                                           const CAddressUnspentKey* pAfter, size_t nLimit) {
+
+    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+    return ReadAddressUnspentRows(pcursor.get(), addressHash, type, &assetName, unspentOutputs, pAfter, nLimit);
+}
+
 bool CBlockTreeDB::ReadAddressUnspentIndex(uint160 addressHash, int type,
-                                           std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs) {
+                                           std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs,
+                                           const CAddressUnspentKey* pAfter, size_t nLimit) {
 
     boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+    return ReadAddressUnspentRows(pcursor.get(), addressHash, type, nullptr, unspentOutputs, pAfter, nLimit);
+}
 
-    pcursor->Seek(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, addressHash)));
+/**
+ * Run a read for each of many addresses in the order of their keys, so that one cursor walks the index
+ * forward instead of a new one seeking all over it for every address. Addresses asked for twice are read
+ * once. Large batches are split into runs of consecutive addresses, each read by its own thread and cursor,
+ * and the results joined in key order.
+ */
+template <typename T>
+static bool ReadAddressesBatch(CBlockTreeDB& db, std::vector<std::pair<uint160, int> > addresses, std::vector<T> &vect, int nThreads,
+                               std::function<bool(CDBIterator*, const std::pair<uint160, int>&, std::vector<T>&)> fnRead) {
+
+    // Keys start with the type byte followed by the hash, and uint160 compares like its serialization
+    std::sort(addresses.begin(), addresses.end(), [](const std::pair<uint160, int>& a, const std::pair<uint160, int>& b) {
+        return a.second != b.second ? (unsigned char)a.second < (unsigned char)b.second : a.first < b.first;
+    });
+    addresses.erase(std::unique(addresses.begin(), addresses.end()), addresses.end());
+
+    size_t nRuns = std::max(1, std::min(nThreads, (int)(addresses.size() / ADDRESS_BATCH_MIN_PER_THREAD)));
+    std::vector<std::vector<T> > vResults(nRuns);
+    std::vector<char> vOk(nRuns, false);
+
+    auto readRun = [&](size_t nRun) {
+        try {
+            boost::scoped_ptr<CDBIterator> pcursor(db.NewIterator());
+            size_t nBegin = addresses.size() * nRun / nRuns;
+            size_t nEnd = addresses.size() * (nRun + 1) / nRuns;
+            for (size_t i = nBegin; i < nEnd; i++) {
+                if (!fnRead(pcursor.get(), addresses[i], vResults[nRun]))
+                    return;
+            }
+            vOk[nRun] = true;
+        } catch (const std::exception& e) {
+            LogPrintf("%s: %s\n", __func__, e.what());
+        }
+    };
+
+    std::vector<std::thread> vThreads;
+    for (size_t nRun = 1; nRun < nRuns; nRun++)
+        vThreads.emplace_back(readRun, nRun);
+    readRun(0);
+    for (std::thread& thread : vThreads)
+        thread.join();
+
+    for (size_t nRun = 0; nRun < nRuns; nRun++) {
+        if (!vOk[nRun])
+            return false;
+        vect.insert(vect.end(), vResults[nRun].begin(), vResults[nRun].end());
+    }
+    return true;
+}
+
+bool CBlockTreeDB::ReadAddressUnspentIndex(const std::vector<std::pair<uint160, int> > &addresses, std::string assetName,
+                                           std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs,
+                                           int nThreads) {
+    return ReadAddressesBatch<std::pair<CAddressUnspentKey, CAddressUnspentValue> >(*this, addresses, unspentOutputs, nThreads,
+        [&assetName](CDBIterator* pcursor, const std::pair<uint160, int>& address, std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >& vect) {
+            return ReadAddressUnspentRows(pcursor, address.first, address.second, &assetName, vect, nullptr, 0);
+        });
+}
 
+bool CBlockTreeDB::ReadAddressUnspentIndex(const std::vector<std::pair<uint160, int> > &addresses,
+                                           std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs,
+                                           int nThreads) {
+    return ReadAddressesBatch<std::pair<CAddressUnspentKey, CAddressUnspentValue> >(*this, addresses, unspentOutputs, nThreads,
+        [](CDBIterator* pcursor, const std::pair<uint160, int>& address, std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >& vect) {
+            return ReadAddressUnspentRows(pcursor, address.first, address.second, nullptr, vect, nullptr, 0);
+        });
+}
+
+/** Erase every row of a secondary index, whose keys are a prefix followed by a K */
+template <typename K>
+static bool EraseIndexRows(CBlockTreeDB& db, char chPrefix) {
+    boost::scoped_ptr<CDBIterator> pcursor(db.NewIterator());
+    CDBBatch batch(db);
+    pcursor->Seek(chPrefix);
     while (pcursor->Valid()) {
         boost::this_thread::interruption_point();
-        std::pair<char,CAddressUnspentKey> key;
-        if (pcursor->GetKey(key) && key.first == DB_ADDRESSUNSPENTINDEX && key.second.hashBytes == addressHash) {
-            CAddressUnspentValue nValue;
-            if (pcursor->GetValue(nValue)) {
-                if (key.second.asset != "RVN") {
-                    unspentOutputs.push_back(std::make_pair(key.second, nValue));
-                }
-                pcursor->Next();
-            } else {
-                return error("failed to get address unspent value");
-            }
-        } else {
+        std::pair<char,K> key;
+        if (!pcursor->GetKey(key) || key.first != chPrefix)
             break;
+        batch.Erase(key);
+        if (batch.SizeEstimate() > ADDRESS_INDEX_BATCH_SIZE) {
+            if (!db.WriteBatch(batch))
+                return false;
+            batch.Clear();
         }
+        pcursor->Next();
     }
+    return db.WriteBatch(batch);
+}
 
+/**
+ * Add the summed deltas of each address and asset to their running balances in the batch, dropping the
+ * balances that return to nothing.
+ */
+bool CBlockTreeDB::UpdateAddressBalanceIndex(CDBBatch& batch, const std::map<CAddressBalanceKey, CAddressBalanceValue>& mapDeltas) {
+    for (std::map<CAddressBalanceKey, CAddressBalanceValue>::const_iterator it=mapDeltas.begin(); it!=mapDeltas.end(); it++) {
+        CAddressBalanceValue value;
+        if (!Read(std::make_pair(DB_ADDRESSBALANCEINDEX, it->first), value))
+            value.SetNull();
+        value.balance += it->second.balance;
+        value.received += it->second.received;
+        if (value.IsNull()) {
+            batch.Erase(std::make_pair(DB_ADDRESSBALANCEINDEX, it->first));
+        } else {
+            batch.Write(std::make_pair(DB_ADDRESSBALANCEINDEX, it->first), value);
+        }
+    }
     return true;
 }
 
 bool CBlockTreeDB::WriteAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount > >&vect) {
     CDBBatch batch(*this);
-    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
+    std::map<CAddressBalanceKey, CAddressBalanceValue> mapDeltas;
+    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=vect.begin(); it!=vect.end(); it++) {
+        CAddressBalanceValue& delta = mapDeltas[CAddressBalanceKey(it->first.type, it->first.hashBytes, it->first.asset)];
+        // A block connected again after an unclean shutdown rewrites its deltas, which must not be counted twice
+        CAmount nOldValue;
+        if (Read(std::make_pair(DB_ADDRESSINDEX, it->first), nOldValue))
+            delta.ApplyDelta(nOldValue, -1);
+        delta.ApplyDelta(it->second, 1);
         batch.Write(std::make_pair(DB_ADDRESSINDEX, it->first), it->second);
+        if (fAddressHeightIndex)
+            batch.Write(std::make_pair(DB_ADDRESSHEIGHTINDEX, CAddressHeightIndexKey(it->first)), it->second);
+    }
+    if (!UpdateAddressBalanceIndex(batch, mapDeltas))
+        return false;
     return WriteBatch(batch);
 }
 
 bool CBlockTreeDB::EraseAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount > >&vect) {
     CDBBatch batch(*this);
-    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
+    std::map<CAddressBalanceKey, CAddressBalanceValue> mapDeltas;
+    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=vect.begin(); it!=vect.end(); it++) {
+        // Take off the value that was stored, which is all that is in the balance
+        CAmount nOldValue;
+        if (Read(std::make_pair(DB_ADDRESSINDEX, it->first), nOldValue))
+            mapDeltas[CAddressBalanceKey(it->first.type, it->first.hashBytes, it->first.asset)].ApplyDelta(nOldValue, -1);
         batch.Erase(std::make_pair(DB_ADDRESSINDEX, it->first));
+        if (fAddressHeightIndex)
+            batch.Erase(std::make_pair(DB_ADDRESSHEIGHTINDEX, CAddressHeightIndexKey(it->first)));
+    }
+    if (!UpdateAddressBalanceIndex(batch, mapDeltas))
+        return false;
     return WriteBatch(batch);
 }
 
+bool CBlockTreeDB::ReadAddressBalance(uint160 addressHash, int type, std::string assetName, CAddressBalanceValue &balance) {
+    // No entry means nothing was ever received
+    if (!Read(std::make_pair(DB_ADDRESSBALANCEINDEX, CAddressBalanceKey(type, addressHash, assetName)), balance))
+        balance.SetNull();
+    return true;
+}
+
+/** Read the balances of one address with an existing cursor: that of one asset, or when pAssetName is null, all of them */
+static bool ReadAddressBalanceRows(CDBIterator* pcursor, const uint160& addressHash, int type, const std::string* pAssetName,
+                                   std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue> > &balances) {
+
+    if (pAssetName) {
+        pcursor->Seek(std::make_pair(DB_ADDRESSBALANCEINDEX, CAddressIndexIteratorAssetKey(type, addressHash, *pAssetName)));
+    } else {
+        pcursor->Seek(std::make_pair(DB_ADDRESSBALANCEINDEX, CAddressIndexIteratorKey(type, addressHash)));
+    }
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char,CAddressBalanceKey> key;
+        if (pcursor->GetKey(key) && key.first == DB_ADDRESSBALANCEINDEX && key.second.hashBytes == addressHash
+                && key.second.type == (unsigned int)type && (!pAssetName || key.second.asset == *pAssetName)) {
+            CAddressBalanceValue value;
+            if (pcursor->GetValue(value)) {
+                balances.push_back(std::make_pair(key.second, value));
+                pcursor->Next();
+            } else {
+                return error("failed to get address balance value");
+            }
+        } else {
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool CBlockTreeDB::ReadAddressBalances(uint160 addressHash, int type,
+                                       std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue> > &balances) {
+
+    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+    return ReadAddressBalanceRows(pcursor.get(), addressHash, type, nullptr, balances);
+}
+
+bool CBlockTreeDB::ReadAddressBalances(const std::vector<std::pair<uint160, int> > &addresses, std::string assetName,
+                                       std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue> > &balances,
+                                       int nThreads) {
+    return ReadAddressesBatch<std::pair<CAddressBalanceKey, CAddressBalanceValue> >(*this, addresses, balances, nThreads,
+        [&assetName](CDBIterator* pcursor, const std::pair<uint160, int>& address, std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue> >& vect) {
+            return ReadAddressBalanceRows(pcursor, address.first, address.second, &assetName, vect);
+        });
+}
+
+bool CBlockTreeDB::ReadAddressBalances(const std::vector<std::pair<uint160, int> > &addresses,
+                                       std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue> > &balances,
+                                       int nThreads) {
+    return ReadAddressesBatch<std::pair<CAddressBalanceKey, CAddressBalanceValue> >(*this, addresses, balances, nThreads,
+        [](CDBIterator* pcursor, const std::pair<uint160, int>& address, std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue> >& vect) {
+            return ReadAddressBalanceRows(pcursor, address.first, address.second, nullptr, vect);
+        });
+}
+
+bool CBlockTreeDB::BuildAddressBalanceIndex() {
+    // Drop whatever an interrupted earlier build left behind
+    if (!EraseIndexRows<CAddressBalanceKey>(*this, DB_ADDRESSBALANCEINDEX))
+        return error("%s: failed to erase address balances", __func__);
+
+    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+    CDBBatch batch(*this);
+
+    // The address index is ordered by address and asset, so each balance is complete once the cursor moves past it
+    uint64_t nBalances = 0;
+    uint64_t nDeltas = 0;
+    bool fHaveBalance = false;
+    CAddressBalanceKey balanceKey;
+    CAddressBalanceValue balance;
+    pcursor->Seek(DB_ADDRESSINDEX);
+    while (true) {
+        boost::this_thread::interruption_point();
+        std::pair<char,CAddressIndexKey> key;
+        bool fValid = pcursor->Valid() && pcursor->GetKey(key) && key.first == DB_ADDRESSINDEX;
+        if (fHaveBalance && (!fValid || key.second.type != balanceKey.type || key.second.hashBytes != balanceKey.hashBytes
+                || key.second.asset != balanceKey.asset)) {
+            if (!balance.IsNull()) {
+                batch.Write(std::make_pair(DB_ADDRESSBALANCEINDEX, balanceKey), balance);
+                nBalances++;
+            }
+            fHaveBalance = false;
+            if (batch.SizeEstimate() > ADDRESS_INDEX_BATCH_SIZE) {
+                if (!WriteBatch(batch))
+                    return error("%s: failed to write address balances", __func__);
+                batch.Clear();
+            }
+        }
+        if (!fValid)
+            break;
+
+        CAmount nValue;
+        if (!pcursor->GetValue(nValue))
+            return error("%s: failed to get address index value", __func__);
+        if (!fHaveBalance) {
+            balanceKey = CAddressBalanceKey(key.second.type, key.second.hashBytes, key.second.asset);
+            balance.SetNull();
+            fHaveBalance = true;
+        }
+        balance.ApplyDelta(nValue, 1);
+        if (++nDeltas % 1000000 == 0)
+            LogPrintf("%s: %u address index deltas summed\n", __func__, nDeltas);
+        pcursor->Next();
+    }
+
+    if (!WriteBatch(batch))
+        return error("%s: failed to write address balances", __func__);
+    LogPrintf("%s: built %u address balances from %u deltas\n", __func__, nBalances, nDeltas);
+    return true;
+}
+
 bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, int type, std::string assetName,
                                     std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
-                                    int start, int end) {
+                                    int start, int end, const CAddressIndexKey* pAfter, size_t nLimit) {
 
     boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
 
-    if (!assetName.empty() && start > 0 && end > 0) {
+    bool fHeightSeek = !assetName.empty() && start > 0 && end > 0;
+    if (pAfter && (!fHeightSeek || (int)pAfter->blockHeight >= start)) {
+        SeekAfter(pcursor.get(), DB_ADDRESSINDEX, *pAfter);
+    } else if (fHeightSeek) {
         pcursor->Seek(std::make_pair(DB_ADDRESSINDEX,
                                      CAddressIndexIteratorHeightKey(type, addressHash, assetName, start)));
     } else if (!assetName.empty()) {
@@ -366,12 +636,19 @@ bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, int type, std::string a
         pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorKey(type, addressHash)));
     }
 
-    while (pcursor->Valid()) {
+    size_t nStart = addressIndex.size();
+    while (pcursor->Valid() && (nLimit == 0 || addressIndex.size() - nStart < nLimit)) {
         boost::this_thread::interruption_point();
         std::pair<char,CAddressIndexKey> key;
         if (pcursor->GetKey(key) && key.first == DB_ADDRESSINDEX && key.second.hashBytes == addressHash
                 && (assetName.empty() || key.second.asset == assetName)) {
-            if (end > 0 && key.second.blockHeight > end) {
+            if (assetName.empty()) {
+                // Every asset starts over from the lowest height, so a range can only be filtered here
+                if ((start > 0 && key.second.blockHeight < start) || (end > 0 && key.second.blockHeight > end)) {
+                    pcursor->Next();
+                    continue;
+                }
+            } else if (end > 0 && key.second.blockHeight > end) {
                 break;
             }
             CAmount nValue;
@@ -391,9 +668,106 @@ bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, int type, std::string a
 
 bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, int type,
                                     std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
-                                    int start, int end) {
+                                    int start, int end, const CAddressIndexKey* pAfter, size_t nLimit) {
+
+    return CBlockTreeDB::ReadAddressIndex(addressHash, type, "", addressIndex, start, end, pAfter, nLimit);
+}
+
+bool CBlockTreeDB::ReadAddressIndexAssets(uint160 addressHash, int type, std::vector<std::string> &assets) {
+
+    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+
+    pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorKey(type, addressHash)));
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char,CAddressIndexKey> key;
+        if (pcursor->GetKey(key) && key.first == DB_ADDRESSINDEX && key.second.hashBytes == addressHash
+                && key.second.type == (unsigned int)type) {
+            assets.push_back(key.second.asset);
+            // No delta is this high, so the next key is the first of the next asset
+            pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorHeightKey(type, addressHash, key.second.asset, -1)));
+        } else {
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool CBlockTreeDB::ReadAddressIndexByHeight(uint160 addressHash, int type,
+                                            std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
+                                            int start, int end, const CAddressIndexKey* pAfter, size_t nLimit) {
+
+    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+
+    if (pAfter && (int)pAfter->blockHeight >= start) {
+        SeekAfter(pcursor.get(), DB_ADDRESSHEIGHTINDEX, CAddressHeightIndexKey(*pAfter));
+    } else {
+        pcursor->Seek(std::make_pair(DB_ADDRESSHEIGHTINDEX, CAddressHeightIndexIteratorKey(type, addressHash, start > 0 ? start : 0)));
+    }
+
+    size_t nStart = addressIndex.size();
+    while (pcursor->Valid() && (nLimit == 0 || addressIndex.size() - nStart < nLimit)) {
+        boost::this_thread::interruption_point();
+        std::pair<char,CAddressHeightIndexKey> key;
+        if (pcursor->GetKey(key) && key.first == DB_ADDRESSHEIGHTINDEX && key.second.hashBytes == addressHash
+                && key.second.type == (unsigned int)type) {
+            if (end > 0 && key.second.blockHeight > end) {
+                break;
+            }
+            CAmount nValue;
+            if (pcursor->GetValue(nValue)) {
+                addressIndex.push_back(std::make_pair(key.second.GetAddressIndexKey(), nValue));
+                pcursor->Next();
+            } else {
+                return error("failed to get address height index value");
+            }
+        } else {
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool CBlockTreeDB::BuildAddressHeightIndex() {
+    // Drop whatever an interrupted earlier build left behind
+    if (!EraseIndexRows<CAddressHeightIndexKey>(*this, DB_ADDRESSHEIGHTINDEX))
+        return error("%s: failed to erase address height index", __func__);
+
+    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+    CDBBatch batch(*this);
+    uint64_t nDeltas = 0;
+
+    pcursor->Seek(DB_ADDRESSINDEX);
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char,CAddressIndexKey> key;
+        if (!pcursor->GetKey(key) || key.first != DB_ADDRESSINDEX)
+            break;
+        CAmount nValue;
+        if (!pcursor->GetValue(nValue))
+            return error("%s: failed to get address index value", __func__);
+        batch.Write(std::make_pair(DB_ADDRESSHEIGHTINDEX, CAddressHeightIndexKey(key.second)), nValue);
+        if (batch.SizeEstimate() > ADDRESS_INDEX_BATCH_SIZE) {
+            if (!WriteBatch(batch))
+                return error("%s: failed to write address height index", __func__);
+            batch.Clear();
+        }
+        if (++nDeltas % 1000000 == 0)
+            LogPrintf("%s: %u address index deltas copied\n", __func__, nDeltas);
+        pcursor->Next();
+    }
 
-    return CBlockTreeDB::ReadAddressIndex(addressHash, type, "", addressIndex, start, end);
+    if (!WriteBatch(batch))
+        return error("%s: failed to write address height index", __func__);
+    LogPrintf("%s: built address height index of %u deltas\n", __func__, nDeltas);
+    return true;
+}
+
+bool CBlockTreeDB::EraseAddressHeightIndex() {
+    return EraseIndexRows<CAddressHeightIndexKey>(*this, DB_ADDRESSHEIGHTINDEX);
 }
 
 bool CBlockTreeDB::WriteTimestampIndex(const CTimestampIndexKey &timestampIndex) {
@@ -457,21 +831,120 @@ bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue) {
     return true;
 }
 
-bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex)
+namespace {
+
+/** Computes the hash of a block index entry from its header and checks it against the entry's target */
+class CBlockIndexPowCheck
+{
+private:
+    const CDiskBlockIndex* pdiskindex;
+    uint256* phash;
+    const Consensus::Params* pconsensusParams;
+
+public:
+    CBlockIndexPowCheck() : pdiskindex(nullptr), phash(nullptr), pconsensusParams(nullptr) {}
+    CBlockIndexPowCheck(const CDiskBlockIndex* pdiskindexIn, uint256* phashIn, const Consensus::Params* pconsensusParamsIn) :
+        pdiskindex(pdiskindexIn), phash(phashIn), pconsensusParams(pconsensusParamsIn) {}
+
+    bool operator()()
+    {
+        *phash = pdiskindex->GetBlockHash();
+        return CheckProofOfWork(*phash, pdiskindex->nBits, *pconsensusParams);
+    }
+
+    void swap(CBlockIndexPowCheck& check)
+    {
+        std::swap(pdiskindex, check.pdiskindex);
+        std::swap(phash, check.phash);
+        std::swap(pconsensusParams, check.pconsensusParams);
+    }
+};
+
+/** Interrupts and joins the worker threads of a check queue when leaving scope */
+class CThreadGroupInterrupter
+{
+private:
+    boost::thread_group& threadGroup;
+
+public:
+    explicit CThreadGroupInterrupter(boost::thread_group& threadGroupIn) : threadGroup(threadGroupIn) {}
+
+    ~CThreadGroupInterrupter()
+    {
+        threadGroup.interrupt_all();
+        threadGroup.join_all();
+    }
+};
+
+} // namespace
+
+/** Number of block index entries read from disk before their hashes are handed to the workers */
+static const size_t BLOCK_INDEX_LOAD_BATCH_SIZE = 4096;
+
+bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex, int nTrustedHeight)
 {
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
 
     pcursor->Seek(std::make_pair(DB_BLOCK_INDEX, uint256()));
 
-    // Load mapBlockIndex
-    while (pcursor->Valid()) {
-        boost::this_thread::interruption_point();
-        std::pair<char, uint256> key;
-        if (pcursor->GetKey(key) && key.first == DB_BLOCK_INDEX) {
-            CDiskBlockIndex diskindex;
-            if (pcursor->GetValue(diskindex)) {
+    // Hashing the headers (X16R, X16RV2 or KAWPOW) is by far the most expensive part of loading the
+    // index, so it is spread over the script check threads. While they hash one batch the next batch
+    // is read from disk, and a batch is only linked into mapBlockIndex once all of its hashes are known.
+    CCheckQueue<CBlockIndexPowCheck> queue(128);
+    boost::thread_group workers;
+    CThreadGroupInterrupter interrupter(workers);
+    for (int i = 0; i < nScriptCheckThreads - 1; i++)
+        workers.create_thread(boost::bind(&CCheckQueue<CBlockIndexPowCheck>::Thread, &queue));
+    const bool fParallel = workers.size() > 0;
+
+    std::vector<CDiskBlockIndex> vBatch, vPending;
+    std::vector<uint256> vBatchHashes, vPendingHashes;
+    std::unique_ptr<CCheckQueueControl<CBlockIndexPowCheck>> control;
+
+    int64_t nTimeRead = 0, nTimeHash = 0, nTimeInsert = 0;
+    size_t nEntries = 0, nTrusted = 0;
+    bool fDone = false;
+
+    while (!fDone || !vPending.empty()) {
+        // Read the next batch from disk while the workers hash the pending one
+        int64_t nTimeStart = GetTimeMicros();
+        vBatch.clear();
+        vBatchHashes.clear();
+        while (!fDone && vBatch.size() < BLOCK_INDEX_LOAD_BATCH_SIZE) {
+            boost::this_thread::interruption_point();
+            std::pair<char, uint256> key;
+            if (!pcursor->Valid() || !pcursor->GetKey(key) || key.first != DB_BLOCK_INDEX) {
+                fDone = true;
+                break;
+            }
+            vBatch.emplace_back();
+            if (!pcursor->GetValue(vBatch.back()))
+                return error("%s: failed to read value", __func__);
+            // Entries the node validated before that are buried under the last checkpoint can be taken at their key
+            vBatchHashes.push_back(vBatch.back().nHeight <= nTrustedHeight && vBatch.back().IsValid(BLOCK_VALID_TREE) ? key.second : uint256());
+            pcursor->Next();
+        }
+        nTimeRead += GetTimeMicros() - nTimeStart;
+
+        // Wait for the pending batch to be hashed, and link it into the index
+        if (!vPending.empty()) {
+            nTimeStart = GetTimeMicros();
+            bool fPowOk = control ? control->Wait() : true;
+            control.reset();
+            nTimeHash += GetTimeMicros() - nTimeStart;
+
+            nTimeStart = GetTimeMicros();
+            for (size_t i = 0; i < vPending.size(); i++) {
+                const CDiskBlockIndex& diskindex = vPending[i];
+                if (!fPowOk || vPendingHashes[i].IsNull()) {
+                    // Either hashed on this thread, or a worker found a bad entry: pin down which one
+                    CBlockIndexPowCheck check(&diskindex, &vPendingHashes[i], &consensusParams);
+                    if (!check())
+                        return error("%s: CheckProofOfWork failed: %s", __func__, diskindex.ToString());
+                }
+
                 // Construct block index object
-                CBlockIndex* pindexNew = insertBlockIndex(diskindex.GetBlockHash());
+                CBlockIndex* pindexNew = insertBlockIndex(vPendingHashes[i]);
                 pindexNew->pprev          = insertBlockIndex(diskindex.hashPrev);
                 pindexNew->nHeight        = diskindex.nHeight;
                 pindexNew->nFile          = diskindex.nFile;
@@ -487,19 +960,30 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams,
                 pindexNew->nNonce64       = diskindex.nNonce64;
                 pindexNew->mix_hash       = diskindex.mix_hash;
                 pindexNew->nHeight        = diskindex.nHeight;
-
-                if (!CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits, consensusParams))
-                    return error("%s: CheckProofOfWork failed: %s", __func__, pindexNew->ToString());
-
-                pcursor->Next();
-            } else {
-                return error("%s: failed to read value", __func__);
             }
-        } else {
-            break;
+            nTimeInsert += GetTimeMicros() - nTimeStart;
+        }
+
+        // Hand the batch just read to the workers
+        std::vector<CBlockIndexPowCheck> vChecks;
+        for (size_t i = 0; i < vBatch.size(); i++) {
+            if (vBatchHashes[i].IsNull())
+                vChecks.emplace_back(&vBatch[i], &vBatchHashes[i], &consensusParams);
         }
+        nEntries += vBatch.size();
+        nTrusted += vBatch.size() - vChecks.size();
+        if (fParallel && !vChecks.empty()) {
+            control.reset(new CCheckQueueControl<CBlockIndexPowCheck>(&queue));
+            control->Add(vChecks);
+        }
+
+        vPending.swap(vBatch);
+        vPendingHashes.swap(vBatchHashes);
     }
 
+    LogPrintf("%s: loaded %u block index entries (%u trusted below height %d) using %u hashing threads: read %.2fms, hash wait %.2fms, insert %.2fms\n",
+        __func__, nEntries, nTrusted, nTrustedHeight, workers.size() + 1, nTimeRead * 0.001, nTimeHash * 0.001, nTimeInsert * 0.001);
+
     return true;
 }
 
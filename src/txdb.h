@@ -41,6 +41,8 @@ static const int64_t nMaxBlockDBCache = 2;
 static const int64_t nMaxBlockDBAndTxIndexCache = 1024;
 //! Max memory allocated to coin DB specific cache (MiB)
 static const int64_t nMaxCoinsDBCache = 8;
+//! Fewest addresses a batched address index read gives to each of its threads
+static const size_t ADDRESS_BATCH_MIN_PER_THREAD = 256;
 
 struct CDiskTxPos : public CDiskBlockPos
 {
@@ -128,25 +130,58 @@ public:
     bool ReadSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value);
     bool UpdateSpentIndex(const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >&vect);
     bool UpdateAddressUnspentIndex(const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue > >&vect);
+    /** The reads of the address indexes start after pAfter when it's given, and return at most nLimit entries when it isn't 0 */
     bool ReadAddressUnspentIndex(uint160 addressHash, int type, std::string assetName,
-                                 std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &vect);
+                                 std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &vect,
+                                 const CAddressUnspentKey* pAfter = nullptr, size_t nLimit = 0);
     bool ReadAddressUnspentIndex(uint160 addressHash, int type,
-                                 std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &vect);
+                                 std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &vect,
+                                 const CAddressUnspentKey* pAfter = nullptr, size_t nLimit = 0);
+    /** Batched reads of many addresses' unspent outputs, see ReadAddressesBatch() */
+    /** Read one unspent output, false when it isn't in the index as it was spent or never there */
+    bool ReadAddressUnspent(const CAddressUnspentKey &key, CAddressUnspentValue &value);
+    bool ReadAddressUnspentIndex(const std::vector<std::pair<uint160, int> > &addresses, std::string assetName,
+                                 std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &vect, int nThreads = 1);
+    bool ReadAddressUnspentIndex(const std::vector<std::pair<uint160, int> > &addresses,
+                                 std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &vect, int nThreads = 1);
     bool WriteAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount> > &vect);
     bool EraseAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount> > &vect);
     bool ReadAddressIndex(uint160 addressHash, int type, std::string assetName,
                           std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
-                          int start = 0, int end = 0);
+                          int start = 0, int end = 0, const CAddressIndexKey* pAfter = nullptr, size_t nLimit = 0);
     bool ReadAddressIndex(uint160 addressHash, int type,
                           std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
-                          int start = 0, int end = 0);
+                          int start = 0, int end = 0, const CAddressIndexKey* pAfter = nullptr, size_t nLimit = 0);
+    bool ReadAddressBalance(uint160 addressHash, int type, std::string assetName, CAddressBalanceValue &balance);
+    bool ReadAddressBalances(uint160 addressHash, int type,
+                             std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue> > &balances);
+    /** Batched reads of many addresses' balances of one asset, or of all of them */
+    bool ReadAddressBalances(const std::vector<std::pair<uint160, int> > &addresses, std::string assetName,
+                             std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue> > &balances, int nThreads = 1);
+    bool ReadAddressBalances(const std::vector<std::pair<uint160, int> > &addresses,
+                             std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue> > &balances, int nThreads = 1);
+    /** Sum the whole address index into per address and asset balances, for address indexes built before they were kept */
+    bool BuildAddressBalanceIndex();
+    /** List the assets an address has deltas of, in key order, seeking past each asset's deltas rather than reading them */
+    bool ReadAddressIndexAssets(uint160 addressHash, int type, std::vector<std::string> &assets);
+    /** Read an address's deltas of all assets from the height ordered index, between two heights when they're given */
+    bool ReadAddressIndexByHeight(uint160 addressHash, int type,
+                                  std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
+                                  int start = 0, int end = 0, const CAddressIndexKey* pAfter = nullptr, size_t nLimit = 0);
+    /** Fill the height ordered address index from the address index, when it gets turned on */
+    bool BuildAddressHeightIndex();
+    bool EraseAddressHeightIndex();
     bool WriteTimestampIndex(const CTimestampIndexKey &timestampIndex);
     bool ReadTimestampIndex(const unsigned int &high, const unsigned int &low, const bool fActiveOnly, std::vector<std::pair<uint256, unsigned int> > &vect);
     bool WriteTimestampBlockIndex(const CTimestampBlockIndexKey &blockhashIndex, const CTimestampBlockIndexValue &logicalts);
     bool ReadTimestampBlockIndex(const uint256 &hash, unsigned int &logicalTS);
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
-    bool LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex);
+    /** Load all block index entries. Entries at or below nTrustedHeight that are already BLOCK_VALID_TREE don't get their proof of work checked again. */
+    bool LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex, int nTrustedHeight = -1);
+
+private:
+    bool UpdateAddressBalanceIndex(CDBBatch& batch, const std::map<CAddressBalanceKey, CAddressBalanceValue>& mapDeltas);
 };
 
 #endif // RAVEN_TXDB_H
@@ -418,11 +418,46 @@ bool CTxMemPool::addUnchecked(const uint256& hash, const CTxMemPoolEntry &entry,
     return true;
 }
 
+void CTxMemPool::addAddressDelta(int type, const uint160& addressHash, const std::string& assetName, const uint256& txhash,
+                                 unsigned int index, int spending, const CMempoolAddressDelta& delta,
+                                 std::vector<std::pair<std::pair<uint160, int>, CMempoolAddressIndexKey> >& inserted)
+{
+    AssertLockHeld(cs);
+
+    uint32_t nAssetId;
+    std::unordered_map<std::string, uint32_t>::iterator it = mapAddressIndexAssetIds.find(assetName);
+    if (it != mapAddressIndexAssetIds.end()) {
+        nAssetId = it->second;
+    } else {
+        if (vFreeAddressIndexAssetIds.empty()) {
+            nAssetId = vAddressIndexAssets.size();
+            vAddressIndexAssets.push_back(std::make_pair(assetName, 0));
+        } else {
+            nAssetId = vFreeAddressIndexAssetIds.back();
+            vFreeAddressIndexAssetIds.pop_back();
+            vAddressIndexAssets[nAssetId] = std::make_pair(assetName, 0);
+        }
+        mapAddressIndexAssetIds.emplace(assetName, nAssetId);
+    }
+
+    std::pair<uint160, int> address(addressHash, type);
+    CMempoolAddressIndexKey key(nAssetId, txhash, index, spending);
+    if (mapAddress[address].emplace(key, delta).second) {
+        vAddressIndexAssets[nAssetId].second++;
+        inserted.push_back(std::make_pair(address, key));
+    } else if (vAddressIndexAssets[nAssetId].second == 0) {
+        // A duplicate of a delta already indexed, don't keep a name nothing refers to
+        mapAddressIndexAssetIds.erase(assetName);
+        vAddressIndexAssets[nAssetId].first.clear();
+        vFreeAddressIndexAssetIds.push_back(nAssetId);
+    }
+}
+
 void CTxMemPool::addAddressIndex(const CTxMemPoolEntry &entry, const CCoinsViewCache &view)
 {
     LOCK(cs);
     const CTransaction& tx = entry.GetTx();
-    std::vector<CMempoolAddressDeltaKey> inserted;
+    std::vector<std::pair<std::pair<uint160, int>, CMempoolAddressIndexKey> > inserted;
 
     uint256 txhash = tx.GetHash();
     for (unsigned int j = 0; j < tx.vin.size(); j++) {
@@ -430,22 +465,16 @@ void CTxMemPool::addAddressIndex(const CTxMemPoolEntry &entry, const CCoinsViewC
         const CTxOut &prevout = view.AccessCoin(input.prevout).out;
         if (prevout.scriptPubKey.IsPayToScriptHash()) {
             std::vector<unsigned char> hashBytes(prevout.scriptPubKey.begin()+2, prevout.scriptPubKey.begin()+22);
-            CMempoolAddressDeltaKey key(2, uint160(hashBytes), RVN, txhash, j, 1);
             CMempoolAddressDelta delta(entry.GetTime(), prevout.nValue * -1, input.prevout.hash, input.prevout.n);
-            mapAddress.insert(std::make_pair(key, delta));
-            inserted.push_back(key);
+            addAddressDelta(2, uint160(hashBytes), RVN, txhash, j, 1, delta, inserted);
         } else if (prevout.scriptPubKey.IsPayToPublicKeyHash()) {
             std::vector<unsigned char> hashBytes(prevout.scriptPubKey.begin()+3, prevout.scriptPubKey.begin()+23);
-            CMempoolAddressDeltaKey key(1, uint160(hashBytes), RVN, txhash, j, 1);
             CMempoolAddressDelta delta(entry.GetTime(), prevout.nValue * -1, input.prevout.hash, input.prevout.n);
-            mapAddress.insert(std::make_pair(key, delta));
-            inserted.push_back(key);
+            addAddressDelta(1, uint160(hashBytes), RVN, txhash, j, 1, delta, inserted);
         } else if (prevout.scriptPubKey.IsPayToPublicKey()) {
             uint160 hashBytes(Hash160(prevout.scriptPubKey.begin()+1, prevout.scriptPubKey.end()-1));
-            CMempoolAddressDeltaKey key(1, hashBytes, RVN, txhash, j, 1);
             CMempoolAddressDelta delta(entry.GetTime(), prevout.nValue * -1, input.prevout.hash, input.prevout.n);
-            mapAddress.insert(std::make_pair(key, delta));
-            inserted.push_back(key);
+            addAddressDelta(1, hashBytes, RVN, txhash, j, 1, delta, inserted);
         } else {
             /** RVN START */
             if (AreAssetsDeployed()) {
@@ -453,10 +482,8 @@ void CTxMemPool::addAddressIndex(const CTxMemPoolEntry &entry, const CCoinsViewC
                 std::string assetName;
                 CAmount assetAmount;
                 if (ParseAssetScript(prevout.scriptPubKey, hashBytes, assetName, assetAmount)) {
-                    CMempoolAddressDeltaKey key(1, hashBytes, assetName, txhash, j, 1);
                     CMempoolAddressDelta delta(entry.GetTime(), assetAmount * -1, input.prevout.hash, input.prevout.n);
-                    mapAddress.insert(std::make_pair(key, delta));
-                    inserted.push_back(key);
+                    addAddressDelta(1, hashBytes, assetName, txhash, j, 1, delta, inserted);
                 }
             }
             /** RVN END */
@@ -467,32 +494,21 @@ void CTxMemPool::addAddressIndex(const CTxMemPoolEntry &entry, const CCoinsViewC
         const CTxOut &out = tx.vout[k];
         if (out.scriptPubKey.IsPayToScriptHash()) {
             std::vector<unsigned char> hashBytes(out.scriptPubKey.begin()+2, out.scriptPubKey.begin()+22);
-            CMempoolAddressDeltaKey key(2, uint160(hashBytes), RVN, txhash, k, 0);
-            mapAddress.insert(std::make_pair(key, CMempoolAddressDelta(entry.GetTime(), out.nValue)));
-            inserted.push_back(key);
+            addAddressDelta(2, uint160(hashBytes), RVN, txhash, k, 0, CMempoolAddressDelta(entry.GetTime(), out.nValue), inserted);
         } else if (out.scriptPubKey.IsPayToPublicKeyHash()) {
             std::vector<unsigned char> hashBytes(out.scriptPubKey.begin()+3, out.scriptPubKey.begin()+23);
-            std::pair<addressDeltaMap::iterator,bool> ret;
-            CMempoolAddressDeltaKey key(1, uint160(hashBytes), RVN, txhash, k, 0);
-            mapAddress.insert(std::make_pair(key, CMempoolAddressDelta(entry.GetTime(), out.nValue)));
-            inserted.push_back(key);
+            addAddressDelta(1, uint160(hashBytes), RVN, txhash, k, 0, CMempoolAddressDelta(entry.GetTime(), out.nValue), inserted);
         } else if (out.scriptPubKey.IsPayToPublicKey()) {
             uint160 hashBytes(Hash160(out.scriptPubKey.begin()+1, out.scriptPubKey.end()-1));
-            std::pair<addressDeltaMap::iterator,bool> ret;
-            CMempoolAddressDeltaKey key(1, hashBytes, RVN, txhash, k, 0);
-            mapAddress.insert(std::make_pair(key, CMempoolAddressDelta(entry.GetTime(), out.nValue)));
-            inserted.push_back(key);
+            addAddressDelta(1, hashBytes, RVN, txhash, k, 0, CMempoolAddressDelta(entry.GetTime(), out.nValue), inserted);
         } else {
             /** RVN START */
             if (AreAssetsDeployed()) {
                 uint160 hashBytes;
                 std::string assetName;
                 CAmount assetAmount;
-                if (ParseAssetScript(out.scriptPubKey, hashBytes, assetName, assetAmount)) {
-                    std::pair<addressDeltaMap::iterator, bool> ret;
-                    CMempoolAddressDeltaKey key(1, hashBytes, assetName, txhash, k, 0);
-                    mapAddress.insert(std::make_pair(key, CMempoolAddressDelta(entry.GetTime(), assetAmount)));
-                    inserted.push_back(key);
+                if (ParseAssetScript(tx, k, hashBytes, assetName, assetAmount)) {
+                    addAddressDelta(1, hashBytes, assetName, txhash, k, 0, CMempoolAddressDelta(entry.GetTime(), assetAmount), inserted);
                 }
             }
             /** RVN END */
@@ -502,18 +518,54 @@ void CTxMemPool::addAddressIndex(const CTxMemPoolEntry &entry, const CCoinsViewC
     mapAddressInserted.insert(std::make_pair(txhash, inserted));
 }
 
+/** Append an address's deltas, of one asset when pAssetId is given, in the order of their keys */
+void CTxMemPool::getAddressDeltas(const std::pair<uint160, int>& address, const uint32_t* pAssetId,
+                                  std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> >& results) const
+{
+    AssertLockHeld(cs);
+
+    addressDeltaMap::const_iterator ait = mapAddress.find(address);
+    if (ait == mapAddress.end())
+        return;
+    const addressDeltas& deltas = ait->second;
+
+    // The deltas of one asset are already in key order, the assets only need putting in the order of their names
+    std::vector<std::pair<addressDeltas::const_iterator, addressDeltas::const_iterator> > vAssetRanges;
+    if (pAssetId) {
+        addressDeltas::const_iterator begin = deltas.lower_bound(CMempoolAddressIndexKey(*pAssetId, uint256(), 0, 0));
+        addressDeltas::const_iterator end = deltas.lower_bound(CMempoolAddressIndexKey(*pAssetId + 1, uint256(), 0, 0));
+        vAssetRanges.push_back(std::make_pair(begin, end));
+    } else {
+        for (addressDeltas::const_iterator it = deltas.begin(); it != deltas.end(); ) {
+            addressDeltas::const_iterator end = deltas.lower_bound(CMempoolAddressIndexKey(it->first.nAssetId + 1, uint256(), 0, 0));
+            vAssetRanges.push_back(std::make_pair(it, end));
+            it = end;
+        }
+        std::sort(vAssetRanges.begin(), vAssetRanges.end(),
+                  [this](const std::pair<addressDeltas::const_iterator, addressDeltas::const_iterator>& a,
+                         const std::pair<addressDeltas::const_iterator, addressDeltas::const_iterator>& b) {
+                      return vAddressIndexAssets[a.first->first.nAssetId].first < vAddressIndexAssets[b.first->first.nAssetId].first;
+                  });
+    }
+
+    for (const std::pair<addressDeltas::const_iterator, addressDeltas::const_iterator>& range : vAssetRanges) {
+        for (addressDeltas::const_iterator it = range.first; it != range.second; it++) {
+            const CMempoolAddressIndexKey& key = it->first;
+            results.push_back(std::make_pair(CMempoolAddressDeltaKey(address.second, address.first, vAddressIndexAssets[key.nAssetId].first,
+                                                                     key.txhash, key.index, key.spending), it->second));
+        }
+    }
+}
+
 bool CTxMemPool::getAddressIndex(std::vector<std::pair<uint160, int> > &addresses, std::string assetName,
                                  std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> > &results)
 {
     LOCK(cs);
+    std::unordered_map<std::string, uint32_t>::const_iterator assetIt = mapAddressIndexAssetIds.find(assetName);
+    if (assetIt == mapAddressIndexAssetIds.end())
+        return true;
     for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        addressDeltaMap::iterator ait = mapAddress.lower_bound(CMempoolAddressDeltaKey((*it).second, (*it).first,
-                                                                                       assetName));
-        while (ait != mapAddress.end() && (*ait).first.addressBytes == (*it).first && (*ait).first.type == (*it).second
-                && (*ait).first.asset == assetName) {
-            results.push_back(*ait);
-            ait++;
-        }
+        getAddressDeltas(*it, &assetIt->second, results);
     }
     return true;
 }
@@ -523,11 +575,7 @@ bool CTxMemPool::getAddressIndex(std::vector<std::pair<uint160, int> > &addresse
 {
     LOCK(cs);
     for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        addressDeltaMap::iterator ait = mapAddress.lower_bound(CMempoolAddressDeltaKey((*it).second, (*it).first));
-        while (ait != mapAddress.end() && (*ait).first.addressBytes == (*it).first && (*ait).first.type == (*it).second) {
-            results.push_back(*ait);
-            ait++;
-        }
+        getAddressDeltas(*it, nullptr, results);
     }
     return true;
 }
@@ -538,9 +586,18 @@ bool CTxMemPool::removeAddressIndex(const uint256 txhash)
     addressDeltaMapInserted::iterator it = mapAddressInserted.find(txhash);
 
     if (it != mapAddressInserted.end()) {
-        std::vector<CMempoolAddressDeltaKey> keys = (*it).second;
-        for (std::vector<CMempoolAddressDeltaKey>::iterator mit = keys.begin(); mit != keys.end(); mit++) {
-            mapAddress.erase(*mit);
+        for (const std::pair<std::pair<uint160, int>, CMempoolAddressIndexKey>& inserted : it->second) {
+            addressDeltaMap::iterator ait = mapAddress.find(inserted.first);
+            if (ait == mapAddress.end() || ait->second.erase(inserted.second) == 0)
+                continue;
+            std::pair<std::string, size_t>& asset = vAddressIndexAssets[inserted.second.nAssetId];
+            if (--asset.second == 0) {
+                mapAddressIndexAssetIds.erase(asset.first);
+                asset.first.clear();
+                vFreeAddressIndexAssetIds.push_back(inserted.second.nAssetId);
+            }
+            if (ait->second.empty())
+                mapAddress.erase(ait);
         }
         mapAddressInserted.erase(it);
     }
@@ -1518,3 +1575,7 @@ bool CTxMemPool::TransactionWithinChainLimit(const uint256& txid, size_t chainLi
 }
 
 SaltedTxidHasher::SaltedTxidHasher() : k0(GetRand(std::numeric_limits<uint64_t>::max())), k1(GetRand(std::numeric_limits<uint64_t>::max())) {}
+
+SaltedAddressHasher::SaltedAddressHasher() : k0(GetRand(std::numeric_limits<uint64_t>::max())), k1(GetRand(std::numeric_limits<uint64_t>::max())) {}
+
+SaltedSpentIndexKeyHasher::SaltedSpentIndexKeyHasher() : k0(GetRand(std::numeric_limits<uint64_t>::max())), k1(GetRand(std::numeric_limits<uint64_t>::max())) {}
@@ -10,6 +10,7 @@
 #include <memory>
 #include <set>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <utility>
 #include <string>
@@ -341,6 +342,58 @@ public:
     }
 };
 
+/** Hashes the (hash, type) addresses of the mempool address index */
+class SaltedAddressHasher
+{
+private:
+    /** Salt */
+    const uint64_t k0, k1;
+
+public:
+    SaltedAddressHasher();
+
+    size_t operator()(const std::pair<uint160, int>& address) const {
+        // The 64 bit write has to come first, CSipHasher only takes those on a whole number of words
+        return CSipHasher(k0, k1).Write(address.second).Write(address.first.begin(), address.first.size()).Finalize();
+    }
+};
+
+class SaltedSpentIndexKeyHasher
+{
+private:
+    /** Salt */
+    const uint64_t k0, k1;
+
+public:
+    SaltedSpentIndexKeyHasher();
+
+    size_t operator()(const CSpentIndexKey& key) const {
+        return SipHashUint256Extra(k0, k1, key.txid, key.outputIndex);
+    }
+};
+
+/** Key of a delta of the mempool address index, within the deltas of its address */
+struct CMempoolAddressIndexKey
+{
+    uint32_t nAssetId; //!< Asset name, interned by the mempool
+    uint256 txhash;
+    unsigned int index;
+    int spending;
+
+    CMempoolAddressIndexKey(uint32_t nAssetIdIn, const uint256& hash, unsigned int i, int s) :
+        nAssetId(nAssetIdIn), txhash(hash), index(i), spending(s) {}
+
+    friend bool operator<(const CMempoolAddressIndexKey& a, const CMempoolAddressIndexKey& b) {
+        if (a.nAssetId != b.nAssetId)
+            return a.nAssetId < b.nAssetId;
+        if (a.txhash != b.txhash)
+            return a.txhash < b.txhash;
+        if (a.index != b.index)
+            return a.index < b.index;
+        return a.spending < b.spending;
+    }
+};
+
 /**
  * CTxMemPool stores valid-according-to-the-current-best-chain transactions
  * that may be included in the next block.
@@ -526,18 +579,31 @@ private:
     typedef std::map<txiter, TxLinks, CompareIteratorByHash> txlinksMap;
     txlinksMap mapLinks;
 
-    typedef std::map<CMempoolAddressDeltaKey, CMempoolAddressDelta, CMempoolAddressDeltaKeyCompare> addressDeltaMap;
+    /** The deltas of each address, grouped by asset and in key order within one, and the deltas each transaction added */
+    typedef std::map<CMempoolAddressIndexKey, CMempoolAddressDelta> addressDeltas;
+    typedef std::unordered_map<std::pair<uint160, int>, addressDeltas, SaltedAddressHasher> addressDeltaMap;
     addressDeltaMap mapAddress;
 
-    typedef std::map<uint256, std::vector<CMempoolAddressDeltaKey> > addressDeltaMapInserted;
+    typedef std::unordered_map<uint256, std::vector<std::pair<std::pair<uint160, int>, CMempoolAddressIndexKey> >, SaltedTxidHasher> addressDeltaMapInserted;
     addressDeltaMapInserted mapAddressInserted;
 
-    typedef std::map<CSpentIndexKey, CSpentIndexValue, CSpentIndexKeyCompare> mapSpentIndex;
+    /** Asset names of the address index deltas, by the id they're interned as, with the number of deltas using them */
+    std::vector<std::pair<std::string, size_t> > vAddressIndexAssets;
+    std::unordered_map<std::string, uint32_t> mapAddressIndexAssetIds;
+    std::vector<uint32_t> vFreeAddressIndexAssetIds;
+
+    typedef std::unordered_map<CSpentIndexKey, CSpentIndexValue, SaltedSpentIndexKeyHasher> mapSpentIndex;
     mapSpentIndex mapSpent;
 
-    typedef std::map<uint256, std::vector<CSpentIndexKey> > mapSpentIndexInserted;
+    typedef std::unordered_map<uint256, std::vector<CSpentIndexKey>, SaltedTxidHasher> mapSpentIndexInserted;
     mapSpentIndexInserted mapSpentInserted;
 
+    void addAddressDelta(int type, const uint160& addressHash, const std::string& assetName, const uint256& txhash,
+                         unsigned int index, int spending, const CMempoolAddressDelta& delta,
+                         std::vector<std::pair<std::pair<uint160, int>, CMempoolAddressIndexKey> >& inserted);
+    void getAddressDeltas(const std::pair<uint160, int>& address, const uint32_t* pAssetId,
+                          std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> >& results) const;
+
     void UpdateParent(txiter entry, txiter parent, bool add);
     void UpdateChild(txiter entry, txiter child, bool add);
 
@@ -59,6 +59,7 @@
 
 #include "assets/snapshotrequestdb.h"
 #include "assets/assetsnapshotdb.h"
+#include "assets/rewards.h"
 
 #if defined(NDEBUG)
 # error "Raven cannot be compiled without assertions."
@@ -93,6 +94,7 @@ bool fMessaging = true;
 bool fTxIndex = false;
 bool fAssetIndex = false;
 bool fAddressIndex = false;
+bool fAddressHeightIndex = false;
 bool fTimestampIndex = false;
 bool fSpentIndex = false;
 bool fHavePruned = false;
@@ -233,10 +235,10 @@ CBlockTreeDB *pblocktree = nullptr;
 
 CAssetsDB *passetsdb = nullptr;
 CAssetsCache *passets = nullptr;
-CLRUCache<std::string, CDatabasedAssetData> *passetsCache = nullptr;
-CLRUCache<std::string, CMessage> *pMessagesCache = nullptr;
-CLRUCache<std::string, int> *pMessageSubscribedChannelsCache = nullptr;
-CLRUCache<std::string, int> *pMessagesSeenAddressCache = nullptr;
+CShardedLRUCache<std::string, CDatabasedAssetData> *passetsCache = nullptr;
+CShardedLRUCache<std::string, CMessage> *pMessagesCache = nullptr;
+CShardedLRUCache<std::string, int> *pMessageSubscribedChannelsCache = nullptr;
+CShardedLRUCache<std::string, int> *pMessagesSeenAddressCache = nullptr;
 CMessageDB *pmessagedb = nullptr;
 CMessageChannelDB *pmessagechanneldb = nullptr;
 CMyRestrictedDB *pmyrestricteddb = nullptr;
@@ -244,10 +246,11 @@ CSnapshotRequestDB *pSnapshotRequestDb = nullptr;
 CAssetSnapshotDB *pAssetSnapshotDb = nullptr;
 CDistributeSnapshotRequestDB *pDistributeSnapshotDb = nullptr;
 
-CLRUCache<std::string, CNullAssetTxVerifierString> *passetsVerifierCache = nullptr;
-CLRUCache<std::string, int8_t> *passetsQualifierCache = nullptr;
-CLRUCache<std::string, int8_t> *passetsRestrictionCache = nullptr;
-CLRUCache<std::string, int8_t> *passetsGlobalRestrictionCache = nullptr;
+CShardedLRUCache<std::string, CNullAssetTxVerifierString> *passetsVerifierCache = nullptr;
+CShardedLRUCache<std::string, std::shared_ptr<const CCompiledVerifierString>> *passetsCompiledVerifierCache = nullptr;
+CShardedLRUCache<std::string, std::set<std::string>> *passetsAddressQualifiersCache = nullptr;
+CShardedLRUCache<std::string, int8_t> *passetsRestrictionCache = nullptr;
+CShardedLRUCache<std::string, int8_t> *passetsGlobalRestrictionCache = nullptr;
 CRestrictedDB *prestricteddb = nullptr;
 
 enum FlushStateMode {
@@ -983,10 +986,11 @@ static bool AcceptToMemoryPoolWorker(const CChainParams& chainparams, CTxMemPool
         }
 
         if (AreAssetsDeployed()) {
-            for (auto out : tx.vout) {
+            for (unsigned int n = 0; n < tx.vout.size(); n++) {
+                const CTxOut& out = tx.vout[n];
                 if (out.scriptPubKey.IsAssetScript()) {
                     CAssetOutputEntry data;
-                    if (!GetAssetData(out.scriptPubKey, data))
+                    if (!GetAssetData(tx, n, data))
                         continue;
                     if (data.type == TX_NEW_ASSET && !IsAssetNameAnOwner(data.assetName)) {
                         pool.mapAssetToHash[data.assetName] = hash;
@@ -1144,53 +1148,158 @@ bool HashOnchainActive(const uint256 &hash)
 }
 
 bool GetAddressIndex(uint160 addressHash, int type, std::string assetName,
-                     std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex, int start, int end)
+                     std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex, int start, int end,
+                     const CAddressIndexKey* pAfter, size_t nLimit)
 {
     if (!fAddressIndex)
         return error("address index not enabled");
 
-    if (!pblocktree->ReadAddressIndex(addressHash, type, assetName, addressIndex, start, end))
+    if (!pblocktree->ReadAddressIndex(addressHash, type, assetName, addressIndex, start, end, pAfter, nLimit))
         return error("unable to get txids for address");
 
     return true;
 }
 
 bool GetAddressIndex(uint160 addressHash, int type,
-                     std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex, int start, int end)
+                     std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex, int start, int end,
+                     const CAddressIndexKey* pAfter, size_t nLimit)
 {
     if (!fAddressIndex)
         return error("address index not enabled");
 
-    if (!pblocktree->ReadAddressIndex(addressHash, type, addressIndex, start, end))
+    if (fAddressHeightIndex) {
+        if (!pblocktree->ReadAddressIndexByHeight(addressHash, type, addressIndex, start, end, pAfter, nLimit))
+            return error("unable to get txids for address");
+        return true;
+    }
+
+    if (!pblocktree->ReadAddressIndex(addressHash, type, addressIndex, start, end, pAfter, nLimit))
         return error("unable to get txids for address");
 
     return true;
 }
 
+bool GetAddressIndexAssets(uint160 addressHash, int type, std::vector<std::string> &assets)
+{
+    if (!fAddressIndex)
+        return error("address index not enabled");
+
+    if (!pblocktree->ReadAddressIndexAssets(addressHash, type, assets))
+        return error("unable to get assets for address");
+
+    return true;
+}
+
+bool GetAddressBalance(uint160 addressHash, int type, std::string assetName, CAddressBalanceValue &balance)
+{
+    if (!fAddressIndex)
+        return error("address index not enabled");
+
+    if (!pblocktree->ReadAddressBalance(addressHash, type, assetName, balance))
+        return error("unable to get balance for address");
+
+    return true;
+}
+
+bool GetAddressBalances(uint160 addressHash, int type,
+                        std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue> > &balances)
+{
+    if (!fAddressIndex)
+        return error("address index not enabled");
+
+    if (!pblocktree->ReadAddressBalances(addressHash, type, balances))
+        return error("unable to get balances for address");
+
+    return true;
+}
+
 bool GetAddressUnspent(uint160 addressHash, int type, std::string assetName,
-                       std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs)
+                       std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs,
+                       const CAddressUnspentKey* pAfter, size_t nLimit)
 {
     if (!fAddressIndex)
         return error("address index not enabled");
 
-    if (!pblocktree->ReadAddressUnspentIndex(addressHash, type, assetName, unspentOutputs))
+    if (!pblocktree->ReadAddressUnspentIndex(addressHash, type, assetName, unspentOutputs, pAfter, nLimit))
         return error("unable to get txids for address");
 
     return true;
 }
 
 bool GetAddressUnspent(uint160 addressHash, int type,
-                       std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs)
+                       std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs,
+                       const CAddressUnspentKey* pAfter, size_t nLimit)
 {
     if (!fAddressIndex)
         return error("address index not enabled");
 
-    if (!pblocktree->ReadAddressUnspentIndex(addressHash, type, unspentOutputs))
+    if (!pblocktree->ReadAddressUnspentIndex(addressHash, type, unspentOutputs, pAfter, nLimit))
         return error("unable to get txids for address");
 
     return true;
 }
 
+bool GetAddressUnspentOutput(const CAddressUnspentKey &key, CAddressUnspentValue &value)
+{
+    if (!fAddressIndex)
+        return error("address index not enabled");
+
+    return pblocktree->ReadAddressUnspent(key, value);
+}
+
+static int GetAddressIndexThreads()
+{
+    return std::max(1, std::min((int)gArgs.GetArg("-addressindexthreads", DEFAULT_ADDRESSINDEX_THREADS), MAX_ADDRESSINDEX_THREADS));
+}
+
+bool GetAddressBalances(const std::vector<std::pair<uint160, int> > &addresses, std::string assetName,
+                        std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue> > &balances)
+{
+    if (!fAddressIndex)
+        return error("address index not enabled");
+
+    if (!pblocktree->ReadAddressBalances(addresses, assetName, balances, GetAddressIndexThreads()))
+        return error("unable to get balances for addresses");
+
+    return true;
+}
+
+bool GetAddressBalances(const std::vector<std::pair<uint160, int> > &addresses,
+                        std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue> > &balances)
+{
+    if (!fAddressIndex)
+        return error("address index not enabled");
+
+    if (!pblocktree->ReadAddressBalances(addresses, balances, GetAddressIndexThreads()))
+        return error("unable to get balances for addresses");
+
+    return true;
+}
+
+bool GetAddressUnspent(const std::vector<std::pair<uint160, int> > &addresses, std::string assetName,
+                       std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs)
+{
+    if (!fAddressIndex)
+        return error("address index not enabled");
+
+    if (!pblocktree->ReadAddressUnspentIndex(addresses, assetName, unspentOutputs, GetAddressIndexThreads()))
+        return error("unable to get txids for addresses");
+
+    return true;
+}
+
+bool GetAddressUnspent(const std::vector<std::pair<uint160, int> > &addresses,
+                       std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs)
+{
+    if (!fAddressIndex)
+        return error("address index not enabled");
+
+    if (!pblocktree->ReadAddressUnspentIndex(addresses, unspentOutputs, GetAddressIndexThreads()))
+        return error("unable to get txids for addresses");
+
+    return true;
+}
+
 /** Return transaction in txOut, and if it was found inside a block, its hash is placed in hashBlock */
 bool GetTransaction(const uint256 &hash, CTransactionRef &txOut, const Consensus::Params& consensusParams, uint256 &hashBlock, bool fAllowSlow)
 {
@@ -1551,6 +1660,20 @@ bool CScriptCheck::operator()() {
     return VerifyScript(scriptSig, m_tx_out.scriptPubKey, witness, nFlags, CachingTransactionSignatureChecker(ptxTo, nIn, m_tx_out.nValue, cacheStore, *txdata), &error);
 }
 
+bool CAssetCheck::operator()() {
+    if (!CheckTransferAsset(transfer, fMessagesDeployed, fRestrictedDeployed, strError)) {
+        if (pfailure) {
+            LOCK(pfailure->cs);
+            if (pfailure->strError.empty()) {
+                pfailure->strError = strError;
+                pfailure->txHash = ptxTo->GetHash();
+            }
+        }
+        return error("%s: transfer of %s in %s: %s", __func__, transfer.strName, ptxTo->GetHash().ToString(), strError);
+    }
+    return true;
+}
+
 int GetSpendHeight(const CCoinsViewCache& inputs)
 {
     LOCK(cs_main);
@@ -1838,7 +1961,7 @@ static DisconnectResult DisconnectBlock(const CBlock& block, const CBlockIndex*
     std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > spentIndex;
 
     // undo transactions in reverse order
-    CAssetsCache tempCache(*assetsCache);
+    CAssetsCache tempCache;
     for (int i = block.vtx.size() - 1; i >= 0; i--) {
         const CTransaction &tx = *(block.vtx[i]);
         uint256 hash = tx.GetHash();
@@ -1879,7 +2002,7 @@ static DisconnectResult DisconnectBlock(const CBlock& block, const CBlockIndex*
                         CAmount assetAmount;
                         uint160 hashBytes;
 
-                        if (ParseAssetScript(out.scriptPubKey, hashBytes, assetName, assetAmount)) {
+                        if (ParseAssetScript(tx, k, hashBytes, assetName, assetAmount)) {
 //                            std::cout << "ConnectBlock(): pushing assets onto addressIndex: " << "1" << ", " << hashBytes.GetHex() << ", " << assetName << ", " << pindex->nHeight
 //                                      << ", " << i << ", " << hash.GetHex() << ", " << k << ", " << "true" << ", " << assetAmount << std::endl;
 
@@ -2074,7 +2197,7 @@ static DisconnectResult DisconnectBlock(const CBlock& block, const CBlockIndex*
                 for (auto index : vAssetTxIndex) {
                     CAssetTransfer transfer;
                     std::string strAddress;
-                    if (!TransferAssetFromScript(tx.vout[index].scriptPubKey, transfer, strAddress)) {
+                    if (!TransferAssetFromTransaction(tx, index, transfer, strAddress)) {
                         error("%s : Failed to get transfer asset from transaction. CTxOut : %s", __func__,
                               tx.vout[index].ToString());
                         return DISCONNECT_FAILED;
@@ -2277,7 +2400,19 @@ void static FlushBlockFile(bool fFinalize = false)
 
 static bool FindUndoPos(CValidationState &state, int nFile, CDiskBlockPos &pos, unsigned int nAddSize);
 
-static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
+static CCheckQueue<CBlockCheck> scriptcheckqueue(128);
+
+/** Hand script or asset checks over to the script check threads */
+template <typename T>
+static void AddBlockChecks(CCheckQueueControl<CBlockCheck>& control, std::vector<T>& vChecks)
+{
+    if (vChecks.empty())
+        return;
+    std::vector<CBlockCheck> vBlockChecks(vChecks.size());
+    for (size_t i = 0; i < vChecks.size(); i++)
+        vBlockChecks[i].Set(vChecks[i]);
+    control.Add(vBlockChecks);
+}
 
 void ThreadScriptCheck() {
     RenameThread("raven-scriptch");
@@ -2491,7 +2626,9 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
     CBlockUndo blockundo;
     std::vector<std::pair<std::string, CBlockAssetUndo> > vUndoAssetData;
 
-    CCheckQueueControl<CScriptCheck> control(fScriptChecks && nScriptCheckThreads ? &scriptcheckqueue : nullptr);
+    // Outlives the control, which waits for the queued checks when it goes out of scope
+    CAssetCheckFailure assetCheckFailure;
+    CCheckQueueControl<CBlockCheck> control(fScriptChecks && nScriptCheckThreads ? &scriptcheckqueue : nullptr);
 
     std::vector<int> prevheights;
     CAmount nFees = 0;
@@ -2540,11 +2677,15 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
 
             if (AreAssetsDeployed()) {
                 std::vector<std::pair<std::string, uint256>> vReissueAssets;
-                if (!Consensus::CheckTxAssets(tx, state, view, assetsCache, false, vReissueAssets, false, &setMessages, block.nTime, &myNullAssetData)) {
+                std::vector<CAssetCheck> vAssetChecks;
+                if (!Consensus::CheckTxAssets(tx, state, view, assetsCache, false, vReissueAssets, false, &setMessages, block.nTime, &myNullAssetData, fScriptChecks && nScriptCheckThreads ? &vAssetChecks : nullptr)) {
                     state.SetFailedTransaction(tx.GetHash());
                     return error("%s: Consensus::CheckTxAssets: %s, %s", __func__, tx.GetHash().ToString(),
                                  FormatStateMessage(state));
                 }
+                for (CAssetCheck& check : vAssetChecks)
+                    check.SetFailure(&assetCheckFailure);
+                AddBlockChecks(control, vAssetChecks);
             }
 
             /** RVN END */
@@ -2646,7 +2787,7 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
             if (!CheckInputs(tx, state, view, fScriptChecks, flags, fCacheResults, fCacheResults, txdata[i], nScriptCheckThreads ? &vChecks : nullptr))
                 return error("ConnectBlock(): CheckInputs on %s failed with %s",
                     tx.GetHash().ToString(), FormatStateMessage(state));
-            control.Add(vChecks);
+            AddBlockChecks(control, vChecks);
         }
 
         if (fAddressIndex) {
@@ -2686,7 +2827,7 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
                         CAmount assetAmount;
                         uint160 hashBytes;
 
-                        if (ParseAssetScript(out.scriptPubKey, hashBytes, assetName, assetAmount)) {
+                        if (ParseAssetScript(tx, k, hashBytes, assetName, assetAmount)) {
 //                            std::cout << "ConnectBlock(): pushing assets onto addressIndex: " << "1" << ", " << hashBytes.GetHex() << ", " << assetName << ", " << pindex->nHeight
 //                                      << ", " << i << ", " << txhash.GetHex() << ", " << k << ", " << "true" << ", " << assetAmount << std::endl;
 
@@ -2740,8 +2881,16 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
                                block.vtx[0]->GetValueOut(AreEnforcedValuesDeployed()), blockReward),
                                REJECT_INVALID, "bad-cb-amount");
 
-    if (!control.Wait())
+    if (!control.Wait()) {
+        // A failed asset check is rejected with its own reason, as it would have been when checked in place
+        LOCK(assetCheckFailure.cs);
+        if (!assetCheckFailure.strError.empty()) {
+            state.SetFailedTransaction(assetCheckFailure.txHash);
+            return state.DoS(100, error("%s: CheckQueue failed: %s", __func__, assetCheckFailure.strError),
+                             REJECT_INVALID, assetCheckFailure.strError, false, "", assetCheckFailure.txHash);
+        }
         return state.DoS(100, error("%s: CheckQueue failed", __func__), REJECT_INVALID, "block-validation-failed");
+    }
     int64_t nTime4 = GetTimeMicros(); nTimeVerify += nTime4 - nTime2;
     LogPrint(BCLog::BENCH, "    - Verify %u txins: %.2fms (%.3fms/txin) [%.2fs (%.2fms/blk)]\n", nInputs - 1, MILLI * (nTime4 - nTime2), nInputs <= 1 ? 0 : MILLI * (nTime4 - nTime2) / (nInputs-1), nTimeVerify * MICRO, nTimeVerify * MILLI / nBlocksTotal);
 
@@ -3146,6 +3295,8 @@ bool static DisconnectTip(CValidationState& state, const CChainParams& chainpara
 
         bool assetsFlushed = assetCache.Flush();
         assert(assetsFlushed);
+
+        GetMainSignals().AssetsChanged(pindexDelete, assetCache, false);
     }
     LogPrint(BCLog::BENCH, "- Disconnect block: %.2fms\n", (GetTimeMicros() - nStart) * MILLI);
     // Write the chain state to disk, if necessary.
@@ -3332,6 +3483,8 @@ bool static ConnectTip(CValidationState& state, const CChainParams& chainparams,
         assert(assetFlushed);
         int64_t nTimeAssetFlushFinished = GetTimeMicros(); nTimeAssetFlush += nTimeAssetFlushFinished - nTimeAssetsFlush;
         LogPrint(BCLog::BENCH, "  - Flush Assets: %.2fms [%.2fs (%.2fms/blk)]\n", (nTimeAssetFlushFinished - nTimeAssetsFlush) * MILLI, nTimeAssetFlush * MICRO, nTimeAssetFlush * MILLI / nBlocksTotal);
+
+        GetMainSignals().AssetsChanged(pindexNew, assetCache, true);
         /** RVN END */
     }
 
@@ -3360,12 +3513,14 @@ bool static ConnectTip(CValidationState& state, const CChainParams& chainparams,
         //  Retrieve the scheduled snapshot requests
         std::set<CSnapshotRequestDBEntry> assetsToSnapshot;
         if (pSnapshotRequestDb->RetrieveSnapshotRequestsForHeight("", pindexNew->nHeight, assetsToSnapshot)) {
-            //  Loop through them
-            for (auto const & assetEntry : assetsToSnapshot) {
-                //  Add a snapshot entry for the target asset ownership
-                if (!pAssetSnapshotDb->AddAssetOwnershipSnapshot(assetEntry.assetName, pindexNew->nHeight)) {
-                   LogPrint(BCLog::REWARDS, "ConnectTip: Failed to snapshot owners for '%s' at height %d!\n",
-                       assetEntry.assetName.c_str(), pindexNew->nHeight);
+            if (!assetsToSnapshot.empty() && passetsdb != nullptr) {
+                //  Get the owners as of this block into the asset DB and freeze a view of it. Walking the
+                //      owners is left to the rewards thread, which reads them from that view. The view has to
+                //      be taken here: BlockConnected is only signalled once the whole step of blocks is connected.
+                FlushStateToDisk();
+                std::shared_ptr<CDBSnapshot> assetsView = std::make_shared<CDBSnapshot>(*passetsdb);
+                for (auto const & assetEntry : assetsToSnapshot) {
+                    QueueOwnershipSnapshot(assetEntry.assetName, pindexNew->nHeight, assetsView);
                 }
             }
         }
@@ -3373,12 +3528,6 @@ bool static ConnectTip(CValidationState& state, const CChainParams& chainparams,
             LogPrint(BCLog::REWARDS, "ConnectTip: Failed to load payable Snapshot Requests at height %d!\n", pindexNew->nHeight);
         }
     }
-
-#ifdef ENABLE_WALLET
-    if (vpwallets.size()) {
-        CheckRewardDistributions(vpwallets[0]);
-    }
-#endif
     /** RVN END */
 
     return true;
@@ -4468,7 +4617,8 @@ bool TestBlockValidity(CValidationState& state, const CChainParams& chainparams,
     indexDummy.nHeight = pindexPrev->nHeight + 1;
 
     /** RVN START */
-    CAssetsCache assetCache = *GetCurrentAssetCache();
+    // Child view over the tip asset cache, its changes are dropped with it
+    CAssetsCache assetCache;
     /** RVN END */
 
     // NOTE: CheckBlockHeader is called by CheckBlock
@@ -4706,11 +4856,21 @@ CBlockIndex * InsertBlockIndex(uint256 hash)
 
 bool static LoadBlockIndexDB(const CChainParams& chainparams)
 {
-    if (!pblocktree->LoadBlockIndexGuts(chainparams.GetConsensus(), InsertBlockIndex))
+    int64_t nTimeStart = GetTimeMicros();
+
+    // Headers buried under the last checkpoint that were accepted before don't need their proof of work checked again
+    int nTrustedHeight = -1;
+    const MapCheckpoints& checkpoints = chainparams.Checkpoints().mapCheckpoints;
+    if (!gArgs.GetBoolArg("-checkindexpow", DEFAULT_CHECK_INDEX_POW) && fCheckpointsEnabled && !checkpoints.empty())
+        nTrustedHeight = checkpoints.rbegin()->first;
+
+    if (!pblocktree->LoadBlockIndexGuts(chainparams.GetConsensus(), InsertBlockIndex, nTrustedHeight))
         return false;
 
     boost::this_thread::interruption_point();
 
+    int64_t nTimeGuts = GetTimeMicros();
+
     // Calculate nChainWork
     std::vector<std::pair<int, CBlockIndex*> > vSortedByHeight;
     vSortedByHeight.reserve(mapBlockIndex.size());
@@ -4753,6 +4913,8 @@ bool static LoadBlockIndexDB(const CChainParams& chainparams)
             pindexBestHeader = pindex;
     }
 
+    int64_t nTimeChainWork = GetTimeMicros();
+
     // Load block file info
     pblocktree->ReadLastBlockFile(nLastBlockFile);
     vinfoBlockFile.resize(nLastBlockFile + 1);
@@ -4788,6 +4950,9 @@ bool static LoadBlockIndexDB(const CChainParams& chainparams)
         }
     }
 
+    LogPrintf("%s: loaded block index in %.2fms (entries %.2fms, chain work %.2fms, block files %.2fms)\n", __func__,
+        (GetTimeMicros() - nTimeStart) * 0.001, (nTimeGuts - nTimeStart) * 0.001, (nTimeChainWork - nTimeGuts) * 0.001, (GetTimeMicros() - nTimeChainWork) * 0.001);
+
     // Check whether we have ever pruned block & undo files
     pblocktree->ReadFlag("prunedblockfiles", fHavePruned);
     if (fHavePruned)
@@ -4809,6 +4974,32 @@ bool static LoadBlockIndexDB(const CChainParams& chainparams)
     pblocktree->ReadFlag("addressindex", fAddressIndex);
     LogPrintf("%s: address index %s\n", __func__, fAddressIndex ? "enabled" : "disabled");
 
+    // Address indexes made before balances were kept alongside them get their balances summed up once
+    if (fAddressIndex) {
+        bool fAddressBalanceIndex = false;
+        pblocktree->ReadFlag("addressbalanceindex", fAddressBalanceIndex);
+        if (!fAddressBalanceIndex) {
+            LogPrintf("%s: building address balance index\n", __func__);
+            if (!pblocktree->BuildAddressBalanceIndex() || !pblocktree->WriteFlag("addressbalanceindex", true))
+                return error("%s: failed to build address balance index", __func__);
+        }
+    }
+
+    // The height ordered address index can be turned on and off without reindexing
+    bool fHaveAddressHeightIndex = false;
+    pblocktree->ReadFlag("addressheightindex", fHaveAddressHeightIndex);
+    fAddressHeightIndex = fAddressIndex && gArgs.GetBoolArg("-addressheightindex", DEFAULT_ADDRESSHEIGHTINDEX);
+    if (fAddressHeightIndex && !fHaveAddressHeightIndex) {
+        LogPrintf("%s: building address height index\n", __func__);
+        if (!pblocktree->BuildAddressHeightIndex() || !pblocktree->WriteFlag("addressheightindex", true))
+            return error("%s: failed to build address height index", __func__);
+    } else if (!fAddressHeightIndex && fHaveAddressHeightIndex) {
+        LogPrintf("%s: removing address height index\n", __func__);
+        if (!pblocktree->WriteFlag("addressheightindex", false) || !pblocktree->EraseAddressHeightIndex())
+            return error("%s: failed to remove address height index", __func__);
+    }
+    LogPrintf("%s: address height index %s\n", __func__, fAddressHeightIndex ? "enabled" : "disabled");
+
     // Check whether we have a timestamp index
     pblocktree->ReadFlag("timestampindex", fTimestampIndex);
     LogPrintf("%s: timestamp index %s\n", __func__, fTimestampIndex ? "enabled" : "disabled");
@@ -4876,8 +5067,8 @@ bool CVerifyDB::VerifyDB(const CChainParams& chainparams, CCoinsView *coinsview,
     CValidationState state;
     int reportDone = 0;
 
-    auto currentActiveAssetCache = GetCurrentAssetCache();
-    CAssetsCache assetCache(*currentActiveAssetCache);
+    // Child view over the tip asset cache, its changes are dropped with it
+    CAssetsCache assetCache;
     LogPrintf("[0%%]...");
     for (CBlockIndex* pindex = chainActive.Tip(); pindex && pindex->pprev; pindex = pindex->pprev)
     {
@@ -4984,8 +5175,8 @@ bool ReplayBlocks(const CChainParams& params, CCoinsView* view)
     LOCK(cs_main);
 
     CCoinsViewCache cache(view);
-    auto currentActiveAssetCache = GetCurrentAssetCache();
-    CAssetsCache assetsCache(*currentActiveAssetCache);
+    // Child view over the tip asset cache, flushed into it once the replay succeeds
+    CAssetsCache assetsCache;
 
     std::vector<uint256> hashHeads = view->GetHeadBlocks();
     if (hashHeads.empty()) return true; // We're already in a consistent state.
@@ -5202,6 +5393,9 @@ bool LoadBlockIndex(const CChainParams& chainparams)
         // Use the provided setting for -addressindex in the new database
         fAddressIndex = gArgs.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX);
         pblocktree->WriteFlag("addressindex", fAddressIndex);
+        pblocktree->WriteFlag("addressbalanceindex", fAddressIndex);
+        fAddressHeightIndex = fAddressIndex && gArgs.GetBoolArg("-addressheightindex", DEFAULT_ADDRESSHEIGHTINDEX);
+        pblocktree->WriteFlag("addressheightindex", fAddressHeightIndex);
         LogPrintf("%s: address index %s\n", __func__, fAddressIndex ? "enabled" : "disabled");
 
         // Use the provided setting for -timestampindex in the new database
@@ -5249,19 +5443,20 @@ bool LoadGenesisBlock(const CChainParams& chainparams)
     return true;
 }
 
-bool LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, CDiskBlockPos *dbp)
+void CBlockFilePrefetcher::ThreadRead(FILE* fileIn)
 {
-    // Map of disk positions for blocks with unknown parent (only used for reindex)
-    static std::multimap<uint256, CDiskBlockPos> mapBlocksUnknownParent;
-    int64_t nStart = GetTimeMillis();
-
-    int nLoaded = 0;
+    RenameThread("raven-loadblk-read");
     try {
         // This takes over fileIn and calls fclose() on it in the CBufferedFile destructor
         CBufferedFile blkdat(fileIn, 2*GetMaxBlockSerializedSize(), GetMaxBlockSerializedSize()+8, SER_DISK, CLIENT_VERSION);
         uint64_t nRewind = blkdat.GetPos();
         while (!blkdat.eof()) {
-            boost::this_thread::interruption_point();
+            {
+                std::unique_lock<std::mutex> lock(cs);
+                condReader.wait(lock, [this] { return fStop || queueBlocks.empty() || nQueuedBytes < nMaxQueuedBytes; });
+                if (fStop)
+                    break;
+            }
 
             blkdat.SetPos(nRewind);
             nRewind++; // start one byte further next time, in case of failure
@@ -5286,15 +5481,134 @@ bool LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, CDiskB
             try {
                 // read block
                 uint64_t nBlockPos = blkdat.GetPos();
-                if (dbp)
-                    dbp->nPos = nBlockPos;
                 blkdat.SetLimit(nBlockPos + nSize);
                 blkdat.SetPos(nBlockPos);
                 std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
-                CBlock& block = *pblock;
-                blkdat >> block;
+                blkdat >> *pblock;
                 nRewind = blkdat.GetPos();
 
+                std::shared_ptr<CPrefetchedBlock> prefetched = std::make_shared<CPrefetchedBlock>(pblock, nBlockPos, nSize);
+                {
+                    std::lock_guard<std::mutex> lock(cs);
+                    queueBlocks.push_back(prefetched);
+                    queueToHash.push_back(prefetched);
+                    nQueuedBytes += nSize;
+                }
+                condHasher.notify_one();
+            } catch (const std::exception& e) {
+                LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, e.what());
+            }
+        }
+    } catch (const std::runtime_error& e) {
+        std::lock_guard<std::mutex> lock(cs);
+        strError = e.what();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        fReaderDone = true;
+    }
+    condHasher.notify_all();
+    condConsumer.notify_all();
+}
+
+void CBlockFilePrefetcher::ThreadHash()
+{
+    RenameThread("raven-loadblk-hash");
+    while (true) {
+        std::shared_ptr<CPrefetchedBlock> prefetched;
+        {
+            std::unique_lock<std::mutex> lock(cs);
+            condHasher.wait(lock, [this] { return fStop || fReaderDone || !queueToHash.empty(); });
+            if (fStop || queueToHash.empty())
+                return;
+            prefetched = queueToHash.front();
+            queueToHash.pop_front();
+        }
+
+        // Both hashes a KAWPOW header may be checked with, see CheckBlockHeader
+        const CBlock& block = *prefetched->pblock;
+        block.GetHash();
+        if (block.nTime >= nKAWPOWActivationTime) {
+            uint256 mix_hash;
+            block.GetHashFull(mix_hash);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(cs);
+            prefetched->fHashed = true;
+        }
+        condConsumer.notify_one();
+    }
+}
+
+CBlockFilePrefetcher::CBlockFilePrefetcher(const CChainParams& _chainparams, FILE* fileIn, size_t _nMaxQueuedBytes) :
+    chainparams(_chainparams), nMaxQueuedBytes(_nMaxQueuedBytes), nQueuedBytes(0), fReaderDone(false), fStop(false)
+{
+    threads.emplace_back(&CBlockFilePrefetcher::ThreadRead, this, fileIn);
+    int nHashThreads = std::max(1, std::min(GetNumCores() - 1, MAX_PREFETCH_HASH_THREADS));
+    for (int i = 0; i < nHashThreads; i++)
+        threads.emplace_back(&CBlockFilePrefetcher::ThreadHash, this);
+}
+
+CBlockFilePrefetcher::~CBlockFilePrefetcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        fStop = true;
+    }
+    condReader.notify_all();
+    condHasher.notify_all();
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+bool CBlockFilePrefetcher::Next(std::shared_ptr<CPrefetchedBlock>& next)
+{
+    std::unique_lock<std::mutex> lock(cs);
+    condConsumer.wait(lock, [this] { return queueBlocks.empty() ? fReaderDone : queueBlocks.front()->fHashed; });
+    if (queueBlocks.empty())
+        return false;
+
+    next = queueBlocks.front();
+    queueBlocks.pop_front();
+    nQueuedBytes -= next->nSize;
+    condReader.notify_one();
+    return true;
+}
+
+size_t CBlockFilePrefetcher::GetQueuedBytes()
+{
+    std::lock_guard<std::mutex> lock(cs);
+    return nQueuedBytes;
+}
+
+std::string CBlockFilePrefetcher::GetError()
+{
+    std::lock_guard<std::mutex> lock(cs);
+    return strError;
+}
+
+bool LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, CDiskBlockPos *dbp)
+{
+    // Map of disk positions for blocks with unknown parent (only used for reindex)
+    static std::multimap<uint256, CDiskBlockPos> mapBlocksUnknownParent;
+    int64_t nStart = GetTimeMillis();
+
+    int nLoaded = 0;
+    std::string strError;
+    {
+        CBlockFilePrefetcher prefetcher(chainparams, fileIn);
+        std::shared_ptr<CPrefetchedBlock> prefetched;
+        while (prefetcher.Next(prefetched)) {
+            boost::this_thread::interruption_point();
+
+            try {
+                if (dbp)
+                    dbp->nPos = prefetched->nPos;
+                std::shared_ptr<CBlock> pblock = prefetched->pblock;
+                CBlock& block = *pblock;
+
                 // detect out of order blocks, and store them for later
                 uint256 hash = block.GetHash();
                 if (hash != chainparams.GetConsensus().hashGenesisBlock && mapBlockIndex.find(block.hashPrevBlock) == mapBlockIndex.end()) {
@@ -5360,9 +5674,10 @@ bool LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, CDiskB
                 LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, e.what());
             }
         }
-    } catch (const std::runtime_error& e) {
-        AbortNode(std::string("System error: ") + e.what());
+        strError = prefetcher.GetError();
     }
+    if (!strError.empty())
+        AbortNode(std::string("System error: ") + strError);
     if (nLoaded > 0)
         LogPrintf("Loaded %i blocks from external file in %dms\n", nLoaded, GetTimeMillis() - nStart);
     return nLoaded > 0;
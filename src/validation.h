@@ -24,15 +24,21 @@
 #include "timestampindex.h"
 
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <exception>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <set>
 #include <stdint.h>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
 #include <atomic>
+#include <boost/variant.hpp>
 #include <assets/assets.h>
 #include <assets/assetdb.h>
 #include <assets/messages.h>
@@ -147,9 +153,16 @@ static const int64_t MAX_FEE_ESTIMATION_TIP_AGE = 3 * 60 * 60;
 /** Default for -permitbaremultisig */
 static const bool DEFAULT_PERMIT_BAREMULTISIG = true;
 static const bool DEFAULT_CHECKPOINTS_ENABLED = true;
+/** Default for -checkindexpow, re-check the proof of work of all block index entries at startup */
+static const bool DEFAULT_CHECK_INDEX_POW = true;
 static const bool DEFAULT_TXINDEX = false;
 static const bool DEFAULT_ASSETINDEX = false;
 static const bool DEFAULT_ADDRESSINDEX = false;
+/** Default for -addressheightindex, keep the address index a second time ordered by height across assets */
+static const bool DEFAULT_ADDRESSHEIGHTINDEX = false;
+/** Default for -addressindexthreads, the threads reading the address index for an RPC call with many addresses */
+static const int DEFAULT_ADDRESSINDEX_THREADS = 4;
+static const int MAX_ADDRESSINDEX_THREADS = 16;
 static const bool DEFAULT_TIMESTAMPINDEX = false;
 static const bool DEFAULT_SPENTINDEX = false;
 static const bool DEFAULT_REWARDS_ENABLED = false;
@@ -198,6 +211,7 @@ extern int nScriptCheckThreads;
 extern bool fTxIndex;
 extern bool fAssetIndex;
 extern bool fAddressIndex;
+extern bool fAddressHeightIndex;
 extern bool fSpentIndex;
 extern bool fTimestampIndex;
 extern bool fIsBareMultisigStd;
@@ -294,6 +308,71 @@ FILE* OpenBlockFile(const CDiskBlockPos &pos, bool fReadOnly = false);
 fs::path GetBlockPosFilename(const CDiskBlockPos &pos, const char *prefix);
 /** Import blocks from an external file */
 bool LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, CDiskBlockPos *dbp = nullptr);
+
+/** Blocks read ahead of LoadExternalBlockFile are capped by size, though one is always let through */
+static const size_t MAX_PREFETCH_BLOCK_BYTES = 64 * 1024 * 1024;
+/** Maximum number of threads hashing the headers of the blocks read ahead */
+static const int MAX_PREFETCH_HASH_THREADS = 8;
+
+/** A block read from an external block file, in the order it appears in the file */
+struct CPrefetchedBlock
+{
+    std::shared_ptr<CBlock> pblock;
+    unsigned int nPos;
+    unsigned int nSize;
+    bool fHashed;
+
+    CPrefetchedBlock(const std::shared_ptr<CBlock>& _pblock, unsigned int _nPos, unsigned int _nSize) : pblock(_pblock), nPos(_nPos), nSize(_nSize), fHashed(false) {}
+};
+
+/**
+ * Reads the blocks out of an external block file ahead of LoadExternalBlockFile, so that reading and deserializing
+ * them, and computing their proof of work hashes, overlaps with validating the ones before them. A reader thread
+ * streams the blocks into a bounded queue, and a small pool of threads hashes their headers, leaving the hashes
+ * in each header's hash cache for the checks that follow. Blocks come out in file order.
+ */
+class CBlockFilePrefetcher
+{
+private:
+    const CChainParams& chainparams;
+    const size_t nMaxQueuedBytes;
+
+    std::mutex cs;
+    std::condition_variable condReader;
+    std::condition_variable condHasher;
+    std::condition_variable condConsumer;
+
+    //! blocks read and not yet handed out, and the ones among them still to be hashed
+    std::deque<std::shared_ptr<CPrefetchedBlock>> queueBlocks;
+    std::deque<std::shared_ptr<CPrefetchedBlock>> queueToHash;
+    size_t nQueuedBytes;
+    bool fReaderDone;
+    bool fStop;
+    std::string strError;
+
+    std::vector<std::thread> threads;
+
+    void ThreadRead(FILE* fileIn);
+    void ThreadHash();
+
+public:
+    //! Takes over fileIn, which is closed once the file is read or the prefetcher is destroyed
+    CBlockFilePrefetcher(const CChainParams& _chainparams, FILE* fileIn, size_t _nMaxQueuedBytes = MAX_PREFETCH_BLOCK_BYTES);
+    //! Stops reading, even in the middle of the file, and waits for the threads to exit
+    ~CBlockFilePrefetcher();
+
+    CBlockFilePrefetcher(const CBlockFilePrefetcher&) = delete;
+    CBlockFilePrefetcher& operator=(const CBlockFilePrefetcher&) = delete;
+
+    //! Wait for the next block in the file to be read and hashed, returns false once the file is done
+    bool Next(std::shared_ptr<CPrefetchedBlock>& next);
+
+    //! Bytes of the blocks read ahead and not yet handed out
+    size_t GetQueuedBytes();
+
+    //! The I/O error the reader stopped on, if any
+    std::string GetError();
+};
 /** Ensures we have a genesis block in the block tree, possibly writing one to disk. */
 bool LoadGenesisBlock(const CChainParams& chainparams);
 /** Load the block tree and coins database from disk,
@@ -427,21 +506,115 @@ public:
     ScriptError GetScriptError() const { return error; }
 };
 
+/**
+ * Where the first queued asset check of a block to fail leaves its reason, as the check queue
+ * itself only tells whether all of its checks passed.
+ */
+struct CAssetCheckFailure
+{
+    CCriticalSection cs;
+    std::string strError;
+    uint256 txHash;
+};
+
+/**
+ * Closure representing the checks of one asset transfer output that don't read the asset
+ * databases, so that they can run on the script check threads while the block's asset cache
+ * is updated serially. The active deployments are captured by the caller, under cs_main.
+ */
+class CAssetCheck
+{
+private:
+    CAssetTransfer transfer;
+    const CTransaction *ptxTo;
+    bool fMessagesDeployed;
+    bool fRestrictedDeployed;
+    std::string strError;
+    CAssetCheckFailure *pfailure;
+
+public:
+    CAssetCheck(): ptxTo(nullptr), fMessagesDeployed(false), fRestrictedDeployed(false), pfailure(nullptr) {}
+    CAssetCheck(const CAssetTransfer& transferIn, const CTransaction& txToIn, bool fMessagesDeployedIn, bool fRestrictedDeployedIn) :
+        transfer(transferIn), ptxTo(&txToIn), fMessagesDeployed(fMessagesDeployedIn), fRestrictedDeployed(fRestrictedDeployedIn), pfailure(nullptr) { }
+
+    bool operator()();
+
+    void swap(CAssetCheck &check) {
+        std::swap(transfer, check.transfer);
+        std::swap(ptxTo, check.ptxTo);
+        std::swap(fMessagesDeployed, check.fMessagesDeployed);
+        std::swap(fRestrictedDeployed, check.fRestrictedDeployed);
+        std::swap(strError, check.strError);
+        std::swap(pfailure, check.pfailure);
+    }
+
+    const std::string& GetError() const { return strError; }
+    /** Report a failure to pfailureIn as well, when it's the first there */
+    void SetFailure(CAssetCheckFailure *pfailureIn) { pfailure = pfailureIn; }
+};
+
+/**
+ * A check queued while connecting a block: either a script verification or an asset check. Only
+ * one of them is held, so an element of the queue is no bigger than the larger of the two.
+ */
+class CBlockCheck
+{
+private:
+    boost::variant<CScriptCheck, CAssetCheck> check;
+
+    struct RunCheck : public boost::static_visitor<bool>
+    {
+        template <typename T>
+        bool operator()(T &check) const { return check(); }
+    };
+
+public:
+    void Set(CScriptCheck &checkIn) {
+        check = CScriptCheck();
+        boost::get<CScriptCheck>(check).swap(checkIn);
+    }
+    void Set(CAssetCheck &checkIn) {
+        check = CAssetCheck();
+        boost::get<CAssetCheck>(check).swap(checkIn);
+    }
+
+    bool operator()() { return boost::apply_visitor(RunCheck(), check); }
+
+    void swap(CBlockCheck &checkIn) { check.swap(checkIn.check); }
+};
+
 /** Initializes the script-execution cache */
 void InitScriptExecutionCache();
 
 bool GetTimestampIndex(const unsigned int &high, const unsigned int &low, const bool fActiveOnly, std::vector<std::pair<uint256, unsigned int> > &hashes);
 bool GetSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value);
 bool HashOnchainActive(const uint256 &hash);
+/** Address index reads start after pAfter when it's given, and return at most nLimit entries when it isn't 0 */
 bool GetAddressIndex(uint160 addressHash, int type, std::string assetName,
                      std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
-                     int start = 0, int end = 0);
+                     int start = 0, int end = 0, const CAddressIndexKey* pAfter = nullptr, size_t nLimit = 0);
 bool GetAddressIndex(uint160 addressHash, int type,
                      std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
-                     int start = 0, int end = 0);
+                     int start = 0, int end = 0, const CAddressIndexKey* pAfter = nullptr, size_t nLimit = 0);
+bool GetAddressIndexAssets(uint160 addressHash, int type, std::vector<std::string> &assets);
+bool GetAddressBalance(uint160 addressHash, int type, std::string assetName, CAddressBalanceValue &balance);
+bool GetAddressBalances(uint160 addressHash, int type,
+                        std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue> > &balances);
 bool GetAddressUnspent(uint160 addressHash, int type, std::string assetName,
-                       std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs);
+                       std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs,
+                       const CAddressUnspentKey* pAfter = nullptr, size_t nLimit = 0);
 bool GetAddressUnspent(uint160 addressHash, int type,
+                       std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs,
+                       const CAddressUnspentKey* pAfter = nullptr, size_t nLimit = 0);
+bool GetAddressUnspentOutput(const CAddressUnspentKey &key, CAddressUnspentValue &value);
+/** Batched address index reads for many addresses at once, in the order of their keys rather than the one given */
+bool GetAddressBalances(const std::vector<std::pair<uint160, int> > &addresses, std::string assetName,
+                        std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue> > &balances);
+bool GetAddressBalances(const std::vector<std::pair<uint160, int> > &addresses,
+                        std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue> > &balances);
+bool GetAddressUnspent(const std::vector<std::pair<uint160, int> > &addresses, std::string assetName,
+                       std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs);
+bool GetAddressUnspent(const std::vector<std::pair<uint160, int> > &addresses,
                        std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs);
 
 /** Functions for disk access for blocks */
@@ -512,16 +685,16 @@ extern CAssetsDB *passetsdb;
 extern CAssetsCache *passets;
 
 /** Global variable that point to the assets metadata LRU Cache (protected by cs_main) */
-extern CLRUCache<std::string, CDatabasedAssetData> *passetsCache;
+extern CShardedLRUCache<std::string, CDatabasedAssetData> *passetsCache;
 
 /** Global variable that points to the subscribed channel LRU Cache (protected by cs_main) */
-extern CLRUCache<std::string, CMessage> *pMessagesCache;
+extern CShardedLRUCache<std::string, CMessage> *pMessagesCache;
 
 /** Global variable that points to the subscribed channel LRU Cache (protected by cs_main) */
-extern CLRUCache<std::string, int> *pMessageSubscribedChannelsCache;
+extern CShardedLRUCache<std::string, int> *pMessageSubscribedChannelsCache;
 
 /** Global variable that points to the address seen LRU Cache (protected by cs_main) */
-extern CLRUCache<std::string, int> *pMessagesSeenAddressCache;
+extern CShardedLRUCache<std::string, int> *pMessagesSeenAddressCache;
 
 /** Global variable that points to the messages database (protected by cs_main) */
 extern CMessageDB *pmessagedb;
@@ -536,16 +709,19 @@ extern CMyRestrictedDB *pmyrestricteddb;
 extern CRestrictedDB *prestricteddb;
 
 /** Global variable that points to the asset verifier LRU Cache (protected by cs_main) */
-extern CLRUCache<std::string, CNullAssetTxVerifierString> *passetsVerifierCache;
+extern CShardedLRUCache<std::string, CNullAssetTxVerifierString> *passetsVerifierCache;
+
+/** Global variable that points to the compiled verifier strings LRU Cache, see CheckVerifierString */
+extern CShardedLRUCache<std::string, std::shared_ptr<const CCompiledVerifierString>> *passetsCompiledVerifierCache;
 
-/** Global variable that points to the asset address qualifier LRU Cache (protected by cs_main) */
-extern CLRUCache<std::string, int8_t> *passetsQualifierCache; // hash(address,qualifier_name) ->int8_t
+/** Global variable that points to the asset address qualifiers LRU Cache (protected by cs_main) */
+extern CShardedLRUCache<std::string, std::set<std::string>> *passetsAddressQualifiersCache; // address -> qualifier names the database holds for it
 
 /** Global variable that points to the asset address restriction LRU Cache (protected by cs_main) */
-extern CLRUCache<std::string, int8_t> *passetsRestrictionCache; // hash(address,qualifier_name) ->int8_t
+extern CShardedLRUCache<std::string, int8_t> *passetsRestrictionCache; // hash(address,qualifier_name) ->int8_t
 
 /** Global variable that points to the global asset restriction LRU Cache (protected by cs_main) */
-extern CLRUCache<std::string, int8_t> *passetsGlobalRestrictionCache;
+extern CShardedLRUCache<std::string, int8_t> *passetsGlobalRestrictionCache;
 
 /** Global variable that point to the active Snapshot Request database (protected by cs_main) */
 extern CSnapshotRequestDB *pSnapshotRequestDb;
@@ -29,6 +29,7 @@ struct MainSignalsInstance {
     boost::signals2::signal<void (const CBlockIndex *, const std::shared_ptr<const CBlock>&)> NewPoWValidBlock;
     boost::signals2::signal<void (const uint256 &)> BlockFound;
     boost::signals2::signal<void (const CMessage &)> NewAssetMessage;
+    boost::signals2::signal<void (const CBlockIndex *, const CAssetsCache &, bool)> AssetsChanged;
     boost::signals2::signal<void (const std::string &)> AssetInventory;
 //    boost::signals2::signal<void (std::shared_ptr<CReserveScript>&)> ScriptForMining;
     
@@ -72,6 +73,7 @@ void RegisterValidationInterface(CValidationInterface* pwalletIn) {
     g_signals.m_internals->NewPoWValidBlock.connect(boost::bind(&CValidationInterface::NewPoWValidBlock, pwalletIn, _1, _2));
     g_signals.m_internals->BlockFound.connect(boost::bind(&CValidationInterface::BlockFound, pwalletIn, _1));
     g_signals.m_internals->NewAssetMessage.connect(boost::bind(&CValidationInterface::NewAssetMessage, pwalletIn, _1));
+    g_signals.m_internals->AssetsChanged.connect(boost::bind(&CValidationInterface::AssetsChanged, pwalletIn, _1, _2, _3));
 //    g_signals.m_internals->ScriptForMining.connect(boost::bind(&CValidationInterface::GetScriptForMining, pwalletIn, _1));
 }
 
@@ -87,6 +89,7 @@ void UnregisterValidationInterface(CValidationInterface* pwalletIn) {
     g_signals.m_internals->NewPoWValidBlock.disconnect(boost::bind(&CValidationInterface::NewPoWValidBlock, pwalletIn, _1, _2));
     g_signals.m_internals->BlockFound.disconnect(boost::bind(&CValidationInterface::BlockFound, pwalletIn, _1));
     g_signals.m_internals->NewAssetMessage.disconnect(boost::bind(&CValidationInterface::NewAssetMessage, pwalletIn, _1));
+    g_signals.m_internals->AssetsChanged.disconnect(boost::bind(&CValidationInterface::AssetsChanged, pwalletIn, _1, _2, _3));
 //    g_signals.m_internals->ScriptForMining.disconnect(boost::bind(&CValidationInterface::GetScriptForMining, pwalletIn, _1));
 }
 
@@ -102,6 +105,7 @@ void UnregisterAllValidationInterfaces() {
     g_signals.m_internals->NewPoWValidBlock.disconnect_all_slots();
     g_signals.m_internals->BlockFound.disconnect_all_slots();
     g_signals.m_internals->NewAssetMessage.disconnect_all_slots();
+    g_signals.m_internals->AssetsChanged.disconnect_all_slots();
 //    g_signals.m_internals->ScriptForMining.disconnect_all_slots();
 }
 
@@ -148,3 +152,7 @@ void CMainSignals::BlockFound(const uint256 &hash) {
 void CMainSignals::NewAssetMessage(const CMessage& message) {
     m_internals->NewAssetMessage(message);
 }
+
+void CMainSignals::AssetsChanged(const CBlockIndex *pindex, const CAssetsCache &assetCache, bool fConnected) {
+    m_internals->AssetsChanged(pindex, assetCache, fConnected);
+}
@@ -22,6 +22,7 @@ class CValidationState;
 class uint256;
 class CScheduler;
 class CMessage;
+class CAssetsCache;
 
 // These functions dispatch to one or all registered wallets
 
@@ -71,6 +72,10 @@ protected:
 
     virtual void BlockFound(const uint256 &hash) {};
     virtual void NewAssetMessage(const CMessage &message) {};
+    /**
+     * Notifies listeners of the asset changes a block made to the chain state, with fConnected false when the
+     * block was disconnected and the changes undone. The cache is only valid for the duration of the call. */
+    virtual void AssetsChanged(const CBlockIndex *pindex, const CAssetsCache &assetCache, bool fConnected) {};
 
 //    virtual void GetScriptForMining(std::shared_ptr<CReserveScript>&) {};
 
@@ -108,6 +113,7 @@ public:
     void NewPoWValidBlock(const CBlockIndex *, const std::shared_ptr<const CBlock>&);
     void BlockFound(const uint256 &);
     void NewAssetMessage(const CMessage&);
+    void AssetsChanged(const CBlockIndex *, const CAssetsCache &, bool fConnected);
 //    void ScriptForMining(std::shared_ptr<CReserveScript>&);
 
 };
@@ -716,4 +716,28 @@ BOOST_FIXTURE_TEST_SUITE(wallet_tests, WalletTestingSetup)
         BOOST_CHECK_EQUAL(list.begin()->second.size(), (uint64_t)2L);
     }
 
+    BOOST_FIXTURE_TEST_CASE(unspent_candidates_balance_test, ListCoinsTestingSetup)
+    {
+        BOOST_TEST_MESSAGE("Running Unspent Candidates Balance Test");
+
+        TurnOffSegwit();
+
+        LOCK2(cs_main, wallet->cs_wallet);
+        BOOST_CHECK_EQUAL(wallet->GetBalance(), 5000 * COIN);
+
+        // Spending the mature coinbase leaves its change, next to the coinbase the new block matured
+        CWalletTx& wtx = AddTx(CRecipient{GetScriptForRawPubKey({}), 1 * COIN, false /* subtract fee */});
+        CAmount nBalance = wallet->GetBalance();
+        BOOST_CHECK(wtx.GetAvailableCredit() < 4999 * COIN);
+        BOOST_CHECK_EQUAL(nBalance, wtx.GetAvailableCredit() + 5000 * COIN);
+        BOOST_CHECK_EQUAL(nBalance, wallet->GetAvailableBalance());
+
+        // Going through every transaction again gives the same
+        wallet->MarkDirty();
+        BOOST_CHECK_EQUAL(wallet->GetBalance(), nBalance);
+        std::vector<COutput> available;
+        wallet->AvailableCoins(available);
+        BOOST_CHECK_EQUAL(available.size(), 2U);
+    }
+
 BOOST_AUTO_TEST_SUITE_END()
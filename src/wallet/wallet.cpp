@@ -963,9 +963,33 @@ void CWallet::MarkDirty()
 {
     {
         LOCK(cs_wallet);
-        for (std::pair<const uint256, CWalletTx>& item : mapWallet)
+        for (std::pair<const uint256, CWalletTx>& item : mapWallet) {
             item.second.MarkDirty();
+            setUnspentCandidates.insert(item.first);
+        }
+    }
+}
+
+std::vector<const CWalletTx*> CWallet::GetUnspentCandidates() const
+{
+    AssertLockHeld(cs_wallet);
+    std::vector<const CWalletTx*> vCandidates;
+    for (std::set<uint256>::iterator it = setUnspentCandidates.begin(); it != setUnspentCandidates.end();) {
+        std::map<uint256, CWalletTx>::const_iterator mi = mapWallet.find(*it);
+        bool fUnspent = false;
+        if (mi != mapWallet.end()) {
+            for (unsigned int i = 0; i < mi->second.tx->vout.size() && !fUnspent; i++) {
+                fUnspent = IsMine(mi->second.tx->vout[i]) != ISMINE_NO && !IsSpent(*it, i);
+            }
+        }
+        if (!fUnspent) {
+            it = setUnspentCandidates.erase(it);
+            continue;
+        }
+        vCandidates.push_back(&mi->second);
+        ++it;
     }
+    return vCandidates;
 }
 
 bool CWallet::MarkReplaced(const uint256& originalHash, const uint256& newHash)
@@ -1065,6 +1089,7 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFlushOnClose)
 
     // Break debit/credit balance caches:
     wtx.MarkDirty();
+    setUnspentCandidates.insert(hash);
 
     // Notify UI of new or updated transaction
     NotifyTransactionChanged(this, hash, fInsertedNew ? CT_NEW : CT_UPDATED);
@@ -1090,6 +1115,7 @@ bool CWallet::LoadToWallet(const CWalletTx& wtxIn)
     wtx.BindWallet(this);
     wtxOrdered.insert(std::make_pair(wtx.nOrderPos, TxPair(&wtx, nullptr)));
     AddToSpends(hash);
+    setUnspentCandidates.insert(hash);
     for (const CTxIn& txin : wtx.tx->vin) {
         auto it = mapWallet.find(txin.prevout.hash);
         if (it != mapWallet.end()) {
@@ -1235,6 +1261,7 @@ bool CWallet::AbandonTransaction(const uint256& hashTx)
                 auto it = mapWallet.find(txin.prevout.hash);
                 if (it != mapWallet.end()) {
                     it->second.MarkDirty();
+                    setUnspentCandidates.insert(it->first);
                 }
             }
         }
@@ -1298,6 +1325,7 @@ void CWallet::MarkConflicted(const uint256& hashBlock, const uint256& hashTx)
                 auto it = mapWallet.find(txin.prevout.hash);
                 if (it != mapWallet.end()) {
                     it->second.MarkDirty();
+                    setUnspentCandidates.insert(it->first);
                 }
             }
         }
@@ -1317,6 +1345,7 @@ void CWallet::SyncTransaction(const CTransactionRef& ptx, const CBlockIndex *pin
         auto it = mapWallet.find(txin.prevout.hash);
         if (it != mapWallet.end()) {
             it->second.MarkDirty();
+            setUnspentCandidates.insert(it->first);
         }
     }
 }
@@ -1730,7 +1759,7 @@ void CWalletTx::GetAmounts(std::list<COutputEntry>& listReceived,
             if (txout.scriptPubKey.IsAssetScript()) {
                 CAssetOutputEntry assetoutput;
                 assetoutput.vout = i;
-                GetAssetData(txout.scriptPubKey, assetoutput);
+                GetAssetData(*tx, i, assetoutput);
 
                 // The only asset type we send is transfer_asset. We need to skip all other types for the sent category
                 if (nDebit > 0 && assetoutput.type == TX_TRANSFER_ASSET)
@@ -2173,9 +2202,8 @@ CAmount CWallet::GetBalance() const
     CAmount nTotal = 0;
     {
         LOCK2(cs_main, cs_wallet);
-        for (std::map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
+        for (const CWalletTx* pcoin : GetUnspentCandidates())
         {
-            const CWalletTx* pcoin = &(*it).second;
             if (pcoin->IsTrusted())
                 nTotal += pcoin->GetAvailableCredit();
         }
@@ -2189,9 +2217,8 @@ CAmount CWallet::GetUnconfirmedBalance() const
     CAmount nTotal = 0;
     {
         LOCK2(cs_main, cs_wallet);
-        for (std::map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
+        for (const CWalletTx* pcoin : GetUnspentCandidates())
         {
-            const CWalletTx* pcoin = &(*it).second;
             if (!pcoin->IsTrusted() && pcoin->GetDepthInMainChain() == 0 && pcoin->InMempool())
                 nTotal += pcoin->GetAvailableCredit();
         }
@@ -2204,9 +2231,8 @@ CAmount CWallet::GetImmatureBalance() const
     CAmount nTotal = 0;
     {
         LOCK2(cs_main, cs_wallet);
-        for (std::map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
+        for (const CWalletTx* pcoin : GetUnspentCandidates())
         {
-            const CWalletTx* pcoin = &(*it).second;
             nTotal += pcoin->GetImmatureCredit();
         }
     }
@@ -2218,9 +2244,8 @@ CAmount CWallet::GetWatchOnlyBalance() const
     CAmount nTotal = 0;
     {
         LOCK2(cs_main, cs_wallet);
-        for (std::map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
+        for (const CWalletTx* pcoin : GetUnspentCandidates())
         {
-            const CWalletTx* pcoin = &(*it).second;
             if (pcoin->IsTrusted())
                 nTotal += pcoin->GetAvailableWatchOnlyCredit();
         }
@@ -2234,9 +2259,8 @@ CAmount CWallet::GetUnconfirmedWatchOnlyBalance() const
     CAmount nTotal = 0;
     {
         LOCK2(cs_main, cs_wallet);
-        for (std::map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
+        for (const CWalletTx* pcoin : GetUnspentCandidates())
         {
-            const CWalletTx* pcoin = &(*it).second;
             if (!pcoin->IsTrusted() && pcoin->GetDepthInMainChain() == 0 && pcoin->InMempool())
                 nTotal += pcoin->GetAvailableWatchOnlyCredit();
         }
@@ -2249,9 +2273,8 @@ CAmount CWallet::GetImmatureWatchOnlyBalance() const
     CAmount nTotal = 0;
     {
         LOCK2(cs_main, cs_wallet);
-        for (std::map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
+        for (const CWalletTx* pcoin : GetUnspentCandidates())
         {
-            const CWalletTx* pcoin = &(*it).second;
             nTotal += pcoin->GetImmatureWatchOnlyCredit();
         }
     }
@@ -2361,9 +2384,8 @@ void CWallet::AvailableCoinsAll(std::vector<COutput>& vCoins, std::map<std::stri
         std::map<uint256, COutPoint> mapOutPoints;
         std::set<std::string> setAssetMaxFound;
         // Turn the OutPoints into a map that is easily interatable.
-        for (std::map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it) {
-            const uint256 &wtxid = it->first;
-            const CWalletTx *pcoin = &(*it).second;
+        for (const CWalletTx *pcoin : GetUnspentCandidates()) {
+            const uint256 &wtxid = pcoin->GetHash();
 
             if (!CheckFinalTx(*pcoin))
                 continue;
@@ -2425,13 +2447,13 @@ void CWallet::AvailableCoinsAll(std::vector<COutput>& vCoins, std::map<std::stri
                 int nType;
                 bool fIsOwner;
                 bool isAssetScript = pcoin->tx->vout[i].scriptPubKey.IsAssetScript(nType, fIsOwner);
-                if (coinControl && !isAssetScript && coinControl->HasSelected() && !coinControl->fAllowOtherInputs && !coinControl->IsSelected(COutPoint((*it).first, i)))
+                if (coinControl && !isAssetScript && coinControl->HasSelected() && !coinControl->fAllowOtherInputs && !coinControl->IsSelected(COutPoint(wtxid, i)))
                     continue;
 
-                if (coinControl && isAssetScript && coinControl->HasAssetSelected() && !coinControl->fAllowOtherInputs && !coinControl->IsAssetSelected(COutPoint((*it).first, i)))
+                if (coinControl && isAssetScript && coinControl->HasAssetSelected() && !coinControl->fAllowOtherInputs && !coinControl->IsAssetSelected(COutPoint(wtxid, i)))
                     continue;
 
-                if (IsLockedCoin((*it).first, i))
+                if (IsLockedCoin(wtxid, i))
                     continue;
 
                 if (IsSpent(wtxid, i))
@@ -2454,7 +2476,7 @@ void CWallet::AvailableCoinsAll(std::vector<COutput>& vCoins, std::map<std::stri
                 if (fGetAssets && AreAssetsDeployed() && isAssetScript) {
 
                     CAssetOutputEntry output_data;
-                    if (!GetAssetData(pcoin->tx->vout[i].scriptPubKey, output_data))
+                    if (!GetAssetData(*pcoin->tx, i, output_data))
                         continue;
 
                     address = EncodeDestination(output_data.destination);
@@ -190,19 +190,6 @@ struct COutputEntry
     int vout;
 };
 
-/** RVN START */
-struct CAssetOutputEntry
-{
-    txnouttype type;
-    std::string assetName;
-    CTxDestination destination;
-    CAmount nAmount;
-    std::string message;
-    int64_t expireTime;
-    int vout;
-};
-/** RVN END */
-
 /** A transaction with a merkle branch linking it to the block chain. */
 class CMerkleTx
 {
@@ -716,6 +703,15 @@ private:
 
     void SyncMetaData(std::pair<TxSpends::iterator, TxSpends::iterator>);
 
+    /**
+     * Transactions that may still have outputs of ours that aren't spent. The balances and available coins
+     * only go through these, dropping the ones found to have none left, so that they don't walk the whole
+     * history of the wallet. Anything that can make a spent output unspent again, or an output ours, puts
+     * its transaction back.
+     */
+    mutable std::set<uint256> setUnspentCandidates;
+    std::vector<const CWalletTx*> GetUnspentCandidates() const;
+
     /* Used by TransactionAddedToMemorypool/BlockConnected/Disconnected.
      * Should be called with pindexBlock and posInBlock if this is for a transaction that is included in a block. */
     void SyncTransaction(const CTransactionRef& tx, const CBlockIndex *pindex = nullptr, int posInBlock = 0);
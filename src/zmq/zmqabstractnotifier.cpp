@@ -4,20 +4,33 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "zmqabstractnotifier.h"
+#include "streams.h"
 #include "util.h"
+#include "version.h"
+#include "rpc/server.h"
 
+std::shared_ptr<const CDataStream> CZMQRawData::Get() const
+{
+    if (!fSerialized) {
+        fSerialized = true;
+        std::shared_ptr<CDataStream> ss = std::make_shared<CDataStream>(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
+        if (serializer(*ss))
+            data = ss;
+    }
+    return data;
+}
 
 CZMQAbstractNotifier::~CZMQAbstractNotifier()
 {
     assert(!psocket);
 }
 
-bool CZMQAbstractNotifier::NotifyBlock(const CBlockIndex * /*CBlockIndex*/)
+bool CZMQAbstractNotifier::NotifyBlock(const CBlockIndex * /*CBlockIndex*/, const CZMQRawData &/*rawBlock*/)
 {
     return true;
 }
 
-bool CZMQAbstractNotifier::NotifyTransaction(const CTransaction &/*transaction*/)
+bool CZMQAbstractNotifier::NotifyTransaction(const CTransaction &/*transaction*/, const CZMQRawData &/*rawTransaction*/)
 {
     return true;
 }
@@ -26,3 +39,8 @@ bool CZMQAbstractNotifier::NotifyMessage(const CMessage &/*message*/)
 {
     return true;
 }
+
+bool CZMQAbstractNotifier::NotifyAssets(const CBlockIndex * /*pindex*/, const CAssetsCache &/*assetCache*/, bool /*fConnected*/)
+{
+    return true;
+}
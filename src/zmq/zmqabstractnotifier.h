@@ -8,12 +8,38 @@
 
 #include "zmqconfig.h"
 
+#include <functional>
+#include <memory>
+
+class CAssetsCache;
 class CBlockIndex;
+class CDataStream;
 class CZMQAbstractNotifier;
 class CMessage;
 
 typedef CZMQAbstractNotifier* (*CZMQNotifierFactory)();
 
+/**
+ * The raw serialization of a block or transaction being published. It is only made once a notifier
+ * asks for it and then shared by every notifier publishing it, which send the same buffer without
+ * copying it.
+ */
+class CZMQRawData
+{
+public:
+    typedef std::function<bool(CDataStream&)> Serializer;
+
+    explicit CZMQRawData(Serializer _serializer) : serializer(std::move(_serializer)), fSerialized(false) { }
+
+    //! Serialize on first use, returns nullptr if that failed
+    std::shared_ptr<const CDataStream> Get() const;
+
+private:
+    Serializer serializer;
+    mutable std::shared_ptr<const CDataStream> data;
+    mutable bool fSerialized;
+};
+
 class CZMQAbstractNotifier
 {
 public:
@@ -34,9 +60,10 @@ public:
     virtual bool Initialize(void *pcontext) = 0;
     virtual void Shutdown() = 0;
 
-    virtual bool NotifyBlock(const CBlockIndex *pindex);
-    virtual bool NotifyTransaction(const CTransaction &transaction);
+    virtual bool NotifyBlock(const CBlockIndex *pindex, const CZMQRawData &rawBlock);
+    virtual bool NotifyTransaction(const CTransaction &transaction, const CZMQRawData &rawTransaction);
     virtual bool NotifyMessage(const CMessage& message);
+    virtual bool NotifyAssets(const CBlockIndex *pindex, const CAssetsCache &assetCache, bool fConnected);
 
 protected:
     void *psocket;
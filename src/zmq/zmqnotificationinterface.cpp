@@ -6,6 +6,7 @@
 #include "zmqnotificationinterface.h"
 #include "zmqpublishnotifier.h"
 
+#include "chainparams.h"
 #include "version.h"
 #include "validation.h"
 #include "streams.h"
@@ -41,6 +42,7 @@ CZMQNotificationInterface* CZMQNotificationInterface::Create()
     factories["pubrawblock"] = CZMQAbstractNotifier::Create<CZMQPublishRawBlockNotifier>;
     factories["pubrawtx"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionNotifier>;
     factories["pubrawmessage"] = CZMQAbstractNotifier::Create<CZMQPublishNewAssetMessageNotifier>;
+    factories["pubassetdelta"] = CZMQAbstractNotifier::Create<CZMQPublishAssetDeltaNotifier>;
 
     for (std::map<std::string, CZMQNotifierFactory>::const_iterator i=factories.begin(); i!=factories.end(); ++i)
     {
@@ -128,13 +130,35 @@ void CZMQNotificationInterface::Shutdown()
 
 void CZMQNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload)
 {
+    std::shared_ptr<const CBlock> pblock;
+    {
+        LOCK(cs_blockConnected);
+        pblock.swap(pblockConnected);
+    }
+
     if (fInitialDownload || pindexNew == pindexFork) // In IBD or blocks were disconnected without any new ones
         return;
 
+    // The new tip is normally the block connected last, only read it from disk otherwise.
+    // Serialized once for all of the notifiers, and without cs_main: blocks on disk are never rewritten.
+    if (pblock && pblock->GetHash() != pindexNew->GetBlockHash())
+        pblock.reset();
+    CZMQRawData rawBlock([pblock, pindexNew](CDataStream& ss) -> bool {
+        if (pblock) {
+            ss << *pblock;
+            return true;
+        }
+        CBlock block;
+        if (!ReadBlockFromDisk(block, pindexNew, GetParams().GetConsensus()))
+            return false;
+        ss << block;
+        return true;
+    });
+
     for (std::list<CZMQAbstractNotifier*>::iterator i = notifiers.begin(); i!=notifiers.end(); )
     {
         CZMQAbstractNotifier *notifier = *i;
-        if (notifier->NotifyBlock(pindexNew))
+        if (notifier->NotifyBlock(pindexNew, rawBlock))
         {
             i++;
         }
@@ -163,16 +187,37 @@ void CZMQNotificationInterface::NewAssetMessage(const CMessage& message)
     }
 }
 
+void CZMQNotificationInterface::AssetsChanged(const CBlockIndex *pindex, const CAssetsCache &assetCache, bool fConnected)
+{
+    for (std::list<CZMQAbstractNotifier*>::iterator i = notifiers.begin(); i!=notifiers.end(); )
+    {
+        CZMQAbstractNotifier *notifier = *i;
+        if (notifier->NotifyAssets(pindex, assetCache, fConnected))
+        {
+            i++;
+        }
+        else
+        {
+            notifier->Shutdown();
+            i = notifiers.erase(i);
+        }
+    }
+}
+
 void CZMQNotificationInterface::TransactionAddedToMempool(const CTransactionRef& ptx)
 {
     // Used by BlockConnected and BlockDisconnected as well, because they're
     // all the same external callback.
     const CTransaction& tx = *ptx;
+    CZMQRawData rawTransaction([&tx](CDataStream& ss) -> bool {
+        ss << tx;
+        return true;
+    });
 
     for (std::list<CZMQAbstractNotifier*>::iterator i = notifiers.begin(); i!=notifiers.end(); )
     {
         CZMQAbstractNotifier *notifier = *i;
-        if (notifier->NotifyTransaction(tx))
+        if (notifier->NotifyTransaction(tx, rawTransaction))
         {
             i++;
         }
@@ -186,6 +231,11 @@ void CZMQNotificationInterface::TransactionAddedToMempool(const CTransactionRef&
 
 void CZMQNotificationInterface::BlockConnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindexConnected, const std::vector<CTransactionRef>& vtxConflicted)
 {
+    {
+        LOCK(cs_blockConnected);
+        pblockConnected = pblock;
+    }
+
     for (const CTransactionRef& ptx : pblock->vtx) {
         // Do a normal notify for each transaction added in the block
         TransactionAddedToMempool(ptx);
@@ -7,9 +7,11 @@
 #define RAVEN_ZMQ_ZMQNOTIFICATIONINTERFACE_H
 
 #include "validationinterface.h"
+#include "sync.h"
 #include <string>
 #include <map>
 #include <list>
+#include <memory>
 
 class CBlockIndex;
 class CZMQAbstractNotifier;
@@ -31,12 +33,17 @@ protected:
     void BlockDisconnected(const std::shared_ptr<const CBlock>& pblock) override;
     void UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload) override;
     void NewAssetMessage(const CMessage& message) override;
+    void AssetsChanged(const CBlockIndex *pindex, const CAssetsCache &assetCache, bool fConnected) override;
 
 private:
     CZMQNotificationInterface();
 
     void *pcontext;
     std::list<CZMQAbstractNotifier*> notifiers;
+
+    //! The last block connected, kept so the rawblock notifiers can publish the new tip without reading it back from disk
+    CCriticalSection cs_blockConnected;
+    std::shared_ptr<const CBlock> pblockConnected;
 };
 
 #endif // RAVEN_ZMQ_ZMQNOTIFICATIONINTERFACE_H
@@ -5,11 +5,15 @@
 
 #include "chain.h"
 #include "chainparams.h"
+#include "core_io.h"
 #include "streams.h"
 #include "zmqpublishnotifier.h"
 #include "validation.h"
 #include "util.h"
 #include "rpc/server.h"
+#include "assets/assets.h"
+
+#include <univalue.h>
 
 static std::multimap<std::string, CZMQAbstractPublishNotifier*> mapPublishNotifiers;
 
@@ -18,6 +22,7 @@ static const char *MSG_HASHTX      = "hashtx";
 static const char *MSG_RAWBLOCK    = "rawblock";
 static const char *MSG_RAWTX       = "rawtx";
 static const char *MSG_RAWASSETMSG = "rawmessage";
+static const char *MSG_ASSETDELTA  = "assetdelta";
 
 // Internal function to send multipart message
 static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
@@ -62,6 +67,64 @@ static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
     return 0;
 }
 
+// Internal function to send one part of a multipart message, copying its data
+static int zmq_send_copy(void *sock, const void* data, size_t size, int flags)
+{
+    zmq_msg_t msg;
+
+    int rc = zmq_msg_init_size(&msg, size);
+    if (rc != 0)
+    {
+        zmqError("Unable to initialize ZMQ msg");
+        return -1;
+    }
+
+    memcpy(zmq_msg_data(&msg), data, size);
+
+    rc = zmq_msg_send(&msg, sock, flags);
+    if (rc == -1)
+    {
+        zmqError("Unable to send ZMQ msg");
+        zmq_msg_close(&msg);
+        return -1;
+    }
+
+    zmq_msg_close(&msg);
+    return 0;
+}
+
+// Drops the reference a zero-copy zmq message holds on its data, called by zmq once the data is sent
+static void zmq_release_shared(void * /*data*/, void *hint)
+{
+    delete static_cast<std::shared_ptr<const CDataStream>*>(hint);
+}
+
+// Internal function to send one part of a multipart message without copying its data
+static int zmq_send_shared(void *sock, const std::shared_ptr<const CDataStream> &data, int flags)
+{
+    zmq_msg_t msg;
+
+    std::shared_ptr<const CDataStream> *hint = new std::shared_ptr<const CDataStream>(data);
+    int rc = zmq_msg_init_data(&msg, const_cast<char*>(data->data()), data->size(), zmq_release_shared, hint);
+    if (rc != 0)
+    {
+        zmqError("Unable to initialize ZMQ msg");
+        delete hint;
+        return -1;
+    }
+
+    rc = zmq_msg_send(&msg, sock, flags);
+    if (rc == -1)
+    {
+        zmqError("Unable to send ZMQ msg");
+        zmq_msg_close(&msg);
+        return -1;
+    }
+
+    zmq_msg_close(&msg);
+    return 0;
+}
+
 bool CZMQAbstractPublishNotifier::Initialize(void *pcontext)
 {
     assert(!psocket);
@@ -148,7 +211,27 @@ bool CZMQAbstractPublishNotifier::SendMessage(const char *command, const void* d
     return true;
 }
 
-bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
+bool CZMQAbstractPublishNotifier::SendMessage(const char *command, const std::shared_ptr<const CDataStream> &data)
+{
+    assert(psocket);
+
+    /* same three parts as above, with the data part shared instead of copied */
+    unsigned char msgseq[sizeof(uint32_t)];
+    WriteLE32(&msgseq[0], nSequence);
+    if (zmq_send_copy(psocket, command, strlen(command), ZMQ_SNDMORE) == -1)
+        return false;
+    if (zmq_send_shared(psocket, data, ZMQ_SNDMORE) == -1)
+        return false;
+    if (zmq_send_copy(psocket, msgseq, sizeof(uint32_t), 0) == -1)
+        return false;
+
+    /* increment memory only sequence number after sending */
+    nSequence++;
+
+    return true;
+}
+
+bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex, const CZMQRawData & /*rawBlock*/)
 {
     uint256 hash = pindex->GetBlockHash();
     LogPrint(BCLog::ZMQ, "zmq: Publish hashblock %s\n", hash.GetHex());
@@ -158,7 +241,7 @@ bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
     return SendMessage(MSG_HASHBLOCK, data, 32);
 }
 
-bool CZMQPublishHashTransactionNotifier::NotifyTransaction(const CTransaction &transaction)
+bool CZMQPublishHashTransactionNotifier::NotifyTransaction(const CTransaction &transaction, const CZMQRawData & /*rawTransaction*/)
 {
     uint256 hash = transaction.GetHash();
     LogPrint(BCLog::ZMQ, "zmq: Publish hashtx %s\n", hash.GetHex());
@@ -168,34 +251,25 @@ bool CZMQPublishHashTransactionNotifier::NotifyTransaction(const CTransaction &t
     return SendMessage(MSG_HASHTX, data, 32);
 }
 
-bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
+bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex, const CZMQRawData &rawBlock)
 {
     LogPrint(BCLog::ZMQ, "zmq: Publish rawblock %s\n", pindex->GetBlockHash().GetHex());
 
-    const Consensus::Params& consensusParams = GetParams().GetConsensus();
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
+    std::shared_ptr<const CDataStream> data = rawBlock.Get();
+    if (!data)
     {
-        LOCK(cs_main);
-        CBlock block;
-        if(!ReadBlockFromDisk(block, pindex, consensusParams))
-        {
-            zmqError("Can't read block from disk");
-            return false;
-        }
-
-        ss << block;
+        zmqError("Can't read block from disk");
+        return false;
     }
 
-    return SendMessage(MSG_RAWBLOCK, &(*ss.begin()), ss.size());
+    return SendMessage(MSG_RAWBLOCK, data);
 }
 
-bool CZMQPublishRawTransactionNotifier::NotifyTransaction(const CTransaction &transaction)
+bool CZMQPublishRawTransactionNotifier::NotifyTransaction(const CTransaction &transaction, const CZMQRawData &rawTransaction)
 {
     uint256 hash = transaction.GetHash();
     LogPrint(BCLog::ZMQ, "zmq: Publish rawtx %s\n", hash.GetHex());
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
-    ss << transaction;
-    return SendMessage(MSG_RAWTX, &(*ss.begin()), ss.size());
+    return SendMessage(MSG_RAWTX, rawTransaction.Get());
 }
 
 bool CZMQPublishNewAssetMessageNotifier::NotifyMessage(const CMessage &message)
@@ -206,3 +280,130 @@ bool CZMQPublishNewAssetMessageNotifier::NotifyMessage(const CMessage &message)
     std::string str = zmqmessage.createJsonString();
     return SendMessage(MSG_RAWASSETMSG, &(*str.begin()), str.size());
 }
+
+// The asset changes of one block, as they leave the chain state once the block is connected (or disconnected)
+static UniValue AssetDeltaToJSON(const CBlockIndex *pindex, const CAssetsCache &assetCache, bool fConnected)
+{
+    UniValue issued(UniValue::VARR), issuesUndone(UniValue::VARR);
+    for (const auto& newAsset : assetCache.setNewAssetsToAdd) {
+        UniValue entry(UniValue::VOBJ);
+        entry.push_back(Pair("name", newAsset.asset.strName));
+        entry.push_back(Pair("address", newAsset.address));
+        entry.push_back(Pair("amount", ValueFromAmount(newAsset.asset.nAmount, newAsset.asset.units)));
+        entry.push_back(Pair("units", newAsset.asset.units));
+        entry.push_back(Pair("reissuable", newAsset.asset.nReissuable != 0));
+        if (newAsset.asset.nHasIPFS)
+            entry.push_back(Pair("ipfs_hash", EncodeAssetData(newAsset.asset.strIPFSHash)));
+        issued.push_back(entry);
+    }
+    for (const auto& newAsset : assetCache.setNewAssetsToRemove)
+        issuesUndone.push_back(newAsset.asset.strName);
+
+    UniValue reissued(UniValue::VARR), reissuesUndone(UniValue::VARR);
+    for (const auto& reissue : assetCache.setNewReissueToAdd) {
+        UniValue entry(UniValue::VOBJ);
+        entry.push_back(Pair("name", reissue.reissue.strName));
+        entry.push_back(Pair("address", reissue.address));
+        entry.push_back(Pair("amount", ValueFromAmount(reissue.reissue.nAmount)));
+        if (reissue.reissue.nUnits != -1)
+            entry.push_back(Pair("units", reissue.reissue.nUnits));
+        entry.push_back(Pair("reissuable", reissue.reissue.nReissuable != 0));
+        if (!reissue.reissue.strIPFSHash.empty())
+            entry.push_back(Pair("ipfs_hash", EncodeAssetData(reissue.reissue.strIPFSHash)));
+        entry.push_back(Pair("txid", reissue.out.hash.GetHex()));
+        entry.push_back(Pair("vout", (int)reissue.out.n));
+        reissued.push_back(entry);
+    }
+    for (const auto& reissue : assetCache.setNewReissueToRemove)
+        reissuesUndone.push_back(reissue.reissue.strName);
+
+    auto transferToJSON = [](const CAssetCacheNewTransfer& transfer) -> UniValue {
+        UniValue entry(UniValue::VOBJ);
+        entry.push_back(Pair("name", transfer.transfer.strName));
+        entry.push_back(Pair("address", transfer.address));
+        entry.push_back(Pair("amount", ValueFromAmount(transfer.transfer.nAmount)));
+        entry.push_back(Pair("txid", transfer.out.hash.GetHex()));
+        entry.push_back(Pair("vout", (int)transfer.out.n));
+        return entry;
+    };
+    UniValue transfers(UniValue::VARR), transfersUndone(UniValue::VARR);
+    for (const auto& transfer : assetCache.setNewTransferAssetsToAdd)
+        transfers.push_back(transferToJSON(transfer));
+    for (const auto& transfer : assetCache.setNewTransferAssetsToRemove)
+        transfersUndone.push_back(transferToJSON(transfer));
+
+    // Undoing a tag, freeze or global freeze has the opposite effect of applying it
+    UniValue tagged(UniValue::VARR), untagged(UniValue::VARR);
+    auto addTag = [&tagged, &untagged](const CAssetCacheQualifierAddress& tag, bool fUndo) {
+        UniValue entry(UniValue::VOBJ);
+        entry.push_back(Pair("qualifier", tag.assetName));
+        entry.push_back(Pair("address", tag.address));
+        ((tag.type == QualifierType::ADD_QUALIFIER) != fUndo ? tagged : untagged).push_back(entry);
+    };
+    for (const auto& tag : assetCache.setNewQualifierAddressToAdd)
+        addTag(tag, false);
+    for (const auto& tag : assetCache.setNewQualifierAddressToRemove)
+        addTag(tag, true);
+
+    UniValue frozen(UniValue::VARR), unfrozen(UniValue::VARR);
+    auto addFreeze = [&frozen, &unfrozen](const CAssetCacheRestrictedAddress& freeze, bool fUndo) {
+        UniValue entry(UniValue::VOBJ);
+        entry.push_back(Pair("name", freeze.assetName));
+        entry.push_back(Pair("address", freeze.address));
+        ((freeze.type == RestrictedType::FREEZE_ADDRESS) != fUndo ? frozen : unfrozen).push_back(entry);
+    };
+    for (const auto& freeze : assetCache.setNewRestrictedAddressToAdd)
+        addFreeze(freeze, false);
+    for (const auto& freeze : assetCache.setNewRestrictedAddressToRemove)
+        addFreeze(freeze, true);
+
+    UniValue globallyFrozen(UniValue::VARR), globallyUnfrozen(UniValue::VARR);
+    for (const auto& global : assetCache.setNewRestrictedGlobalToAdd)
+        (global.type == RestrictedType::GLOBAL_FREEZE ? globallyFrozen : globallyUnfrozen).push_back(global.assetName);
+    for (const auto& global : assetCache.setNewRestrictedGlobalToRemove)
+        (global.type == RestrictedType::GLOBAL_FREEZE ? globallyUnfrozen : globallyFrozen).push_back(global.assetName);
+
+    UniValue verifiers(UniValue::VARR), verifiersUndone(UniValue::VARR);
+    for (const auto& verifier : assetCache.setNewRestrictedVerifierToAdd) {
+        UniValue entry(UniValue::VOBJ);
+        entry.push_back(Pair("name", verifier.assetName));
+        entry.push_back(Pair("verifier_string", verifier.verifier));
+        verifiers.push_back(entry);
+    }
+    for (const auto& verifier : assetCache.setNewRestrictedVerifierToRemove)
+        verifiersUndone.push_back(verifier.assetName);
+
+    UniValue result(UniValue::VOBJ);
+    result.push_back(Pair("event", fConnected ? "connected" : "disconnected"));
+    result.push_back(Pair("height", pindex->nHeight));
+    result.push_back(Pair("blockhash", pindex->GetBlockHash().GetHex()));
+
+    // Only the kinds of changes the block made are listed, an empty object means none at all
+    UniValue changes(UniValue::VOBJ);
+    for (const auto& item : std::vector<std::pair<const char*, const UniValue*>>{
+            {"issued", &issued}, {"issues_undone", &issuesUndone},
+            {"reissued", &reissued}, {"reissues_undone", &reissuesUndone},
+            {"transfers", &transfers}, {"transfers_undone", &transfersUndone},
+            {"tagged", &tagged}, {"untagged", &untagged},
+            {"frozen", &frozen}, {"unfrozen", &unfrozen},
+            {"globally_frozen", &globallyFrozen}, {"globally_unfrozen", &globallyUnfrozen},
+            {"verifiers", &verifiers}, {"verifiers_undone", &verifiersUndone}}) {
+        if (!item.second->empty())
+            changes.push_back(Pair(item.first, *item.second));
+    }
+    result.push_back(Pair("changes", changes));
+
+    return result;
+}
+
+bool CZMQPublishAssetDeltaNotifier::NotifyAssets(const CBlockIndex *pindex, const CAssetsCache &assetCache, bool fConnected)
+{
+    UniValue delta = AssetDeltaToJSON(pindex, assetCache, fConnected);
+    if (delta["changes"].empty())
+        return true;
+
+    LogPrint(BCLog::ZMQ, "zmq: Publish assetdelta %s %s\n", delta["event"].get_str(), pindex->GetBlockHash().GetHex());
+
+    std::string str = delta.write();
+    return SendMessage(MSG_ASSETDELTA, &(*str.begin()), str.size());
+}
@@ -26,6 +26,11 @@ public:
     */
     bool SendMessage(const char *command, const void* data, size_t size);
 
+    /* send the same multipart message with data that is handed to zmq without
+       being copied, and kept alive until zmq is done sending it
+    */
+    bool SendMessage(const char *command, const std::shared_ptr<const CDataStream> &data);
+
     bool Initialize(void *pcontext) override;
     void Shutdown() override;
 };
@@ -33,25 +38,25 @@ public:
 class CZMQPublishHashBlockNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyBlock(const CBlockIndex *pindex) override;
+    bool NotifyBlock(const CBlockIndex *pindex, const CZMQRawData &rawBlock) override;
 };
 
 class CZMQPublishHashTransactionNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyTransaction(const CTransaction &transaction) override;
+    bool NotifyTransaction(const CTransaction &transaction, const CZMQRawData &rawTransaction) override;
 };
 
 class CZMQPublishRawBlockNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyBlock(const CBlockIndex *pindex) override;
+    bool NotifyBlock(const CBlockIndex *pindex, const CZMQRawData &rawBlock) override;
 };
 
 class CZMQPublishRawTransactionNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyTransaction(const CTransaction &transaction) override;
+    bool NotifyTransaction(const CTransaction &transaction, const CZMQRawData &rawTransaction) override;
 };
 
 class CZMQPublishNewAssetMessageNotifier : public CZMQAbstractPublishNotifier
@@ -60,4 +65,10 @@ public:
     bool NotifyMessage(const CMessage& message) override;
 };
 
+class CZMQPublishAssetDeltaNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyAssets(const CBlockIndex *pindex, const CAssetsCache &assetCache, bool fConnected) override;
+};
+
 #endif // RAVEN_ZMQ_ZMQPUBLISHNOTIFIER_H
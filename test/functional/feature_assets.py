@@ -165,6 +165,13 @@ class AssetTest(RavenTestFramework):
         assert_equal(len(raven_assets), 2)
         assert_equal(raven_assets[0], "RAVEN2")
         assert_equal(raven_assets[1], "RAVEN3")
+
+        self.log.info("Checking listassets() resume cursor...")
+        raven_assets = n0.listassets(asset="RAVEN*", verbose=False, count=2)
+        assert_equal(raven_assets, ["RAVEN1", "RAVEN2"])
+        raven_assets = n0.listassets(asset="RAVEN*", verbose=False, count=2, start=0, after=raven_assets[-1])
+        assert_equal(raven_assets, ["RAVEN3"])
+        assert_raises_rpc_error(-8, "start can't be negative when after is given.", n0.listassets, "RAVEN*", False, 2, -2, "RAVEN1")
         self.sync_all()
 
     def issue_param_checks(self):
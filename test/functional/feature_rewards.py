@@ -7,7 +7,7 @@
 """Testing rewards use cases"""
 
 from test_framework.test_framework import RavenTestFramework
-from test_framework.util import assert_equal, assert_raises_rpc_error, assert_contains, Decimal
+from test_framework.util import assert_equal, assert_raises_rpc_error, assert_contains, sync_blocks, sync_mempools, Decimal
 
 # noinspection PyAttributeOutsideInit
 class RewardsTest(RavenTestFramework):
@@ -17,6 +17,18 @@ class RewardsTest(RavenTestFramework):
         self.extra_args = [["-assetindex", "-debug=rewards"], ["-assetindex", "-minrewardheight=15"], ["-assetindex"],
                            ["-assetindex"]]
 
+    def sync_rewards(self, nodes=None):
+        """Wait for the rewards thread of each node to work through the snapshots and distributions queued for it."""
+        for node in nodes or self.nodes:
+            node.syncwithrewardsthread()
+
+    def sync_all(self, node_groups=None):
+        """Also wait for the rewards threads, so distribution payments have been sent before the next block is mined."""
+        for group in node_groups or [self.nodes]:
+            sync_blocks(group)
+            self.sync_rewards(group)
+            sync_mempools(group)
+
     def activate_assets(self):
         self.log.info("Generating RVN for node[0] and activating assets...")
         n0, n1, n2 = self.nodes[0], self.nodes[1], self.nodes[2]
@@ -126,6 +138,9 @@ class RewardsTest(RavenTestFramework):
         snap_shot = n0.getsnapshot(asset_name="STOCK1", block_height=tgt_block_height)
         assert_equal(snap_shot["name"], "STOCK1")
         assert_equal(snap_shot["height"], tgt_block_height)
+        snap_shot_req = n0.getsnapshotrequest(asset_name="STOCK1", block_height=tgt_block_height)
+        assert_equal(snap_shot_req["snapshot"]["status"], "complete")
+        assert_equal(snap_shot_req["snapshot"]["owners_processed"], len(snap_shot["owners"]))
         owner0 = False
         owner1 = False
         owner2 = False
@@ -181,6 +196,7 @@ class RewardsTest(RavenTestFramework):
         self.log.info("Initiating reward payout")
         n0.distributereward(asset_name="STOCK1", snapshot_height=tgt_block_height, distribution_asset_name="RVN",
                             gross_distribution_amount=2000, exception_addresses=dist_addr0)
+        self.sync_rewards()
         n0.generate(10)
         self.sync_all()
 
@@ -193,6 +209,9 @@ class RewardsTest(RavenTestFramework):
         assert_equal(n1.getreceivedbyaddress(shareholder_addr3, 0), 500)
         assert_equal(n0.getreceivedbyaddress(shareholder_addr4, 0), 600)
 
+        self.log.info("Verifying the distribution was marked complete once its payments were mined")
+        assert_equal(n0.getdistributestatus("STOCK1", tgt_block_height, "RVN", 2000, dist_addr0)['Status'], 2)
+
     # Basic functionality test - ASSET reward
     # - create the main owner address
     # - mine blocks to have enough RVN for the reward fees, plus purchasing the asset
@@ -328,6 +347,7 @@ class RewardsTest(RavenTestFramework):
         self.log.info("Initiating reward payout")
         n0.distributereward(asset_name="STOCK2", snapshot_height=tgt_block_height, distribution_asset_name="PAYOUT1",
                             gross_distribution_amount=2000, exception_addresses=dist_addr0)
+        self.sync_rewards()
         n0.generate(10)
         self.sync_all()
 
@@ -496,6 +516,7 @@ class RewardsTest(RavenTestFramework):
         self.log.info("Initiating reward payout should succeed because -minrewardheight=15 on node1")
         n1.distributereward("STOCK7", tgt_block_height, "RVN", 2000, owner_addr0)
 
+        self.sync_rewards()
         n1.generate(2)
         self.sync_all()
 
@@ -553,6 +574,7 @@ class RewardsTest(RavenTestFramework):
         self.log.info("Initiating reward payout")
         n1.distributereward("STOCK_7.1", tgt_block_height, "LOW_ASSET_AMOUNT", 2000, owner_addr0)
 
+        self.sync_rewards()
         n1.generate(2)
         self.sync_all()
 
@@ -706,6 +728,7 @@ class RewardsTest(RavenTestFramework):
         self.log.info("Initiating reward payout")
         n0.distributereward(asset_name="STOCK8", snapshot_height=tgt_block_height, distribution_asset_name="PAYOUT8",
                             gross_distribution_amount=10, exception_addresses=dist_addr0)
+        self.sync_rewards()
         n0.generate(10)
         self.sync_all()
 
@@ -809,6 +832,7 @@ class RewardsTest(RavenTestFramework):
         self.log.info("Initiating reward payout")
         n0.distributereward(asset_name="STOCK9", snapshot_height=tgt_block_height, distribution_asset_name="PAYOUT9",
                             gross_distribution_amount=10, exception_addresses=dist_addr0)
+        self.sync_rewards()
         n0.generate(10)
         self.sync_all()
 
@@ -913,6 +937,7 @@ class RewardsTest(RavenTestFramework):
         self.log.info("Initiating reward payout")
         n0.distributereward(asset_name="STOCK10", snapshot_height=tgt_block_height, distribution_asset_name="PAYOUT10",
                             gross_distribution_amount=10, exception_addresses=dist_addr0)
+        self.sync_rewards()
         n0.generate(10)
         self.sync_all()
 
@@ -1024,6 +1049,7 @@ class RewardsTest(RavenTestFramework):
         self.log.info("Initiating reward payout")
         n0.distributereward(asset_name="STOCK11", snapshot_height=tgt_block_height, distribution_asset_name="PAYOUT11",
                             gross_distribution_amount=10, exception_addresses=dist_addr0)
+        self.sync_rewards()
         n0.generate(10)
         self.sync_all()
 
@@ -1131,6 +1157,7 @@ class RewardsTest(RavenTestFramework):
         self.log.info("Initiating reward payout")
         n0.distributereward(asset_name="STOCK12", snapshot_height=tgt_block_height, distribution_asset_name="PAYOUT12",
                             gross_distribution_amount=10, exception_addresses=dist_addr0)
+        self.sync_rewards()
         n0.generate(10)
         self.sync_all()
 
@@ -1237,6 +1264,7 @@ class RewardsTest(RavenTestFramework):
                             distribution_asset_name="TTTTTTTTTTTTTTTTTTTTTTTTTTTTT1", gross_distribution_amount=100000,
                             exception_addresses=dist_addr0, change_address="", dry_run=False)
         # print(result)
+        self.sync_rewards()
         n0.generate(10)
         self.sync_all()
 
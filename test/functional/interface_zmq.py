@@ -8,6 +8,7 @@
 """Test the ZMQ notification interface."""
 
 import configparser
+import json
 import os
 import struct
 from test_framework.test_framework import RavenTestFramework, SkipTest
@@ -72,13 +73,21 @@ class ZMQTest(RavenTestFramework):
         self.rawblock = ZMQSubscriber(socket, b"rawblock")
         self.rawtx = ZMQSubscriber(socket, b"rawtx")
 
-        self.extra_args = [["-zmqpub%s=%s" % (sub.topic.decode(), address) for sub in [self.hashblock, self.hashtx, self.rawblock, self.rawtx]], []]
+        # The asset changes are read from a socket of their own, so the blocks and transactions published
+        # while assets are activated don't have to be read off the one above.
+        asset_socket = self.zmq_context.socket(zmq.SUB)
+        asset_socket.set(zmq.RCVTIMEO, 60000)
+        asset_socket.connect(address)
+        self.assetdelta = ZMQSubscriber(asset_socket, b"assetdelta")
+
+        self.extra_args = [["-zmqpub%s=%s" % (sub.topic.decode(), address) for sub in [self.hashblock, self.hashtx, self.rawblock, self.rawtx, self.assetdelta]], []]
         self.add_nodes(self.num_nodes, self.extra_args)
         self.start_nodes()
 
     def run_test(self):
         try:
             self._zmq_test()
+            self._zmq_asset_test()
         finally:
             # Destroy the ZMQ context.
             self.log.debug("Destroying ZMQ context")
@@ -97,6 +106,7 @@ class ZMQTest(RavenTestFramework):
             # Should receive the coinbase raw transaction.
             hex_data = self.rawtx.receive()
             assert_equal(hash256(hex_data).hex(), self.nodes[1].getrawtransaction(txid.hex(), True)["hash"])
+            assert_equal(hex_data.hex(), self.nodes[1].getrawtransaction(txid.hex()))
 
             # Should receive the generated block hash.
             hash_data = self.hashblock.receive().hex()
@@ -107,6 +117,7 @@ class ZMQTest(RavenTestFramework):
             # Should receive the generated raw block.
             block = self.rawblock.receive()
             assert_equal(genhashes[x], x16_hash_block(block[:80].hex(), "2"))
+            assert_equal(block.hex(), self.nodes[1].getblock(genhashes[x], 0))
 
         self.log.info("Wait for tx from second node")
         payment_txid = self.nodes[1].sendtoaddress(self.nodes[0].getnewaddress(), 1.0)
@@ -119,6 +130,80 @@ class ZMQTest(RavenTestFramework):
         # Should receive the broadcasted raw transaction.
         hex_data = self.rawtx.receive()
         assert_equal(payment_txid, hash256(hex_data).hex())
+        assert_equal(hex_data.hex(), self.nodes[1].getrawtransaction(payment_txid))
+
+        # The raw topics hand zmq a buffer shared with the node rather than a copy, which zmq holds on to
+        # until the message is sent. Publish a burst of blocks and transactions before reading any of them,
+        # so that they queue up behind the subscriber, and check every payload still arrives intact.
+        self.log.info("Queue a burst of blocks and transactions and check their payloads")
+        payment_txids = [self.nodes[1].sendtoaddress(self.nodes[0].getnewaddress(), 1.0) for _ in range(3)]
+        self.sync_all()
+        genhashes = self.nodes[0].generate(num_blocks * 2)
+        self.sync_all()
+
+        received_txids = set()
+        for _ in payment_txids:
+            txid = self.hashtx.receive().hex()
+            assert_equal(self.rawtx.receive().hex(), self.nodes[1].getrawtransaction(txid))
+            received_txids.add(txid)
+        assert_equal(received_txids, set(payment_txids))
+
+        mined_txids = set()
+        for blockhash in genhashes:
+            # Each transaction of the block is published again as it is connected, then the block itself
+            for txid in self.nodes[1].getblock(blockhash)["tx"]:
+                assert_equal(txid, self.hashtx.receive().hex())
+                assert_equal(self.rawtx.receive().hex(), self.nodes[1].getrawtransaction(txid))
+                mined_txids.add(txid)
+            assert_equal(blockhash, self.hashblock.receive().hex())
+            assert_equal(self.rawblock.receive().hex(), self.nodes[1].getblock(blockhash, 0))
+        assert set(payment_txids + [payment_txid]).issubset(mined_txids)
+
+
+    def _zmq_asset_test(self):
+        node = self.nodes[0]
+        self.log.info("Activate assets")
+        node.generate(432)
+        assert_equal("active", node.getblockchaininfo()['bip9_softforks']['assets']['status'])
+
+        self.log.info("Issue an asset and check its block's changes are published once they are flushed")
+        address = node.getnewaddress()
+        node.issue(asset_name="ZMQ_ASSET", qty=1000, to_address=address, change_address="", units=2, reissuable=True, has_ipfs=False)
+        blockhash = node.generate(1)[0]
+        height = node.getblockcount()
+
+        delta = json.loads(self.assetdelta.receive().decode())
+        assert_equal(delta["event"], "connected")
+        assert_equal(delta["height"], height)
+        assert_equal(delta["blockhash"], blockhash)
+        issued = [entry for entry in delta["changes"]["issued"] if entry["name"] == "ZMQ_ASSET"]
+        assert_equal(len(issued), 1)
+        assert_equal(issued[0]["address"], address)
+        assert_equal(issued[0]["amount"], 1000)
+        assert_equal(issued[0]["units"], 2)
+        assert_equal(issued[0]["reissuable"], True)
+
+        # The message describes the asset state the node now serves
+        asset_data = node.getassetdata("ZMQ_ASSET")
+        assert_equal(asset_data["amount"], 1000)
+        assert_equal(asset_data["units"], 2)
+
+        self.log.info("Disconnect the block and check the undone issue is published")
+        node.invalidateblock(blockhash)
+        delta = json.loads(self.assetdelta.receive().decode())
+        assert_equal(delta["event"], "disconnected")
+        assert_equal(delta["height"], height)
+        assert_equal(delta["blockhash"], blockhash)
+        assert "ZMQ_ASSET" in delta["changes"]["issues_undone"]
+        assert_equal(node.getassetdata("ZMQ_ASSET"), None)
+
+        self.log.info("Reconnect the block and check its changes are published again")
+        node.reconsiderblock(blockhash)
+        delta = json.loads(self.assetdelta.receive().decode())
+        assert_equal(delta["event"], "connected")
+        assert_equal(delta["blockhash"], blockhash)
+        assert "ZMQ_ASSET" in [entry["name"] for entry in delta["changes"]["issued"]]
+        assert_equal(node.getassetdata("ZMQ_ASSET")["amount"], 1000)
 
 
 if __name__ == '__main__':